@@ -0,0 +1,290 @@
+// Benchmark suite for the collection, filtering, sorting, tree and
+// rendering paths. Run with `make bench`; `./lpm-bench --json` writes
+// machine-readable results for regression tracking.
+
+#include "process.hpp"
+#include "process_filter.hpp"
+#include "process_group.hpp"
+#include "process_source.hpp"
+#include "process_tree.hpp"
+#include "process_profile.hpp"
+#include "process_tui.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+struct BenchResult {
+    std::string name;
+    size_t processes;         // Table size the benchmark ran against
+    uint64_t iterations;
+    double nsPerOp;
+    double allocsPerOp;
+    double bytesPerOp;
+    double itemsPerSecond;    // Processes (or rows) handled per second
+};
+
+struct BenchOptions {
+    std::vector<size_t> sizes;
+    double minTimeMs;
+    std::string filter;
+    bool json;
+
+    BenchOptions() : sizes({1000, 10000, 100000}), minTimeMs(200), json(false) {}
+};
+
+static BenchOptions options;
+static std::vector<BenchResult> results;
+
+// Run 'op' until minTimeMs has elapsed; each call handles 'itemsPerOp' items
+static void measure(const std::string& name, size_t processes, size_t itemsPerOp,
+                    const std::function<void()>& op) {
+    if (!options.filter.empty() && name.find(options.filter) == std::string::npos) {
+        return;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    op(); // Warm up caches and lazily built state
+
+    uint64_t iterations = 0;
+    uint64_t batch = 1;
+    double elapsedNs = 0;
+    uint64_t allocs = 0;
+    uint64_t bytes = 0;
+
+    while (elapsedNs < options.minTimeMs * 1e6) {
+        uint64_t allocsBefore = Profiler::get(Profiler::ALLOCATIONS);
+        uint64_t bytesBefore = Profiler::get(Profiler::ALLOCATED_BYTES);
+        auto start = Clock::now();
+        for (uint64_t i = 0; i < batch; i++) {
+            op();
+        }
+        auto end = Clock::now();
+        allocs += Profiler::get(Profiler::ALLOCATIONS) - allocsBefore;
+        bytes += Profiler::get(Profiler::ALLOCATED_BYTES) - bytesBefore;
+        elapsedNs += std::chrono::duration<double, std::nano>(end - start).count();
+        iterations += batch;
+        batch *= 2;
+    }
+
+    BenchResult result;
+    result.name = name;
+    result.processes = processes;
+    result.iterations = iterations;
+    result.nsPerOp = elapsedNs / iterations;
+    result.allocsPerOp = (double)allocs / iterations;
+    result.bytesPerOp = (double)bytes / iterations;
+    result.itemsPerSecond = itemsPerOp * 1e9 / result.nsPerOp;
+    results.push_back(result);
+
+    if (!options.json) {
+        printf("%-28s %8zu %10llu %14.0f %12.1f %14.0f %14.0f\n",
+               name.c_str(), processes, (unsigned long long)iterations, result.nsPerOp,
+               result.allocsPerOp, result.bytesPerOp, result.itemsPerSecond);
+        fflush(stdout);
+    }
+}
+
+// Benchmarks against the live /proc of this host
+static void benchLive() {
+    ProcessManager manager(std::make_shared<ProcfsSource>());
+    size_t count = manager.getAllProcesses().size();
+
+    measure("collect/live", count, count, [&]() {
+        std::vector<Process> processes = manager.getAllProcesses();
+    });
+
+    int self = getpid();
+    measure("readFromProc/live", count, 1, [&]() {
+        Process proc;
+        proc.readFromProc(self);
+    });
+}
+
+// Benchmarks for one table size
+static void benchSize(size_t size) {
+    auto synthetic = std::make_shared<SyntheticSource>(size);
+    ProcessManager manager(synthetic);
+    std::vector<Process> processes = manager.getAllProcesses();
+    size_t count = processes.size();
+
+    measure("collect/synthetic", count, count, [&]() {
+        std::vector<Process> snapshot = manager.getAllProcesses();
+    });
+
+    // Parse the same table from files, as from a captured /proc
+    char dirTemplate[] = "/tmp/lpm-bench-XXXXXX";
+    std::string error;
+    if (mkdtemp(dirTemplate) && synthetic->writeTree(dirTemplate, error)) {
+        ProcessManager directory(std::make_shared<DirectorySource>(dirTemplate));
+        measure("collect/directory", count, count, [&]() {
+            std::vector<Process> snapshot = directory.getAllProcesses();
+        });
+
+        size_t next = 0;
+        std::string root = dirTemplate;
+        measure("readFromProc/directory", count, 1, [&]() {
+            Process proc;
+            proc.readFromProc(processes[next].pid, root);
+            next = (next + 1) % count;
+        });
+    } else if (!error.empty()) {
+        std::cerr << "skipping directory benchmarks: " << error << "\n";
+    }
+    std::error_code ec;
+    std::filesystem::remove_all(dirTemplate, ec);
+
+    measure("search/hit", count, count, [&]() {
+        std::vector<Process> found = ProcessFilter::search(processes, "chrome");
+    });
+    measure("search/miss", count, count, [&]() {
+        std::vector<Process> found = ProcessFilter::search(processes, "no-such-process");
+    });
+
+    // Sorting works in place, so every run sorts a fresh copy of the
+    // unsorted table; sort/copy measures the copy alone
+    std::vector<Process> shuffled = processes;
+    for (size_t i = shuffled.size(); i > 1; i--) {
+        std::swap(shuffled[i - 1], shuffled[(i * 2654435761u) % i]);
+    }
+    std::vector<Process> work;
+    measure("sort/copy", count, count, [&]() {
+        work = shuffled;
+    });
+
+    static const struct {
+        ProcessSorter::SortField field;
+        const char* name;
+    } fields[] = {
+        {ProcessSorter::BY_PID, "sort/pid"},
+        {ProcessSorter::BY_NAME, "sort/name"},
+        {ProcessSorter::BY_USER, "sort/user"},
+        {ProcessSorter::BY_CPU, "sort/cpu"},
+        {ProcessSorter::BY_MEMORY, "sort/memory"},
+        {ProcessSorter::BY_STATE, "sort/state"},
+        {ProcessSorter::BY_PPID, "sort/ppid"},
+    };
+    for (const auto& entry : fields) {
+        measure(entry.name, count, count, [&]() {
+            work = shuffled;
+            ProcessSorter::sort(work, entry.field, true);
+        });
+    }
+
+    measure("tree/build", count, count, [&]() {
+        ProcessTree tree;
+        tree.buildTree(processes);
+    });
+
+    ProcessTree tree;
+    tree.buildTree(processes);
+    measure("tree/lines", count, count, [&]() {
+        std::vector<std::string> lines = tree.getTreeLines(true);
+    });
+
+    // One aggregation pass and a sort of the groups, as on every refresh
+    // of the TUI's group view
+    static const struct {
+        ProcessGrouper::Key key;
+        const char* name;
+    } keys[] = {
+        {ProcessGrouper::BY_USER, "group/user"},
+        {ProcessGrouper::BY_NAME, "group/name"},
+        {ProcessGrouper::BY_STATE, "group/state"},
+    };
+    ProcessGrouper grouper;
+    for (const auto& entry : keys) {
+        measure(entry.name, count, count, [&]() {
+            grouper.build(processes, entry.key);
+            grouper.sort(ProcessGrouper::SORT_RSS);
+        });
+    }
+
+    // One list row per operation, cycling through the table
+    ProcessTUI tui;
+    size_t row = 0;
+    measure("render/row", count, 1, [&]() {
+        std::string line = tui.getProcessLine(processes[row], 200);
+        row = (row + 1) % count;
+    });
+}
+
+// Parse a comma-separated list of sizes
+static bool parseSizes(const std::string& text, std::vector<size_t>& sizes) {
+    sizes.clear();
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t comma = text.find(',', start);
+        std::string item = text.substr(start, comma == std::string::npos ? std::string::npos
+                                                                          : comma - start);
+        char* end = nullptr;
+        unsigned long value = std::strtoul(item.c_str(), &end, 10);
+        if (item.empty() || *end != '\0' || value == 0) {
+            return false;
+        }
+        sizes.push_back(value);
+        if (comma == std::string::npos) {
+            break;
+        }
+        start = comma + 1;
+    }
+    return !sizes.empty();
+}
+
+static void writeJSON() {
+    printf("{\"benchmarks\":[");
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        printf("%s\n{\"name\":\"%s\",\"processes\":%zu,\"iterations\":%llu,"
+               "\"ns_per_op\":%.1f,\"allocs_per_op\":%.2f,\"bytes_per_op\":%.1f,"
+               "\"items_per_second\":%.1f}",
+               i ? "," : "", r.name.c_str(), r.processes, (unsigned long long)r.iterations,
+               r.nsPerOp, r.allocsPerOp, r.bytesPerOp, r.itemsPerSecond);
+    }
+    printf("\n]}\n");
+}
+
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--json") {
+            options.json = true;
+        } else if (arg == "--sizes" && hasValue) {
+            if (!parseSizes(argv[++i], options.sizes)) {
+                std::cerr << "Error: invalid size list: " << argv[i] << "\n";
+                return 1;
+            }
+        } else if (arg == "--min-time" && hasValue) {
+            options.minTimeMs = std::atof(argv[++i]);
+        } else if (arg == "--filter" && hasValue) {
+            options.filter = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--json] [--sizes N,N,...] [--min-time MS] [--filter NAME]\n";
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    if (!options.json) {
+        printf("%-28s %8s %10s %14s %12s %14s %14s\n", "BENCHMARK", "PROCS", "ITERS",
+               "NS/OP", "ALLOCS/OP", "BYTES/OP", "ITEMS/S");
+        printf("%s\n", std::string(106, '-').c_str());
+    }
+
+    benchLive();
+    for (size_t size : options.sizes) {
+        benchSize(size);
+    }
+
+    if (options.json) {
+        writeJSON();
+    }
+    return 0;
+}
@@ -1,235 +1,2045 @@
-#include "process.hpp"
-#include "process_control.hpp"
-#include "process_tree.hpp"
-#include "process_filter.hpp"
-#include "process_tui.hpp"
-#include <iostream>
-#include <iomanip>
-#include <string>
-#include <cstring>
-
-// Function prototypes
-void printUsage(const char* programName);
-void listProcesses(bool detailed);
-void showProcessTree();
-void searchProcesses(const std::string& query);
-void killProcess(int pid, int signal);
-void showTopProcesses(int count);
-void interactiveMode();
-
-int main(int argc, char* argv[]) {
-    // Parse command line arguments
-    if (argc == 1) {
-        // No arguments - run interactive TUI
-        interactiveMode();
-        return 0;
-    }
-    
-    std::string command = argv[1];
-    
-    if (command == "--help" || command == "-h") {
-        printUsage(argv[0]);
-        return 0;
-    }
-    else if (command == "--list" || command == "-l") {
-        bool detailed = false;
-        if (argc > 2 && std::string(argv[2]) == "--detailed") {
-            detailed = true;
-        }
-        listProcesses(detailed);
-    }
-    else if (command == "--tree" || command == "-t") {
-        showProcessTree();
-    }
-    else if (command == "--search" || command == "-s") {
-        if (argc < 3) {
-            std::cerr << "Error: --search requires a search query\n";
-            return 1;
-        }
-        searchProcesses(argv[2]);
-    }
-    else if (command == "--kill" || command == "-k") {
-        if (argc < 3) {
-            std::cerr << "Error: --kill requires a PID\n";
-            return 1;
-        }
-        int pid = std::atoi(argv[2]);
-        int signal = 15; // SIGTERM by default
-        if (argc > 3) {
-            signal = std::atoi(argv[3]);
-        }
-        killProcess(pid, signal);
-    }
-    else if (command == "--top") {
-        int count = 10;
-        if (argc > 2) {
-            count = std::atoi(argv[2]);
-        }
-        showTopProcesses(count);
-    }
-    else if (command == "--interactive" || command == "-i") {
-        interactiveMode();
-    }
-    else {
-        std::cerr << "Unknown command: " << command << "\n";
-        printUsage(argv[0]);
-        return 1;
-    }
-    
-    return 0;
-}
-
-void printUsage(const char* programName) {
-    std::cout << "Linux Process Manager (LPM)\n\n";
-    std::cout << "Usage:\n";
-    std::cout << "  " << programName << "                         Run interactive TUI mode\n";
-    std::cout << "  " << programName << " --list [-l]            List all processes\n";
-    std::cout << "  " << programName << " --list --detailed      List with detailed info\n";
-    std::cout << "  " << programName << " --tree [-t]            Show process tree\n";
-    std::cout << "  " << programName << " --search [-s] QUERY    Search for processes\n";
-    std::cout << "  " << programName << " --kill [-k] PID [SIG]  Kill process (default: SIGTERM)\n";
-    std::cout << "  " << programName << " --top [N]              Show top N processes by CPU\n";
-    std::cout << "  " << programName << " --interactive [-i]     Run interactive mode\n";
-    std::cout << "  " << programName << " --help [-h]            Show this help\n\n";
-    std::cout << "Examples:\n";
-    std::cout << "  " << programName << " --list\n";
-    std::cout << "  " << programName << " --search firefox\n";
-    std::cout << "  " << programName << " --kill 1234\n";
-    std::cout << "  " << programName << " --top 20\n";
-}
-
-void listProcesses(bool detailed) {
-    ProcessManager manager;
-    std::vector<Process> processes = manager.getAllProcesses();
-    
-    ProcessSorter::sort(processes, ProcessSorter::BY_PID, true);
-    
-    std::cout << "Total processes: " << processes.size() << "\n\n";
-    
-    if (detailed) {
-        std::cout << std::left 
-                  << std::setw(8) << "PID"
-                  << std::setw(8) << "PPID"
-                  << std::setw(20) << "NAME"
-                  << std::setw(12) << "USER"
-                  << std::setw(8) << "STATE"
-                  << std::setw(12) << "MEMORY(MB)"
-                  << std::setw(8) << "THREADS"
-                  << "\n";
-        std::cout << std::string(80, '-') << "\n";
-        
-        for (const auto& proc : processes) {
-            std::cout << std::left
-                      << std::setw(8) << proc.pid
-                      << std::setw(8) << proc.ppid
-                      << std::setw(20) << proc.name.substr(0, 19)
-                      << std::setw(12) << proc.user.substr(0, 11)
-                      << std::setw(8) << proc.state
-                      << std::setw(12) << (proc.vmRSS / 1024)
-                      << std::setw(8) << proc.numThreads
-                      << "\n";
-        }
-    } else {
-        std::cout << std::left
-                  << std::setw(8) << "PID"
-                  << std::setw(24) << "NAME"
-                  << std::setw(12) << "MEMORY(kB)"
-                  << "\n";
-        std::cout << std::string(44, '-') << "\n";
-        
-        for (const auto& proc : processes) {
-            std::cout << std::left
-                      << std::setw(8) << proc.pid
-                      << std::setw(24) << proc.name.substr(0, 23)
-                      << std::setw(12) << proc.vmRSS
-                      << "\n";
-        }
-    }
-}
-
-void showProcessTree() {
-    ProcessManager manager;
-    std::vector<Process> processes = manager.getAllProcesses();
-    
-    std::cout << "Process Tree (Total: " << processes.size() << " processes)\n\n";
-    
-    ProcessTree tree;
-    tree.buildTree(processes);
-    tree.printTree(true);
-}
-
-void searchProcesses(const std::string& query) {
-    ProcessManager manager;
-    std::vector<Process> processes = manager.getAllProcesses();
-    std::vector<Process> results = ProcessFilter::search(processes, query);
-    
-    std::cout << "Search results for: \"" << query << "\"\n";
-    std::cout << "Found " << results.size() << " matching processes\n\n";
-    
-    std::cout << std::left
-              << std::setw(8) << "PID"
-              << std::setw(24) << "NAME"
-              << std::setw(12) << "USER"
-              << std::setw(12) << "MEMORY(MB)"
-              << "\n";
-    std::cout << std::string(56, '-') << "\n";
-    
-    for (const auto& proc : results) {
-        std::cout << std::left
-                  << std::setw(8) << proc.pid
-                  << std::setw(24) << proc.name.substr(0, 23)
-                  << std::setw(12) << proc.user.substr(0, 11)
-                  << std::setw(12) << (proc.vmRSS / 1024)
-                  << "\n";
-    }
-}
-
-void killProcess(int pid, int signal) {
-    std::cout << "Attempting to send signal " << signal << " to process " << pid << "...\n";
-    
-    if (ProcessController::sendSignal(pid, signal)) {
-        std::cout << "Signal sent successfully.\n";
-    } else {
-        std::cerr << "Failed to send signal. Error: " << strerror(errno) << "\n";
-        std::cerr << "You may need root privileges.\n";
-    }
-}
-
-void showTopProcesses(int count) {
-    ProcessManager manager;
-    std::vector<Process> processes = manager.getAllProcesses();
-    
-    std::cout << "Top " << count << " processes by memory usage:\n\n";
-    
-    std::vector<Process> topProcs = ProcessSorter::topByMemory(processes, count);
-    
-    std::cout << std::left
-              << std::setw(8) << "PID"
-              << std::setw(24) << "NAME"
-              << std::setw(12) << "USER"
-              << std::setw(12) << "MEMORY(MB)"
-              << std::setw(8) << "THREADS"
-              << "\n";
-    std::cout << std::string(64, '-') << "\n";
-    
-    for (const auto& proc : topProcs) {
-        std::cout << std::left
-                  << std::setw(8) << proc.pid
-                  << std::setw(24) << proc.name.substr(0, 23)
-                  << std::setw(12) << proc.user.substr(0, 11)
-                  << std::setw(12) << (proc.vmRSS / 1024)
-                  << std::setw(8) << proc.numThreads
-                  << "\n";
-    }
-}
-
-void interactiveMode() {
-    ProcessTUI tui;
-    
-    if (!tui.init()) {
-        std::cerr << "Failed to initialize TUI\n";
-        return;
-    }
-    
-    tui.run();
-}
+#include "process.hpp"
+#include "process_control.hpp"
+#include "process_tree.hpp"
+#include "process_filter.hpp"
+#include "process_tui.hpp"
+#include "process_output.hpp"
+#include "process_record.hpp"
+#include "process_source.hpp"
+#include "process_profile.hpp"
+#include "process_cgroup.hpp"
+#include "process_events.hpp"
+#include "process_shared.hpp"
+#include "process_metrics.hpp"
+#include "process_rules.hpp"
+#include "process_leaks.hpp"
+#include "process_watch.hpp"
+#include "process_group.hpp"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <climits>
+#include <cctype>
+#include <set>
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+#include <csignal>
+#include <ctime>
+#include <unistd.h>
+
+// Function prototypes
+void printUsage(const char* programName);
+void listProcesses(bool detailed, ProcessWriter::Format format);
+void showProcessTree();
+void searchProcesses(const std::string& query, ProcessWriter::Format format);
+void killProcess(int pid, int signal);
+int killMatching(const std::string& expression, const SignalOptions& options,
+                 bool subtree, bool dryRun);
+int controlMatching(const std::string& expression, const ControlAction& action,
+                    bool subtree, bool dryRun);
+bool selectMatching(ProcessManager& manager, const std::string& expression, bool subtree,
+                    std::vector<Process>& processes, std::vector<const Process*>& selected);
+void showTopProcesses(int count, ProcessWriter::Format format);
+void showTopByPSS(int count);
+void showTopByIO(int count, int64_t intervalNs, ProcessWriter::Format format);
+void showTopByWait(int count, int64_t intervalNs, ProcessWriter::Format format);
+int showThreads(const std::string& pids, int64_t intervalNs, ProcessWriter::Format format);
+int watchProcesses(const std::string& pids, long hz, bool threads, int64_t durationNs,
+                   bool summary);
+void showCgroups(bool showProcesses, int64_t intervalNs);
+int showGroups(ProcessGrouper::Key key, ProcessGrouper::Column column, int count,
+               int64_t intervalNs, ProcessWriter::Format format);
+int recordProcesses(const std::string& path, int64_t intervalNs, int64_t keyframeNs);
+int publishSnapshots(const std::string& name, int64_t intervalNs, bool io);
+int serveMetrics(const std::string& address, int64_t intervalNs, size_t topK);
+int runRules(const std::string& path, int64_t intervalNs, bool dryRun);
+int findLeaks(const std::string& path, int64_t intervalNs, int64_t durationNs, int count);
+int watchEvents(int64_t intervalNs, int64_t durationNs);
+int generateProcTree(const std::string& dir, size_t count);
+bool requireLiveSource();
+void printStats();
+int replayRecording(const std::string& path, const std::string& at,
+                    ProcessWriter::Format format);
+void interactiveMode(SnapshotReader* replay = nullptr);
+
+int main(int argc, char* argv[]) {
+    // Global options may appear anywhere; strip them before dispatch
+    ProcessWriter::Format format = ProcessWriter::FORMAT_TABLE;
+    std::vector<char*> args;
+    for (int i = 0; i < argc; i++) {
+        if (std::strcmp(argv[i], "--format") == 0) {
+            if (i + 1 >= argc || !ProcessWriter::parseFormat(argv[i + 1], format)) {
+                std::cerr << "Error: --format requires table, json, csv or binary\n";
+                return 1;
+            }
+            i++;
+        } else if (std::strcmp(argv[i], "--stats") == 0) {
+            // Printed on every exit path, after the TUI has closed
+            std::atexit(printStats);
+        } else if (std::strcmp(argv[i], "--proc-root") == 0) {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --proc-root requires a directory\n";
+                return 1;
+            }
+            ProcessManager::setDefaultSource(std::make_shared<DirectorySource>(argv[++i]));
+        } else if (std::strcmp(argv[i], "--proc-events") == 0) {
+            auto source = std::make_shared<ProcessEventSource>();
+            std::string error;
+            if (!source->start(error)) {
+                std::cerr << "Process events unavailable (" << error << "), polling /proc\n";
+            }
+            ProcessManager::setDefaultSource(source);
+        } else if (std::strcmp(argv[i], "--attach") == 0) {
+            // Shared-memory names start with '/', so the name is optional
+            std::string name = SHARED_DEFAULT_NAME;
+            if (i + 1 < argc && argv[i + 1][0] == '/') {
+                name = argv[++i];
+            }
+            auto source = std::make_shared<SharedSnapshotSource>();
+            std::string error;
+            if (!source->open(name, error)) {
+                std::cerr << "Error: " << error << "\n";
+                return 1;
+            }
+            ProcessManager::setDefaultSource(source);
+        } else if (std::strcmp(argv[i], "--synthetic") == 0) {
+            long count = i + 1 < argc ? std::atol(argv[i + 1]) : 0;
+            if (count <= 0) {
+                std::cerr << "Error: --synthetic requires a process count\n";
+                return 1;
+            }
+            auto source = std::make_shared<SyntheticSource>(count);
+            source->setRealTime(true);
+            ProcessManager::setDefaultSource(source);
+            i++;
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+    args.push_back(nullptr);
+    argc = (int)args.size() - 1;
+    argv = args.data();
+    
+    // Parse command line arguments
+    if (argc == 1) {
+        // No arguments - run interactive TUI
+        interactiveMode();
+        return 0;
+    }
+    
+    std::string command = argv[1];
+    
+    if (command == "--help" || command == "-h") {
+        printUsage(argv[0]);
+        return 0;
+    }
+    else if (command == "--list" || command == "-l") {
+        bool detailed = false;
+        if (argc > 2 && std::string(argv[2]) == "--detailed") {
+            detailed = true;
+        }
+        listProcesses(detailed, format);
+    }
+    else if (command == "--tree" || command == "-t") {
+        showProcessTree();
+    }
+    else if (command == "--search" || command == "-s") {
+        if (argc < 3) {
+            std::cerr << "Error: --search requires a search query\n";
+            return 1;
+        }
+        searchProcesses(argv[2], format);
+    }
+    else if (command == "--kill" || command == "-k") {
+        if (argc < 3) {
+            std::cerr << "Error: --kill requires a PID\n";
+            return 1;
+        }
+        if (!requireLiveSource()) {
+            return 1;
+        }
+        int pid = std::atoi(argv[2]);
+        int signal = 15; // SIGTERM by default
+        if (argc > 3 && !ProcessController::parseSignal(argv[3], signal)) {
+            std::cerr << "Error: invalid signal: " << argv[3] << "\n";
+            return 1;
+        }
+        killProcess(pid, signal);
+    }
+    else if (command == "--kill-matching") {
+        if (argc < 3) {
+            std::cerr << "Error: --kill-matching requires an expression\n";
+            return 1;
+        }
+        SignalOptions options;
+        bool subtree = false;
+        bool dryRun = false;
+        for (int i = 3; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--subtree") {
+                subtree = true;
+            } else if (arg == "--dry-run") {
+                dryRun = true;
+            } else if (arg == "--timeout" && i + 1 < argc) {
+                // Wait for exit, then escalate survivors to SIGKILL
+                options.timeoutMs = (int)(std::atof(argv[++i]) * 1000);
+                options.escalate = true;
+            } else if (arg.compare(0, 2, "--") == 0 ||
+                       !ProcessController::parseSignal(arg, options.signal)) {
+                // Neither an option nor a signal ("TERM", "SIGKILL" or "9")
+                std::cerr << "Unknown option for --kill-matching: " << arg << "\n";
+                return 1;
+            }
+        }
+        if (!dryRun && !requireLiveSource()) {
+            return 1;
+        }
+        return killMatching(argv[2], options, subtree, dryRun);
+    }
+    else if (command == "--control-matching") {
+        if (argc < 3) {
+            std::cerr << "Error: --control-matching requires an expression\n";
+            return 1;
+        }
+        ControlAction action;
+        bool subtree = false;
+        bool dryRun = false;
+        for (int i = 3; i < argc; i++) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--subtree") {
+                subtree = true;
+            } else if (arg == "--dry-run") {
+                dryRun = true;
+            } else if (arg == "--nice" && hasValue) {
+                action.setNice = true;
+                char* end = nullptr;
+                long nice = std::strtol(argv[++i], &end, 10);
+                if (end == argv[i] || *end != '\0' || nice < -20 || nice > 19) {
+                    std::cerr << "Error: nice value must be between -20 and 19\n";
+                    return 1;
+                }
+                action.nice = (int)nice;
+            } else if (arg == "--affinity" && hasValue) {
+                action.setAffinity = true;
+                if (!ProcessController::parseCPUList(argv[++i], action.cpus)) {
+                    std::cerr << "Error: invalid CPU list: " << argv[i] << "\n";
+                    return 1;
+                }
+            } else if (arg == "--policy" && hasValue) {
+                action.setPolicy = true;
+                if (!ProcessController::parsePolicy(argv[++i], action.policy, action.rtPriority)) {
+                    std::cerr << "Error: invalid policy: " << argv[i] << "\n";
+                    return 1;
+                }
+            } else if (arg == "--ioprio" && hasValue) {
+                action.setIOPriority = true;
+                if (!ProcessController::parseIOPriority(argv[++i], action.ioClass, action.ioLevel)) {
+                    std::cerr << "Error: invalid I/O priority: " << argv[i] << "\n";
+                    return 1;
+                }
+            } else {
+                std::cerr << "Unknown option for --control-matching: " << arg << "\n";
+                return 1;
+            }
+        }
+        if (!action.setNice && !action.setAffinity && !action.setPolicy && !action.setIOPriority) {
+            std::cerr << "Error: --control-matching needs --nice, --affinity, --policy or --ioprio\n";
+            return 1;
+        }
+        if (!dryRun && !requireLiveSource()) {
+            return 1;
+        }
+        return controlMatching(argv[2], action, subtree, dryRun);
+    }
+    else if (command == "--top") {
+        int count = 10;
+        bool pss = false;
+        bool io = false;
+        bool sched = false;
+        int64_t intervalNs = 1000000000LL;
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--pss") {
+                pss = true;
+            } else if (arg == "--io") {
+                io = true;
+            } else if (arg == "--sched") {
+                sched = true;
+            } else if (arg == "--interval" && i + 1 < argc) {
+                if (!SnapshotRecorder::parseDuration(argv[++i], intervalNs) || intervalNs <= 0) {
+                    std::cerr << "Error: invalid interval: " << argv[i] << "\n";
+                    return 1;
+                }
+            } else {
+                char* end = nullptr;
+                long value = std::strtol(argv[i], &end, 10);
+                if (end == argv[i] || *end != '\0') {
+                    std::cerr << "Unknown option for --top: " << arg << "\n";
+                    return 1;
+                }
+                if (value <= 0 || value > INT_MAX) {
+                    std::cerr << "Error: invalid count: " << arg << "\n";
+                    return 1;
+                }
+                count = (int)value;
+            }
+        }
+        if (pss) {
+            showTopByPSS(count);
+        } else if (io) {
+            showTopByIO(count, intervalNs, format);
+        } else if (sched) {
+            showTopByWait(count, intervalNs, format);
+        } else {
+            showTopProcesses(count, format);
+        }
+    }
+    else if (command == "--threads") {
+        if (argc < 3) {
+            std::cerr << "Error: --threads requires a PID\n";
+            return 1;
+        }
+        int64_t intervalNs = 500000000LL;
+        for (int i = 3; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--interval" && i + 1 < argc) {
+                if (!SnapshotRecorder::parseDuration(argv[++i], intervalNs) || intervalNs <= 0) {
+                    std::cerr << "Error: invalid interval: " << argv[i] << "\n";
+                    return 1;
+                }
+            } else {
+                std::cerr << "Unknown option for --threads: " << arg << "\n";
+                return 1;
+            }
+        }
+        return showThreads(argv[2], intervalNs, format);
+    }
+    else if (command == "--watch") {
+        if (argc < 3) {
+            std::cerr << "Error: --watch requires a PID\n";
+            return 1;
+        }
+        long hz = 100;
+        bool threads = false;
+        bool summary = false;
+        int64_t durationNs = 0;
+        for (int i = 3; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--hz" && i + 1 < argc) {
+                hz = std::atol(argv[++i]);
+                if (hz <= 0 || hz > 10000) {
+                    std::cerr << "Error: --hz must be between 1 and 10000\n";
+                    return 1;
+                }
+            } else if (arg == "--duration" && i + 1 < argc) {
+                if (!SnapshotRecorder::parseDuration(argv[++i], durationNs) || durationNs <= 0) {
+                    std::cerr << "Error: invalid duration: " << argv[i] << "\n";
+                    return 1;
+                }
+            } else if (arg == "--threads") {
+                threads = true;
+            } else if (arg == "--summary") {
+                summary = true;
+            } else {
+                std::cerr << "Unknown option for --watch: " << arg << "\n";
+                return 1;
+            }
+        }
+        if (!requireLiveSource()) {
+            return 1;
+        }
+        return watchProcesses(argv[2], hz, threads, durationNs, summary);
+    }
+    else if (command == "--cgroups") {
+        bool showProcesses = false;
+        int64_t intervalNs = 500000000LL;
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--processes") {
+                showProcesses = true;
+            } else if (arg == "--interval" && i + 1 < argc) {
+                if (!SnapshotRecorder::parseDuration(argv[++i], intervalNs) || intervalNs <= 0) {
+                    std::cerr << "Error: invalid interval: " << argv[i] << "\n";
+                    return 1;
+                }
+            } else {
+                std::cerr << "Unknown option for --cgroups: " << arg << "\n";
+                return 1;
+            }
+        }
+        showCgroups(showProcesses, intervalNs);
+    }
+    else if (command == "--group-by") {
+        ProcessGrouper::Key key;
+        if (argc < 3 || !ProcessGrouper::parseKey(argv[2], key)) {
+            std::cerr << "Error: --group-by requires user, name or state\n";
+            return 1;
+        }
+        ProcessGrouper::Column column = ProcessGrouper::SORT_RSS;
+        int count = 0;
+        int64_t intervalNs = 500000000LL;
+        for (int i = 3; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--sort" && i + 1 < argc) {
+                if (!ProcessGrouper::parseColumn(argv[++i], column)) {
+                    std::cerr << "Error: --sort requires key, count, threads, rss, max-rss or cpu\n";
+                    return 1;
+                }
+            } else if (arg == "--top" && i + 1 < argc) {
+                count = std::atoi(argv[++i]);
+                if (count <= 0) {
+                    std::cerr << "Error: invalid count: " << argv[i] << "\n";
+                    return 1;
+                }
+            } else if (arg == "--interval" && i + 1 < argc) {
+                if (!SnapshotRecorder::parseDuration(argv[++i], intervalNs) || intervalNs <= 0) {
+                    std::cerr << "Error: invalid interval: " << argv[i] << "\n";
+                    return 1;
+                }
+            } else {
+                std::cerr << "Unknown option for --group-by: " << arg << "\n";
+                return 1;
+            }
+        }
+        return showGroups(key, column, count, intervalNs, format);
+    }
+    else if (command == "--events") {
+        int64_t intervalNs = 1000000000LL;
+        int64_t durationNs = 0;
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            int64_t* target = arg == "--interval" ? &intervalNs :
+                              arg == "--duration" ? &durationNs : nullptr;
+            if (!target || i + 1 >= argc) {
+                std::cerr << "Unknown option for --events: " << arg << "\n";
+                return 1;
+            }
+            if (!SnapshotRecorder::parseDuration(argv[++i], *target) || *target <= 0) {
+                std::cerr << "Error: invalid duration: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        if (!requireLiveSource()) {
+            return 1;
+        }
+        return watchEvents(intervalNs, durationNs);
+    }
+    else if (command == "--record") {
+        if (argc < 3) {
+            std::cerr << "Error: --record requires a file name\n";
+            return 1;
+        }
+        int64_t intervalNs = 1000000000LL;
+        int64_t keyframeNs = 3600 * 1000000000LL;
+        for (int i = 3; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--interval" && i + 1 < argc) {
+                if (!SnapshotRecorder::parseDuration(argv[++i], intervalNs) || intervalNs <= 0) {
+                    std::cerr << "Error: invalid interval: " << argv[i] << "\n";
+                    return 1;
+                }
+            } else if (arg == "--keyframe-every" && i + 1 < argc) {
+                if (!SnapshotRecorder::parseDuration(argv[++i], keyframeNs) || keyframeNs <= 0) {
+                    std::cerr << "Error: invalid keyframe spacing: " << argv[i] << "\n";
+                    return 1;
+                }
+            } else {
+                std::cerr << "Unknown option for --record: " << arg << "\n";
+                return 1;
+            }
+        }
+        return recordProcesses(argv[2], intervalNs, keyframeNs);
+    }
+    else if (command == "--daemon") {
+        std::string name = SHARED_DEFAULT_NAME;
+        int64_t intervalNs = 1000000000LL;
+        bool io = false;
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg[0] == '/' && i == 2) {
+                name = arg;
+            } else if (arg == "--interval" && i + 1 < argc) {
+                if (!SnapshotRecorder::parseDuration(argv[++i], intervalNs) || intervalNs <= 0) {
+                    std::cerr << "Error: invalid interval: " << argv[i] << "\n";
+                    return 1;
+                }
+            } else if (arg == "--io") {
+                io = true;
+            } else {
+                std::cerr << "Unknown option for --daemon: " << arg << "\n";
+                return 1;
+            }
+        }
+        return publishSnapshots(name, intervalNs, io);
+    }
+    else if (command == "--serve") {
+        if (argc < 3) {
+            std::cerr << "Error: --serve requires unix:/path or HOST:PORT\n";
+            return 1;
+        }
+        int64_t intervalNs = 5000000000LL;
+        long topK = 20;
+        for (int i = 3; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--interval" && i + 1 < argc) {
+                if (!SnapshotRecorder::parseDuration(argv[++i], intervalNs) || intervalNs <= 0) {
+                    std::cerr << "Error: invalid interval: " << argv[i] << "\n";
+                    return 1;
+                }
+            } else if (arg == "--top" && i + 1 < argc) {
+                topK = std::atol(argv[++i]);
+                if (topK <= 0) {
+                    std::cerr << "Error: invalid count: " << argv[i] << "\n";
+                    return 1;
+                }
+            } else {
+                std::cerr << "Unknown option for --serve: " << arg << "\n";
+                return 1;
+            }
+        }
+        return serveMetrics(argv[2], intervalNs, topK);
+    }
+    else if (command == "--rules") {
+        if (argc < 3) {
+            std::cerr << "Error: --rules requires a file name\n";
+            return 1;
+        }
+        int64_t intervalNs = 1000000000LL;
+        bool dryRun = false;
+        for (int i = 3; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--interval" && i + 1 < argc) {
+                if (!SnapshotRecorder::parseDuration(argv[++i], intervalNs) || intervalNs <= 0) {
+                    std::cerr << "Error: invalid interval: " << argv[i] << "\n";
+                    return 1;
+                }
+            } else if (arg == "--dry-run") {
+                dryRun = true;
+            } else {
+                std::cerr << "Unknown option for --rules: " << arg << "\n";
+                return 1;
+            }
+        }
+        if (!dryRun && !requireLiveSource()) {
+            return 1;
+        }
+        return runRules(argv[2], intervalNs, dryRun);
+    }
+    else if (command == "--leaks") {
+        std::string path;
+        int start = 2;
+        if (argc > 2 && std::strncmp(argv[2], "--", 2) != 0) {
+            path = argv[2];
+            start = 3;
+        }
+        int64_t intervalNs = 5000000000LL;
+        int64_t durationNs = 600000000000LL;
+        int count = 20;
+        for (int i = start; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--top" && i + 1 < argc) {
+                count = std::atoi(argv[++i]);
+                if (count <= 0) {
+                    std::cerr << "Error: invalid count: " << argv[i] << "\n";
+                    return 1;
+                }
+                continue;
+            }
+            int64_t* target = arg == "--interval" ? &intervalNs :
+                              arg == "--duration" ? &durationNs : nullptr;
+            if (!target || i + 1 >= argc) {
+                std::cerr << "Unknown option for --leaks: " << arg << "\n";
+                return 1;
+            }
+            if (!SnapshotRecorder::parseDuration(argv[++i], *target) || *target <= 0) {
+                std::cerr << "Error: invalid duration: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        return findLeaks(path, intervalNs, durationNs, count);
+    }
+    else if (command == "--replay") {
+        if (argc < 3) {
+            std::cerr << "Error: --replay requires a file name\n";
+            return 1;
+        }
+        std::string at;
+        for (int i = 3; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--at" && i + 1 < argc) {
+                at = argv[++i];
+            } else {
+                std::cerr << "Unknown option for --replay: " << arg << "\n";
+                return 1;
+            }
+        }
+        return replayRecording(argv[2], at, format);
+    }
+    else if (command == "--generate-proc") {
+        if (argc < 3) {
+            std::cerr << "Error: --generate-proc requires a directory\n";
+            return 1;
+        }
+        long count = argc > 3 ? std::atol(argv[3]) : 10000;
+        if (count <= 0) {
+            std::cerr << "Error: invalid process count: " << argv[3] << "\n";
+            return 1;
+        }
+        return generateProcTree(argv[2], count);
+    }
+    else if (command == "--interactive" || command == "-i") {
+        interactiveMode();
+    }
+    else {
+        std::cerr << "Unknown command: " << command << "\n";
+        printUsage(argv[0]);
+        return 1;
+    }
+    
+    return 0;
+}
+
+void printUsage(const char* programName) {
+    std::cout << "Linux Process Manager (LPM)\n\n";
+    std::cout << "Usage:\n";
+    std::cout << "  " << programName << "                         Run interactive TUI mode\n";
+    std::cout << "  " << programName << " --list [-l]            List all processes\n";
+    std::cout << "  " << programName << " --list --detailed      List with detailed info\n";
+    std::cout << "  " << programName << " --tree [-t]            Show process tree\n";
+    std::cout << "  " << programName << " --search [-s] QUERY    Search for processes\n";
+    std::cout << "  " << programName << " --kill [-k] PID [SIG]  Kill process (default: SIGTERM)\n";
+    std::cout << "  " << programName << " --kill-matching EXPR [SIG] [--subtree] [--timeout SEC] [--dry-run]\n";
+    std::cout << "                                 Signal all processes matching EXPR\n";
+    std::cout << "  " << programName << " --control-matching EXPR [--nice N] [--affinity CPUS]\n";
+    std::cout << "        [--policy POLICY] [--ioprio CLASS[:LEVEL]] [--subtree] [--dry-run]\n";
+    std::cout << "                                 Reprioritize all threads of matching processes\n";
+    std::cout << "  " << programName << " --top [N]              Show top N processes by memory (RSS)\n";
+    std::cout << "  " << programName << " --top [N] --pss        Top N by PSS (shared pages split), with USS and swap\n";
+    std::cout << "  " << programName << " --top [N] --io [--interval DUR]\n";
+    std::cout << "                                 Top N by storage I/O rate over DUR (default 1s)\n";
+    std::cout << "  " << programName << " --top [N] --sched [--interval DUR]\n";
+    std::cout << "                                 Top N by run-queue wait over DUR, with context\n";
+    std::cout << "                                 switch rates\n";
+    std::cout << "  " << programName << " --threads PID[,PID] [--interval DUR]\n";
+    std::cout << "                                 Show threads with CPU% over DUR (default 500ms)\n";
+    std::cout << "  " << programName << " --watch PID[,PID] [--hz N] [--threads] [--duration DUR] [--summary]\n";
+    std::cout << "                                 Sample a few processes at N Hz (default 100) from\n";
+    std::cout << "                                 pinned files; stream samples or print percentiles\n";
+    std::cout << "  " << programName << " --cgroups [--processes] [--interval DUR]\n";
+    std::cout << "                                 Group processes by cgroup with cgroup v2 totals\n";
+    std::cout << "  " << programName << " --group-by user|name|state [--sort COL] [--top N] [--interval DUR]\n";
+    std::cout << "                                 Count, threads, sum/max RSS and CPU% per group;\n";
+    std::cout << "                                 COL: key, count, threads, rss (default), max-rss, cpu\n";
+    std::cout << "  " << programName << " --events [--interval DUR] [--duration DUR]\n";
+    std::cout << "                                 Report spawn/exit rates and short-lived processes\n";
+    std::cout << "  " << programName << " --record FILE [--interval DUR] [--keyframe-every DUR]\n";
+    std::cout << "                                 Record snapshots until interrupted (default 1s)\n";
+    std::cout << "  " << programName << " --daemon [/NAME] [--interval DUR] [--io]\n";
+    std::cout << "                                 Publish snapshots to shared memory (default\n";
+    std::cout << "                                 /lpm, every 1s) for clients run with --attach\n";
+    std::cout << "  " << programName << " --serve unix:/PATH|HOST:PORT [--interval DUR] [--top K]\n";
+    std::cout << "                                 Serve OpenMetrics at /metrics, collected every DUR\n";
+    std::cout << "                                 (default 5s), top K series plus \"other\" (default 20)\n";
+    std::cout << "  " << programName << " --rules FILE [--interval DUR] [--dry-run]\n";
+    std::cout << "                                 Act on rules such as 'rss > 8G for 30s -> SIGTERM,\n";
+    std::cout << "                                 then SIGKILL after 10s', checked every DUR (default 1s)\n";
+    std::cout << "  " << programName << " --leaks [FILE] [--interval DUR] [--duration DUR] [--top N]\n";
+    std::cout << "                                 Find processes whose RSS grows steadily, sampled\n";
+    std::cout << "                                 every 5s for 10m (default) or from a recording\n";
+    std::cout << "  " << programName << " --replay FILE [--at TIME]\n";
+    std::cout << "                                 Browse a recording in the TUI (or print\n";
+    std::cout << "                                 the snapshot at TIME with --format)\n";
+    std::cout << "  " << programName << " --generate-proc DIR [N]  Write a synthetic /proc tree of N processes\n";
+    std::cout << "  " << programName << " --interactive [-i]     Run interactive mode\n";
+    std::cout << "  " << programName << " --help [-h]            Show this help\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  --format table|json|csv|binary   Output format for --list, --search, --top,\n";
+    std::cout << "                                   --threads, --replay\n";
+    std::cout << "  --proc-root DIR                  Read processes from a captured /proc tree\n";
+    std::cout << "  --synthetic N                    Read N generated processes instead of /proc\n";
+    std::cout << "  --proc-events                    Track processes with netlink proc events\n";
+    std::cout << "                                   instead of rescanning /proc (needs root)\n";
+    std::cout << "  --attach [/NAME]                 Read the snapshots of a running --daemon\n";
+    std::cout << "                                   instead of scanning /proc\n";
+    std::cout << "  --stats                          Print LPM's own timings and counters on exit\n\n";
+    std::cout << "Examples:\n";
+    std::cout << "  " << programName << " --list\n";
+    std::cout << "  " << programName << " --search firefox\n";
+    std::cout << "  " << programName << " --kill 1234\n";
+    std::cout << "  " << programName << " --top 20\n";
+    std::cout << "  " << programName << " --kill-matching 'name ~ cc1plus && rss > 1G' --timeout 5\n";
+    std::cout << "  " << programName << " --record trace.lpm --interval 500ms\n";
+    std::cout << "  " << programName << " --replay trace.lpm --at 03:12\n\n";
+    std::cout << "Expressions: FIELD OP VALUE joined with &&\n";
+    std::cout << "  fields: pid ppid name user state rss vsz cpu threads\n";
+    std::cout << "  ops:    == != < <= > >= ~ (substring) !~\n";
+    std::cout << "Policies: other batch idle fifo:PRIO rr:PRIO; I/O classes: rt:N be:N idle\n";
+}
+
+// Stream processes (matching 'filter') in a machine-readable format as
+// they are collected
+void writeProcesses(ProcessWriter::Format format, const FilterExpression* filter) {
+    ProcessManager manager;
+    OutputBuffer out(STDOUT_FILENO);
+    ProcessWriter writer(format, out);
+    manager.setFields(writer.requiredFields());
+    
+    writer.begin();
+    manager.forEachProcess([&](const Process& proc) {
+        writer.write(proc);
+    }, filter);
+    writer.end();
+}
+
+void listProcesses(bool detailed, ProcessWriter::Format format) {
+    if (format != ProcessWriter::FORMAT_TABLE) {
+        // /proc is enumerated in ascending PID order already
+        writeProcesses(format, nullptr);
+        return;
+    }
+    
+    // Only the detailed table shows users
+    ProcessManager manager;
+    manager.setFields(detailed ? ProcessFields::USER : ProcessFields::NONE);
+    std::vector<Process> processes = manager.getAllProcesses();
+    
+    ProcessSorter::sort(processes, ProcessSorter::BY_PID, true);
+    
+    std::cout << "Total processes: " << processes.size() << "\n\n";
+    
+    if (detailed) {
+        std::cout << std::left 
+                  << std::setw(8) << "PID"
+                  << std::setw(8) << "PPID"
+                  << std::setw(20) << "NAME"
+                  << std::setw(12) << "USER"
+                  << std::setw(8) << "STATE"
+                  << std::setw(12) << "MEMORY(MB)"
+                  << std::setw(8) << "THREADS"
+                  << "\n";
+        std::cout << std::string(80, '-') << "\n";
+        
+        for (const auto& proc : processes) {
+            std::cout << std::left
+                      << std::setw(8) << proc.pid
+                      << std::setw(8) << proc.ppid
+                      << std::setw(20) << proc.name.substr(0, 19)
+                      << std::setw(12) << proc.user.substr(0, 11)
+                      << std::setw(8) << proc.state
+                      << std::setw(12) << (proc.vmRSS / 1024)
+                      << std::setw(8) << proc.numThreads
+                      << "\n";
+        }
+    } else {
+        std::cout << std::left
+                  << std::setw(8) << "PID"
+                  << std::setw(24) << "NAME"
+                  << std::setw(12) << "MEMORY(kB)"
+                  << "\n";
+        std::cout << std::string(44, '-') << "\n";
+        
+        for (const auto& proc : processes) {
+            std::cout << std::left
+                      << std::setw(8) << proc.pid
+                      << std::setw(24) << proc.name.substr(0, 23)
+                      << std::setw(12) << proc.vmRSS
+                      << "\n";
+        }
+    }
+}
+
+void showProcessTree() {
+    ProcessManager manager;
+    manager.setFields(ProcessFields::NONE);
+    std::vector<Process> processes = manager.getAllProcesses();
+    
+    std::cout << "Process Tree (Total: " << processes.size() << " processes)\n\n";
+    
+    ProcessTree tree;
+    tree.buildTree(processes);
+    tree.printTree(true);
+}
+
+// Matching happens during the scan: a process whose name does not match
+// has its status file read only if some user name could match the query
+void searchProcesses(const std::string& query, ProcessWriter::Format format) {
+    FilterExpression filter;
+    filter.addSearch(query);
+    
+    if (format != ProcessWriter::FORMAT_TABLE) {
+        writeProcesses(format, &filter);
+        return;
+    }
+    
+    ProcessManager manager;
+    std::vector<Process> results = manager.getAllProcesses(&filter);
+    
+    std::cout << "Search results for: \"" << query << "\"\n";
+    std::cout << "Found " << results.size() << " matching processes\n\n";
+    
+    std::cout << std::left
+              << std::setw(8) << "PID"
+              << std::setw(24) << "NAME"
+              << std::setw(12) << "USER"
+              << std::setw(12) << "MEMORY(MB)"
+              << "\n";
+    std::cout << std::string(56, '-') << "\n";
+    
+    for (const auto& proc : results) {
+        std::cout << std::left
+                  << std::setw(8) << proc.pid
+                  << std::setw(24) << proc.name.substr(0, 23)
+                  << std::setw(12) << proc.user.substr(0, 11)
+                  << std::setw(12) << (proc.vmRSS / 1024)
+                  << "\n";
+    }
+}
+
+void killProcess(int pid, int signal) {
+    std::cout << "Attempting to send signal " << signal << " to process " << pid << "...\n";
+    
+    if (ProcessController::sendSignal(pid, signal)) {
+        std::cout << "Signal sent successfully.\n";
+    } else {
+        std::cerr << "Failed to send signal. Error: " << strerror(errno) << "\n";
+        std::cerr << "You may need root privileges.\n";
+    }
+}
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void requestStop(int) {
+    stopRequested = 1;
+}
+
+// End the loops of long-running commands on Ctrl-C or SIGTERM, so they
+// can finish their output and clean up
+static void stopOnSignals() {
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = requestStop;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+}
+
+// Sleep for a relative interval, such as between the two scans of a rate
+// measurement
+static void sleepFor(int64_t nanoseconds) {
+    struct timespec delay;
+    delay.tv_sec = nanoseconds / 1000000000LL;
+    delay.tv_nsec = nanoseconds % 1000000000LL;
+    nanosleep(&delay, nullptr);
+}
+
+static void addNanoseconds(struct timespec& time, int64_t nanoseconds) {
+    int64_t next = time.tv_nsec + nanoseconds;
+    time.tv_sec += next / 1000000000LL;
+    time.tv_nsec = next % 1000000000LL;
+}
+
+static int64_t toNanoseconds(const struct timespec& time) {
+    return (int64_t)time.tv_sec * 1000000000LL + time.tv_nsec;
+}
+
+// Sleep until an absolute CLOCK_MONOTONIC deadline or a stop request
+static void sleepUntil(const struct timespec& deadline) {
+    while (!stopRequested &&
+           clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {
+    }
+}
+
+// Call 'work' now and then on absolute deadlines 'intervalNs' apart, so
+// the period does not drift with the time 'work' takes, until it returns
+// false or a stop is requested. 'work' gets the CLOCK_MONOTONIC time it
+// was due. Until each deadline, 'idle' is called with the milliseconds
+// left, for as long as it keeps returning early.
+template <typename Work, typename Idle>
+static void runEvery(int64_t intervalNs, Work work, Idle idle) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    while (!stopRequested && work(toNanoseconds(deadline))) {
+        addNanoseconds(deadline, intervalNs);
+        while (!stopRequested) {
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            int64_t remainingMs = (toNanoseconds(deadline) - toNanoseconds(now)) / 1000000LL;
+            if (remainingMs <= 0) {
+                break;
+            }
+            idle((int)remainingMs);
+        }
+    }
+}
+
+// As above, sleeping until each deadline
+template <typename Work>
+static void runEvery(int64_t intervalNs, Work work) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    while (!stopRequested && work(toNanoseconds(deadline))) {
+        addNanoseconds(deadline, intervalNs);
+        sleepUntil(deadline);
+    }
+}
+
+// Scan and select the processes matching an expression, optionally with
+// their subtrees. CPU usage needs two scans, so an expression testing it
+// is evaluated over the second of two taken a second apart.
+bool selectMatching(ProcessManager& manager, const std::string& expression, bool subtree,
+                    std::vector<Process>& processes, std::vector<const Process*>& selected) {
+    FilterExpression filter;
+    std::string error;
+    if (!filter.parse(expression, error)) {
+        std::cerr << "Invalid expression: " << error << "\n";
+        return false;
+    }
+    
+    for (const auto& cond : filter.getConditions()) {
+        if (cond.field == FilterExpression::FIELD_CPU) {
+            manager.getAllProcesses();
+            sleepFor(1000000000LL);
+            break;
+        }
+    }
+    processes = manager.getAllProcesses();
+    
+    std::vector<Process> matches = filter.apply(processes);
+    
+    // Optionally include all descendants of every match
+    std::set<int> pids;
+    for (const auto& proc : matches) {
+        pids.insert(proc.pid);
+    }
+    if (subtree) {
+        ProcessTree tree;
+        tree.buildTree(processes);
+        for (const auto& proc : matches) {
+            for (int child : tree.getDescendants(proc.pid)) {
+                pids.insert(child);
+            }
+        }
+    }
+    
+    // Never act on ourselves
+    pids.erase(getpid());
+    
+    selected.clear();
+    for (const auto& proc : processes) {
+        if (pids.count(proc.pid)) {
+            selected.push_back(&proc);
+        }
+    }
+    return true;
+}
+
+int killMatching(const std::string& expression, const SignalOptions& options,
+                 bool subtree, bool dryRun) {
+    ProcessManager manager;
+    std::vector<Process> processes;
+    std::vector<const Process*> targetProcs;
+    if (!selectMatching(manager, expression, subtree, processes, targetProcs)) {
+        return 1;
+    }
+    
+    std::vector<ProcessKey> targets;
+    for (const Process* proc : targetProcs) {
+        targets.push_back(proc->key());
+    }
+    
+    std::cout << (dryRun ? "Would send " : "Sending ")
+              << ProcessController::getSignalName(options.signal)
+              << " to " << targets.size() << " processes\n\n";
+    
+    std::vector<SignalResult> results;
+    if (!dryRun) {
+        results = ProcessController::sendSignalBatch(targets, options);
+    }
+    
+    std::cout << std::left
+              << std::setw(8) << "PID"
+              << std::setw(24) << "NAME"
+              << std::setw(12) << "USER"
+              << "RESULT"
+              << "\n";
+    std::cout << std::string(60, '-') << "\n";
+    
+    int failed = 0;
+    for (size_t i = 0; i < targets.size(); i++) {
+        std::string status = "-";
+        if (!dryRun) {
+            status = ProcessController::getStatusName(results[i].status);
+            if (results[i].status == SignalResult::FAILED) {
+                status += std::string(" (") + strerror(results[i].error) + ")";
+                failed++;
+            }
+        }
+        std::cout << std::left
+                  << std::setw(8) << targetProcs[i]->pid
+                  << std::setw(24) << targetProcs[i]->name.substr(0, 23)
+                  << std::setw(12) << targetProcs[i]->user.substr(0, 11)
+                  << status
+                  << "\n";
+    }
+    return failed > 0 ? 1 : 0;
+}
+
+int controlMatching(const std::string& expression, const ControlAction& action,
+                    bool subtree, bool dryRun) {
+    ProcessManager manager;
+    std::vector<Process> processes;
+    std::vector<const Process*> targetProcs;
+    if (!selectMatching(manager, expression, subtree, processes, targetProcs)) {
+        return 1;
+    }
+    
+    std::vector<ProcessKey> targets;
+    for (const Process* proc : targetProcs) {
+        targets.push_back(proc->key());
+    }
+    
+    std::cout << (dryRun ? "Would change " : "Changing ") << targets.size() << " processes\n\n";
+    
+    std::vector<ControlResult> results;
+    if (!dryRun) {
+        results = ProcessController::applyBatch(targets, action);
+    }
+    
+    std::cout << std::left
+              << std::setw(8) << "PID"
+              << std::setw(24) << "NAME"
+              << std::setw(12) << "USER"
+              << std::setw(10) << "THREADS"
+              << "RESULT"
+              << "\n";
+    std::cout << std::string(70, '-') << "\n";
+    
+    int failed = 0;
+    for (size_t i = 0; i < targets.size(); i++) {
+        std::string status = "-";
+        std::string threads = std::to_string(targetProcs[i]->numThreads);
+        if (!dryRun) {
+            const ControlResult& result = results[i];
+            threads = std::to_string(result.threads);
+            if (result.gone) {
+                status = "gone";
+            } else if (result.raced) {
+                status = "exited during change (PID may have been reused)";
+            } else if (result.failures == 0) {
+                status = "ok";
+            } else {
+                status = "failed on " + std::to_string(result.failures) + " threads (" +
+                         strerror(result.error) + ")";
+                failed++;
+            }
+        }
+        std::cout << std::left
+                  << std::setw(8) << targetProcs[i]->pid
+                  << std::setw(24) << targetProcs[i]->name.substr(0, 23)
+                  << std::setw(12) << targetProcs[i]->user.substr(0, 11)
+                  << std::setw(10) << threads
+                  << status
+                  << "\n";
+    }
+    return failed > 0 ? 1 : 0;
+}
+
+// Ranking by memory needs only the stat files; users are read for the
+// top N alone
+void showTopProcesses(int count, ProcessWriter::Format format) {
+    ProcessManager manager;
+    manager.setFields(ProcessFields::NONE);
+    
+    if (format != ProcessWriter::FORMAT_TABLE) {
+        // Keep only the N largest in a min-heap while streaming
+        size_t limit = count > 0 ? count : 0;
+        std::vector<Process> heap;
+        heap.reserve(limit + 1);
+        auto largerRSS = [](const Process& a, const Process& b) { return a.vmRSS > b.vmRSS; };
+        
+        manager.forEachProcess([&](const Process& proc) {
+            if (heap.size() < limit) {
+                heap.push_back(proc);
+                std::push_heap(heap.begin(), heap.end(), largerRSS);
+            } else if (limit > 0 && proc.vmRSS > heap.front().vmRSS) {
+                std::pop_heap(heap.begin(), heap.end(), largerRSS);
+                heap.back() = proc;
+                std::push_heap(heap.begin(), heap.end(), largerRSS);
+            }
+        });
+        std::sort_heap(heap.begin(), heap.end(), largerRSS);
+        
+        OutputBuffer out(STDOUT_FILENO);
+        ProcessWriter writer(format, out);
+        writer.begin();
+        for (auto& proc : heap) {
+            manager.readFields(proc, writer.requiredFields());
+            writer.write(proc);
+        }
+        writer.end();
+        return;
+    }
+    
+    std::vector<Process> processes = manager.getAllProcesses();
+    
+    std::cout << "Top " << count << " processes by memory usage:\n\n";
+    
+    std::vector<Process> topProcs = ProcessSorter::topByMemory(processes, count);
+    for (auto& proc : topProcs) {
+        manager.readFields(proc, ProcessFields::USER);
+    }
+    
+    std::cout << std::left
+              << std::setw(8) << "PID"
+              << std::setw(24) << "NAME"
+              << std::setw(12) << "USER"
+              << std::setw(12) << "MEMORY(MB)"
+              << std::setw(8) << "THREADS"
+              << "\n";
+    std::cout << std::string(64, '-') << "\n";
+    
+    for (const auto& proc : topProcs) {
+        std::cout << std::left
+                  << std::setw(8) << proc.pid
+                  << std::setw(24) << proc.name.substr(0, 23)
+                  << std::setw(12) << proc.user.substr(0, 11)
+                  << std::setw(12) << (proc.vmRSS / 1024)
+                  << std::setw(8) << proc.numThreads
+                  << "\n";
+    }
+}
+
+// Show the threads of one or more processes. Threads are read twice,
+// 'intervalNs' apart, so CPU% covers that interval.
+int showThreads(const std::string& pids, int64_t intervalNs, ProcessWriter::Format format) {
+    ProcessManager manager;
+    std::vector<Process> owners;
+    
+    std::stringstream list(pids);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        int pid = std::atoi(item.c_str());
+        Process proc = manager.getProcess(pid);
+        if (pid <= 0 || proc.name.empty()) {
+            std::cerr << "Error: no such process: " << item << "\n";
+            return 1;
+        }
+        owners.push_back(proc);
+    }
+    
+    // First pass: baseline counters
+    std::vector<Process> threads;
+    for (const auto& owner : owners) {
+        if (!manager.getThreads(owner, threads)) {
+            std::cerr << "Error: no thread information for process " << owner.pid << "\n";
+            return 1;
+        }
+    }
+    
+    sleepFor(intervalNs);
+    
+    OutputBuffer out(STDOUT_FILENO);
+    ProcessWriter writer(format, out);
+    if (format != ProcessWriter::FORMAT_TABLE) {
+        writer.begin();
+    }
+    
+    for (const auto& owner : owners) {
+        if (!manager.getThreads(owner, threads)) {
+            std::cerr << "Process " << owner.pid << " exited\n";
+            continue;
+        }
+        ProcessSorter::sort(threads, ProcessSorter::BY_CPU, false);
+        
+        if (format != ProcessWriter::FORMAT_TABLE) {
+            for (const auto& thread : threads) {
+                writer.write(thread);
+            }
+            continue;
+        }
+        
+        std::cout << "Process " << owner.pid << " (" << owner.name << "): "
+                  << threads.size() << " threads\n\n";
+        std::cout << std::left
+                  << std::setw(8) << "TID"
+                  << std::setw(20) << "NAME"
+                  << std::setw(8) << "STATE"
+                  << std::setw(8) << "CPU%"
+                  << std::setw(12) << "UTIME"
+                  << std::setw(12) << "STIME"
+                  << "\n";
+        std::cout << std::string(68, '-') << "\n";
+        
+        for (const auto& thread : threads) {
+            std::cout << std::left
+                      << std::setw(8) << thread.pid
+                      << std::setw(20) << thread.name.substr(0, 19)
+                      << std::setw(8) << thread.state
+                      << std::setw(8) << std::fixed << std::setprecision(1) << thread.cpuPercent
+                      << std::setw(12) << thread.utime
+                      << std::setw(12) << thread.stime
+                      << "\n";
+        }
+        std::cout << "\n";
+    }
+    
+    if (format != ProcessWriter::FORMAT_TABLE) {
+        writer.end();
+    }
+    return 0;
+}
+
+// Group processes by cgroup. Two snapshots 'intervalNs' apart give
+// per-process CPU% and the cgroups' cpu.stat usage rate.
+void showCgroups(bool showProcesses, int64_t intervalNs) {
+    ProcessManager manager;
+    manager.setFields(ProcessFields::NONE);
+    CgroupTree tree;
+    
+    std::vector<Process> processes = manager.getAllProcesses();
+    tree.build(processes, manager.getSource());
+    
+    sleepFor(intervalNs);
+    
+    processes = manager.getAllProcesses();
+    tree.build(processes, manager.getSource());
+    
+    std::cout << "Cgroups (Total: " << processes.size() << " processes";
+    if (!manager.isLive() || tree.getCgroupRoot().empty()) {
+        std::cout << ", no cgroup v2 totals: mem and cpu are process sums";
+    }
+    std::cout << ")\n\n";
+    
+    for (const auto& line : tree.getTreeLines(showProcesses)) {
+        std::cout << line << "\n";
+    }
+}
+
+// Totals per user, name or state. Two snapshots 'intervalNs' apart give
+// per-process CPU% for the CPU column.
+int showGroups(ProcessGrouper::Key key, ProcessGrouper::Column column, int count,
+               int64_t intervalNs, ProcessWriter::Format format) {
+    if (format == ProcessWriter::FORMAT_BINARY) {
+        std::cerr << "Error: --group-by supports table, json and csv\n";
+        return 1;
+    }
+    
+    ProcessManager manager;
+    manager.setFields(ProcessGrouper::requiredFields(key));
+    manager.getAllProcesses();
+    
+    sleepFor(intervalNs);
+    
+    std::vector<Process> processes = manager.getAllProcesses();
+    ProcessGrouper grouper;
+    grouper.build(processes, key);
+    grouper.sort(column);
+    const std::vector<ProcessGroup>& groups = grouper.getGroups();
+    size_t shown = count > 0 ? std::min(groups.size(), (size_t)count) : groups.size();
+    const char* keyField = ProcessGrouper::keyName(key);
+    
+    if (format != ProcessWriter::FORMAT_TABLE) {
+        OutputBuffer out(STDOUT_FILENO);
+        ProcessWriter writer(format, out);
+        writer.beginGroups(keyField);
+        for (size_t i = 0; i < shown; i++) {
+            writer.writeGroup(keyField, grouper.getKey(groups[i].keyId), groups[i]);
+        }
+        writer.end();
+        return 0;
+    }
+    
+    std::string header = keyField;
+    std::transform(header.begin(), header.end(), header.begin(), ::toupper);
+    std::cout << groups.size() << " groups of " << processes.size()
+              << " processes by " << keyField << ":\n\n";
+    std::cout << std::left
+              << std::setw(24) << header
+              << std::setw(8) << "COUNT"
+              << std::setw(10) << "THREADS"
+              << std::setw(10) << "RSS(MB)"
+              << std::setw(12) << "MAX RSS(MB)"
+              << "CPU%\n";
+    std::cout << std::string(70, '-') << "\n";
+    
+    for (size_t i = 0; i < shown; i++) {
+        const ProcessGroup& group = groups[i];
+        std::cout << std::left
+                  << std::setw(24) << grouper.getKey(group.keyId).substr(0, 23)
+                  << std::setw(8) << group.count
+                  << std::setw(10) << group.threads
+                  << std::setw(10) << group.rssKB / 1024
+                  << std::setw(12) << group.maxRssKB / 1024
+                  << std::fixed << std::setprecision(1) << group.cpuPercent << "\n";
+    }
+    return 0;
+}
+
+// Top processes by proportional set size. smaps_rollup is only read for
+// processes whose RSS could still place them in the top N.
+void showTopByPSS(int count) {
+    ProcessManager manager;
+    manager.setFields(ProcessFields::NONE);
+    std::vector<Process> processes = manager.getAllProcesses();
+    
+    MemoryCollector memory;
+    memory.beginRefresh();
+    std::vector<const Process*> top = memory.topByPSS(processes, count > 0 ? count : 0,
+                                                      manager.getSource());
+    const MemoryCollector::Cost& cost = memory.getCost();
+    for (const Process* proc : top) {
+        manager.readFields(processes[proc - processes.data()], ProcessFields::USER);
+    }
+    
+    std::cout << "Top " << count << " processes by PSS:\n\n";
+    std::cout << std::left
+              << std::setw(8) << "PID"
+              << std::setw(24) << "NAME"
+              << std::setw(12) << "USER"
+              << std::setw(10) << "PSS(MB)"
+              << std::setw(10) << "USS(MB)"
+              << std::setw(10) << "SWAP(MB)"
+              << std::setw(10) << "RSS(MB)"
+              << "\n";
+    std::cout << std::string(84, '-') << "\n";
+    
+    for (const Process* proc : top) {
+        const MemoryUsage* usage = memory.find(proc->key());
+        std::cout << std::left
+                  << std::setw(8) << proc->pid
+                  << std::setw(24) << proc->name.substr(0, 23)
+                  << std::setw(12) << proc->user.substr(0, 11)
+                  << std::setw(10) << usage->pss / 1024
+                  << std::setw(10) << usage->uss / 1024
+                  << std::setw(10) << usage->swap / 1024
+                  << std::setw(10) << proc->vmRSS / 1024
+                  << "\n";
+    }
+    
+    std::cout << "\nsmaps_rollup: " << cost.reads << " of " << processes.size()
+              << " processes read in " << std::fixed << std::setprecision(1)
+              << cost.ns / 1e6 << " ms\n";
+}
+
+// Format a byte rate as "812K", "3.2M" or "1.1G"
+static std::string formatRate(double bytes) {
+    char buf[32];
+    if (bytes >= 1024.0 * 1024 * 1024) {
+        snprintf(buf, sizeof(buf), "%.1fG", bytes / (1024.0 * 1024 * 1024));
+    } else if (bytes >= 1024.0 * 1024) {
+        snprintf(buf, sizeof(buf), "%.1fM", bytes / (1024.0 * 1024));
+    } else {
+        snprintf(buf, sizeof(buf), "%.0fK", bytes / 1024.0);
+    }
+    return buf;
+}
+
+// Top processes by storage I/O. Two scans 'intervalNs' apart give
+// per-second rates; /proc/<pid>/io is only read here, not by other views.
+void showTopByIO(int count, int64_t intervalNs, ProcessWriter::Format format) {
+    ProcessManager manager;
+    manager.setFields(ProcessFields::IO);
+    manager.getAllProcesses();
+    
+    sleepFor(intervalNs);
+    
+    std::vector<Process> processes = manager.getAllProcesses();
+    std::vector<Process> top = ProcessSorter::topByIO(processes, count > 0 ? count : 0);
+    for (auto& proc : top) {
+        manager.readFields(proc, ProcessFields::USER);
+    }
+    
+    if (format != ProcessWriter::FORMAT_TABLE) {
+        OutputBuffer out(STDOUT_FILENO);
+        ProcessWriter writer(format, out);
+        writer.setIncludeIO(true);
+        writer.begin();
+        for (const auto& proc : top) {
+            writer.write(proc);
+        }
+        writer.end();
+        return;
+    }
+    
+    size_t unreadable = std::count_if(processes.begin(), processes.end(),
+                                      [](const Process& proc) { return !proc.hasIO; });
+    
+    std::cout << "Top " << count << " processes by I/O over " << std::fixed
+              << std::setprecision(1) << intervalNs / 1e9 << "s:\n\n";
+    std::cout << std::left
+              << std::setw(8) << "PID"
+              << std::setw(24) << "NAME"
+              << std::setw(12) << "USER"
+              << std::setw(10) << "READ/s"
+              << std::setw(10) << "WRITE/s"
+              << std::setw(10) << "SYSCR/s"
+              << std::setw(10) << "SYSCW/s"
+              << "\n";
+    std::cout << std::string(84, '-') << "\n";
+    
+    for (const auto& proc : top) {
+        std::cout << std::left
+                  << std::setw(8) << proc.pid
+                  << std::setw(24) << proc.name.substr(0, 23)
+                  << std::setw(12) << proc.user.substr(0, 11)
+                  << std::setw(10) << (proc.hasIO ? formatRate(proc.readRate) : "-")
+                  << std::setw(10) << (proc.hasIO ? formatRate(proc.writeRate) : "-")
+                  << std::setw(10) << (long long)(proc.syscrRate + 0.5)
+                  << std::setw(10) << (long long)(proc.syscwRate + 0.5)
+                  << "\n";
+    }
+    
+    if (unreadable > 0) {
+        std::cout << "\n" << unreadable << " of " << processes.size()
+                  << " processes have unreadable I/O counters (run as root to see all)\n";
+    }
+}
+
+// Top processes by run-queue wait: the most CPU-starved. Two scans
+// 'intervalNs' apart give the share of the interval spent runnable but
+// not running, and context switches per second.
+void showTopByWait(int count, int64_t intervalNs, ProcessWriter::Format format) {
+    ProcessManager manager;
+    manager.setFields(ProcessFields::SCHED);
+    manager.getAllProcesses();
+    
+    sleepFor(intervalNs);
+    
+    std::vector<Process> processes = manager.getAllProcesses();
+    std::vector<Process> top = ProcessSorter::topByWait(processes, count > 0 ? count : 0);
+    
+    if (format != ProcessWriter::FORMAT_TABLE) {
+        OutputBuffer out(STDOUT_FILENO);
+        ProcessWriter writer(format, out);
+        writer.setIncludeSched(true);
+        writer.begin();
+        for (const auto& proc : top) {
+            writer.write(proc);
+        }
+        writer.end();
+        return;
+    }
+    
+    size_t unreadable = std::count_if(processes.begin(), processes.end(),
+                                      [](const Process& proc) { return !proc.hasSched; });
+    
+    std::cout << "Top " << count << " processes by run-queue wait over " << std::fixed
+              << std::setprecision(1) << intervalNs / 1e9 << "s:\n\n";
+    std::cout << std::left
+              << std::setw(8) << "PID"
+              << std::setw(24) << "NAME"
+              << std::setw(12) << "USER"
+              << std::setw(10) << "CPU%"
+              << std::setw(10) << "WAIT%"
+              << std::setw(10) << "VCSW/s"
+              << std::setw(10) << "NVCSW/s"
+              << "\n";
+    std::cout << std::string(84, '-') << "\n";
+    
+    for (const auto& proc : top) {
+        std::cout << std::left
+                  << std::setw(8) << proc.pid
+                  << std::setw(24) << proc.name.substr(0, 23)
+                  << std::setw(12) << proc.user.substr(0, 11)
+                  << std::setw(10) << proc.cpuPercent
+                  << std::setw(10) << proc.waitPercent
+                  << std::setw(10) << (long long)(proc.voluntaryRate + 0.5)
+                  << std::setw(10) << (long long)(proc.involuntaryRate + 0.5)
+                  << "\n";
+    }
+    
+    if (unreadable > 0) {
+        std::cout << "\n" << unreadable << " of " << processes.size()
+                  << " processes have no schedstat (kernel without CONFIG_SCHED_INFO,"
+                  << " or not /proc)\n";
+    }
+    std::cout << "Wait and switches are summed over each process's threads\n";
+}
+
+// Signals and priority changes only make sense for the live system
+bool requireLiveSource() {
+    ProcessManager manager;
+    if (manager.isLive()) {
+        return true;
+    }
+    std::cerr << "Error: process actions are not available when reading "
+              << manager.getSource().describe() << "\n";
+    return false;
+}
+
+// Report LPM's own per-stage timings and I/O and allocation counters
+void printStats() {
+    std::cerr << "\nLPM self-profile:\n";
+    for (const auto& line : Profiler::formatReport()) {
+        std::cerr << "  " << line << "\n";
+    }
+}
+
+int generateProcTree(const std::string& dir, size_t count) {
+    SyntheticSource source(count);
+    std::string error;
+    if (!source.writeTree(dir, error)) {
+        std::cerr << "Error: " << error << "\n";
+        return 1;
+    }
+    std::cout << "Wrote " << source.getProcesses().size() << " processes to " << dir << "\n";
+    return 0;
+}
+
+int recordProcesses(const std::string& path, int64_t intervalNs, int64_t keyframeNs) {
+    SnapshotRecorder recorder;
+    recorder.setKeyframeSpacing(keyframeNs);
+    std::string error;
+    if (!recorder.open(path, intervalNs, error)) {
+        std::cerr << "Error: " << error << "\n";
+        return 1;
+    }
+    
+    // Stop cleanly on Ctrl-C so the footer index gets written
+    stopOnSignals();
+    
+    std::cerr << "Recording to " << path << " every "
+              << (intervalNs / 1e6) << " ms (Ctrl-C to stop)\n";
+    
+    ProcessManager manager;
+    bool ok = true;
+    runEvery(intervalNs, [&](int64_t) {
+        std::vector<Process> processes = manager.getAllProcesses();
+        
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        if (!recorder.writeSnapshot(processes, toNanoseconds(now), manager.getTotalCPUTime(), error)) {
+            std::cerr << "Error: failed to write " << path << ": " << error << "\n";
+            ok = false;
+        }
+        return ok;
+    });
+    
+    recorder.close();
+    
+    uint32_t frames = recorder.getFrameCount();
+    std::cerr << "\nRecorded " << frames << " frames (" << recorder.getKeyframeCount()
+              << " keyframes), " << recorder.getBytesWritten() << " bytes";
+    if (frames > 0) {
+        std::cerr << ", " << recorder.getBytesWritten() / frames << " bytes/frame";
+    }
+    std::cerr << "\n";
+    return ok ? 0 : 1;
+}
+
+// Collect once per interval and publish each snapshot to shared memory,
+// so any number of --attach clients cost a single /proc scan
+int publishSnapshots(const std::string& name, int64_t intervalNs, bool io) {
+    SnapshotPublisher publisher;
+    std::string error;
+    if (!publisher.open(name, intervalNs, error)) {
+        std::cerr << "Error: " << error << "\n";
+        return 1;
+    }
+    
+    // Stop cleanly on Ctrl-C so the region is removed
+    stopOnSignals();
+    
+    std::cerr << "Publishing to " << name << " every " << (intervalNs / 1e6)
+              << " ms (Ctrl-C to stop)\n";
+    
+    // Everything a client may show from the scan itself
+    ProcessManager manager;
+    unsigned fields = ProcessFields::USER | (io ? ProcessFields::IO : ProcessFields::NONE);
+    manager.setFields(fields);
+    
+    std::vector<Process> processes;
+    runEvery(intervalNs, [&](int64_t) {
+        unsigned long cpuTicks = manager.getTotalCPUTime();
+        double uptime = manager.getSystemUptime();
+        processes = manager.getAllProcesses();
+        
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        publisher.publish(processes, fields, toNanoseconds(now), cpuTicks, uptime);
+        return true;
+    });
+    
+    std::cerr << "\nPublished " << publisher.getGeneration() << " snapshots\n";
+    publisher.close();
+    return 0;
+}
+
+// Collect every interval and serve the OpenMetrics body between
+// collections; scrapes only copy out the body maintained from change sets
+int serveMetrics(const std::string& address, int64_t intervalNs, size_t topK) {
+    MetricsServer server;
+    std::string error;
+    if (!server.open(address, error)) {
+        std::cerr << "Error: " << error << "\n";
+        return 1;
+    }
+    
+    stopOnSignals();
+    
+    std::cerr << "Serving OpenMetrics on " << address << "/metrics, collecting every "
+              << (intervalNs / 1e6) << " ms (Ctrl-C to stop)\n";
+    
+    ProcessManager manager;
+    manager.setFields(ProcessFields::USER);
+    SnapshotDiff diff;
+    MetricsExporter exporter(topK);
+    
+    std::vector<Process> processes;
+    runEvery(intervalNs, [&](int64_t) {
+        processes = manager.getAllProcesses();
+        diff.update(processes);
+        
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        exporter.update(processes, diff, manager.getSource(), toNanoseconds(now));
+        return true;
+    }, [&](int remainingMs) {
+        server.serve(exporter.getBody(), remainingMs);
+    });
+    
+    std::cerr << "\nServed " << server.getScrapeCount() << " scrapes\n";
+    server.close();
+    return 0;
+}
+
+// Evaluate a rules file every interval against what changed and log the
+// actions taken
+int runRules(const std::string& path, int64_t intervalNs, bool dryRun) {
+    RuleEngine engine;
+    std::string error;
+    if (!engine.load(path, error)) {
+        std::cerr << "Error: " << error << "\n";
+        return 1;
+    }
+    if (engine.getRules().empty()) {
+        std::cerr << "Error: no rules in " << path << "\n";
+        return 1;
+    }
+    engine.setDryRun(dryRun);
+    stopOnSignals();
+    
+    std::cerr << engine.getRules().size() << " rules from " << path << ", checked every "
+              << (intervalNs / 1e6) << " ms" << (dryRun ? " (dry run)" : "")
+              << " (Ctrl-C to stop)\n";
+    
+    ProcessManager manager;
+    manager.setFields(engine.requiredFields());
+    SnapshotDiff diff;
+    std::vector<Process> processes;
+    std::vector<RuleEvent> events;
+    
+    runEvery(intervalNs, [&](int64_t) {
+        processes = manager.getAllProcesses();
+        diff.update(processes);
+        
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        events.clear();
+        engine.update(diff, toNanoseconds(now), events);
+        
+        time_t wall = time(nullptr);
+        char stamp[16];
+        strftime(stamp, sizeof(stamp), "%H:%M:%S", localtime(&wall));
+        for (const auto& event : events) {
+            std::cout << stamp << "  rule " << event.rule + 1 << ": ";
+            switch (event.step.kind) {
+                case RuleStep::ALERT:
+                    std::cout << "alert";
+                    break;
+                case RuleStep::SIGNAL:
+                    std::cout << ProcessController::getSignalName(event.step.value);
+                    break;
+                case RuleStep::NICE:
+                    std::cout << "nice " << event.step.value;
+                    break;
+            }
+            std::cout << " " << event.target.pid << " (" << event.name << ")";
+            if (event.gone) {
+                std::cout << " - already exited";
+            } else if (dryRun && event.step.kind != RuleStep::ALERT) {
+                std::cout << " - dry run";
+            }
+            std::cout << "\n";
+        }
+        std::cout.flush();
+        return true;
+    });
+    return 0;
+}
+
+// Sample the given processes (and their threads) 'hz' times a second on
+// absolute deadlines, streaming each sample or, with 'summary', printing
+// percentiles at the end. The lateness of each wake-up is reported too.
+int watchProcesses(const std::string& pids, long hz, bool threads, int64_t durationNs,
+                   bool summary) {
+    ProcessManager manager;
+    ProcessWatcher watcher;
+    watcher.setKeepHistory(summary);
+    
+    std::stringstream list(pids);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        std::string error;
+        if (!watcher.add(manager, std::atoi(item.c_str()), threads, error)) {
+            std::cerr << "Error: " << error << "\n";
+            return 1;
+        }
+    }
+    
+    stopOnSignals();
+    
+    std::cerr << "Watching " << watcher.getTargets().size() << " targets at " << hz
+              << " Hz (Ctrl-C to stop)\n";
+    
+    OutputBuffer out(STDOUT_FILENO);
+    char line[160];
+    if (!summary) {
+        int length = snprintf(line, sizeof(line), "%-10s %-8s %-8s %-16s %-2s %-7s %-7s %s\n",
+                              "TIME", "PID", "TID", "NAME", "S", "CPU%", "WAIT%", "RSS(kB)");
+        out.write(line, length);
+        out.flush();
+    }
+    
+    int64_t intervalNs = 1000000000LL / hz;
+    LogHistogram lateness(4);               // Nanoseconds past each deadline
+    uint64_t missed = 0;
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    int64_t start = toNanoseconds(deadline);
+    int64_t lastThreadScan = start;
+    
+    // Not runEvery: the lateness of each wake-up is measured, and
+    // deadlines missed after an overrun are skipped, not caught up
+    while (!stopRequested && watcher.getLiveCount() > 0) {
+        addNanoseconds(deadline, intervalNs);
+        int64_t due = toNanoseconds(deadline);
+        if (durationNs > 0 && due - start > durationNs) {
+            break;
+        }
+        sleepUntil(deadline);
+        if (stopRequested) {
+            break;
+        }
+        
+        struct timespec woke;
+        clock_gettime(CLOCK_MONOTONIC, &woke);
+        int64_t now = toNanoseconds(woke);
+        lateness.add(std::max<int64_t>(0, now - due));
+        watcher.sample(now);
+        
+        if (threads && now - lastThreadScan >= 1000000000LL) {
+            watcher.refreshThreads();
+            lastThreadScan = now;
+        }
+        
+        if (!summary) {
+            for (const auto& target : watcher.getTargets()) {
+                if (!target.alive || target.time != now || target.cpuPercent < 0) {
+                    continue;
+                }
+                char wait[16] = "-";
+                if (target.waitPercent >= 0) {
+                    snprintf(wait, sizeof(wait), "%.1f", target.waitPercent);
+                }
+                int length = snprintf(line, sizeof(line),
+                                      "%-10.3f %-8d %-8s %-16.16s %-2c %-7.1f %-7s %s\n",
+                                      (now - start) / 1e9, target.owner,
+                                      target.thread ? std::to_string(target.key.pid).c_str() : "-",
+                                      target.name.c_str(), target.state, target.cpuPercent, wait,
+                                      target.thread ? "-" : std::to_string(target.vmRSS).c_str());
+                out.write(line, std::min(length, (int)sizeof(line) - 1));
+            }
+            if (!out.flush()) {
+                break;
+            }
+        }
+        
+        // After an overrun, skip the deadlines already passed rather than
+        // sampling in a burst to catch up
+        clock_gettime(CLOCK_MONOTONIC, &woke);
+        int64_t after = toNanoseconds(woke);
+        if (after - due >= intervalNs) {
+            int64_t skipped = (after - due) / intervalNs;
+            missed += skipped;
+            addNanoseconds(deadline, skipped * intervalNs);
+        }
+    }
+    
+    if (summary) {
+        int length = snprintf(line, sizeof(line), "%-8s %-8s %-16s %-8s %-23s %s\n",
+                              "PID", "TID", "NAME", "SAMPLES", "CPU% p50/p99/max",
+                              "WAIT% p50/p99/max");
+        out.write(line, length);
+        for (const auto& target : watcher.getTargets()) {
+            const LogHistogram& cpu = target.cpuHistory;
+            const LogHistogram& wait = target.waitHistory;
+            char cpuText[32], waitText[32] = "-";
+            snprintf(cpuText, sizeof(cpuText), "%.1f/%.1f/%.1f",
+                     ProcessWatcher::percentile(cpu, 0.5), ProcessWatcher::percentile(cpu, 0.99),
+                     ProcessWatcher::percentile(cpu, 1.0));
+            if (wait.getCount() > 0) {
+                snprintf(waitText, sizeof(waitText), "%.1f/%.1f/%.1f",
+                         ProcessWatcher::percentile(wait, 0.5),
+                         ProcessWatcher::percentile(wait, 0.99),
+                         ProcessWatcher::percentile(wait, 1.0));
+            }
+            length = snprintf(line, sizeof(line), "%-8d %-8s %-16.16s %-8zu %-23s %s\n",
+                              target.owner,
+                              target.thread ? std::to_string(target.key.pid).c_str() : "-",
+                              target.name.c_str(), (size_t)cpu.getCount(), cpuText, waitText);
+            out.write(line, std::min(length, (int)sizeof(line) - 1));
+        }
+        out.flush();
+    }
+    
+    std::cerr << std::fixed << std::setprecision(1) << "\n" << lateness.getCount()
+              << " samples; wake-up lateness p50 " << lateness.percentile(0.5) / 1e3
+              << " us, p99 " << lateness.percentile(0.99) / 1e3
+              << " us, max " << lateness.percentile(1.0) / 1e3 << " us; "
+              << missed << " deadlines missed\n";
+    return 0;
+}
+
+// Feed RSS samples to a LeakDetector, live every 'intervalNs' for
+// 'durationNs' or from each frame of the recording at 'path', and print
+// the suspected leaks
+int findLeaks(const std::string& path, int64_t intervalNs, int64_t durationNs, int count) {
+    LeakDetector detector;
+    std::vector<Process> processes;
+    SnapshotReader reader;
+    if (!path.empty()) {
+        std::string error;
+        if (!reader.open(path, error)) {
+            std::cerr << "Error: " << error << "\n";
+            return 1;
+        }
+        durationNs = reader.getEndTime() - reader.getStartTime();
+    }
+    
+    // A trend need not span more than half of the run or recording
+    LeakDetector::Thresholds thresholds = detector.getThresholds();
+    thresholds.minSpanSeconds = std::min(thresholds.minSpanSeconds, durationNs / 2e9);
+    detector.setThresholds(thresholds);
+    
+    if (!path.empty()) {
+        for (uint32_t frame = 0; frame < reader.getFrameCount(); frame++) {
+            if (!reader.seekFrame(frame)) {
+                std::cerr << "Warning: " << path << " is damaged at frame " << frame + 1
+                          << "; using the frames before it\n";
+                break;
+            }
+            reader.getProcesses(processes);
+            detector.update(processes, reader.getTimestamp());
+        }
+        std::cout << reader.getFrameCount() << " frames from "
+                  << SnapshotReader::formatTime(reader.getStartTime()) << "\n\n";
+    } else {
+        stopOnSignals();
+        
+        std::cerr << "Sampling RSS every " << intervalNs / 1e9 << " s for " << durationNs / 1e9
+                  << " s (Ctrl-C to report early)\n";
+        
+        ProcessManager manager;
+        manager.setFields(ProcessFields::NONE);
+        int64_t start = -1;
+        runEvery(intervalNs, [&](int64_t now) {
+            if (start < 0) {
+                start = now;
+            }
+            if (now - start > durationNs) {
+                return false;
+            }
+            processes = manager.getAllProcesses();
+            detector.update(processes, now);
+            return true;
+        });
+        
+        // Names for the report
+        for (auto& proc : processes) {
+            manager.readFields(proc, ProcessFields::USER);
+        }
+    }
+    
+    std::unordered_map<ProcessKey, const Process*, ProcessKeyHash> byKey;
+    for (const auto& proc : processes) {
+        byKey.emplace(proc.key(), &proc);
+    }
+    
+    std::vector<std::pair<ProcessKey, LeakTrend>> suspects = detector.getSuspects();
+    if (suspects.empty()) {
+        std::cout << "No suspected leaks among " << detector.size() << " processes\n";
+        return 0;
+    }
+    
+    std::cout << "Suspected leaks (" << suspects.size() << " of " << detector.size()
+              << " processes):\n\n";
+    std::cout << std::left
+              << std::setw(8) << "PID"
+              << std::setw(24) << "NAME"
+              << std::setw(12) << "USER"
+              << std::setw(10) << "RSS(MB)"
+              << std::setw(10) << "GROWTH/h"
+              << std::setw(10) << "OVER"
+              << std::setw(8) << "T"
+              << "R2\n";
+    std::cout << std::string(84, '-') << "\n";
+    
+    for (size_t i = 0; i < suspects.size() && (int)i < count; i++) {
+        const LeakTrend& trend = suspects[i].second;
+        auto it = byKey.find(suspects[i].first);
+        std::string name = it != byKey.end() ? it->second->name : "?";
+        std::string user = it != byKey.end() ? it->second->user : "?";
+        std::string span = std::to_string((long)trend.spanSeconds / 60) + "m" +
+                           std::to_string((long)trend.spanSeconds % 60) + "s";
+        std::cout << std::left << std::fixed
+                  << std::setw(8) << suspects[i].first.pid
+                  << std::setw(24) << name.substr(0, 23)
+                  << std::setw(12) << user.substr(0, 11)
+                  << std::setw(10) << trend.rssKB / 1024
+                  << std::setw(10) << LeakDetector::formatGrowth(trend.slope * 3600)
+                  << std::setw(10) << span
+                  << std::setw(8) << std::setprecision(1) << std::min(trend.tScore, 999.0)
+                  << std::setprecision(2) << trend.fit << "\n";
+    }
+    return 0;
+}
+
+// Print per-interval fork, exec and exit rates and the processes that
+// lived and died between two listings
+int watchEvents(int64_t intervalNs, int64_t durationNs) {
+    auto source = std::make_shared<ProcessEventSource>();
+    std::string error;
+    if (!source->start(error)) {
+        std::cerr << "Process events unavailable (" << error << "); polling /proc.\n"
+                  << "Rates are from PID listings and short-lived processes are not seen.\n";
+    }
+    
+    stopOnSignals();
+    
+    std::vector<int> pids;
+    source->listPids(pids);
+    ProcessEventCounters last = source->getCounters();
+    double seconds = intervalNs / 1e9;
+    int64_t elapsed = 0;
+    
+    std::cout << std::left << std::setw(10) << "TIME" << std::setw(10) << "FORK/s"
+              << std::setw(10) << "EXEC/s" << std::setw(10) << "EXIT/s"
+              << std::setw(10) << "PROCS" << "SHORT-LIVED\n";
+    
+    std::vector<ShortLivedProcess> shortLived;
+    
+    // The first call only starts the first interval. Events are drained
+    // continuously in between so bursts do not overrun the socket.
+    int64_t start = -1;
+    runEvery(intervalNs, [&](int64_t due) {
+        if (start < 0) {
+            start = due;
+            return true;
+        }
+        elapsed = due - start;
+        
+        pids.clear();
+        source->listPids(pids);
+        source->takeShortLived(shortLived);
+        const ProcessEventCounters& counters = source->getCounters();
+        
+        time_t wall = time(nullptr);
+        char stamp[16];
+        strftime(stamp, sizeof(stamp), "%H:%M:%S", localtime(&wall));
+        std::cout << std::left << std::fixed << std::setprecision(1)
+                  << std::setw(10) << stamp
+                  << std::setw(10) << (counters.forks - last.forks) / seconds
+                  << std::setw(10) << (counters.execs - last.execs) / seconds
+                  << std::setw(10) << (counters.exits - last.exits) / seconds
+                  << std::setw(10) << pids.size()
+                  << (counters.shortLived - last.shortLived) << "\n";
+        if (counters.lost > last.lost) {
+            std::cout << "  (events lost; PID set resynced from /proc)\n";
+        }
+        
+        const size_t shown = 10;
+        for (size_t i = 0; i < shortLived.size() && i < shown; i++) {
+            const auto& proc = shortLived[i];
+            std::cout << "  " << std::setw(8) << proc.pid << "ppid " << std::setw(8) << proc.ppid
+                      << std::setw(20) << proc.name.substr(0, 19)
+                      << std::setprecision(2) << proc.lifetimeNs / 1e6 << " ms, exit "
+                      << (proc.exitCode >> 8) << "\n";
+        }
+        if (shortLived.size() > shown) {
+            std::cout << "  ... and " << shortLived.size() - shown << " more\n";
+        }
+        std::cout.flush();
+        last = counters;
+        return durationNs == 0 || elapsed < durationNs;
+    }, [&](int remainingMs) {
+        if (source->isEventDriven()) {
+            source->poll(std::min(remainingMs, 100));
+        } else {
+            sleepFor(remainingMs * 1000000LL);
+        }
+    });
+    
+    const ProcessEventCounters& total = source->getCounters();
+    std::cerr << "\n" << total.forks << " forks, " << total.execs << " execs, " << total.exits
+              << " exits, " << total.shortLived << " short-lived";
+    if (total.lost > 0) {
+        std::cerr << ", " << total.lost << " overruns";
+    }
+    std::cerr << "\n";
+    return 0;
+}
+
+int replayRecording(const std::string& path, const std::string& at,
+                    ProcessWriter::Format format) {
+    SnapshotReader reader;
+    std::string error;
+    if (!reader.open(path, error)) {
+        std::cerr << "Error: " << error << "\n";
+        return 1;
+    }
+    
+    int64_t timestamp = reader.getStartTime();
+    if (!at.empty() && !reader.parseTime(at, timestamp)) {
+        std::cerr << "Error: invalid time: " << at
+                  << " (use HH:MM[:SS], YYYY-MM-DD HH:MM[:SS] or +DURATION)\n";
+        return 1;
+    }
+    if (!reader.seekTime(timestamp)) {
+        std::cerr << "Error: " << path << " is damaged\n";
+        return 1;
+    }
+    
+    if (format == ProcessWriter::FORMAT_TABLE) {
+        interactiveMode(&reader);
+        return 0;
+    }
+    
+    std::vector<Process> processes;
+    reader.getProcesses(processes);
+    
+    OutputBuffer out(STDOUT_FILENO);
+    ProcessWriter writer(format, out);
+    writer.begin();
+    for (const auto& proc : processes) {
+        writer.write(proc);
+    }
+    writer.end();
+    return 0;
+}
+
+void interactiveMode(SnapshotReader* replay) {
+    ProcessTUI tui;
+    tui.setReplay(replay);
+    
+    if (!tui.init()) {
+        std::cerr << "Failed to initialize TUI\n";
+        return;
+    }
+    
+    tui.run();
+}
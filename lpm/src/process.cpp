@@ -1,218 +1,680 @@
-#include "process.hpp"
-#include <fstream>
-#include <sstream>
-#include <filesystem>
-#include <cctype>
-#include <cstring>
-#include <unistd.h>
-#include <pwd.h>
-#include <signal.h>
-#include <sys/resource.h>
-
-// Process constructor
-Process::Process() 
-    : pid(0), ppid(0), name(""), state(""), user(""),
-      vmSize(0), vmRSS(0), utime(0), stime(0), 
-      cpuPercent(0.0), numThreads(0), starttime(0) {
-}
-
-// Read process information from /proc filesystem
-bool Process::readFromProc(int processId) {
-    pid = processId;
-    
-    // Read /proc/<pid>/stat for basic info
-    std::string statPath = "/proc/" + std::to_string(pid) + "/stat";
-    std::ifstream statFile(statPath);
-    if (!statFile.is_open()) {
-        return false;
-    }
-    
-    std::string line;
-    if (!std::getline(statFile, line)) {
-        return false;
-    }
-    
-    // Parse stat file - format: pid (comm) state ppid ...
-    size_t start = line.find('(');
-    size_t end = line.rfind(')');
-    
-    if (start == std::string::npos || end == std::string::npos) {
-        return false;
-    }
-    
-    name = line.substr(start + 1, end - start - 1);
-    
-    // Parse remaining fields after comm
-    std::istringstream iss(line.substr(end + 2));
-    iss >> state >> ppid;
-    
-    // Skip fields: pgrp, session, tty_nr, tpgid, flags, minflt, cminflt, majflt, cmajflt
-    for (int i = 0; i < 9; i++) {
-        unsigned long dummy;
-        iss >> dummy;
-    }
-    
-    iss >> utime >> stime;
-    
-    // Skip cutime, cstime, priority, nice
-    for (int i = 0; i < 4; i++) {
-        long dummy;
-        iss >> dummy;
-    }
-    
-    iss >> numThreads;
-    
-    // Skip itrealvalue
-    long dummy;
-    iss >> dummy;
-    
-    iss >> starttime;
-    
-    // Read /proc/<pid>/status for additional info
-    std::string statusPath = "/proc/" + std::to_string(pid) + "/status";
-    std::ifstream statusFile(statusPath);
-    if (statusFile.is_open()) {
-        std::string statusLine;
-        int uid = -1;
-        
-        while (std::getline(statusFile, statusLine)) {
-            if (statusLine.find("VmSize:") == 0) {
-                std::istringstream vss(statusLine.substr(7));
-                vss >> vmSize;
-            } else if (statusLine.find("VmRSS:") == 0) {
-                std::istringstream vss(statusLine.substr(6));
-                vss >> vmRSS;
-            } else if (statusLine.find("Uid:") == 0) {
-                std::istringstream uss(statusLine.substr(4));
-                uss >> uid;
-            }
-        }
-        
-        // Get username from UID
-        if (uid >= 0) {
-            struct passwd* pw = getpwuid(uid);
-            if (pw) {
-                user = pw->pw_name;
-            } else {
-                user = std::to_string(uid);
-            }
-        }
-    }
-    
-    return true;
-}
-
-// Calculate CPU percentage
-void Process::calculateCPU(unsigned long prevUtime, unsigned long prevStime, 
-                          unsigned long totalTimeDiff) {
-    if (totalTimeDiff == 0) {
-        cpuPercent = 0.0;
-        return;
-    }
-    
-    unsigned long processTimeDiff = (utime + stime) - (prevUtime + prevStime);
-    cpuPercent = (100.0 * processTimeDiff) / totalTimeDiff;
-}
-
-// ProcessManager constructor
-ProcessManager::ProcessManager() 
-    : lastTotalCPUTime(0), lastUpdateTime(0.0) {
-}
-
-// Get all running processes
-std::vector<Process> ProcessManager::getAllProcesses() {
-    std::vector<Process> processes;
-    const std::string procPath = "/proc";
-    
-    try {
-        for (const auto& entry : std::filesystem::directory_iterator(procPath)) {
-            if (!entry.is_directory()) {
-                continue;
-            }
-            
-            std::string dirName = entry.path().filename().string();
-            
-            // Check if directory name is numeric (PID)
-            bool isNumeric = true;
-            for (char c : dirName) {
-                if (!std::isdigit(c)) {
-                    isNumeric = false;
-                    break;
-                }
-            }
-            
-            if (!isNumeric) {
-                continue;
-            }
-            
-            int pid = std::stoi(dirName);
-            Process proc;
-            
-            if (proc.readFromProc(pid)) {
-                processes.push_back(proc);
-            }
-        }
-    } catch (const std::exception& e) {
-        // Handle filesystem errors silently
-    }
-    
-    return processes;
-}
-
-// Get single process by PID
-Process ProcessManager::getProcess(int pid) {
-    Process proc;
-    proc.readFromProc(pid);
-    return proc;
-}
-
-// Kill a process with specified signal
-bool ProcessManager::killProcess(int pid, int signal) {
-    if (pid <= 0) {
-        return false;
-    }
-    
-    return (kill(pid, signal) == 0);
-}
-
-// Change process priority (nice value: -20 to 19)
-bool ProcessManager::setProcessPriority(int pid, int priority) {
-    if (pid <= 0) {
-        return false;
-    }
-    
-    return (setpriority(PRIO_PROCESS, pid, priority) == 0);
-}
-
-// Get system uptime in seconds
-double ProcessManager::getSystemUptime() {
-    std::ifstream uptimeFile("/proc/uptime");
-    if (!uptimeFile.is_open()) {
-        return 0.0;
-    }
-    
-    double uptime;
-    uptimeFile >> uptime;
-    return uptime;
-}
-
-// Get total CPU time since boot (sum of all CPU time values)
-unsigned long ProcessManager::getTotalCPUTime() {
-    std::ifstream statFile("/proc/stat");
-    if (!statFile.is_open()) {
-        return 0;
-    }
-    
-    std::string line;
-    std::getline(statFile, line);
-    
-    // First line is "cpu  user nice system idle iowait irq softirq ..."
-    std::istringstream iss(line);
-    std::string cpu;
-    iss >> cpu; // Skip "cpu"
-    
-    unsigned long user, nice, system, idle, iowait, irq, softirq;
-    iss >> user >> nice >> system >> idle >> iowait >> irq >> softirq;
-    
-    return user + nice + system + idle + iowait + irq + softirq;
-}
+#include "process.hpp"
+#include "process_source.hpp"
+#include "process_profile.hpp"
+#include "process_filter.hpp"
+#include <algorithm>
+#include <sstream>
+#include <filesystem>
+#include <cctype>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pwd.h>
+#include <signal.h>
+#include <sys/resource.h>
+
+// Process constructor
+Process::Process() 
+    : pid(0), ppid(0), name(""), state(""), user(""),
+      vmSize(0), vmRSS(0), utime(0), stime(0), 
+      cpuPercent(0.0), numThreads(0), starttime(0),
+      hasIO(false), readBytes(0), writeBytes(0), syscr(0), syscw(0),
+      readRate(0.0), writeRate(0.0), syscrRate(0.0), syscwRate(0.0),
+      hasSched(false), runNs(0), waitNs(0), timeslices(0), voluntarySwitches(0),
+      involuntarySwitches(0), waitPercent(0.0), voluntaryRate(0.0), involuntaryRate(0.0) {
+}
+
+// Read a small /proc file with one open/read/close. Returns the length
+// read, or -1 if the file cannot be opened.
+static ssize_t readProcFile(const std::string& path, char* buf, size_t size) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    Profiler::add(Profiler::FILES_OPENED, 1);
+    
+    ssize_t length = 0;
+    while ((size_t)length < size) {
+        ssize_t n = read(fd, buf + length, size - length);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        length += n;
+    }
+    close(fd);
+    
+    Profiler::add(Profiler::BYTES_READ, length);
+    return length;
+}
+
+// Read process information from /proc filesystem (or a copy of it)
+bool Process::readFromProc(int processId, const std::string& procRoot, unsigned fields) {
+    ScopedTimer timer(Profiler::STAGE_READ_PROC);
+    pid = processId;
+    char buf[1024];
+    
+    // Read /proc/<pid>/stat for basic info, memory included
+    ssize_t length = readProcFile(procRoot + "/" + std::to_string(pid) + "/stat",
+                                  buf, sizeof(buf));
+    if (length <= 0) {
+        return false;
+    }
+    
+    if (!parseStat(buf, length)) {
+        return false;
+    }
+    
+    // The process may exit in between; what was read still stands
+    if (fields & ProcessFields::USER) {
+        readUserFromProc(processId, procRoot);
+    }
+    if (fields & ProcessFields::IO) {
+        readIOFromProc(processId, procRoot);
+    }
+    
+    return true;
+}
+
+// Read the real UID from /proc/<pid>/status and resolve it to a name.
+// VmSize and VmRSS are taken from status as well: on recent kernels stat
+// reports RSS from per-CPU counters that may lag by a few pages.
+bool Process::readUserFromProc(int processId, const std::string& procRoot) {
+    int uid;
+    if (!readStatusFromProc(processId, procRoot, uid)) {
+        return false;
+    }
+    
+    ScopedTimer lookupTimer(Profiler::STAGE_GETPWUID);
+    struct passwd* pw = getpwuid(uid);
+    if (pw) {
+        user = pw->pw_name;
+    } else {
+        user = std::to_string(uid);
+    }
+    return true;
+}
+
+bool Process::readStatusFromProc(int processId, const std::string& procRoot, int& uid) {
+    ScopedTimer timer(Profiler::STAGE_READ_PROC);
+    char buf[4096];
+    
+    ssize_t length = readProcFile(procRoot + "/" + std::to_string(processId) + "/status",
+                                  buf, sizeof(buf));
+    return length > 0 && parseStatus(buf, length, uid);
+}
+
+// Parse the contents of a status file: "Uid:\treal\teffective\tsaved\tfs",
+// "VmRSS:\t   1234 kB", "voluntary_ctxt_switches:\t42". False if there is
+// no Uid line.
+bool Process::parseStatus(const char* data, size_t length, int& uid) {
+    const char* end = data + length;
+    const char* pos = data;
+    uid = -1;
+    while (pos < end) {
+        const char* newline = static_cast<const char*>(memchr(pos, '\n', end - pos));
+        const char* lineEnd = newline ? newline : end;
+        const char* colon = static_cast<const char*>(memchr(pos, ':', lineEnd - pos));
+        if (colon) {
+            const char* digit = colon + 1;
+            while (digit < lineEnd && (*digit == '\t' || *digit == ' ')) {
+                digit++;
+            }
+            bool isNumber = digit < lineEnd && *digit >= '0' && *digit <= '9';
+            long value = 0;
+            while (digit < lineEnd && *digit >= '0' && *digit <= '9') {
+                value = value * 10 + (*digit++ - '0');
+            }
+            
+            size_t keyLength = colon - pos;
+            if (isNumber && keyLength == 3 && memcmp(pos, "Uid", 3) == 0) {
+                uid = (int)value;
+            } else if (isNumber && keyLength == 6 && memcmp(pos, "VmSize", 6) == 0) {
+                vmSize = value;
+            } else if (isNumber && keyLength == 5 && memcmp(pos, "VmRSS", 5) == 0) {
+                vmRSS = value;
+            } else if (isNumber && keyLength == 23 &&
+                       memcmp(pos, "voluntary_ctxt_switches", 23) == 0) {
+                voluntarySwitches = value;
+            } else if (isNumber && keyLength == 26 &&
+                       memcmp(pos, "nonvoluntary_ctxt_switches", 26) == 0) {
+                involuntarySwitches = value;
+            }
+        }
+        pos = lineEnd + 1;
+    }
+    return uid >= 0;
+}
+
+// Read one thread from /proc/<pid>/task/<tid>/stat
+bool Process::readThreadFromProc(int processId, int threadId, const std::string& procRoot) {
+    ScopedTimer timer(Profiler::STAGE_READ_PROC);
+    char buf[1024];
+    
+    ssize_t length = readProcFile(procRoot + "/" + std::to_string(processId) + "/task/" +
+                                  std::to_string(threadId) + "/stat", buf, sizeof(buf));
+    if (length <= 0 || !parseStat(buf, length)) {
+        return false;
+    }
+    
+    // Memory belongs to the process, not to each thread
+    pid = threadId;
+    ppid = processId;
+    numThreads = 1;
+    vmSize = 0;
+    vmRSS = 0;
+    return true;
+}
+
+// Parse a stat line: pid (comm) state ppid pgrp session tty_nr tpgid flags
+// minflt cminflt majflt cmajflt utime stime cutime cstime priority nice
+// num_threads itrealvalue starttime vsize rss ...
+// vsize (bytes) and rss (pages) are the VmSize and VmRSS of status.
+// comm may contain spaces and parentheses, so it ends at the last ')'.
+bool Process::parseStat(const char* data, size_t length) {
+    const char* end = data + length;
+    const char* open = static_cast<const char*>(memchr(data, '(', length));
+    const char* close = static_cast<const char*>(memrchr(data, ')', length));
+    if (!open || !close || close < open || end - close < 4) {
+        return false;
+    }
+    
+    name.assign(open + 1, close - open - 1);
+    
+    // Field 3: state
+    const char* pos = close + 2;
+    const char* token = pos;
+    while (pos < end && *pos != ' ') {
+        pos++;
+    }
+    state.assign(token, pos - token);
+    
+    static const long pageKB = std::max(1L, sysconf(_SC_PAGESIZE) / 1024);
+    
+    // Fields 4-24 are decimal numbers; some (priority, nice) may be negative
+    for (int field = 4; field <= 24; field++) {
+        while (pos < end && *pos == ' ') {
+            pos++;
+        }
+        bool negative = pos < end && *pos == '-';
+        if (negative) {
+            pos++;
+        }
+        if (pos >= end || *pos < '0' || *pos > '9') {
+            return false;
+        }
+        
+        unsigned long value = 0;
+        while (pos < end && *pos >= '0' && *pos <= '9') {
+            value = value * 10 + (*pos++ - '0');
+        }
+        long number = negative ? -(long)value : (long)value;
+        
+        switch (field) {
+            case 4:  ppid = (int)number; break;
+            case 14: utime = value; break;
+            case 15: stime = value; break;
+            case 20: numThreads = (int)number; break;
+            case 22: starttime = number; break;
+            case 23: vmSize = (long)(value / 1024); break;
+            case 24: vmRSS = number * pageKB; break;
+        }
+    }
+    
+    return true;
+}
+
+// Read I/O counters from /proc/<pid>/io
+bool Process::readIOFromProc(int processId, const std::string& procRoot) {
+    ScopedTimer timer(Profiler::STAGE_READ_PROC);
+    char buf[512];
+    
+    ssize_t length = readProcFile(procRoot + "/" + std::to_string(processId) + "/io",
+                                  buf, sizeof(buf));
+    return length > 0 && parseIO(buf, length);
+}
+
+// Parse "key: value" lines: rchar wchar syscr syscw read_bytes write_bytes
+// cancelled_write_bytes
+bool Process::parseIO(const char* data, size_t length) {
+    const char* end = data + length;
+    const char* pos = data;
+    int found = 0;
+    
+    while (pos < end) {
+        const char* colon = static_cast<const char*>(memchr(pos, ':', end - pos));
+        if (!colon) {
+            break;
+        }
+        
+        const char* digit = colon + 1;
+        while (digit < end && *digit == ' ') {
+            digit++;
+        }
+        unsigned long long value = 0;
+        while (digit < end && *digit >= '0' && *digit <= '9') {
+            value = value * 10 + (*digit++ - '0');
+        }
+        
+        size_t keyLength = colon - pos;
+        if (keyLength == 5 && memcmp(pos, "syscr", 5) == 0) {
+            syscr = value;
+            found++;
+        } else if (keyLength == 5 && memcmp(pos, "syscw", 5) == 0) {
+            syscw = value;
+            found++;
+        } else if (keyLength == 10 && memcmp(pos, "read_bytes", 10) == 0) {
+            readBytes = value;
+            found++;
+        } else if (keyLength == 11 && memcmp(pos, "write_bytes", 11) == 0) {
+            writeBytes = value;
+            found++;
+        }
+        
+        const char* newline = static_cast<const char*>(memchr(digit, '\n', end - digit));
+        pos = newline ? newline + 1 : end;
+    }
+    
+    hasIO = found == 4;
+    return hasIO;
+}
+
+// Read scheduler statistics from /proc/<pid>/schedstat
+bool Process::readSchedFromProc(int processId, const std::string& procRoot) {
+    ScopedTimer timer(Profiler::STAGE_READ_PROC);
+    char buf[128];
+    
+    ssize_t length = readProcFile(procRoot + "/" + std::to_string(processId) + "/schedstat",
+                                  buf, sizeof(buf));
+    return length > 0 && parseSchedstat(buf, length);
+}
+
+// Sum the schedstat and status switch counts of each thread
+bool Process::readTaskSchedFromProc(int processId, const std::vector<int>& threadIds,
+                                    const std::string& procRoot) {
+    ScopedTimer timer(Profiler::STAGE_READ_PROC);
+    char buf[4096];
+    std::string taskDir = procRoot + "/" + std::to_string(processId) + "/task/";
+    
+    Process total;
+    Process thread;
+    bool found = false;
+    for (int tid : threadIds) {
+        std::string dir = taskDir + std::to_string(tid);
+        ssize_t length = readProcFile(dir + "/schedstat", buf, sizeof(buf));
+        if (length <= 0 || !thread.parseSchedstat(buf, length)) {
+            continue;   // Thread exited
+        }
+        thread.voluntarySwitches = thread.involuntarySwitches = 0;
+        length = readProcFile(dir + "/status", buf, sizeof(buf));
+        int uid;
+        if (length > 0) {
+            thread.parseStatus(buf, length, uid);
+        }
+        total.runNs += thread.runNs;
+        total.waitNs += thread.waitNs;
+        total.timeslices += thread.timeslices;
+        total.voluntarySwitches += thread.voluntarySwitches;
+        total.involuntarySwitches += thread.involuntarySwitches;
+        found = true;
+    }
+    if (!found) {
+        return false;
+    }
+    
+    runNs = total.runNs;
+    waitNs = total.waitNs;
+    timeslices = total.timeslices;
+    voluntarySwitches = total.voluntarySwitches;
+    involuntarySwitches = total.involuntarySwitches;
+    hasSched = true;
+    return true;
+}
+
+// Parse "run_ns wait_ns timeslices"
+bool Process::parseSchedstat(const char* data, size_t length) {
+    const char* end = data + length;
+    const char* pos = data;
+    unsigned long long values[3];
+    
+    for (int i = 0; i < 3; i++) {
+        while (pos < end && *pos == ' ') {
+            pos++;
+        }
+        if (pos == end || *pos < '0' || *pos > '9') {
+            return false;
+        }
+        values[i] = 0;
+        while (pos < end && *pos >= '0' && *pos <= '9') {
+            values[i] = values[i] * 10 + (*pos++ - '0');
+        }
+    }
+    
+    runNs = values[0];
+    waitNs = values[1];
+    timeslices = values[2];
+    hasSched = true;
+    return true;
+}
+
+// Calculate CPU percentage
+void Process::calculateCPU(unsigned long prevUtime, unsigned long prevStime, 
+                          unsigned long totalTimeDiff) {
+    if (totalTimeDiff == 0) {
+        cpuPercent = 0.0;
+        return;
+    }
+    
+    unsigned long processTimeDiff = (utime + stime) - (prevUtime + prevStime);
+    cpuPercent = (100.0 * processTimeDiff) / totalTimeDiff;
+}
+
+// Source shared by default-constructed managers
+static std::shared_ptr<ProcessSource>& defaultSource() {
+    static std::shared_ptr<ProcessSource> source = std::make_shared<ProcfsSource>();
+    return source;
+}
+
+// ProcessManager constructor
+ProcessManager::ProcessManager() 
+    : source(defaultSource()), fields(ProcessFields::DEFAULT), lastTotalCPUTime(0), lastUpdateTime(0.0),
+      elapsedTime(0.0), totalTimeDiff(0) {
+}
+
+// ProcessManager reading from a specific source
+ProcessManager::ProcessManager(std::shared_ptr<ProcessSource> source)
+    : source(source), fields(ProcessFields::DEFAULT), lastTotalCPUTime(0), lastUpdateTime(0.0),
+      elapsedTime(0.0), totalTimeDiff(0) {
+}
+
+// Change the source used by default-constructed managers
+void ProcessManager::setDefaultSource(std::shared_ptr<ProcessSource> source) {
+    defaultSource() = source;
+}
+
+std::shared_ptr<ProcessSource> ProcessManager::getDefaultSource() {
+    return defaultSource();
+}
+
+// True when reading the live system
+bool ProcessManager::isLive() const {
+    return source->isLive();
+}
+
+// Get all running processes
+std::vector<Process> ProcessManager::getAllProcesses(const FilterExpression* filter) {
+    std::vector<Process> processes;
+    
+    forEachProcess([&processes](const Process& proc) {
+        processes.push_back(proc);
+    }, filter);
+    
+    return processes;
+}
+
+// Visit every running process as it is read. Each process costs its stat
+// file, then the files of the requested fields, read only once the
+// filter conditions decidable so far have passed.
+void ProcessManager::forEachProcess(const std::function<void(const Process&)>& callback,
+                                    const FilterExpression* filter) {
+    ScopedTimer timer(Profiler::STAGE_SCAN);
+    Process proc;
+    
+    // Searches that no user name can match need no user to be decided
+    FilterExpression staged;
+    unsigned filterFields = 0;
+    if (filter) {
+        staged = *filter;
+        staged.narrowSearches(*source);
+        filterFields = staged.requiredFields();
+    }
+    
+    beginDeltas();
+    
+    pidBuffer.clear();
+    source->listPids(pidBuffer);
+    
+    for (int pid : pidBuffer) {
+        proc = Process();
+        
+        // Processes may exit between listing and reading
+        if (!source->readProcess(pid, proc)) {
+            continue;
+        }
+        
+        // CPU% first: filters may test it
+        applyDeltas(proc);
+        if (filter && !staged.matches(proc, ProcessFields::NONE)) {
+            continue;
+        }
+        
+        // Context switches come from the same status read as the user
+        if ((fields | filterFields) & (ProcessFields::USER | ProcessFields::SCHED)) {
+            source->readUser(pid, proc);
+        }
+        if (filterFields != ProcessFields::NONE && !staged.matches(proc)) {
+            continue;
+        }
+        
+        if ((fields & ProcessFields::IO) && source->readIO(pid, proc)) {
+            applyIODeltas(proc);
+        }
+        if ((fields & ProcessFields::SCHED) && source->readSched(pid, proc)) {
+            applySchedDeltas(proc);
+        }
+        callback(proc);
+    }
+    
+    endDeltas();
+}
+
+// Start a scan: compute the system CPU time elapsed since the last one
+void ProcessManager::beginDeltas() {
+    unsigned long totalTime = getTotalCPUTime();
+    
+    // No time has passed: the source is serving the same snapshot again
+    // (a shared-memory reader refreshing faster than the daemon publishes).
+    // Restore the baseline before it so CPU% and rates repeat rather than
+    // drop to zero.
+    if (lastTotalCPUTime > 0 && totalTime == lastTotalCPUTime) {
+        prevSamples.swap(nextSamples);
+        nextSamples.clear();
+        nextSamples.reserve(prevSamples.size());
+        return;
+    }
+    
+    totalTimeDiff = (lastTotalCPUTime > 0 && totalTime > lastTotalCPUTime) ?
+                    totalTime - lastTotalCPUTime : 0;
+    lastTotalCPUTime = totalTime;
+    
+    // I/O and scheduler rates are per second of wall time; a scan without
+    // them breaks the series, so re-enabling starts from a fresh baseline
+    if (fields & (ProcessFields::IO | ProcessFields::SCHED)) {
+        double uptime = source->getUptime();
+        elapsedTime = (lastUpdateTime > 0 && uptime > lastUpdateTime) ?
+                      uptime - lastUpdateTime : 0.0;
+        lastUpdateTime = uptime;
+    } else {
+        lastUpdateTime = 0.0;
+        elapsedTime = 0.0;
+    }
+    
+    nextSamples.clear();
+    nextSamples.reserve(prevSamples.size());
+}
+
+// Compute CPU% for one process from the counters of the previous scan
+void ProcessManager::applyDeltas(Process& proc) {
+    auto it = prevSamples.find(proc.key());
+    if (it != prevSamples.end() &&
+        proc.utime + proc.stime >= it->second.utime + it->second.stime) {
+        proc.calculateCPU(it->second.utime, it->second.stime, totalTimeDiff);
+    }
+    
+    nextSamples[proc.key()] = ProcessSample{proc.utime, proc.stime, false, 0, 0, 0, 0,
+                                                 false, 0, 0, 0};
+}
+
+// Compute I/O rates for a process whose counters were just read (after
+// applyDeltas)
+void ProcessManager::applyIODeltas(Process& proc) {
+    auto it = prevSamples.find(proc.key());
+    if (it != prevSamples.end()) {
+        const ProcessSample& prev = it->second;
+        if (prev.hasIO && elapsedTime > 0 &&
+            proc.readBytes >= prev.readBytes && proc.writeBytes >= prev.writeBytes &&
+            proc.syscr >= prev.syscr && proc.syscw >= prev.syscw) {
+            proc.readRate = (proc.readBytes - prev.readBytes) / elapsedTime;
+            proc.writeRate = (proc.writeBytes - prev.writeBytes) / elapsedTime;
+            proc.syscrRate = (proc.syscr - prev.syscr) / elapsedTime;
+            proc.syscwRate = (proc.syscw - prev.syscw) / elapsedTime;
+        }
+    }
+    
+    ProcessSample& sample = nextSamples[proc.key()];
+    sample.hasIO = true;
+    sample.readBytes = proc.readBytes;
+    sample.writeBytes = proc.writeBytes;
+    sample.syscr = proc.syscr;
+    sample.syscw = proc.syscw;
+}
+
+// Compute run-queue wait and context switch rates for a process whose
+// schedstat and status were just read (after applyDeltas)
+void ProcessManager::applySchedDeltas(Process& proc) {
+    auto it = prevSamples.find(proc.key());
+    if (it != prevSamples.end()) {
+        const ProcessSample& prev = it->second;
+        if (prev.hasSched && elapsedTime > 0 && proc.waitNs >= prev.waitNs &&
+            proc.voluntarySwitches >= prev.voluntarySwitches &&
+            proc.involuntarySwitches >= prev.involuntarySwitches) {
+            proc.waitPercent = (proc.waitNs - prev.waitNs) / (elapsedTime * 1e7);
+            proc.voluntaryRate = (proc.voluntarySwitches - prev.voluntarySwitches) / elapsedTime;
+            proc.involuntaryRate = (proc.involuntarySwitches - prev.involuntarySwitches) / elapsedTime;
+        }
+    }
+    
+    ProcessSample& sample = nextSamples[proc.key()];
+    sample.hasSched = true;
+    sample.waitNs = proc.waitNs;
+    sample.voluntarySwitches = proc.voluntarySwitches;
+    sample.involuntarySwitches = proc.involuntarySwitches;
+}
+
+// Finish a scan: the samples just taken become the baseline
+void ProcessManager::endDeltas() {
+    // The older baseline stays in nextSamples until the next scan begins
+    prevSamples.swap(nextSamples);
+    
+    // Thread samples of exited processes are no longer needed
+    for (auto it = threadSamples.begin(); it != threadSamples.end(); ) {
+        if (prevSamples.count(it->first)) {
+            ++it;
+        } else {
+            it = threadSamples.erase(it);
+        }
+    }
+}
+
+// Get single process by PID, with the configured fields (I/O without rates)
+Process ProcessManager::getProcess(int pid) {
+    Process proc;
+    if (source->readProcess(pid, proc)) {
+        readFields(proc, fields);
+    }
+    return proc;
+}
+
+// Read optional fields of a process taken with fewer fields
+void ProcessManager::readFields(Process& proc, unsigned fields) {
+    if (fields & (ProcessFields::USER | ProcessFields::SCHED)) {
+        source->readUser(proc.pid, proc);
+    }
+    if (fields & ProcessFields::IO) {
+        source->readIO(proc.pid, proc);
+    }
+    if (fields & ProcessFields::SCHED) {
+        source->readSched(proc.pid, proc);
+    }
+}
+
+// Read the threads of one process with per-thread CPU% deltas
+bool ProcessManager::getThreads(const Process& owner, std::vector<Process>& threads) {
+    threads.clear();
+    tidBuffer.clear();
+    
+    if (!source->listThreads(owner.pid, tidBuffer)) {
+        threadSamples.erase(owner.key());
+        return false;
+    }
+    
+    unsigned long totalTime = source->getTotalCPUTime();
+    ThreadSamples& previous = threadSamples[owner.key()];
+    unsigned long timeDiff = (previous.totalTime > 0 && totalTime > previous.totalTime) ?
+                             totalTime - previous.totalTime : 0;
+    
+    std::unordered_map<ProcessKey, ProcessSample, ProcessKeyHash> samples;
+    samples.reserve(tidBuffer.size());
+    threads.reserve(tidBuffer.size());
+    
+    Process thread;
+    for (int tid : tidBuffer) {
+        thread = Process();
+        if (!source->readThread(owner.pid, tid, thread)) {
+            continue; // Thread exited
+        }
+        
+        // The main thread shares the process's start time; a mismatch
+        // means the PID now belongs to another process
+        if (tid == owner.pid && thread.starttime != owner.starttime) {
+            threadSamples.erase(owner.key());
+            threads.clear();
+            return false;
+        }
+        
+        thread.user = owner.user;
+        auto it = previous.samples.find(thread.key());
+        if (it != previous.samples.end() &&
+            thread.utime + thread.stime >= it->second.utime + it->second.stime) {
+            thread.calculateCPU(it->second.utime, it->second.stime, timeDiff);
+        }
+        samples[thread.key()] = ProcessSample{thread.utime, thread.stime, false, 0, 0, 0, 0,
+                                                      false, 0, 0, 0};
+        threads.push_back(thread);
+    }
+    
+    previous.samples.swap(samples);
+    previous.totalTime = totalTime;
+    return true;
+}
+
+// Kill a process with specified signal
+bool ProcessManager::killProcess(int pid, int signal) {
+    if (pid <= 0) {
+        return false;
+    }
+    
+    return (kill(pid, signal) == 0);
+}
+
+// Change process priority (nice value: -20 to 19)
+bool ProcessManager::setProcessPriority(int pid, int priority) {
+    if (pid <= 0) {
+        return false;
+    }
+    
+    return (setpriority(PRIO_PROCESS, pid, priority) == 0);
+}
+
+// Get system uptime in seconds
+double ProcessManager::getSystemUptime() {
+    return source->getUptime();
+}
+
+// Get total CPU time since boot (sum of all CPU time values)
+unsigned long ProcessManager::getTotalCPUTime() {
+    return source->getTotalCPUTime();
+}
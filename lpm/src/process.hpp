@@ -1,67 +1,253 @@
-#pragma once
-
-#include <string>
-#include <vector>
-
-// Represents a single process with all its attributes
-class Process {
-public:
-    int pid;
-    int ppid;              // Parent process ID
-    std::string name;
-    std::string state;     // R, S, D, Z, T, etc.
-    std::string user;
-    long vmSize;           // Virtual memory size in kB
-    long vmRSS;            // Resident set size in kB
-    unsigned long utime;   // CPU time in user mode (jiffies)
-    unsigned long stime;   // CPU time in kernel mode (jiffies)
-    double cpuPercent;     // CPU usage percentage
-    int numThreads;
-    long starttime;        // Process start time (jiffies since boot)
-
-    Process();
-    
-    // Read process information from /proc/<pid>
-    bool readFromProc(int processId);
-    
-    // Calculate CPU percentage based on previous sample
-    void calculateCPU(unsigned long prevUtime, unsigned long prevStime, 
-                     unsigned long totalTimeDiff);
-};
-
-// Process information collector
-class ProcessManager {
-public:
-    ProcessManager();
-    
-    // Get all running processes
-    std::vector<Process> getAllProcesses();
-    
-    // Get process by PID
-    Process getProcess(int pid);
-    
-    // Kill a process with specified signal
-    bool killProcess(int pid, int signal = 15); // SIGTERM by default
-    
-    // Change process priority
-    bool setProcessPriority(int pid, int priority);
-    
-    // Get system uptime in seconds
-    double getSystemUptime();
-    
-    // Get total CPU time since boot (for CPU % calculations)
-    unsigned long getTotalCPUTime();
-
-private:
-    unsigned long lastTotalCPUTime;
-    double lastUpdateTime;
-    
-    // Helper to read /proc/<pid>/stat
-    bool readStat(int pid, Process& proc);
-    
-    // Helper to read /proc/<pid>/status
-    bool readStatus(int pid, Process& proc);
-    
-    // Helper to get username from UID
-    std::string getUsername(int uid);
-};
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <memory>
+#include <cstddef>
+
+// Identifies a process instance; starttime disambiguates recycled PIDs
+struct ProcessKey {
+    int pid;
+    long starttime;
+
+    ProcessKey() : pid(0), starttime(0) {}
+    ProcessKey(int p, long start) : pid(p), starttime(start) {}
+
+    bool operator==(const ProcessKey& other) const {
+        return pid == other.pid && starttime == other.starttime;
+    }
+    bool operator!=(const ProcessKey& other) const {
+        return !(*this == other);
+    }
+};
+
+// Hash for ProcessKey in unordered containers
+struct ProcessKeyHash {
+    size_t operator()(const ProcessKey& key) const {
+        return std::hash<long>()(((long)key.pid << 40) ^ key.starttime);
+    }
+};
+
+// Optional parts of a Process, named by the /proc file each one costs.
+// The stat fields (pid, ppid, name, state, memory, CPU times, threads and
+// start time) are always read.
+struct ProcessFields {
+    enum : unsigned {
+        NONE = 0,
+        USER = 1 << 0,     // <pid>/status Uid, resolved with getpwuid (and
+                           // exact memory: stat's RSS may lag slightly)
+        IO = 1 << 1,       // <pid>/io counters and rates
+        SCHED = 1 << 2,    // <pid>/schedstat run and wait times, plus the
+                           // context switch counts of <pid>/status (read
+                           // in the same pass as USER)
+        DEFAULT = USER
+    };
+};
+
+// Represents a single process with all its attributes
+class Process {
+public:
+    int pid;
+    int ppid;              // Parent process ID
+    std::string name;
+    std::string state;     // R, S, D, Z, T, etc.
+    std::string user;
+    long vmSize;           // Virtual memory size in kB
+    long vmRSS;            // Resident set size in kB
+    unsigned long utime;   // CPU time in user mode (jiffies)
+    unsigned long stime;   // CPU time in kernel mode (jiffies)
+    double cpuPercent;     // CPU usage percentage
+    int numThreads;
+    long starttime;        // Process start time (jiffies since boot)
+    
+    // Storage I/O from /proc/<pid>/io, only read when requested
+    bool hasIO;                    // Counters were read
+    unsigned long long readBytes;  // Bytes fetched from storage
+    unsigned long long writeBytes; // Bytes sent to storage
+    unsigned long long syscr;      // read()-family system calls
+    unsigned long long syscw;      // write()-family system calls
+    double readRate;               // Per-second rates over the last interval
+    double writeRate;
+    double syscrRate;
+    double syscwRate;
+    
+    // Scheduler statistics, only read when requested. Totals over all
+    // threads where the source can read them (ProcfsSource); otherwise
+    // the main thread's.
+    bool hasSched;                           // schedstat was read
+    unsigned long long runNs;                // Time on a CPU
+    unsigned long long waitNs;               // Time runnable on a run queue
+    unsigned long long timeslices;           // Times scheduled onto a CPU
+    unsigned long long voluntarySwitches;    // Blocked or yielded
+    unsigned long long involuntarySwitches;  // Preempted
+    double waitPercent;                      // Run-queue wait, % of the last interval
+    double voluntaryRate;                    // Switches per second
+    double involuntaryRate;
+
+    Process();
+    
+    // Identity of this process instance
+    ProcessKey key() const { return ProcessKey(pid, starttime); }
+    
+    // Read process information from <procRoot>/<pid>: the stat file plus
+    // the files of 'fields' (ProcessFields bits)
+    bool readFromProc(int processId, const std::string& procRoot = "/proc",
+                      unsigned fields = ProcessFields::DEFAULT);
+    
+    // Read the owner from <procRoot>/<pid>/status and resolve the name;
+    // also takes the exact VmSize and VmRSS from it
+    bool readUserFromProc(int processId, const std::string& procRoot = "/proc");
+    
+    // As above, leaving the owner's real UID in 'uid' unresolved
+    bool readStatusFromProc(int processId, const std::string& procRoot, int& uid);
+    
+    // Read one thread from <procRoot>/<pid>/task/<tid>. The thread is
+    // described as a Process with pid = TID and ppid = the owning PID.
+    bool readThreadFromProc(int processId, int threadId,
+                            const std::string& procRoot = "/proc");
+    
+    // Parse the contents of a status file: the real UID, VmSize, VmRSS
+    // and the voluntary and involuntary context switch counts
+    bool parseStatus(const char* data, size_t length, int& uid);
+    
+    // Parse the contents of a stat file (process or thread): name, state,
+    // ppid, utime, stime, numThreads, starttime, vmSize and vmRSS
+    bool parseStat(const char* data, size_t length);
+    
+    // Read <procRoot>/<pid>/io (own processes, or any as root)
+    bool readIOFromProc(int processId, const std::string& procRoot = "/proc");
+    
+    // Parse the contents of an io file: syscr, syscw, read_bytes, write_bytes
+    bool parseIO(const char* data, size_t length);
+    
+    // Read <procRoot>/<pid>/schedstat
+    bool readSchedFromProc(int processId, const std::string& procRoot = "/proc");
+
+    // Sum <procRoot>/<pid>/task/<tid>/schedstat and the context switch
+    // counts of each task's status over 'threadIds', since the process
+    // files only describe the main thread. False if no thread was read.
+    bool readTaskSchedFromProc(int processId, const std::vector<int>& threadIds,
+                               const std::string& procRoot = "/proc");
+    
+    // Parse the contents of a schedstat file: "run_ns wait_ns timeslices"
+    bool parseSchedstat(const char* data, size_t length);
+    
+    // Calculate CPU percentage based on previous sample
+    void calculateCPU(unsigned long prevUtime, unsigned long prevStime, 
+                     unsigned long totalTimeDiff);
+};
+
+class ProcessSource;
+class FilterExpression;
+
+// Process information collector
+class ProcessManager {
+public:
+    // Read from the default source (the live /proc unless changed)
+    ProcessManager();
+    
+    // Read from a specific source
+    explicit ProcessManager(std::shared_ptr<ProcessSource> source);
+    
+    // Source used by default-constructed managers
+    static void setDefaultSource(std::shared_ptr<ProcessSource> source);
+    static std::shared_ptr<ProcessSource> getDefaultSource();
+    
+    ProcessSource& getSource() { return *source; }
+    
+    // Optional fields read on every scan (ProcessFields bits, DEFAULT
+    // unless changed). Only the files behind them are opened; with IO
+    // the rates are computed against the previous scan.
+    void setFields(unsigned fields) { this->fields = fields; }
+    unsigned getFields() const { return fields; }
+    
+    // True when reading the live system (process actions apply)
+    bool isLive() const;
+    
+    // Get all running processes, or those matching 'filter'
+    std::vector<Process> getAllProcesses(const FilterExpression* filter = nullptr);
+    
+    // Visit every running process (matching 'filter') as it is read,
+    // without building a list. Filter conditions are checked as soon as
+    // the fields they need are read, so a rejected process costs no more
+    // files. The Process passed to the callback is reused between calls.
+    void forEachProcess(const std::function<void(const Process&)>& callback,
+                        const FilterExpression* filter = nullptr);
+    
+    // Get process by PID
+    Process getProcess(int pid);
+    
+    // Read 'fields' of a process taken with fewer fields (I/O without rates)
+    void readFields(Process& proc, unsigned fields);
+    
+    // Read the threads of one process. Threads are only enumerated on
+    // request; CPU% is computed against the previous call for the same
+    // process. False if the process has gone or the source has no threads.
+    bool getThreads(const Process& owner, std::vector<Process>& threads);
+    
+    // Kill a process with specified signal
+    bool killProcess(int pid, int signal = 15); // SIGTERM by default
+    
+    // Change process priority
+    bool setProcessPriority(int pid, int priority);
+    
+    // Get system uptime in seconds
+    double getSystemUptime();
+    
+    // Get total CPU time since boot (for CPU % calculations)
+    unsigned long getTotalCPUTime();
+
+private:
+    std::shared_ptr<ProcessSource> source;
+    std::vector<int> pidBuffer;
+    
+    // Counters from the previous scan, used to compute per-interval deltas
+    struct ProcessSample {
+        unsigned long utime;
+        unsigned long stime;
+        bool hasIO;
+        unsigned long long readBytes;
+        unsigned long long writeBytes;
+        unsigned long long syscr;
+        unsigned long long syscw;
+        bool hasSched;
+        unsigned long long waitNs;
+        unsigned long long voluntarySwitches;
+        unsigned long long involuntarySwitches;
+    };
+    
+    unsigned fields;
+    unsigned long lastTotalCPUTime;
+    double lastUpdateTime;         // Uptime at the last scan collecting rates
+    double elapsedTime;            // Seconds between the last two such scans
+    std::unordered_map<ProcessKey, ProcessSample, ProcessKeyHash> prevSamples;
+    std::unordered_map<ProcessKey, ProcessSample, ProcessKeyHash> nextSamples;
+    unsigned long totalTimeDiff;
+    
+    // Thread counters per owning process, kept while the owner is alive
+    struct ThreadSamples {
+        unsigned long totalTime;
+        std::unordered_map<ProcessKey, ProcessSample, ProcessKeyHash> samples;
+    };
+    
+    std::unordered_map<ProcessKey, ThreadSamples, ProcessKeyHash> threadSamples;
+    std::vector<int> tidBuffer;
+    
+    // Delta engine: compute per-interval values against the previous scan
+    void beginDeltas();
+    void applyDeltas(Process& proc);
+    void applyIODeltas(Process& proc);
+    void applySchedDeltas(Process& proc);
+    void endDeltas();
+    
+    // Helper to read /proc/<pid>/stat
+    bool readStat(int pid, Process& proc);
+    
+    // Helper to read /proc/<pid>/status
+    bool readStatus(int pid, Process& proc);
+    
+    // Helper to get username from UID
+    std::string getUsername(int uid);
+};
@@ -0,0 +1,283 @@
+#include "process_cgroup.hpp"
+#include "process_source.hpp"
+#include "process_profile.hpp"
+#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <unistd.h>
+
+// Locate the cgroup v2 hierarchy: unified, or hybrid with v1
+static std::string findCgroupRoot() {
+    static const char* candidates[] = {"/sys/fs/cgroup", "/sys/fs/cgroup/unified"};
+    for (const char* dir : candidates) {
+        if (access((std::string(dir) + "/cgroup.controllers").c_str(), R_OK) == 0) {
+            return dir;
+        }
+    }
+    return "";
+}
+
+// Format a size in kB as "512K", "812M" or "3.2G"
+static std::string formatKB(long long kb) {
+    char buf[32];
+    if (kb >= 1024 * 1024) {
+        snprintf(buf, sizeof(buf), "%.1fG", kb / (1024.0 * 1024.0));
+    } else if (kb >= 1024) {
+        snprintf(buf, sizeof(buf), "%lldM", kb / 1024);
+    } else {
+        snprintf(buf, sizeof(buf), "%lldK", kb);
+    }
+    return buf;
+}
+
+CgroupTree::CgroupTree(const std::string& cgroupRoot)
+    : cgroupRoot(cgroupRoot.empty() ? findCgroupRoot() : cgroupRoot), lastReadTime(0) {
+    intern("/");
+}
+
+// Interned ID of a path, adding it and its ancestors if new
+int CgroupTree::intern(const std::string& path) {
+    std::string normalized = path;
+    while (normalized.size() > 1 && normalized.back() == '/') {
+        normalized.pop_back();
+    }
+    if (normalized.empty() || normalized[0] != '/') {
+        normalized.insert(normalized.begin(), '/');
+    }
+
+    auto it = pathIds.find(normalized);
+    if (it != pathIds.end()) {
+        return it->second;
+    }
+
+    CgroupNode node;
+    node.path = normalized;
+    if (normalized != "/") {
+        size_t slash = normalized.rfind('/');
+        node.parent = intern(slash == 0 ? "/" : normalized.substr(0, slash));
+        node.name = normalized.substr(slash + 1);
+    } else {
+        node.name = "/";
+    }
+
+    int id = (int)nodes.size();
+    nodes.push_back(node);
+    pathIds[normalized] = id;
+
+    // Keep siblings sorted by name as they are interned
+    if (node.parent >= 0) {
+        std::vector<int>& siblings = nodes[node.parent].children;
+        auto pos = std::lower_bound(siblings.begin(), siblings.end(), id,
+                                    [this](int a, int b) { return nodes[a].name < nodes[b].name; });
+        siblings.insert(pos, id);
+    }
+    return id;
+}
+
+// Group a snapshot by cgroup
+void CgroupTree::build(const std::vector<Process>& processes, ProcessSource& source) {
+    ScopedTimer timer(Profiler::STAGE_CGROUP);
+
+    for (auto& node : nodes) {
+        node.members.clear();
+        node.processCount = 0;
+        node.rssKB = 0;
+        node.cpuPercent = 0.0;
+    }
+
+    // One pass over the snapshot; only new process instances read a file
+    nextMembership.clear();
+    nextMembership.reserve(processes.size());
+    for (const auto& proc : processes) {
+        int id = 0;
+        auto it = membership.find(proc.key());
+        if (it != membership.end()) {
+            id = it->second;
+        } else {
+            std::string path;
+            if (source.readCgroup(proc.pid, path)) {
+                id = intern(path);
+            }
+        }
+        nextMembership[proc.key()] = id;
+
+        CgroupNode& node = nodes[id];
+        node.members.push_back(&proc);
+        node.processCount++;
+        node.rssKB += proc.vmRSS;
+        node.cpuPercent += proc.cpuPercent;
+    }
+    membership.swap(nextMembership);
+
+    // Roll sums up to the ancestors; children always have larger IDs, so
+    // a node's sums are complete by the time it is reached
+    size_t expired = 0;
+    for (int id = (int)nodes.size() - 1; id > 0; id--) {
+        CgroupNode& node = nodes[id];
+        node.idleBuilds = node.processCount > 0 ? 0 : node.idleBuilds + 1;
+        if (node.idleBuilds >= IDLE_BUILDS) {
+            expired++;
+        }
+
+        CgroupNode& parent = nodes[node.parent];
+        parent.processCount += node.processCount;
+        parent.rssKB += node.rssKB;
+        parent.cpuPercent += node.cpuPercent;
+    }
+    if (expired > 0) {
+        compact();
+    }
+
+    // Authoritative totals for the cgroups in use
+    if (!source.isLive() || cgroupRoot.empty()) {
+        return;
+    }
+    int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    double elapsedUsec = lastReadTime > 0 ? (now - lastReadTime) / 1000.0 : 0.0;
+    lastReadTime = now;
+
+    for (auto& node : nodes) {
+        if (node.processCount > 0) {
+            readTotals(node, elapsedUsec);
+        } else {
+            node.cpuUsageUsec = -1;
+            node.cgroupCPUPercent = -1.0;
+        }
+    }
+}
+
+// Drop cgroups idle for IDLE_BUILDS builds, along with their (equally
+// idle) descendants. Order is kept, so parents still precede children and
+// siblings stay sorted; IDs in 'pathIds' and 'membership' are remapped.
+void CgroupTree::compact() {
+    std::vector<char> keep(nodes.size(), 0);
+    keep[0] = 1;
+    for (int id = (int)nodes.size() - 1; id > 0; id--) {
+        if (keep[id] || nodes[id].idleBuilds < IDLE_BUILDS) {
+            keep[id] = 1;
+            keep[nodes[id].parent] = 1;
+        }
+    }
+
+    std::vector<int> remap(nodes.size(), -1);
+    std::vector<CgroupNode> kept;
+    for (size_t id = 0; id < nodes.size(); id++) {
+        if (!keep[id]) {
+            pathIds.erase(nodes[id].path);
+            continue;
+        }
+        remap[id] = (int)kept.size();
+        pathIds[nodes[id].path] = remap[id];
+        kept.push_back(std::move(nodes[id]));
+    }
+
+    for (auto& node : kept) {
+        if (node.parent >= 0) {
+            node.parent = remap[node.parent];
+        }
+        size_t count = 0;
+        for (int child : node.children) {
+            if (remap[child] >= 0) {
+                node.children[count++] = remap[child];
+            }
+        }
+        node.children.resize(count);
+    }
+
+    // Every process of the last build is in a cgroup that was kept
+    for (auto& entry : membership) {
+        entry.second = remap[entry.second];
+    }
+    nodes.swap(kept);
+}
+
+// Read memory.current and cpu.stat for one cgroup
+void CgroupTree::readTotals(CgroupNode& node, double elapsedUsec) {
+    static const long cpus = std::max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+    std::string dir = cgroupRoot + (node.path == "/" ? "" : node.path);
+
+    // The root cgroup has no memory.current
+    node.memoryCurrent = -1;
+    std::ifstream memory(dir + "/memory.current");
+    if (memory.is_open()) {
+        Profiler::add(Profiler::FILES_OPENED, 1);
+        long long value;
+        if (memory >> value) {
+            node.memoryCurrent = value;
+        }
+    }
+
+    long long previous = node.cpuUsageUsec;
+    node.cpuUsageUsec = -1;
+    node.cgroupCPUPercent = -1.0;
+    std::ifstream cpuStat(dir + "/cpu.stat");
+    if (!cpuStat.is_open()) {
+        return;
+    }
+    Profiler::add(Profiler::FILES_OPENED, 1);
+
+    std::string key;
+    long long value;
+    while (cpuStat >> key >> value) {
+        if (key == "usage_usec") {
+            node.cpuUsageUsec = value;
+            break;
+        }
+    }
+    if (previous >= 0 && node.cpuUsageUsec >= previous && elapsedUsec > 0) {
+        node.cgroupCPUPercent = 100.0 * (node.cpuUsageUsec - previous) / (elapsedUsec * cpus);
+    }
+}
+
+// Get the hierarchy as formatted lines
+std::vector<std::string> CgroupTree::getTreeLines(bool showProcesses) const {
+    std::vector<std::string> lines;
+    if (!nodes.empty() && nodes[0].processCount > 0) {
+        getNodeLines(0, "", true, showProcesses, lines);
+    }
+    return lines;
+}
+
+// Format one cgroup and its children recursively. Memory and CPU come
+// from the cgroup files when available, otherwise from the process sums.
+void CgroupTree::getNodeLines(int id, const std::string& prefix, bool isLast,
+                              bool showProcesses, std::vector<std::string>& lines) const {
+    const CgroupNode& node = nodes[id];
+
+    std::string line = prefix;
+    if (id != 0) {
+        line += isLast ? "└── " : "├── ";
+    }
+
+    char stats[160];
+    double cpu = node.cgroupCPUPercent >= 0 ? node.cgroupCPUPercent : node.cpuPercent;
+    snprintf(stats, sizeof(stats), "  [%zu procs, rss %s, mem %s, cpu %.1f%%]",
+             node.processCount, formatKB(node.rssKB).c_str(),
+             node.memoryCurrent >= 0 ? formatKB(node.memoryCurrent / 1024).c_str() : "-",
+             cpu);
+    lines.push_back(line + node.name + stats);
+
+    std::string childPrefix = id == 0 ? "" : prefix + (isLast ? "    " : "│   ");
+
+    std::vector<int> shown;
+    for (int child : node.children) {
+        if (nodes[child].processCount > 0) {
+            shown.push_back(child);
+        }
+    }
+
+    if (showProcesses) {
+        for (size_t i = 0; i < node.members.size(); i++) {
+            const Process* proc = node.members[i];
+            bool last = shown.empty() && i == node.members.size() - 1;
+            lines.push_back(childPrefix + (last ? "└── " : "├── ") + std::to_string(proc->pid) +
+                            " " + proc->name);
+        }
+    }
+
+    for (size_t i = 0; i < shown.size(); i++) {
+        getNodeLines(shown[i], childPrefix, i == shown.size() - 1, showProcesses, lines);
+    }
+}
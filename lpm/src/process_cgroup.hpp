@@ -0,0 +1,79 @@
+#pragma once
+
+#include "process.hpp"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+class ProcessSource;
+
+// One cgroup in the hierarchy. Nodes are indexed by interned path ID;
+// a parent is always interned before its children.
+struct CgroupNode {
+    std::string path;                        // "/system.slice/cron.service"
+    std::string name;                        // Last path component
+    int parent;                              // -1 for the root "/"
+    std::vector<int> children;               // Sorted by name
+    std::vector<const Process*> members;     // Processes directly in this cgroup
+
+    // Sums over the processes in this cgroup and its descendants
+    size_t processCount;
+    long rssKB;
+    double cpuPercent;
+
+    // Totals from the cgroup v2 files (-1 if unavailable)
+    long long memoryCurrent;                 // memory.current, bytes
+    long long cpuUsageUsec;                  // cpu.stat usage_usec
+    double cgroupCPUPercent;                 // usage_usec rate, % of all CPUs (-1 until two builds)
+
+    int idleBuilds;                          // Builds since the cgroup last had processes
+
+    CgroupNode() : parent(-1), processCount(0), rssKB(0), cpuPercent(0.0),
+                   memoryCurrent(-1), cpuUsageUsec(-1), cgroupCPUPercent(-1.0), idleBuilds(0) {}
+};
+
+// Groups a process snapshot by cgroup. Each process instance's cgroup is
+// read once per (pid, starttime) and interned; the grouping is built in
+// one pass over the snapshot plus one pass over the cgroups in use.
+// Cgroups left without processes for IDLE_BUILDS builds are dropped, so
+// a long-running tree does not keep every pod or scope it has seen.
+class CgroupTree {
+public:
+    static const int IDLE_BUILDS = 10;
+
+    // 'cgroupRoot' is where the v2 hierarchy is mounted; totals are only
+    // read for live sources
+    explicit CgroupTree(const std::string& cgroupRoot = "");
+
+    // Group 'processes' (which must outlive the tree's use of members)
+    void build(const std::vector<Process>& processes, ProcessSource& source);
+
+    // Interned cgroups; node 0 is the root "/". IDs may change on build.
+    const std::vector<CgroupNode>& getNodes() const { return nodes; }
+
+    // Interned ID of a path, adding it and its ancestors if new
+    int intern(const std::string& path);
+
+    // Hierarchy as formatted lines; cgroups without processes are skipped
+    std::vector<std::string> getTreeLines(bool showProcesses = false) const;
+
+    // Mount point of the cgroup v2 hierarchy ("" if none was found)
+    const std::string& getCgroupRoot() const { return cgroupRoot; }
+
+private:
+    std::string cgroupRoot;
+    std::vector<CgroupNode> nodes;
+    std::unordered_map<std::string, int> pathIds;
+
+    // Cgroup of every process instance seen in the last build
+    std::unordered_map<ProcessKey, int, ProcessKeyHash> membership;
+    std::unordered_map<ProcessKey, int, ProcessKeyHash> nextMembership;
+
+    int64_t lastReadTime;                    // Monotonic ns of the last totals read
+
+    void compact();
+    void readTotals(CgroupNode& node, double elapsedUsec);
+    void getNodeLines(int id, const std::string& prefix, bool isLast,
+                      bool showProcesses, std::vector<std::string>& lines) const;
+};
@@ -1,104 +1,477 @@
-#include "process_control.hpp"
-#include <signal.h>
-#include <sys/resource.h>
-#include <unistd.h>
-#include <cerrno>
-
-// Send signal to process
-bool ProcessController::sendSignal(int pid, int signal) {
-    if (pid <= 0) {
-        return false;
-    }
-    return (::kill(pid, signal) == 0);
-}
-
-// Terminate process gracefully (SIGTERM)
-bool ProcessController::terminate(int pid) {
-    return sendSignal(pid, SIGTERM);
-}
-
-// Force kill process (SIGKILL)
-bool ProcessController::kill(int pid) {
-    return sendSignal(pid, SIGKILL);
-}
-
-// Stop/suspend process (SIGSTOP)
-bool ProcessController::stop(int pid) {
-    return sendSignal(pid, SIGSTOP);
-}
-
-// Resume stopped process (SIGCONT)
-bool ProcessController::resume(int pid) {
-    return sendSignal(pid, SIGCONT);
-}
-
-// Send interrupt signal (SIGINT)
-bool ProcessController::interrupt(int pid) {
-    return sendSignal(pid, SIGINT);
-}
-
-// Set process priority (nice value: -20 to 19, lower = higher priority)
-bool ProcessController::setPriority(int pid, int niceness) {
-    if (pid <= 0 || niceness < -20 || niceness > 19) {
-        return false;
-    }
-    return (setpriority(PRIO_PROCESS, pid, niceness) == 0);
-}
-
-// Get process priority
-int ProcessController::getPriority(int pid) {
-    if (pid <= 0) {
-        return 0;
-    }
-    
-    errno = 0;
-    int priority = getpriority(PRIO_PROCESS, pid);
-    
-    if (errno != 0) {
-        return 0;
-    }
-    
-    return priority;
-}
-
-// Get signal name from number
-std::string ProcessController::getSignalName(int signal) {
-    switch (signal) {
-        case SIGHUP:    return "SIGHUP";
-        case SIGINT:    return "SIGINT";
-        case SIGQUIT:   return "SIGQUIT";
-        case SIGILL:    return "SIGILL";
-        case SIGTRAP:   return "SIGTRAP";
-        case SIGABRT:   return "SIGABRT";
-        case SIGBUS:    return "SIGBUS";
-        case SIGFPE:    return "SIGFPE";
-        case SIGKILL:   return "SIGKILL";
-        case SIGUSR1:   return "SIGUSR1";
-        case SIGSEGV:   return "SIGSEGV";
-        case SIGUSR2:   return "SIGUSR2";
-        case SIGPIPE:   return "SIGPIPE";
-        case SIGALRM:   return "SIGALRM";
-        case SIGTERM:   return "SIGTERM";
-        case SIGCHLD:   return "SIGCHLD";
-        case SIGCONT:   return "SIGCONT";
-        case SIGSTOP:   return "SIGSTOP";
-        case SIGTSTP:   return "SIGTSTP";
-        case SIGTTIN:   return "SIGTTIN";
-        case SIGTTOU:   return "SIGTTOU";
-        default:        return "UNKNOWN";
-    }
-}
-
-// Get list of common signals for user selection
-std::vector<std::pair<int, std::string>> ProcessController::getCommonSignals() {
-    return {
-        {SIGTERM, "SIGTERM (15) - Terminate gracefully"},
-        {SIGKILL, "SIGKILL (9) - Force kill"},
-        {SIGINT,  "SIGINT (2) - Interrupt"},
-        {SIGHUP,  "SIGHUP (1) - Hangup"},
-        {SIGSTOP, "SIGSTOP (19) - Stop process"},
-        {SIGCONT, "SIGCONT (18) - Continue process"},
-        {SIGUSR1, "SIGUSR1 (10) - User signal 1"},
-        {SIGUSR2, "SIGUSR2 (12) - User signal 2"}
-    };
-}
+#include "process_control.hpp"
+#include "process_pids.hpp"
+#include <signal.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <chrono>
+#include <sched.h>
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+#ifndef SYS_pidfd_send_signal
+#define SYS_pidfd_send_signal 424
+#endif
+
+// ioprio_set(2) constants (no glibc wrapper)
+#define IOPRIO_WHO_PROCESS 1
+#define IOPRIO_CLASS_SHIFT 13
+
+// Read a process's start time from /proc/<pid>/stat, -1 if gone
+static long readStartTime(int pid) {
+    int fd = open(("/proc/" + std::to_string(pid) + "/stat").c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    char buf[1024];
+    ssize_t length = read(fd, buf, sizeof(buf));
+    close(fd);
+    
+    Process proc;
+    if (length <= 0 || !proc.parseStat(buf, length)) {
+        return -1;
+    }
+    return proc.starttime;
+}
+
+// Wait until the pidfds exit or the timeout expires. Exited entries get
+// their status set and their fd closed (set to -1).
+static void waitForExit(std::vector<int>& fds, std::vector<SignalResult*>& results,
+                        SignalResult::Status exitStatus, int timeoutMs) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    
+    std::vector<struct pollfd> pfds(fds.size());
+    size_t remaining = 0;
+    for (size_t i = 0; i < fds.size(); i++) {
+        pfds[i].fd = fds[i];
+        pfds[i].events = POLLIN;
+        if (fds[i] >= 0) {
+            remaining++;
+        }
+    }
+    
+    while (remaining > 0) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (left <= 0) {
+            break;
+        }
+        
+        int ready = poll(pfds.data(), pfds.size(), (int)left);
+        if (ready < 0 && errno != EINTR) {
+            break;
+        }
+        
+        for (size_t i = 0; ready > 0 && i < pfds.size(); i++) {
+            if (pfds[i].fd >= 0 && pfds[i].revents) {
+                results[i]->status = exitStatus;
+                close(fds[i]);
+                fds[i] = -1;
+                pfds[i].fd = -1;  // poll() ignores negative fds
+                remaining--;
+            }
+        }
+    }
+}
+
+// Pidfds held open at once while waiting for exits; larger batches are
+// signalled and waited for in chunks of this size
+static const size_t MAX_PENDING_FDS = 256;
+
+// Signal one target. Returns a pidfd to wait on when 'keep' is set and the
+// signal was sent through one, -1 otherwise.
+static int signalTarget(const ProcessKey& target, int signal, bool keep, SignalResult& result) {
+    result.target = target;
+    if (target.pid <= 0) {
+        result.status = SignalResult::FAILED;
+        result.error = EINVAL;
+        return -1;
+    }
+    
+    int fd = syscall(SYS_pidfd_open, target.pid, 0);
+    if (fd < 0 && errno != ENOSYS) {
+        // Out of fds, permission or memory: never fall back to a racy kill()
+        result.status = errno == ESRCH ? SignalResult::GONE : SignalResult::FAILED;
+        result.error = errno == ESRCH ? 0 : errno;
+        return -1;
+    }
+    
+    // The pidfd pins the process, so checking starttime after opening
+    // proves the fd refers to the process from the snapshot
+    if (readStartTime(target.pid) != target.starttime) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        result.status = SignalResult::GONE;
+        return -1;
+    }
+    
+    int rc;
+    if (fd >= 0) {
+        rc = syscall(SYS_pidfd_send_signal, fd, signal, nullptr, 0);
+    } else {
+        // No pidfd support (ENOSYS, kernel < 5.3): best-effort plain kill()
+        rc = ::kill(target.pid, signal);
+    }
+    
+    if (rc != 0) {
+        result.status = (errno == ESRCH) ? SignalResult::GONE : SignalResult::FAILED;
+        result.error = errno;
+    } else {
+        result.status = SignalResult::SENT;
+    }
+    if (fd >= 0 && (rc != 0 || !keep)) {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+// Send a signal to many processes through pidfds
+std::vector<SignalResult> ProcessController::sendSignalBatch(const std::vector<ProcessKey>& targets,
+                                                            const SignalOptions& options) {
+    std::vector<SignalResult> results(targets.size());
+    bool wait = options.timeoutMs > 0;
+    bool escalate = options.escalate && options.signal != SIGKILL;
+    std::vector<int> fds;
+    std::vector<SignalResult*> pending;
+    
+    for (size_t i = 0; i < targets.size(); ) {
+        fds.clear();
+        pending.clear();
+        for (; i < targets.size() && fds.size() < MAX_PENDING_FDS; i++) {
+            int fd = signalTarget(targets[i], options.signal, wait, results[i]);
+            if (fd >= 0) {
+                fds.push_back(fd);
+                pending.push_back(&results[i]);
+            }
+        }
+        if (fds.empty()) {
+            continue;
+        }
+        
+        waitForExit(fds, pending, SignalResult::EXITED, options.timeoutMs);
+        for (size_t j = 0; j < fds.size(); j++) {
+            if (fds[j] < 0) {
+                continue;
+            }
+            pending[j]->status = SignalResult::RUNNING;
+            if (escalate && syscall(SYS_pidfd_send_signal, fds[j], SIGKILL, nullptr, 0) != 0) {
+                pending[j]->error = errno;
+            }
+        }
+        if (escalate) {
+            waitForExit(fds, pending, SignalResult::KILLED, options.killTimeoutMs);
+        }
+        
+        for (int fd : fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+    
+    return results;
+}
+
+// Get name of a batch result status
+std::string ProcessController::getStatusName(SignalResult::Status status) {
+    switch (status) {
+        case SignalResult::SENT:    return "sent";
+        case SignalResult::EXITED:  return "exited";
+        case SignalResult::KILLED:  return "killed";
+        case SignalResult::RUNNING: return "still running";
+        case SignalResult::GONE:    return "gone";
+        case SignalResult::FAILED:  return "failed";
+        default:                    return "unknown";
+    }
+}
+
+// Send signal to process
+bool ProcessController::sendSignal(int pid, int signal) {
+    if (pid <= 0) {
+        return false;
+    }
+    return (::kill(pid, signal) == 0);
+}
+
+// Terminate process gracefully (SIGTERM)
+bool ProcessController::terminate(int pid) {
+    return sendSignal(pid, SIGTERM);
+}
+
+// Force kill process (SIGKILL)
+bool ProcessController::kill(int pid) {
+    return sendSignal(pid, SIGKILL);
+}
+
+// Stop/suspend process (SIGSTOP)
+bool ProcessController::stop(int pid) {
+    return sendSignal(pid, SIGSTOP);
+}
+
+// Resume stopped process (SIGCONT)
+bool ProcessController::resume(int pid) {
+    return sendSignal(pid, SIGCONT);
+}
+
+// Send interrupt signal (SIGINT)
+bool ProcessController::interrupt(int pid) {
+    return sendSignal(pid, SIGINT);
+}
+
+// Apply scheduling changes to every thread of each target
+std::vector<ControlResult> ProcessController::applyBatch(const std::vector<ProcessKey>& targets,
+                                                        const ControlAction& action) {
+    std::vector<ControlResult> results(targets.size());
+    
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (int cpu : action.cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &cpuSet);
+        }
+    }
+    
+    struct sched_param param;
+    param.sched_priority = action.rtPriority;
+    int ioprio = (action.ioClass << IOPRIO_CLASS_SHIFT) | action.ioLevel;
+    PidEnumerator taskEnumerator(16 * 1024);
+    std::vector<int> tids;
+    
+    for (size_t i = 0; i < targets.size(); i++) {
+        ControlResult& result = results[i];
+        result.target = targets[i];
+        
+        if (targets[i].pid <= 0 || readStartTime(targets[i].pid) != targets[i].starttime) {
+            result.gone = true;
+            continue;
+        }
+        
+        // Nice, affinity, policy and I/O priority are all per-thread on Linux
+        tids.clear();
+        taskEnumerator.list("/proc/" + std::to_string(targets[i].pid) + "/task", tids);
+        for (int tid : tids) {
+            bool ok = true;
+            auto fail = [&]() {
+                if (result.error == 0) {
+                    result.error = errno;
+                }
+                ok = false;
+            };
+            
+            if (action.setNice && setpriority(PRIO_PROCESS, tid, action.nice) != 0) {
+                fail();
+            }
+            if (action.setAffinity && sched_setaffinity(tid, sizeof(cpuSet), &cpuSet) != 0) {
+                fail();
+            }
+            if (action.setPolicy && sched_setscheduler(tid, action.policy, &param) != 0) {
+                fail();
+            }
+            if (action.setIOPriority &&
+                syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, tid, ioprio) != 0) {
+                fail();
+            }
+            
+            result.threads++;
+            if (!ok) {
+                result.failures++;
+            }
+        }
+        
+        // The process exited before any thread could be changed
+        if (result.threads == 0) {
+            result.gone = true;
+            continue;
+        }
+        
+        // These calls take plain IDs, so the PID could have been reused
+        // between the check above and the changes. A process still there
+        // with the same starttime never exited, so its PID was not reused.
+        if (readStartTime(targets[i].pid) != targets[i].starttime) {
+            result.raced = true;
+        }
+    }
+    
+    return results;
+}
+
+// Parse a CPU list such as "0-3,6"
+bool ProcessController::parseCPUList(const std::string& text, std::vector<int>& cpus) {
+    cpus.clear();
+    size_t pos = 0;
+    
+    while (pos < text.size()) {
+        size_t comma = text.find(',', pos);
+        std::string part = text.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        pos = (comma == std::string::npos) ? text.size() : comma + 1;
+        
+        char* end = nullptr;
+        long first = std::strtol(part.c_str(), &end, 10);
+        long last = first;
+        if (end == part.c_str()) {
+            return false;
+        }
+        if (*end == '-') {
+            const char* rangeStart = end + 1;
+            last = std::strtol(rangeStart, &end, 10);
+            if (end == rangeStart) {
+                return false;
+            }
+        }
+        if (*end != '\0' || first < 0 || last < first || last >= CPU_SETSIZE) {
+            return false;
+        }
+        
+        for (long cpu = first; cpu <= last; cpu++) {
+            cpus.push_back((int)cpu);
+        }
+    }
+    
+    return !cpus.empty();
+}
+
+// Parse a scheduling policy "other|batch|idle|fifo:PRIO|rr:PRIO"
+bool ProcessController::parsePolicy(const std::string& text, int& policy, int& rtPriority) {
+    std::string name = text.substr(0, text.find(':'));
+    rtPriority = 0;
+    
+    if (name == "other" || name == "normal") {
+        policy = SCHED_OTHER;
+    } else if (name == "batch") {
+        policy = SCHED_BATCH;
+    } else if (name == "idle") {
+        policy = SCHED_IDLE;
+    } else if (name == "fifo" || name == "rr") {
+        policy = (name == "fifo") ? SCHED_FIFO : SCHED_RR;
+        size_t colon = text.find(':');
+        rtPriority = (colon == std::string::npos) ? 1 : std::atoi(text.c_str() + colon + 1);
+        return rtPriority >= 1 && rtPriority <= 99;
+    } else {
+        return false;
+    }
+    
+    return name.size() == text.size();
+}
+
+// Parse an I/O priority "rt:LEVEL|be:LEVEL|idle"
+bool ProcessController::parseIOPriority(const std::string& text, int& ioClass, int& ioLevel) {
+    std::string name = text.substr(0, text.find(':'));
+    size_t colon = text.find(':');
+    ioLevel = (colon == std::string::npos) ? 4 : std::atoi(text.c_str() + colon + 1);
+    
+    if (name == "rt" || name == "realtime") {
+        ioClass = 1;
+    } else if (name == "be" || name == "best-effort") {
+        ioClass = 2;
+    } else if (name == "idle") {
+        ioClass = 3;
+        ioLevel = 0;
+    } else {
+        return false;
+    }
+    
+    return ioLevel >= 0 && ioLevel <= 7;
+}
+
+// Set process priority (nice value: -20 to 19, lower = higher priority)
+bool ProcessController::setPriority(int pid, int niceness) {
+    if (pid <= 0 || niceness < -20 || niceness > 19) {
+        return false;
+    }
+    return (setpriority(PRIO_PROCESS, pid, niceness) == 0);
+}
+
+// Get process priority
+int ProcessController::getPriority(int pid) {
+    if (pid <= 0) {
+        return 0;
+    }
+    
+    errno = 0;
+    int priority = getpriority(PRIO_PROCESS, pid);
+    
+    if (errno != 0) {
+        return 0;
+    }
+    
+    return priority;
+}
+
+// Get signal name from number
+std::string ProcessController::getSignalName(int signal) {
+    switch (signal) {
+        case SIGHUP:    return "SIGHUP";
+        case SIGINT:    return "SIGINT";
+        case SIGQUIT:   return "SIGQUIT";
+        case SIGILL:    return "SIGILL";
+        case SIGTRAP:   return "SIGTRAP";
+        case SIGABRT:   return "SIGABRT";
+        case SIGBUS:    return "SIGBUS";
+        case SIGFPE:    return "SIGFPE";
+        case SIGKILL:   return "SIGKILL";
+        case SIGUSR1:   return "SIGUSR1";
+        case SIGSEGV:   return "SIGSEGV";
+        case SIGUSR2:   return "SIGUSR2";
+        case SIGPIPE:   return "SIGPIPE";
+        case SIGALRM:   return "SIGALRM";
+        case SIGTERM:   return "SIGTERM";
+        case SIGCHLD:   return "SIGCHLD";
+        case SIGCONT:   return "SIGCONT";
+        case SIGSTOP:   return "SIGSTOP";
+        case SIGTSTP:   return "SIGTSTP";
+        case SIGTTIN:   return "SIGTTIN";
+        case SIGTTOU:   return "SIGTTOU";
+        default:        return "UNKNOWN";
+    }
+}
+
+// Parse a signal name (with or without "SIG") or number
+bool ProcessController::parseSignal(const std::string& text, int& signal) {
+    if (!text.empty() && std::isdigit((unsigned char)text[0])) {
+        char* end = nullptr;
+        long value = std::strtol(text.c_str(), &end, 10);
+        if (*end != '\0' || value <= 0 || value >= NSIG) {
+            return false;
+        }
+        signal = (int)value;
+        return true;
+    }
+    
+    std::string name;
+    for (char c : text) {
+        name += (char)std::toupper((unsigned char)c);
+    }
+    if (name.compare(0, 3, "SIG") != 0) {
+        name = "SIG" + name;
+    }
+    for (int candidate = 1; candidate < 32; candidate++) {
+        if (getSignalName(candidate) == name) {
+            signal = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Get list of common signals for user selection
+std::vector<std::pair<int, std::string>> ProcessController::getCommonSignals() {
+    return {
+        {SIGTERM, "SIGTERM (15) - Terminate gracefully"},
+        {SIGKILL, "SIGKILL (9) - Force kill"},
+        {SIGINT,  "SIGINT (2) - Interrupt"},
+        {SIGHUP,  "SIGHUP (1) - Hangup"},
+        {SIGSTOP, "SIGSTOP (19) - Stop process"},
+        {SIGCONT, "SIGCONT (18) - Continue process"},
+        {SIGUSR1, "SIGUSR1 (10) - User signal 1"},
+        {SIGUSR2, "SIGUSR2 (12) - User signal 2"}
+    };
+}
@@ -1,29 +1,122 @@
-#pragma once
-
-#include "process.hpp"
-#include <vector>
-#include <string>
-
-// Process control operations
-class ProcessController {
-public:
-    // Send signal to process
-    static bool sendSignal(int pid, int signal);
-    
-    // Common signal operations
-    static bool terminate(int pid);      // SIGTERM (15)
-    static bool kill(int pid);           // SIGKILL (9)
-    static bool stop(int pid);           // SIGSTOP (19)
-    static bool resume(int pid);         // SIGCONT (18)
-    static bool interrupt(int pid);      // SIGINT (2)
-    
-    // Change process priority
-    static bool setPriority(int pid, int niceness);
-    static int getPriority(int pid);
-    
-    // Get signal name from number
-    static std::string getSignalName(int signal);
-    
-    // Get list of common signals
-    static std::vector<std::pair<int, std::string>> getCommonSignals();
-};
+#pragma once
+
+#include "process.hpp"
+#include <vector>
+#include <string>
+
+// Outcome of a batch signal for one target
+struct SignalResult {
+    enum Status {
+        SENT,           // Signal delivered, not waited for
+        EXITED,         // Exited after the signal
+        KILLED,         // Exited after escalation to SIGKILL
+        RUNNING,        // Still running after the timeout
+        GONE,           // Not found, or PID now belongs to another process
+        FAILED          // Delivery failed (see error)
+    };
+    
+    ProcessKey target;
+    Status status;
+    int error;          // errno for FAILED
+    
+    SignalResult() : status(FAILED), error(0) {}
+};
+
+// Options for batch signal delivery
+struct SignalOptions {
+    int signal;
+    int timeoutMs;      // Wait up to this long for exit (0 = don't wait)
+    bool escalate;      // Send SIGKILL to survivors after the timeout
+    int killTimeoutMs;  // Wait after SIGKILL
+    
+    SignalOptions() : signal(15), timeoutMs(0), escalate(false), killTimeoutMs(1000) {}
+};
+
+// Scheduling changes applied by ProcessController::applyBatch
+struct ControlAction {
+    bool setNice;
+    int nice;                   // -20 to 19
+    
+    bool setAffinity;
+    std::vector<int> cpus;      // CPUs to pin to
+    
+    bool setPolicy;
+    int policy;                 // SCHED_OTHER, SCHED_BATCH, SCHED_IDLE, SCHED_FIFO, SCHED_RR
+    int rtPriority;             // 1-99 for FIFO/RR, 0 otherwise
+    
+    bool setIOPriority;
+    int ioClass;                // 1 = realtime, 2 = best-effort, 3 = idle
+    int ioLevel;                // 0 (highest) to 7
+    
+    ControlAction() : setNice(false), nice(0), setAffinity(false),
+                      setPolicy(false), policy(0), rtPriority(0),
+                      setIOPriority(false), ioClass(2), ioLevel(4) {}
+};
+
+// Outcome of a batch control action for one target
+struct ControlResult {
+    ProcessKey target;
+    bool gone;          // Not found, or PID now belongs to another process
+    int threads;        // Threads the action was applied to
+    int failures;       // Threads where at least one change failed
+    int error;          // First errno seen
+    bool raced;         // Exited while being changed; a new process reusing
+                        // the PID may have received some of the changes
+    
+    ControlResult() : gone(false), threads(0), failures(0), error(0), raced(false) {}
+};
+
+// Process control operations
+class ProcessController {
+public:
+    // Send a signal to many processes. Each target is opened as a pidfd
+    // and its starttime verified, so a recycled PID is never signalled;
+    // plain kill() is only used where the kernel lacks pidfds (ENOSYS).
+    // With a timeout, targets are waited for in chunks of up to 256 open
+    // pidfds, so each chunk may take up to the timeout.
+    static std::vector<SignalResult> sendSignalBatch(const std::vector<ProcessKey>& targets,
+                                                     const SignalOptions& options);
+    
+    // Human-readable name of a batch result status
+    static std::string getStatusName(SignalResult::Status status);
+    
+
+    // Send signal to process
+    static bool sendSignal(int pid, int signal);
+    
+    // Common signal operations
+    static bool terminate(int pid);      // SIGTERM (15)
+    static bool kill(int pid);           // SIGKILL (9)
+    static bool stop(int pid);           // SIGSTOP (19)
+    static bool resume(int pid);         // SIGCONT (18)
+    static bool interrupt(int pid);      // SIGINT (2)
+    
+    // Apply nice, CPU affinity, scheduling policy and I/O priority to
+    // every thread of each target. Targets whose starttime no longer
+    // matches are reported as gone and left untouched; starttime is
+    // checked again afterwards to report targets that exited mid-change.
+    static std::vector<ControlResult> applyBatch(const std::vector<ProcessKey>& targets,
+                                                 const ControlAction& action);
+    
+    // Parse a CPU list such as "0-3,6"
+    static bool parseCPUList(const std::string& text, std::vector<int>& cpus);
+    
+    // Parse a scheduling policy "other|batch|idle|fifo:PRIO|rr:PRIO"
+    static bool parsePolicy(const std::string& text, int& policy, int& rtPriority);
+    
+    // Parse an I/O priority "rt:LEVEL|be:LEVEL|idle"
+    static bool parseIOPriority(const std::string& text, int& ioClass, int& ioLevel);
+    
+    // Change process priority
+    static bool setPriority(int pid, int niceness);
+    static int getPriority(int pid);
+    
+    // Get signal name from number
+    static std::string getSignalName(int signal);
+    
+    // Parse a signal given as "SIGTERM", "TERM" or "15"
+    static bool parseSignal(const std::string& text, int& signal);
+    
+    // Get list of common signals
+    static std::vector<std::pair<int, std::string>> getCommonSignals();
+};
@@ -0,0 +1,345 @@
+#include "process_details.hpp"
+#include "process_profile.hpp"
+#include <fstream>
+#include <sstream>
+#include <iterator>
+#include <filesystem>
+#include <algorithm>
+#include <cctype>
+#include <unistd.h>
+
+// Read an entire /proc file into a string
+static bool readWholeFile(const std::string& path, std::string& out) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    out.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    Profiler::add(Profiler::FILES_OPENED, 1);
+    Profiler::add(Profiler::BYTES_READ, out.size());
+    return true;
+}
+
+// ProcessDetails constructor
+ProcessDetails::ProcessDetails()
+    : pid(0), starttime(0), environBytes(0), environCount(0), fdCount(-1),
+      smapsAvailable(false), rss(0), pss(0), pssAnon(0), pssFile(0), pssShmem(0),
+      sharedClean(0), sharedDirty(0), privateClean(0), privateDirty(0),
+      swap(0), swapPss(0),
+      ioAvailable(false), rchar(0), wchar(0), syscr(0), syscw(0),
+      readBytes(0), writeBytes(0), cancelledWriteBytes(0), exited(false) {
+}
+
+// Read all details for a process
+bool ProcessDetails::load(int processId, const std::string& procRoot) {
+    Process proc;
+    if (!proc.readFromProc(processId, procRoot, ProcessFields::NONE)) {
+        return false;
+    }
+
+    pid = processId;
+    starttime = proc.starttime;
+    name = proc.name;
+    exited = proc.state == "Z" || proc.state == "X";
+
+    std::string base = procRoot + "/" + std::to_string(pid);
+    std::error_code ec;
+
+    // Command line: NUL-separated arguments
+    std::string raw;
+    if (readWholeFile(base + "/cmdline", raw)) {
+        while (!raw.empty() && raw.back() == '\0') {
+            raw.pop_back();
+        }
+        std::replace(raw.begin(), raw.end(), '\0', ' ');
+        cmdline = raw.empty() ? "[" + name + "]" : raw;
+    } else {
+        cmdline = "N/A";
+    }
+
+    cwd = std::filesystem::read_symlink(base + "/cwd", ec).string();
+    if (ec) {
+        cwd = "N/A";
+    }
+
+    exe = std::filesystem::read_symlink(base + "/exe", ec).string();
+    if (ec) {
+        exe = "N/A";
+    }
+
+    // Environment: NUL-terminated entries
+    if (readWholeFile(base + "/environ", raw)) {
+        environBytes = raw.size();
+        environCount = std::count(raw.begin(), raw.end(), '\0');
+    }
+
+    // Count open file descriptors
+    fdCount = 0;
+    std::filesystem::directory_iterator fdIt(base + "/fd", ec);
+    if (ec) {
+        fdCount = -1;
+    } else {
+        for (; fdIt != std::filesystem::directory_iterator(); fdIt.increment(ec)) {
+            if (ec) break;
+            fdCount++;
+        }
+    }
+
+    // Cgroup: prefer the unified (v2) hierarchy entry "0::/path"
+    std::ifstream cgroupFile(base + "/cgroup");
+    std::string line;
+    while (std::getline(cgroupFile, line)) {
+        if (line.compare(0, 3, "0::") == 0) {
+            cgroup = line.substr(3);
+            break;
+        }
+        if (cgroup.empty()) {
+            cgroup = line;
+        }
+    }
+
+    readSmapsRollup(pid, procRoot, *this);
+    readIO(pid, procRoot, *this);
+    readThreads(pid, procRoot, threads);
+
+    return true;
+}
+
+// Read memory breakdown from <procRoot>/<pid>/smaps_rollup
+bool ProcessDetails::readSmapsRollup(int pid, const std::string& procRoot,
+                                     ProcessDetails& details) {
+    std::ifstream file(procRoot + "/" + std::to_string(pid) + "/smaps_rollup");
+    if (!file.is_open()) {
+        details.smapsAvailable = false;
+        return false;
+    }
+    Profiler::add(Profiler::FILES_OPENED, 1);
+
+    static const struct {
+        const char* key;
+        long ProcessDetails::* field;
+    } fields[] = {
+        {"Rss:",           &ProcessDetails::rss},
+        {"Pss:",           &ProcessDetails::pss},
+        {"Pss_Anon:",      &ProcessDetails::pssAnon},
+        {"Pss_File:",      &ProcessDetails::pssFile},
+        {"Pss_Shmem:",     &ProcessDetails::pssShmem},
+        {"Shared_Clean:",  &ProcessDetails::sharedClean},
+        {"Shared_Dirty:",  &ProcessDetails::sharedDirty},
+        {"Private_Clean:", &ProcessDetails::privateClean},
+        {"Private_Dirty:", &ProcessDetails::privateDirty},
+        {"Swap:",          &ProcessDetails::swap},
+        {"SwapPss:",       &ProcessDetails::swapPss},
+    };
+
+    std::string line;
+    bool found = false;
+    while (std::getline(file, line)) {
+        for (const auto& f : fields) {
+            size_t len = std::char_traits<char>::length(f.key);
+            if (line.compare(0, len, f.key) == 0) {
+                details.*(f.field) = std::atol(line.c_str() + len);
+                found = true;
+                break;
+            }
+        }
+    }
+
+    details.smapsAvailable = found;
+    return found;
+}
+
+// Read I/O counters from <procRoot>/<pid>/io (requires same user or root)
+bool ProcessDetails::readIO(int pid, const std::string& procRoot, ProcessDetails& details) {
+    std::ifstream file(procRoot + "/" + std::to_string(pid) + "/io");
+    if (!file.is_open()) {
+        details.ioAvailable = false;
+        return false;
+    }
+    Profiler::add(Profiler::FILES_OPENED, 1);
+
+    std::string key;
+    unsigned long long value;
+    bool found = false;
+    while (file >> key >> value) {
+        found = true;
+        if (key == "rchar:") details.rchar = value;
+        else if (key == "wchar:") details.wchar = value;
+        else if (key == "syscr:") details.syscr = value;
+        else if (key == "syscw:") details.syscw = value;
+        else if (key == "read_bytes:") details.readBytes = value;
+        else if (key == "write_bytes:") details.writeBytes = value;
+        else if (key == "cancelled_write_bytes:") details.cancelledWriteBytes = value;
+    }
+
+    details.ioAvailable = found;
+    return found;
+}
+
+// Read per-thread CPU times from <procRoot>/<pid>/task/<tid>/stat
+void ProcessDetails::readThreads(int pid, const std::string& procRoot,
+                                 std::vector<ThreadInfo>& threads) {
+    threads.clear();
+
+    std::error_code ec;
+    std::string taskPath = procRoot + "/" + std::to_string(pid) + "/task";
+    std::filesystem::directory_iterator it(taskPath, ec);
+    if (ec) {
+        return;
+    }
+
+    for (; it != std::filesystem::directory_iterator(); it.increment(ec)) {
+        if (ec) break;
+
+        // Same stat parser as the process scan
+        Process stat;
+        int tid = std::atoi(it->path().filename().c_str());
+        if (tid <= 0 || !stat.readThreadFromProc(pid, tid, procRoot)) {
+            continue;
+        }
+
+        ThreadInfo thread;
+        thread.tid = tid;
+        thread.name = stat.name;
+        thread.state = stat.state;
+        thread.utime = stat.utime;
+        thread.stime = stat.stime;
+
+        threads.push_back(thread);
+    }
+
+    std::sort(threads.begin(), threads.end(),
+             [](const ThreadInfo& a, const ThreadInfo& b) { return a.tid < b.tid; });
+}
+
+// ProcessDetailsLoader constructor - starts the worker thread
+ProcessDetailsLoader::ProcessDetailsLoader()
+    : stopping(false), pending(false), loading(false), hasResult(false), exited(false),
+      prevPid(0), prevStarttime(0) {
+    worker = std::thread(&ProcessDetailsLoader::workerLoop, this);
+}
+
+// Stop and join the worker thread
+ProcessDetailsLoader::~ProcessDetailsLoader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_one();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+// Request details for a process
+void ProcessDetailsLoader::request(const Process& proc, unsigned long tick,
+                                   const std::string& procRoot) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (wanted.pid == proc.pid && wanted.starttime == proc.starttime &&
+        wanted.tick == tick && wanted.procRoot == procRoot && (pending || loading || hasResult)) {
+        return; // Already cached or in flight for this tick
+    }
+
+    wanted.pid = proc.pid;
+    wanted.starttime = proc.starttime;
+    wanted.tick = tick;
+    wanted.procRoot = procRoot;
+    pending = true;
+    cv.notify_one();
+}
+
+// Get the latest details for the requested process
+bool ProcessDetailsLoader::get(ProcessDetails& out, bool& exited) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Stale results for another process are never shown
+    if (!hasResult || loaded.pid != wanted.pid || loaded.starttime != wanted.starttime ||
+        loaded.procRoot != wanted.procRoot) {
+        return false;
+    }
+
+    out = result;
+    exited = this->exited || result.exited;
+    return true;
+}
+
+// Get the last details loaded, whichever process they belong to
+bool ProcessDetailsLoader::getLast(ProcessDetails& out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!hasResult) {
+        return false;
+    }
+    out = result;
+    return true;
+}
+
+// Check whether a load is in progress
+bool ProcessDetailsLoader::isLoading() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending || loading;
+}
+
+// Background loop: load the most recent request, dropping superseded ones
+void ProcessDetailsLoader::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        cv.wait(lock, [this] { return stopping || pending; });
+        if (stopping) {
+            break;
+        }
+
+        Request req = wanted;
+        pending = false;
+        loading = true;
+        lock.unlock();
+
+        ProcessDetails details;
+        bool ok = details.load(req.pid, req.procRoot) && details.starttime == req.starttime;
+        if (ok) {
+            computeThreadCPU(details);
+        }
+
+        lock.lock();
+        loading = false;
+        bool seen = hasResult && loaded.pid == req.pid && loaded.starttime == req.starttime &&
+                    loaded.procRoot == req.procRoot;
+        if (seen && (!ok || details.exited)) {
+            // Gone, a zombie or its PID reused since the last load: the
+            // details read while it ran say more than what is left
+            exited = true;
+        } else if (ok) {
+            result = std::move(details);
+            loaded = req;
+            hasResult = true;
+            exited = false;
+        }
+    }
+}
+
+// Compute per-thread CPU% from the previous load of the same process.
+// Only called from the worker thread.
+void ProcessDetailsLoader::computeThreadCPU(ProcessDetails& details) {
+    auto now = std::chrono::steady_clock::now();
+    bool samePrev = (prevPid == details.pid && prevStarttime == details.starttime);
+    double elapsed = std::chrono::duration<double>(now - prevSampleTime).count();
+    static const long ticksPerSecond = sysconf(_SC_CLK_TCK);
+
+    std::map<int, unsigned long> times;
+    for (auto& thread : details.threads) {
+        unsigned long total = thread.utime + thread.stime;
+        times[thread.tid] = total;
+
+        auto it = prevThreadTimes.find(thread.tid);
+        if (samePrev && elapsed > 0 && it != prevThreadTimes.end() && total >= it->second) {
+            thread.cpuPercent = 100.0 * (total - it->second) / (elapsed * ticksPerSecond);
+        }
+    }
+
+    prevPid = details.pid;
+    prevStarttime = details.starttime;
+    prevThreadTimes.swap(times);
+    prevSampleTime = now;
+}
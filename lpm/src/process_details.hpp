@@ -0,0 +1,137 @@
+#pragma once
+
+#include "process.hpp"
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+// Per-thread information from /proc/<pid>/task/<tid>/stat
+struct ThreadInfo {
+    int tid;
+    std::string name;
+    std::string state;
+    unsigned long utime;
+    unsigned long stime;
+    double cpuPercent;
+
+    ThreadInfo() : tid(0), utime(0), stime(0), cpuPercent(0.0) {}
+};
+
+// Expensive per-process information, only collected for a single PID
+struct ProcessDetails {
+    int pid;
+    long starttime;
+    std::string name;
+
+    std::string cmdline;
+    std::string cwd;
+    std::string exe;
+    std::string cgroup;
+    size_t environBytes;   // Size of /proc/<pid>/environ
+    int environCount;      // Number of environment variables
+    int fdCount;           // Open file descriptors (-1 if not readable)
+
+    // Memory breakdown from /proc/<pid>/smaps_rollup (kB)
+    bool smapsAvailable;
+    long rss;
+    long pss;
+    long pssAnon;
+    long pssFile;
+    long pssShmem;
+    long sharedClean;
+    long sharedDirty;
+    long privateClean;
+    long privateDirty;
+    long swap;
+    long swapPss;
+
+    // I/O counters from /proc/<pid>/io (bytes / syscalls)
+    bool ioAvailable;
+    unsigned long long rchar;
+    unsigned long long wchar;
+    unsigned long long syscr;
+    unsigned long long syscw;
+    unsigned long long readBytes;
+    unsigned long long writeBytes;
+    unsigned long long cancelledWriteBytes;
+
+    std::vector<ThreadInfo> threads;
+
+    bool exited;           // Zombie: the details are what is left of it
+
+    ProcessDetails();
+
+    // Read all details for a process from <procRoot>/<pid> (synchronous).
+    // Files missing from a captured tree leave their fields unavailable.
+    bool load(int processId, const std::string& procRoot = "/proc");
+
+    // Read memory breakdown from smaps_rollup
+    static bool readSmapsRollup(int pid, const std::string& procRoot, ProcessDetails& details);
+
+    // Read I/O counters
+    static bool readIO(int pid, const std::string& procRoot, ProcessDetails& details);
+
+    // Read per-thread CPU times
+    static void readThreads(int pid, const std::string& procRoot, std::vector<ThreadInfo>& threads);
+};
+
+// Loads ProcessDetails on a background thread and caches the result
+// for the current refresh tick, so the UI thread never blocks on /proc.
+// Once the process has exited, the last details loaded stay available.
+class ProcessDetailsLoader {
+public:
+    ProcessDetailsLoader();
+    ~ProcessDetailsLoader();
+
+    // Request details for a process under 'procRoot' (the source's
+    // directory); no-op if already cached for this tick
+    void request(const Process& proc, unsigned long tick,
+                 const std::string& procRoot = "/proc");
+
+    // Copy the latest loaded details for the requested process, with
+    // 'exited' set once a later load found it gone (or a zombie).
+    // Returns false if nothing has been loaded for it yet.
+    bool get(ProcessDetails& out, bool& exited);
+
+    // Copy the last details loaded for any process; false if none
+    bool getLast(ProcessDetails& out);
+
+    // True while a load is in progress
+    bool isLoading();
+
+private:
+    struct Request {
+        int pid;
+        long starttime;
+        unsigned long tick;
+        std::string procRoot;
+
+        Request() : pid(0), starttime(0), tick(0) {}
+    };
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping;
+    bool pending;
+    bool loading;
+
+    Request wanted;        // Most recent request from the UI
+    Request loaded;        // Request that produced 'result'
+    bool hasResult;
+    bool exited;           // The last load of 'loaded' found it gone
+    ProcessDetails result;
+
+    // Previous thread CPU times for per-thread CPU% deltas
+    int prevPid;
+    long prevStarttime;
+    std::map<int, unsigned long> prevThreadTimes;
+    std::chrono::steady_clock::time_point prevSampleTime;
+
+    void workerLoop();
+    void computeThreadCPU(ProcessDetails& details);
+};
@@ -0,0 +1,286 @@
+#include "process_events.hpp"
+#include "process_profile.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/connector.h>
+#include <linux/cn_proc.h>
+
+// Short-lived processes kept between takeShortLived() calls
+static const size_t MAX_SHORT_LIVED = 10000;
+
+ProcessEventSource::ProcessEventSource()
+    : socketFd(-1), resync(true), primed(false), buffer(64 * 1024) {
+}
+
+ProcessEventSource::~ProcessEventSource() {
+    if (socketFd >= 0) {
+        close(socketFd);
+    }
+}
+
+// Subscribe to the proc connector multicast group
+bool ProcessEventSource::start(std::string& error) {
+    if (socketFd >= 0) {
+        return true;
+    }
+
+    int fd = socket(PF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_CONNECTOR);
+    if (fd < 0) {
+        error = std::string("netlink socket: ") + strerror(errno);
+        return false;
+    }
+
+    // Bursts of thousands of forks per second arrive between scans; ask for
+    // a large buffer (beyond rmem_max when privileged)
+    int size = 8 * 1024 * 1024;
+    if (setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)) < 0) {
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    }
+
+    struct sockaddr_nl addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = CN_IDX_PROC;
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        error = std::string("netlink bind: ") + strerror(errno);
+        close(fd);
+        return false;
+    }
+
+    // nlmsghdr + cn_msg + PROC_CN_MCAST_LISTEN
+    char request[NLMSG_SPACE(sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op))];
+    memset(request, 0, sizeof(request));
+    struct nlmsghdr* header = (struct nlmsghdr*)request;
+    header->nlmsg_len = NLMSG_LENGTH(sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op));
+    header->nlmsg_type = NLMSG_DONE;
+    header->nlmsg_pid = getpid();
+
+    struct cn_msg* message = (struct cn_msg*)NLMSG_DATA(header);
+    message->id.idx = CN_IDX_PROC;
+    message->id.val = CN_VAL_PROC;
+    message->len = sizeof(enum proc_cn_mcast_op);
+    enum proc_cn_mcast_op op = PROC_CN_MCAST_LISTEN;
+    memcpy(message->data, &op, sizeof(op));
+
+    if (send(fd, request, header->nlmsg_len, 0) < 0) {
+        error = std::string("proc connector: ") + strerror(errno);
+        close(fd);
+        return false;
+    }
+
+    socketFd = fd;
+    resync = true;
+    return true;
+}
+
+// Drain pending events
+void ProcessEventSource::poll(int timeoutMs) {
+    if (socketFd < 0) {
+        return;
+    }
+
+    if (timeoutMs > 0) {
+        struct pollfd pfd = {socketFd, POLLIN, 0};
+        if (::poll(&pfd, 1, timeoutMs) <= 0) {
+            return;
+        }
+    }
+
+    while (true) {
+        struct sockaddr_nl sender;
+        socklen_t senderLength = sizeof(sender);
+        ssize_t n = recvfrom(socketFd, buffer.data(), buffer.size(), 0,
+                             (struct sockaddr*)&sender, &senderLength);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == ENOBUFS) {
+                // Events were dropped: the PID set can no longer be trusted
+                counters.lost++;
+                resync = true;
+                continue;
+            }
+            break; // EAGAIN: nothing pending
+        }
+        if (n == 0) {
+            break;
+        }
+
+        // Only the kernel (port 0) sends proc events; anything else is a
+        // local process unicasting to our port, possibly forged exits
+        if (senderLength < sizeof(sender) || sender.nl_family != AF_NETLINK ||
+            sender.nl_pid != 0) {
+            continue;
+        }
+
+        int remaining = (int)n;
+        for (struct nlmsghdr* header = (struct nlmsghdr*)buffer.data();
+             NLMSG_OK(header, remaining); header = NLMSG_NEXT(header, remaining)) {
+            if (header->nlmsg_type == NLMSG_ERROR || header->nlmsg_type == NLMSG_NOOP) {
+                continue;
+            }
+            // The connector header and its payload must fit in the message
+            size_t payload = NLMSG_PAYLOAD(header, 0);
+            if (payload < sizeof(struct cn_msg)) {
+                continue;
+            }
+            const struct cn_msg* message = (const struct cn_msg*)NLMSG_DATA(header);
+            if (message->len > payload - sizeof(struct cn_msg)) {
+                continue;
+            }
+            if (message->id.idx == CN_IDX_PROC && message->id.val == CN_VAL_PROC) {
+                handleMessage((const char*)message->data, message->len);
+            }
+        }
+    }
+}
+
+// Apply one proc_event. Thread creation and exit are ignored; only
+// thread-group leaders are processes.
+void ProcessEventSource::handleMessage(const char* data, size_t length) {
+    struct proc_event event;
+    memset(&event, 0, sizeof(event));
+    memcpy(&event, data, std::min(length, sizeof(event)));
+    int64_t timestamp = (int64_t)event.timestamp_ns;
+
+    switch (event.what) {
+        case proc_event::PROC_EVENT_FORK: {
+            const auto& fork = event.event_data.fork;
+            if (fork.child_pid != fork.child_tgid) {
+                break;
+            }
+            counters.forks++;
+            pids.insert(fork.child_tgid);
+            births[fork.child_tgid] = Birth{fork.parent_tgid, timestamp, readComm(fork.child_tgid)};
+            break;
+        }
+
+        case proc_event::PROC_EVENT_EXEC: {
+            counters.execs++;
+            auto it = births.find(event.event_data.exec.process_tgid);
+            if (it != births.end()) {
+                std::string name = readComm(it->first);
+                if (!name.empty()) {
+                    it->second.name = name;
+                }
+            }
+            break;
+        }
+
+        case proc_event::PROC_EVENT_COMM: {
+            const auto& comm = event.event_data.comm;
+            auto it = births.find(comm.process_tgid);
+            if (it != births.end() && comm.process_pid == comm.process_tgid) {
+                it->second.name.assign(comm.comm, strnlen(comm.comm, sizeof(comm.comm)));
+            }
+            break;
+        }
+
+        case proc_event::PROC_EVENT_EXIT: {
+            const auto& exit = event.event_data.exit;
+            if (exit.process_pid != exit.process_tgid) {
+                break;
+            }
+            counters.exits++;
+            pids.erase(exit.process_tgid);
+
+            // Born and gone since the last listing: no scan ever saw it
+            auto it = births.find(exit.process_tgid);
+            if (it != births.end()) {
+                counters.shortLived++;
+                if (shortLived.size() < MAX_SHORT_LIVED) {
+                    ShortLivedProcess proc;
+                    proc.pid = it->first;
+                    proc.ppid = it->second.ppid;
+                    proc.name = it->second.name.empty() ? "?" : it->second.name;
+                    proc.lifetimeNs = timestamp - it->second.timestamp;
+                    proc.exitCode = (int)exit.exit_code;
+                    shortLived.push_back(proc);
+                }
+                births.erase(it);
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+// Read /proc/<pid>/comm; empty if the process has already gone
+std::string ProcessEventSource::readComm(int pid) {
+    char buf[64];
+    std::string path = root + "/" + std::to_string(pid) + "/comm";
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return "";
+    }
+    Profiler::add(Profiler::FILES_OPENED, 1);
+
+    ssize_t n = read(fd, buf, sizeof(buf));
+    close(fd);
+    if (n <= 0) {
+        return "";
+    }
+    Profiler::add(Profiler::BYTES_READ, n);
+    while (n > 0 && buf[n - 1] == '\n') {
+        n--;
+    }
+    return std::string(buf, n);
+}
+
+// List PIDs from the event-maintained set, scanning /proc only when
+// polling or after lost events
+void ProcessEventSource::listPids(std::vector<int>& out) {
+    poll(0);
+
+    if (socketFd >= 0 && !resync) {
+        out.insert(out.end(), pids.begin(), pids.end());
+        births.clear();
+        return;
+    }
+
+    size_t first = out.size();
+    ProcfsSource::listPids(out);
+
+    // Polling: count PIDs that appeared and vanished between listings
+    if (socketFd < 0 && primed) {
+        auto known = pids.begin();
+        for (size_t i = first; i < out.size(); i++) {
+            while (known != pids.end() && *known < out[i]) {
+                counters.exits++;
+                ++known;
+            }
+            if (known != pids.end() && *known == out[i]) {
+                ++known;
+            } else {
+                counters.forks++;
+            }
+        }
+        counters.exits += std::distance(known, pids.end());
+    }
+
+    pids.clear();
+    pids.insert(out.begin() + first, out.end());
+    births.clear();
+    resync = false;
+    primed = true;
+}
+
+// Description for status lines
+std::string ProcessEventSource::describe() const {
+    return root + (socketFd >= 0 ? " (proc events)" : " (polling)");
+}
+
+// Move out the short-lived processes detected since the last call
+void ProcessEventSource::takeShortLived(std::vector<ShortLivedProcess>& out) {
+    out.clear();
+    out.swap(shortLived);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "process_source.hpp"
+#include <string>
+#include <vector>
+#include <set>
+#include <unordered_map>
+#include <cstdint>
+
+// A process that exited before any PID listing could see it
+struct ShortLivedProcess {
+    int pid;
+    int ppid;
+    std::string name;
+    int64_t lifetimeNs;      // Fork to exit
+    int exitCode;            // Exit status as from wait(2)
+
+    ShortLivedProcess() : pid(0), ppid(0), lifetimeNs(0), exitCode(0) {}
+};
+
+// Cumulative event counts since start()
+struct ProcessEventCounters {
+    uint64_t forks;          // New processes (not threads)
+    uint64_t execs;
+    uint64_t exits;
+    uint64_t shortLived;
+    uint64_t lost;           // Socket overruns; the PID set was resynced
+
+    ProcessEventCounters() : forks(0), execs(0), exits(0), shortLived(0), lost(0) {}
+};
+
+// The live /proc, with the PID set kept current from netlink proc
+// connector events (fork, exec, exit) instead of a directory scan.
+// Listening needs CAP_NET_ADMIN; without it the source polls like
+// ProcfsSource and derives spawn and exit counts from successive listings.
+class ProcessEventSource : public ProcfsSource {
+public:
+    ProcessEventSource();
+    ~ProcessEventSource() override;
+
+    // Subscribe to process events; false (with the reason) if unavailable,
+    // in which case the source keeps polling
+    bool start(std::string& error);
+
+    // True when the PID set is maintained from events
+    bool isEventDriven() const { return socketFd >= 0; }
+
+    // Process pending events, waiting up to 'timeoutMs' for the first one
+    void poll(int timeoutMs = 0);
+
+    void listPids(std::vector<int>& pids) override;
+    std::string describe() const override;
+
+    const ProcessEventCounters& getCounters() const { return counters; }
+
+    // Move out the short-lived processes detected since the last call
+    void takeShortLived(std::vector<ShortLivedProcess>& out);
+
+private:
+    struct Birth {
+        int ppid;
+        int64_t timestamp;   // ns since boot
+        std::string name;
+    };
+
+    int socketFd;
+    bool resync;                             // Next listing must scan /proc
+    bool primed;                             // A listing has been taken
+    std::set<int> pids;                      // Current processes
+    std::unordered_map<int, Birth> births;   // Forked since the last listing
+    std::vector<ShortLivedProcess> shortLived;
+    ProcessEventCounters counters;
+    std::vector<char> buffer;
+
+    void handleMessage(const char* data, size_t length);
+    std::string readComm(int pid);
+};
@@ -1,254 +1,668 @@
-#include "process_filter.hpp"
-#include <algorithm>
-#include <cctype>
-
-// Helper: Convert string to lowercase
-std::string ProcessFilter::toLower(const std::string& str) {
-    std::string result = str;
-    std::transform(result.begin(), result.end(), result.begin(),
-                  [](unsigned char c) { return std::tolower(c); });
-    return result;
-}
-
-// Filter by name (substring match, case-insensitive)
-std::vector<Process> ProcessFilter::filterByName(const std::vector<Process>& processes,
-                                                const std::string& namePattern) {
-    std::vector<Process> result;
-    std::string lowerPattern = toLower(namePattern);
-    
-    for (const auto& proc : processes) {
-        std::string lowerName = toLower(proc.name);
-        if (lowerName.find(lowerPattern) != std::string::npos) {
-            result.push_back(proc);
-        }
-    }
-    
-    return result;
-}
-
-// Filter by user
-std::vector<Process> ProcessFilter::filterByUser(const std::vector<Process>& processes,
-                                                const std::string& username) {
-    std::vector<Process> result;
-    
-    for (const auto& proc : processes) {
-        if (proc.user == username) {
-            result.push_back(proc);
-        }
-    }
-    
-    return result;
-}
-
-// Filter by state
-std::vector<Process> ProcessFilter::filterByState(const std::vector<Process>& processes,
-                                                  const std::string& state) {
-    std::vector<Process> result;
-    
-    for (const auto& proc : processes) {
-        if (proc.state == state) {
-            result.push_back(proc);
-        }
-    }
-    
-    return result;
-}
-
-// Filter by PID range
-std::vector<Process> ProcessFilter::filterByPIDRange(const std::vector<Process>& processes,
-                                                     int minPID, int maxPID) {
-    std::vector<Process> result;
-    
-    for (const auto& proc : processes) {
-        if (proc.pid >= minPID && proc.pid <= maxPID) {
-            result.push_back(proc);
-        }
-    }
-    
-    return result;
-}
-
-// Filter by memory usage
-std::vector<Process> ProcessFilter::filterByMemory(const std::vector<Process>& processes,
-                                                   long minMemory, long maxMemory) {
-    std::vector<Process> result;
-    
-    for (const auto& proc : processes) {
-        if (proc.vmRSS >= minMemory && proc.vmRSS <= maxMemory) {
-            result.push_back(proc);
-        }
-    }
-    
-    return result;
-}
-
-// Filter by CPU usage
-std::vector<Process> ProcessFilter::filterByCPU(const std::vector<Process>& processes,
-                                               double minCPU, double maxCPU) {
-    std::vector<Process> result;
-    
-    for (const auto& proc : processes) {
-        if (proc.cpuPercent >= minCPU && proc.cpuPercent <= maxCPU) {
-            result.push_back(proc);
-        }
-    }
-    
-    return result;
-}
-
-// Filter by parent PID
-std::vector<Process> ProcessFilter::filterByParent(const std::vector<Process>& processes,
-                                                   int ppid) {
-    std::vector<Process> result;
-    
-    for (const auto& proc : processes) {
-        if (proc.ppid == ppid) {
-            result.push_back(proc);
-        }
-    }
-    
-    return result;
-}
-
-// Get children of a process
-std::vector<Process> ProcessFilter::getChildren(const std::vector<Process>& processes,
-                                               int ppid) {
-    return filterByParent(processes, ppid);
-}
-
-// Custom filter with predicate
-std::vector<Process> ProcessFilter::filterCustom(const std::vector<Process>& processes,
-                                                std::function<bool(const Process&)> predicate) {
-    std::vector<Process> result;
-    
-    for (const auto& proc : processes) {
-        if (predicate(proc)) {
-            result.push_back(proc);
-        }
-    }
-    
-    return result;
-}
-
-// Search for processes (name or user match)
-std::vector<Process> ProcessFilter::search(const std::vector<Process>& processes,
-                                          const std::string& query) {
-    std::vector<Process> result;
-    std::string lowerQuery = toLower(query);
-    
-    for (const auto& proc : processes) {
-        std::string lowerName = toLower(proc.name);
-        std::string lowerUser = toLower(proc.user);
-        
-        if (lowerName.find(lowerQuery) != std::string::npos ||
-            lowerUser.find(lowerQuery) != std::string::npos) {
-            result.push_back(proc);
-        }
-    }
-    
-    return result;
-}
-
-// ProcessSorter implementations
-
-bool ProcessSorter::comparePID(const Process& a, const Process& b, bool ascending) {
-    return ascending ? (a.pid < b.pid) : (a.pid > b.pid);
-}
-
-bool ProcessSorter::compareName(const Process& a, const Process& b, bool ascending) {
-    return ascending ? (a.name < b.name) : (a.name > b.name);
-}
-
-bool ProcessSorter::compareUser(const Process& a, const Process& b, bool ascending) {
-    return ascending ? (a.user < b.user) : (a.user > b.user);
-}
-
-bool ProcessSorter::compareCPU(const Process& a, const Process& b, bool ascending) {
-    return ascending ? (a.cpuPercent < b.cpuPercent) : (a.cpuPercent > b.cpuPercent);
-}
-
-bool ProcessSorter::compareMemory(const Process& a, const Process& b, bool ascending) {
-    return ascending ? (a.vmRSS < b.vmRSS) : (a.vmRSS > b.vmRSS);
-}
-
-bool ProcessSorter::compareState(const Process& a, const Process& b, bool ascending) {
-    return ascending ? (a.state < b.state) : (a.state > b.state);
-}
-
-bool ProcessSorter::comparePPID(const Process& a, const Process& b, bool ascending) {
-    return ascending ? (a.ppid < b.ppid) : (a.ppid > b.ppid);
-}
-
-// Sort processes by specified field
-void ProcessSorter::sort(std::vector<Process>& processes, SortField field, bool ascending) {
-    switch (field) {
-        case BY_PID:
-            std::sort(processes.begin(), processes.end(),
-                     [ascending](const Process& a, const Process& b) {
-                         return comparePID(a, b, ascending);
-                     });
-            break;
-        case BY_NAME:
-            std::sort(processes.begin(), processes.end(),
-                     [ascending](const Process& a, const Process& b) {
-                         return compareName(a, b, ascending);
-                     });
-            break;
-        case BY_USER:
-            std::sort(processes.begin(), processes.end(),
-                     [ascending](const Process& a, const Process& b) {
-                         return compareUser(a, b, ascending);
-                     });
-            break;
-        case BY_CPU:
-            std::sort(processes.begin(), processes.end(),
-                     [ascending](const Process& a, const Process& b) {
-                         return compareCPU(a, b, ascending);
-                     });
-            break;
-        case BY_MEMORY:
-            std::sort(processes.begin(), processes.end(),
-                     [ascending](const Process& a, const Process& b) {
-                         return compareMemory(a, b, ascending);
-                     });
-            break;
-        case BY_STATE:
-            std::sort(processes.begin(), processes.end(),
-                     [ascending](const Process& a, const Process& b) {
-                         return compareState(a, b, ascending);
-                     });
-            break;
-        case BY_PPID:
-            std::sort(processes.begin(), processes.end(),
-                     [ascending](const Process& a, const Process& b) {
-                         return comparePPID(a, b, ascending);
-                     });
-            break;
-    }
-}
-
-// Get top N processes by CPU usage
-std::vector<Process> ProcessSorter::topByCPU(const std::vector<Process>& processes, 
-                                            size_t count) {
-    std::vector<Process> sorted = processes;
-    sort(sorted, BY_CPU, false); // Descending
-    
-    if (sorted.size() > count) {
-        sorted.resize(count);
-    }
-    
-    return sorted;
-}
-
-// Get top N processes by memory usage
-std::vector<Process> ProcessSorter::topByMemory(const std::vector<Process>& processes,
-                                               size_t count) {
-    std::vector<Process> sorted = processes;
-    sort(sorted, BY_MEMORY, false); // Descending
-    
-    if (sorted.size() > count) {
-        sorted.resize(count);
-    }
-    
-    return sorted;
-}
+#include "process_filter.hpp"
+#include "process_source.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+// Helper: Convert string to lowercase
+std::string ProcessFilter::toLower(const std::string& str) {
+    std::string result = str;
+    std::transform(result.begin(), result.end(), result.begin(),
+                  [](unsigned char c) { return std::tolower(c); });
+    return result;
+}
+
+// Filter by name (substring match, case-insensitive)
+std::vector<Process> ProcessFilter::filterByName(const std::vector<Process>& processes,
+                                                const std::string& namePattern) {
+    std::vector<Process> result;
+    std::string lowerPattern = toLower(namePattern);
+    
+    for (const auto& proc : processes) {
+        std::string lowerName = toLower(proc.name);
+        if (lowerName.find(lowerPattern) != std::string::npos) {
+            result.push_back(proc);
+        }
+    }
+    
+    return result;
+}
+
+// Filter by user
+std::vector<Process> ProcessFilter::filterByUser(const std::vector<Process>& processes,
+                                                const std::string& username) {
+    std::vector<Process> result;
+    
+    for (const auto& proc : processes) {
+        if (proc.user == username) {
+            result.push_back(proc);
+        }
+    }
+    
+    return result;
+}
+
+// Filter by state
+std::vector<Process> ProcessFilter::filterByState(const std::vector<Process>& processes,
+                                                  const std::string& state) {
+    std::vector<Process> result;
+    
+    for (const auto& proc : processes) {
+        if (proc.state == state) {
+            result.push_back(proc);
+        }
+    }
+    
+    return result;
+}
+
+// Filter by PID range
+std::vector<Process> ProcessFilter::filterByPIDRange(const std::vector<Process>& processes,
+                                                     int minPID, int maxPID) {
+    std::vector<Process> result;
+    
+    for (const auto& proc : processes) {
+        if (proc.pid >= minPID && proc.pid <= maxPID) {
+            result.push_back(proc);
+        }
+    }
+    
+    return result;
+}
+
+// Filter by memory usage
+std::vector<Process> ProcessFilter::filterByMemory(const std::vector<Process>& processes,
+                                                   long minMemory, long maxMemory) {
+    std::vector<Process> result;
+    
+    for (const auto& proc : processes) {
+        if (proc.vmRSS >= minMemory && proc.vmRSS <= maxMemory) {
+            result.push_back(proc);
+        }
+    }
+    
+    return result;
+}
+
+// Filter by CPU usage
+std::vector<Process> ProcessFilter::filterByCPU(const std::vector<Process>& processes,
+                                               double minCPU, double maxCPU) {
+    std::vector<Process> result;
+    
+    for (const auto& proc : processes) {
+        if (proc.cpuPercent >= minCPU && proc.cpuPercent <= maxCPU) {
+            result.push_back(proc);
+        }
+    }
+    
+    return result;
+}
+
+// Filter by parent PID
+std::vector<Process> ProcessFilter::filterByParent(const std::vector<Process>& processes,
+                                                   int ppid) {
+    std::vector<Process> result;
+    
+    for (const auto& proc : processes) {
+        if (proc.ppid == ppid) {
+            result.push_back(proc);
+        }
+    }
+    
+    return result;
+}
+
+// Get children of a process
+std::vector<Process> ProcessFilter::getChildren(const std::vector<Process>& processes,
+                                               int ppid) {
+    return filterByParent(processes, ppid);
+}
+
+// Custom filter with predicate
+std::vector<Process> ProcessFilter::filterCustom(const std::vector<Process>& processes,
+                                                std::function<bool(const Process&)> predicate) {
+    std::vector<Process> result;
+    
+    for (const auto& proc : processes) {
+        if (predicate(proc)) {
+            result.push_back(proc);
+        }
+    }
+    
+    return result;
+}
+
+// Search for processes (name or user match)
+std::vector<Process> ProcessFilter::search(const std::vector<Process>& processes,
+                                          const std::string& query) {
+    std::vector<Process> result;
+    std::string lowerQuery = toLower(query);
+    
+    for (const auto& proc : processes) {
+        if (matchesQuery(proc, lowerQuery)) {
+            result.push_back(proc);
+        }
+    }
+    
+    return result;
+}
+
+// Check a single process against a lowercased search query
+bool ProcessFilter::matchesQuery(const Process& proc, const std::string& lowerQuery) {
+    return toLower(proc.name).find(lowerQuery) != std::string::npos ||
+           toLower(proc.user).find(lowerQuery) != std::string::npos;
+}
+
+// ProcessSorter implementations
+
+bool ProcessSorter::comparePID(const Process& a, const Process& b, bool ascending) {
+    return ascending ? (a.pid < b.pid) : (a.pid > b.pid);
+}
+
+bool ProcessSorter::compareName(const Process& a, const Process& b, bool ascending) {
+    return ascending ? (a.name < b.name) : (a.name > b.name);
+}
+
+bool ProcessSorter::compareUser(const Process& a, const Process& b, bool ascending) {
+    return ascending ? (a.user < b.user) : (a.user > b.user);
+}
+
+bool ProcessSorter::compareCPU(const Process& a, const Process& b, bool ascending) {
+    return ascending ? (a.cpuPercent < b.cpuPercent) : (a.cpuPercent > b.cpuPercent);
+}
+
+bool ProcessSorter::compareMemory(const Process& a, const Process& b, bool ascending) {
+    return ascending ? (a.vmRSS < b.vmRSS) : (a.vmRSS > b.vmRSS);
+}
+
+bool ProcessSorter::compareState(const Process& a, const Process& b, bool ascending) {
+    return ascending ? (a.state < b.state) : (a.state > b.state);
+}
+
+bool ProcessSorter::comparePPID(const Process& a, const Process& b, bool ascending) {
+    return ascending ? (a.ppid < b.ppid) : (a.ppid > b.ppid);
+}
+
+bool ProcessSorter::compareReadRate(const Process& a, const Process& b, bool ascending) {
+    return ascending ? (a.readRate < b.readRate) : (a.readRate > b.readRate);
+}
+
+bool ProcessSorter::compareWriteRate(const Process& a, const Process& b, bool ascending) {
+    return ascending ? (a.writeRate < b.writeRate) : (a.writeRate > b.writeRate);
+}
+
+bool ProcessSorter::compareIORate(const Process& a, const Process& b, bool ascending) {
+    double rateA = a.readRate + a.writeRate;
+    double rateB = b.readRate + b.writeRate;
+    return ascending ? (rateA < rateB) : (rateA > rateB);
+}
+
+bool ProcessSorter::compareSyscallRate(const Process& a, const Process& b, bool ascending) {
+    double rateA = a.syscrRate + a.syscwRate;
+    double rateB = b.syscrRate + b.syscwRate;
+    return ascending ? (rateA < rateB) : (rateA > rateB);
+}
+
+bool ProcessSorter::compareWait(const Process& a, const Process& b, bool ascending) {
+    return ascending ? (a.waitPercent < b.waitPercent) : (a.waitPercent > b.waitPercent);
+}
+
+bool ProcessSorter::compareSwitchRate(const Process& a, const Process& b, bool ascending) {
+    double rateA = a.voluntaryRate + a.involuntaryRate;
+    double rateB = b.voluntaryRate + b.involuntaryRate;
+    return ascending ? (rateA < rateB) : (rateA > rateB);
+}
+
+// Sort processes by specified field
+void ProcessSorter::sort(std::vector<Process>& processes, SortField field, bool ascending) {
+    switch (field) {
+        case BY_PID:
+            std::sort(processes.begin(), processes.end(),
+                     [ascending](const Process& a, const Process& b) {
+                         return comparePID(a, b, ascending);
+                     });
+            break;
+        case BY_NAME:
+            std::sort(processes.begin(), processes.end(),
+                     [ascending](const Process& a, const Process& b) {
+                         return compareName(a, b, ascending);
+                     });
+            break;
+        case BY_USER:
+            std::sort(processes.begin(), processes.end(),
+                     [ascending](const Process& a, const Process& b) {
+                         return compareUser(a, b, ascending);
+                     });
+            break;
+        case BY_CPU:
+            std::sort(processes.begin(), processes.end(),
+                     [ascending](const Process& a, const Process& b) {
+                         return compareCPU(a, b, ascending);
+                     });
+            break;
+        case BY_MEMORY:
+            std::sort(processes.begin(), processes.end(),
+                     [ascending](const Process& a, const Process& b) {
+                         return compareMemory(a, b, ascending);
+                     });
+            break;
+        case BY_STATE:
+            std::sort(processes.begin(), processes.end(),
+                     [ascending](const Process& a, const Process& b) {
+                         return compareState(a, b, ascending);
+                     });
+            break;
+        case BY_PPID:
+            std::sort(processes.begin(), processes.end(),
+                     [ascending](const Process& a, const Process& b) {
+                         return comparePPID(a, b, ascending);
+                     });
+            break;
+        case BY_IO_READ:
+            std::sort(processes.begin(), processes.end(),
+                     [ascending](const Process& a, const Process& b) {
+                         return compareReadRate(a, b, ascending);
+                     });
+            break;
+        case BY_IO_WRITE:
+            std::sort(processes.begin(), processes.end(),
+                     [ascending](const Process& a, const Process& b) {
+                         return compareWriteRate(a, b, ascending);
+                     });
+            break;
+        case BY_IO:
+            std::sort(processes.begin(), processes.end(),
+                     [ascending](const Process& a, const Process& b) {
+                         return compareIORate(a, b, ascending);
+                     });
+            break;
+        case BY_SYSCALLS:
+            std::sort(processes.begin(), processes.end(),
+                     [ascending](const Process& a, const Process& b) {
+                         return compareSyscallRate(a, b, ascending);
+                     });
+            break;
+        case BY_WAIT:
+            std::sort(processes.begin(), processes.end(),
+                     [ascending](const Process& a, const Process& b) {
+                         return compareWait(a, b, ascending);
+                     });
+            break;
+        case BY_SWITCHES:
+            std::sort(processes.begin(), processes.end(),
+                     [ascending](const Process& a, const Process& b) {
+                         return compareSwitchRate(a, b, ascending);
+                     });
+            break;
+    }
+}
+
+// Optional fields a sort key reads
+unsigned ProcessSorter::requiredFields(SortField field) {
+    switch (field) {
+        case BY_USER:
+            return ProcessFields::USER;
+        case BY_IO_READ:
+        case BY_IO_WRITE:
+        case BY_IO:
+        case BY_SYSCALLS:
+            return ProcessFields::IO;
+        case BY_WAIT:
+        case BY_SWITCHES:
+            return ProcessFields::SCHED;
+        default:
+            return ProcessFields::NONE;
+    }
+}
+
+// Get top N processes by CPU usage
+std::vector<Process> ProcessSorter::topByCPU(const std::vector<Process>& processes, 
+                                            size_t count) {
+    std::vector<Process> sorted = processes;
+    sort(sorted, BY_CPU, false); // Descending
+    
+    if (sorted.size() > count) {
+        sorted.resize(count);
+    }
+    
+    return sorted;
+}
+
+// Get top N processes by memory usage
+std::vector<Process> ProcessSorter::topByMemory(const std::vector<Process>& processes,
+                                               size_t count) {
+    std::vector<Process> sorted = processes;
+    sort(sorted, BY_MEMORY, false); // Descending
+    
+    if (sorted.size() > count) {
+        sorted.resize(count);
+    }
+    
+    return sorted;
+}
+
+// Get top N processes by storage I/O rate
+std::vector<Process> ProcessSorter::topByIO(const std::vector<Process>& processes,
+                                           size_t count) {
+    std::vector<Process> sorted = processes;
+    sort(sorted, BY_IO, false); // Descending
+    
+    if (sorted.size() > count) {
+        sorted.resize(count);
+    }
+    
+    return sorted;
+}
+
+// Get top N processes by run-queue wait
+std::vector<Process> ProcessSorter::topByWait(const std::vector<Process>& processes,
+                                             size_t count) {
+    std::vector<Process> sorted = processes;
+    sort(sorted, BY_WAIT, false); // Descending
+    
+    if (sorted.size() > count) {
+        sorted.resize(count);
+    }
+    
+    return sorted;
+}
+
+// FilterExpression implementation
+
+FilterExpression::FilterExpression() {
+}
+
+// Parse a number with an optional K/M/G/T suffix; memory fields are in kB
+bool FilterExpression::parseSize(const std::string& text, double& value) {
+    if (text.empty()) {
+        return false;
+    }
+    
+    char* end = nullptr;
+    value = std::strtod(text.c_str(), &end);
+    if (end == text.c_str()) {
+        return false;
+    }
+    
+    std::string suffix = ProcessFilter::toLower(end);
+    if (suffix == "" || suffix == "k" || suffix == "kb") {
+        return true;
+    } else if (suffix == "m" || suffix == "mb") {
+        value *= 1024.0;
+    } else if (suffix == "g" || suffix == "gb") {
+        value *= 1024.0 * 1024.0;
+    } else if (suffix == "t" || suffix == "tb") {
+        value *= 1024.0 * 1024.0 * 1024.0;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Check whether a field compares numerically
+bool FilterExpression::isNumericField(Field field) {
+    return field != FIELD_NAME && field != FIELD_USER &&
+           field != FIELD_STATE && field != FIELD_SEARCH;
+}
+
+// Parse an expression into a list of conditions
+bool FilterExpression::parse(const std::string& text, std::string& error) {
+    static const struct {
+        const char* name;
+        Field field;
+    } fieldNames[] = {
+        {"pid", FIELD_PID}, {"ppid", FIELD_PPID}, {"name", FIELD_NAME},
+        {"comm", FIELD_NAME}, {"user", FIELD_USER}, {"state", FIELD_STATE},
+        {"rss", FIELD_RSS}, {"mem", FIELD_RSS}, {"vsz", FIELD_VSZ},
+        {"cpu", FIELD_CPU}, {"threads", FIELD_THREADS},
+    };
+    
+    static const struct {
+        const char* text;
+        Op op;
+    } opNames[] = {
+        // Longest operators first so "<=" is not read as "<"
+        {"==", OP_EQ}, {"!=", OP_NE}, {"<=", OP_LE}, {">=", OP_GE},
+        {"!~", OP_NOT_MATCH}, {"=", OP_EQ}, {"<", OP_LT}, {">", OP_GT},
+        {"~", OP_MATCH},
+    };
+    
+    conditions.clear();
+    error.clear();
+    
+    // Split into tokens: words, quoted strings and operators
+    std::vector<std::string> tokens;
+    size_t i = 0;
+    while (i < text.size()) {
+        char c = text[i];
+        if (std::isspace((unsigned char)c)) {
+            i++;
+        } else if (c == '"' || c == '\'') {
+            size_t close = text.find(c, i + 1);
+            if (close == std::string::npos) {
+                error = "unterminated string";
+                return false;
+            }
+            tokens.push_back(text.substr(i, close - i + 1));
+            i = close + 1;
+        } else if (text.compare(i, 2, "&&") == 0) {
+            tokens.push_back("&&");
+            i += 2;
+        } else if (std::strchr("=!<>~", c)) {
+            size_t len = (i + 1 < text.size() && std::strchr("=~", text[i + 1])) ? 2 : 1;
+            tokens.push_back(text.substr(i, len));
+            i += len;
+        } else {
+            size_t start = i;
+            while (i < text.size() && !std::isspace((unsigned char)text[i]) &&
+                   !std::strchr("=!<>~\"'", text[i]) && text.compare(i, 2, "&&") != 0) {
+                i++;
+            }
+            tokens.push_back(text.substr(start, i - start));
+        }
+    }
+    
+    auto unquote = [](const std::string& token) {
+        if (token.size() >= 2 && (token[0] == '"' || token[0] == '\'')) {
+            return token.substr(1, token.size() - 2);
+        }
+        return token;
+    };
+    
+    auto findOp = [](const std::string& token, Op& op) {
+        for (const auto& entry : opNames) {
+            if (token == entry.text) {
+                op = entry.op;
+                return true;
+            }
+        }
+        return false;
+    };
+    
+    size_t pos = 0;
+    while (pos < tokens.size()) {
+        Condition cond;
+        cond.number = 0;
+        cond.nameOnly = false;
+        Op op;
+        
+        if (pos + 1 < tokens.size() && findOp(tokens[pos + 1], op)) {
+            // FIELD OP VALUE
+            std::string fieldName = ProcessFilter::toLower(tokens[pos]);
+            bool known = false;
+            for (const auto& entry : fieldNames) {
+                if (fieldName == entry.name) {
+                    cond.field = entry.field;
+                    known = true;
+                    break;
+                }
+            }
+            if (!known) {
+                error = "unknown field '" + tokens[pos] + "'";
+                return false;
+            }
+            if (pos + 2 >= tokens.size() || tokens[pos + 2] == "&&") {
+                error = "missing value after '" + tokens[pos + 1] + "'";
+                return false;
+            }
+            
+            cond.op = op;
+            cond.text = unquote(tokens[pos + 2]);
+            
+            if (op == OP_MATCH || op == OP_NOT_MATCH) {
+                cond.text = ProcessFilter::toLower(cond.text);
+            } else if (isNumericField(cond.field)) {
+                if (!parseSize(cond.text, cond.number)) {
+                    error = "invalid number '" + cond.text + "'";
+                    return false;
+                }
+            } else if (op != OP_EQ && op != OP_NE) {
+                error = "operator '" + tokens[pos + 1] + "' needs a numeric field";
+                return false;
+            }
+            pos += 3;
+        } else if (tokens[pos] != "&&") {
+            // Bare word: same semantics as ProcessFilter::search
+            cond.field = FIELD_SEARCH;
+            cond.op = OP_MATCH;
+            cond.text = ProcessFilter::toLower(unquote(tokens[pos]));
+            pos += 1;
+        } else {
+            error = "unexpected '&&'";
+            return false;
+        }
+        
+        conditions.push_back(cond);
+        
+        if (pos < tokens.size()) {
+            if (tokens[pos] != "&&") {
+                error = "expected '&&' before '" + tokens[pos] + "'";
+                return false;
+            }
+            pos++;
+            if (pos == tokens.size()) {
+                error = "expression ends with '&&'";
+                return false;
+            }
+        }
+    }
+    
+    return true;
+}
+
+// Evaluate one condition against a process
+bool FilterExpression::evaluate(const Condition& cond, const Process& proc) {
+    if (cond.field == FIELD_SEARCH) {
+        if (cond.nameOnly) {
+            return ProcessFilter::toLower(proc.name).find(cond.text) != std::string::npos;
+        }
+        return ProcessFilter::matchesQuery(proc, cond.text);
+    }
+    
+    if (!isNumericField(cond.field)) {
+        const std::string& value = cond.field == FIELD_NAME ? proc.name :
+                                   cond.field == FIELD_USER ? proc.user : proc.state;
+        switch (cond.op) {
+            case OP_MATCH:
+                return ProcessFilter::toLower(value).find(cond.text) != std::string::npos;
+            case OP_NOT_MATCH:
+                return ProcessFilter::toLower(value).find(cond.text) == std::string::npos;
+            case OP_NE:
+                return value != cond.text;
+            default:
+                return value == cond.text;
+        }
+    }
+    
+    double value = 0;
+    switch (cond.field) {
+        case FIELD_PID:     value = proc.pid; break;
+        case FIELD_PPID:    value = proc.ppid; break;
+        case FIELD_RSS:     value = proc.vmRSS; break;
+        case FIELD_VSZ:     value = proc.vmSize; break;
+        case FIELD_CPU:     value = proc.cpuPercent; break;
+        case FIELD_THREADS: value = proc.numThreads; break;
+        default: break;
+    }
+    
+    switch (cond.op) {
+        case OP_EQ: return value == cond.number;
+        case OP_NE: return value != cond.number;
+        case OP_LT: return value < cond.number;
+        case OP_LE: return value <= cond.number;
+        case OP_GT: return value > cond.number;
+        case OP_GE: return value >= cond.number;
+        case OP_MATCH:
+            return std::to_string((long long)value).find(cond.text) != std::string::npos;
+        case OP_NOT_MATCH:
+            return std::to_string((long long)value).find(cond.text) == std::string::npos;
+    }
+    return false;
+}
+
+// Check whether a process satisfies all conditions
+bool FilterExpression::matches(const Process& proc) const {
+    for (const auto& cond : conditions) {
+        if (!evaluate(cond, proc)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Check the conditions decidable from the fields read so far
+bool FilterExpression::matches(const Process& proc, unsigned available) const {
+    for (const auto& cond : conditions) {
+        if ((fieldsOf(cond) & ~available) == 0) {
+            if (!evaluate(cond, proc)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Optional fields one condition reads
+unsigned FilterExpression::fieldsOf(const Condition& cond) {
+    if (cond.field == FIELD_USER || (cond.field == FIELD_SEARCH && !cond.nameOnly)) {
+        return ProcessFields::USER;
+    }
+    return ProcessFields::NONE;
+}
+
+// Optional fields all conditions read
+unsigned FilterExpression::requiredFields() const {
+    unsigned fields = ProcessFields::NONE;
+    for (const auto& cond : conditions) {
+        fields |= fieldsOf(cond);
+    }
+    return fields;
+}
+
+// Add a bare-word condition
+void FilterExpression::addSearch(const std::string& query) {
+    Condition cond;
+    cond.field = FIELD_SEARCH;
+    cond.op = OP_MATCH;
+    cond.text = ProcessFilter::toLower(query);
+    cond.number = 0;
+    cond.nameOnly = false;
+    conditions.push_back(cond);
+}
+
+// Decide searches on the name alone where no user can match
+void FilterExpression::narrowSearches(ProcessSource& source) {
+    for (auto& cond : conditions) {
+        if (cond.field == FIELD_SEARCH && !cond.nameOnly) {
+            cond.nameOnly = !source.userNameMayContain(cond.text);
+        }
+    }
+}
+
+// Filter a process list
+std::vector<Process> FilterExpression::apply(const std::vector<Process>& processes) const {
+    return ProcessFilter::filterCustom(processes, [this](const Process& proc) {
+        return matches(proc);
+    });
+}
@@ -1,88 +1,201 @@
-#pragma once
-
-#include "process.hpp"
-#include <vector>
-#include <string>
-#include <functional>
-
-// Process filter criteria
-class ProcessFilter {
-public:
-    // Filter by name (substring match, case-insensitive)
-    static std::vector<Process> filterByName(const std::vector<Process>& processes,
-                                             const std::string& namePattern);
-    
-    // Filter by user
-    static std::vector<Process> filterByUser(const std::vector<Process>& processes,
-                                            const std::string& username);
-    
-    // Filter by state (R, S, D, Z, T, etc.)
-    static std::vector<Process> filterByState(const std::vector<Process>& processes,
-                                              const std::string& state);
-    
-    // Filter by PID range
-    static std::vector<Process> filterByPIDRange(const std::vector<Process>& processes,
-                                                 int minPID, int maxPID);
-    
-    // Filter by memory usage (min/max in kB)
-    static std::vector<Process> filterByMemory(const std::vector<Process>& processes,
-                                               long minMemory, long maxMemory);
-    
-    // Filter by CPU usage percentage
-    static std::vector<Process> filterByCPU(const std::vector<Process>& processes,
-                                           double minCPU, double maxCPU);
-    
-    // Filter by parent PID
-    static std::vector<Process> filterByParent(const std::vector<Process>& processes,
-                                               int ppid);
-    
-    // Get children of a process
-    static std::vector<Process> getChildren(const std::vector<Process>& processes,
-                                           int ppid);
-    
-    // Custom filter with predicate function
-    static std::vector<Process> filterCustom(const std::vector<Process>& processes,
-                                            std::function<bool(const Process&)> predicate);
-    
-    // Search for processes (combines name and user search)
-    static std::vector<Process> search(const std::vector<Process>& processes,
-                                      const std::string& query);
-
-private:
-    static std::string toLower(const std::string& str);
-};
-
-// Process sorting utilities
-class ProcessSorter {
-public:
-    enum SortField {
-        BY_PID,
-        BY_NAME,
-        BY_USER,
-        BY_CPU,
-        BY_MEMORY,
-        BY_STATE,
-        BY_PPID
-    };
-    
-    // Sort processes by specified field
-    static void sort(std::vector<Process>& processes, SortField field, 
-                    bool ascending = true);
-    
-    // Get top N processes by CPU
-    static std::vector<Process> topByCPU(const std::vector<Process>& processes, 
-                                        size_t count);
-    
-    // Get top N processes by memory
-    static std::vector<Process> topByMemory(const std::vector<Process>& processes,
-                                           size_t count);
-
-private:
-    static bool comparePID(const Process& a, const Process& b, bool ascending);
-    static bool compareName(const Process& a, const Process& b, bool ascending);
-    static bool compareUser(const Process& a, const Process& b, bool ascending);
-    static bool compareCPU(const Process& a, const Process& b, bool ascending);
-    static bool compareMemory(const Process& a, const Process& b, bool ascending);
-    static bool compareState(const Process& a, const Process& b, bool ascending);
-    static bool comparePPID(const Process& a, const Process& b, bool ascending);
-};
+#pragma once
+
+#include "process.hpp"
+#include <vector>
+#include <string>
+#include <functional>
+
+class ProcessSource;
+
+// Process filter criteria
+class ProcessFilter {
+public:
+    // Filter by name (substring match, case-insensitive)
+    static std::vector<Process> filterByName(const std::vector<Process>& processes,
+                                             const std::string& namePattern);
+    
+    // Filter by user
+    static std::vector<Process> filterByUser(const std::vector<Process>& processes,
+                                            const std::string& username);
+    
+    // Filter by state (R, S, D, Z, T, etc.)
+    static std::vector<Process> filterByState(const std::vector<Process>& processes,
+                                              const std::string& state);
+    
+    // Filter by PID range
+    static std::vector<Process> filterByPIDRange(const std::vector<Process>& processes,
+                                                 int minPID, int maxPID);
+    
+    // Filter by memory usage (min/max in kB)
+    static std::vector<Process> filterByMemory(const std::vector<Process>& processes,
+                                               long minMemory, long maxMemory);
+    
+    // Filter by CPU usage percentage
+    static std::vector<Process> filterByCPU(const std::vector<Process>& processes,
+                                           double minCPU, double maxCPU);
+    
+    // Filter by parent PID
+    static std::vector<Process> filterByParent(const std::vector<Process>& processes,
+                                               int ppid);
+    
+    // Get children of a process
+    static std::vector<Process> getChildren(const std::vector<Process>& processes,
+                                           int ppid);
+    
+    // Custom filter with predicate function
+    static std::vector<Process> filterCustom(const std::vector<Process>& processes,
+                                            std::function<bool(const Process&)> predicate);
+    
+    // Search for processes (combines name and user search)
+    static std::vector<Process> search(const std::vector<Process>& processes,
+                                      const std::string& query);
+    
+    // Check a single process against a lowercased search query
+    static bool matchesQuery(const Process& proc, const std::string& lowerQuery);
+
+private:
+    friend class FilterExpression;
+    
+    static std::string toLower(const std::string& str);
+};
+
+// Filter expression such as: name ~ "worker" && rss > 1G && user == root
+//
+// Conditions are joined with "&&". Each condition is FIELD OP VALUE with
+// fields pid, ppid, name, user, state, rss, vsz, cpu, threads and operators
+// == (or =), !=, <, <=, >, >=, ~ (case-insensitive substring), !~.
+// Memory values are in kB and accept K/M/G/T suffixes. A bare word matches
+// like ProcessFilter::search (name or user substring).
+class FilterExpression {
+public:
+    FilterExpression();
+    
+    // Parse an expression; returns false and sets error on syntax errors
+    bool parse(const std::string& text, std::string& error);
+    
+    // Check whether a process satisfies all conditions
+    bool matches(const Process& proc) const;
+    
+    // Check the conditions that can be decided from the stat fields plus
+    // 'available' (ProcessFields bits); false if one of them fails.
+    // Conditions needing a missing field pass.
+    bool matches(const Process& proc, unsigned available) const;
+    
+    // Optional fields (ProcessFields bits) the conditions read
+    unsigned requiredFields() const;
+    
+    // Add a bare-word condition (name or user substring)
+    void addSearch(const std::string& query);
+    
+    // Let bare words match the name only where no user name of 'source'
+    // contains them; the result is the same, but users need not be read
+    void narrowSearches(ProcessSource& source);
+    
+    // Filter a process list
+    std::vector<Process> apply(const std::vector<Process>& processes) const;
+    
+    // True if the expression has no conditions (matches everything)
+    bool empty() const { return conditions.empty(); }
+
+    enum Field {
+        FIELD_PID,
+        FIELD_PPID,
+        FIELD_NAME,
+        FIELD_USER,
+        FIELD_STATE,
+        FIELD_RSS,
+        FIELD_VSZ,
+        FIELD_CPU,
+        FIELD_THREADS,
+        FIELD_SEARCH     // Bare word: name or user substring
+    };
+    
+    enum Op {
+        OP_EQ,
+        OP_NE,
+        OP_LT,
+        OP_LE,
+        OP_GT,
+        OP_GE,
+        OP_MATCH,
+        OP_NOT_MATCH
+    };
+    
+    struct Condition {
+        Field field;
+        Op op;
+        std::string text;    // Lowercased for ~ / !~ and search
+        double number;
+        bool nameOnly;       // Search that no user name can match
+    };
+    
+    const std::vector<Condition>& getConditions() const { return conditions; }
+    
+    // Parse a number with an optional K/M/G/T suffix (result in kB units)
+    static bool parseSize(const std::string& text, double& value);
+
+private:
+    std::vector<Condition> conditions;
+    
+    static bool isNumericField(Field field);
+    static bool evaluate(const Condition& cond, const Process& proc);
+    static unsigned fieldsOf(const Condition& cond);
+};
+
+// Process sorting utilities
+class ProcessSorter {
+public:
+    enum SortField {
+        BY_PID,
+        BY_NAME,
+        BY_USER,
+        BY_CPU,
+        BY_MEMORY,
+        BY_STATE,
+        BY_PPID,
+        BY_IO_READ,      // Storage read rate
+        BY_IO_WRITE,     // Storage write rate
+        BY_IO,           // Read + write rate
+        BY_SYSCALLS,     // Read + write system call rate
+        BY_WAIT,         // Run-queue wait
+        BY_SWITCHES      // Voluntary + involuntary context switch rate
+    };
+    
+    // Sort processes by specified field
+    static void sort(std::vector<Process>& processes, SortField field, 
+                    bool ascending = true);
+    
+    // Optional fields (ProcessFields bits) a sort key reads
+    static unsigned requiredFields(SortField field);
+    
+    // Get top N processes by CPU
+    static std::vector<Process> topByCPU(const std::vector<Process>& processes, 
+                                        size_t count);
+    
+    // Get top N processes by memory
+    static std::vector<Process> topByMemory(const std::vector<Process>& processes,
+                                           size_t count);
+    
+    // Get top N processes by storage I/O rate (read + write)
+    static std::vector<Process> topByIO(const std::vector<Process>& processes,
+                                       size_t count);
+    
+    // Get top N processes by run-queue wait
+    static std::vector<Process> topByWait(const std::vector<Process>& processes,
+                                         size_t count);
+
+private:
+    static bool comparePID(const Process& a, const Process& b, bool ascending);
+    static bool compareName(const Process& a, const Process& b, bool ascending);
+    static bool compareUser(const Process& a, const Process& b, bool ascending);
+    static bool compareCPU(const Process& a, const Process& b, bool ascending);
+    static bool compareMemory(const Process& a, const Process& b, bool ascending);
+    static bool compareState(const Process& a, const Process& b, bool ascending);
+    static bool comparePPID(const Process& a, const Process& b, bool ascending);
+    static bool compareReadRate(const Process& a, const Process& b, bool ascending);
+    static bool compareWriteRate(const Process& a, const Process& b, bool ascending);
+    static bool compareIORate(const Process& a, const Process& b, bool ascending);
+    static bool compareSyscallRate(const Process& a, const Process& b, bool ascending);
+    static bool compareWait(const Process& a, const Process& b, bool ascending);
+    static bool compareSwitchRate(const Process& a, const Process& b, bool ascending);
+};
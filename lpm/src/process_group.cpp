@@ -0,0 +1,160 @@
+#include "process_group.hpp"
+#include <algorithm>
+
+static const char* KEY_NAMES[] = {"user", "name", "state"};
+static const char* COLUMN_NAMES[] = {"key", "count", "threads", "rss", "max-rss", "cpu"};
+
+// FNV-1a; keys are short names, so a simple byte loop is enough
+static uint64_t hashKey(const std::string& text) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : text) {
+        hash = (hash ^ c) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+ProcessGrouper::ProcessGrouper() : key(BY_USER), slots(64, -1), pass(0) {
+}
+
+bool ProcessGrouper::parseKey(const std::string& name, Key& key) {
+    for (int i = 0; i <= BY_STATE; i++) {
+        if (name == KEY_NAMES[i]) {
+            key = (Key)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ProcessGrouper::parseColumn(const std::string& name, Column& column) {
+    for (int i = 0; i < COLUMN_COUNT; i++) {
+        if (name == COLUMN_NAMES[i]) {
+            column = (Column)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* ProcessGrouper::keyName(Key key) {
+    return KEY_NAMES[key];
+}
+
+const char* ProcessGrouper::columnName(Column column) {
+    return COLUMN_NAMES[column];
+}
+
+// Forget every interned key
+void ProcessGrouper::reset() {
+    keys.clear();
+    hashes.clear();
+    stamps.clear();
+    slotOf.clear();
+    std::fill(slots.begin(), slots.end(), -1);
+}
+
+void ProcessGrouper::begin(Key key) {
+    // Keys of another kind, or many that stopped appearing (short-lived
+    // processes with unique names), are dropped rather than kept forever
+    if (key != this->key || keys.size() > 4 * groups.size() + 4096) {
+        reset();
+    }
+    this->key = key;
+    groups.clear();
+    pass++;
+    if (pass == 0) {
+        std::fill(stamps.begin(), stamps.end(), 0);
+        pass = 1;
+    }
+}
+
+// Double the slot array and reinsert the IDs from their stored hashes
+void ProcessGrouper::grow() {
+    std::vector<int32_t> larger(slots.size() * 2, -1);
+    size_t mask = larger.size() - 1;
+    for (uint32_t id = 0; id < keys.size(); id++) {
+        size_t slot = hashes[id] & mask;
+        while (larger[slot] >= 0) {
+            slot = (slot + 1) & mask;
+        }
+        larger[slot] = (int32_t)id;
+    }
+    slots.swap(larger);
+}
+
+uint32_t ProcessGrouper::intern(const std::string& text) {
+    uint64_t hash = hashKey(text);
+    size_t mask = slots.size() - 1;
+    size_t slot = hash & mask;
+    while (slots[slot] >= 0) {
+        uint32_t id = (uint32_t)slots[slot];
+        if (hashes[id] == hash && keys[id] == text) {
+            return id;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    uint32_t id = (uint32_t)keys.size();
+    keys.push_back(text);
+    hashes.push_back(hash);
+    stamps.push_back(0);
+    slotOf.push_back(0);
+    slots[slot] = (int32_t)id;
+
+    // Keep the load factor at or below one half
+    if (keys.size() * 2 > slots.size()) {
+        grow();
+    }
+    return id;
+}
+
+void ProcessGrouper::add(const Process& proc) {
+    const std::string& text = key == BY_USER ? proc.user :
+                              key == BY_NAME ? proc.name : proc.state;
+    uint32_t id = intern(text);
+
+    if (stamps[id] != pass) {
+        stamps[id] = pass;
+        slotOf[id] = (uint32_t)groups.size();
+        groups.push_back(ProcessGroup{id, 0, 0, 0, 0, 0.0});
+    }
+    ProcessGroup& group = groups[slotOf[id]];
+    group.count++;
+    group.threads += proc.numThreads;
+    group.rssKB += std::max(0L, proc.vmRSS);
+    group.maxRssKB = std::max(group.maxRssKB, proc.vmRSS);
+    group.cpuPercent += proc.cpuPercent;
+}
+
+void ProcessGrouper::build(const std::vector<Process>& processes, Key key) {
+    begin(key);
+    for (const auto& proc : processes) {
+        add(proc);
+    }
+}
+
+void ProcessGrouper::sort(Column column) {
+    auto byKey = [this](const ProcessGroup& a, const ProcessGroup& b) {
+        return keys[a.keyId] < keys[b.keyId];
+    };
+    auto value = [column](const ProcessGroup& group) -> double {
+        switch (column) {
+            case SORT_COUNT: return (double)group.count;
+            case SORT_THREADS: return (double)group.threads;
+            case SORT_RSS: return (double)group.rssKB;
+            case SORT_MAX_RSS: return (double)group.maxRssKB;
+            case SORT_CPU: return group.cpuPercent;
+            default: return 0.0;
+        }
+    };
+
+    if (column == SORT_KEY) {
+        std::sort(groups.begin(), groups.end(), byKey);
+        return;
+    }
+    std::sort(groups.begin(), groups.end(),
+              [&](const ProcessGroup& a, const ProcessGroup& b) {
+                  double va = value(a), vb = value(b);
+                  return va != vb ? va > vb : byKey(a, b);
+              });
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "process.hpp"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Totals of the processes sharing one key
+struct ProcessGroup {
+    uint32_t keyId;                 // Interned key; see ProcessGrouper::getKey
+    size_t count;
+    long threads;
+    long rssKB;
+    long maxRssKB;
+    double cpuPercent;
+};
+
+// Aggregates a snapshot by user, name or state in one pass. Keys are
+// interned in an open-addressing table (linear probing over a power-of-two
+// slot array holding key IDs, with the hashes kept beside the keys), and
+// survive between passes, so a refresh over the same processes hashes
+// each key once and allocates nothing.
+class ProcessGrouper {
+public:
+    enum Key {
+        BY_USER,
+        BY_NAME,
+        BY_STATE
+    };
+
+    enum Column {
+        SORT_KEY,                   // Ascending; the others descend
+        SORT_COUNT,
+        SORT_THREADS,
+        SORT_RSS,
+        SORT_MAX_RSS,
+        SORT_CPU,
+        COLUMN_COUNT
+    };
+
+    ProcessGrouper();
+
+    // Parse "user|name|state" and "key|count|threads|rss|max-rss|cpu"
+    static bool parseKey(const std::string& name, Key& key);
+    static bool parseColumn(const std::string& name, Column& column);
+    static const char* keyName(Key key);
+    static const char* columnName(Column column);
+
+    // Optional fields (ProcessFields bits) grouping by 'key' reads
+    static unsigned requiredFields(Key key) {
+        return key == BY_USER ? ProcessFields::USER : ProcessFields::NONE;
+    }
+
+    // One pass: begin, then add each process. The groups are in
+    // first-seen order until sorted.
+    void begin(Key key);
+    void add(const Process& proc);
+
+    void build(const std::vector<Process>& processes, Key key);
+
+    void sort(Column column);
+
+    const std::vector<ProcessGroup>& getGroups() const { return groups; }
+    const std::string& getKey(uint32_t keyId) const { return keys[keyId]; }
+    Key getKeyType() const { return key; }
+
+private:
+    Key key;
+    std::vector<std::string> keys;          // Interned keys by ID
+    std::vector<uint64_t> hashes;           // Hash of each key
+    std::vector<int32_t> slots;             // Key ID or -1; size is a power of two
+
+    // Accumulators by key ID; 'slotOf' maps a key ID to its group in this
+    // pass, valid while 'stamps' matches 'pass'
+    std::vector<uint32_t> stamps;
+    std::vector<uint32_t> slotOf;
+    uint32_t pass;
+    std::vector<ProcessGroup> groups;
+
+    uint32_t intern(const std::string& text);
+    void grow();
+    void reset();
+};
@@ -0,0 +1,220 @@
+#include "process_history.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Number of bits needed to represent a value
+static int bitLength(uint64_t value) {
+    int bits = 0;
+    while (value) {
+        bits++;
+        value >>= 1;
+    }
+    return bits;
+}
+
+// ProcessHistory constructor - allocates the whole pool up front
+ProcessHistory::ProcessHistory(size_t capacity)
+    : slots(capacity), generation(0), droppedCount(0) {
+    freeList.reserve(capacity);
+    for (size_t i = capacity; i > 0; i--) {
+        freeList.push_back(i - 1);
+    }
+    index.reserve(capacity);
+}
+
+// Read the 4-bit code at a position
+uint8_t ProcessHistory::getCode(const Series& series, int pos) {
+    uint8_t byte = series.codes[pos / 2];
+    return (pos & 1) ? (byte >> 4) : (byte & 0x0F);
+}
+
+// Write the 4-bit code at a position
+void ProcessHistory::setCode(Series& series, int pos, uint8_t code) {
+    uint8_t& byte = series.codes[pos / 2];
+    if (pos & 1) {
+        byte = (byte & 0x0F) | (code << 4);
+    } else {
+        byte = (byte & 0xF0) | code;
+    }
+}
+
+// Append a value to a series, growing its scale if needed
+void ProcessHistory::append(Slot& slot, Series& series, uint64_t value) {
+    int needed = bitLength(value);
+    if (needed > series.exponent) {
+        // Rescale existing codes to the larger exponent (rare)
+        int shift = needed - series.exponent;
+        for (int i = 0; i < SAMPLES; i++) {
+            uint8_t code = getCode(series, i);
+            setCode(series, i, shift >= 4 ? 0 : (code + (1 << (shift - 1))) >> shift);
+        }
+        series.exponent = needed;
+    }
+
+    uint64_t scale = series.exponent > 0 ? (1ULL << series.exponent) : 1;
+    uint8_t code = (uint8_t)std::min<uint64_t>(15, (value * 15 + scale / 2) / scale);
+    setCode(series, slot.head, code);
+}
+
+// Shrink the scale once old peaks have left the window
+void ProcessHistory::normalize(Series& series, int count) {
+    uint8_t maxCode = 0;
+    for (int i = 0; i < count; i++) {
+        maxCode = std::max(maxCode, getCode(series, i));
+    }
+
+    int shift = 0;
+    while (series.exponent > shift && (maxCode << (shift + 1)) <= 15) {
+        shift++;
+    }
+    if (shift == 0) {
+        return;
+    }
+
+    for (int i = 0; i < count; i++) {
+        setCode(series, i, getCode(series, i) << shift);
+    }
+    series.exponent -= shift;
+}
+
+// Convert a process field into the integer domain that is stored
+uint64_t ProcessHistory::quantizeInput(Metric metric, const Process& proc) {
+    switch (metric) {
+        case CPU:     return (uint64_t)std::lround(std::max(0.0, proc.cpuPercent) * 10);
+        case RSS:     return proc.vmRSS > 0 ? proc.vmRSS : 0;
+        case THREADS: return proc.numThreads > 0 ? proc.numThreads : 0;
+        default:      return 0;
+    }
+}
+
+// Convert a stored value back to the field's unit
+double ProcessHistory::scaleOutput(Metric metric, double value) {
+    return metric == CPU ? value / 10.0 : value;
+}
+
+// Append one sample per process and release slots of exited processes
+void ProcessHistory::update(const std::vector<Process>& processes) {
+    generation++;
+    droppedCount = 0;
+
+    for (const auto& proc : processes) {
+        ProcessKey key = proc.key();
+        uint32_t slotIndex;
+
+        auto it = index.find(key);
+        if (it != index.end()) {
+            slotIndex = it->second;
+        } else {
+            if (freeList.empty()) {
+                droppedCount++;
+                continue;
+            }
+            slotIndex = freeList.back();
+            freeList.pop_back();
+
+            slots[slotIndex] = Slot();
+            index.emplace(key, slotIndex);
+        }
+
+        Slot& slot = slots[slotIndex];
+        slot.generation = generation;
+        for (int m = 0; m < METRIC_COUNT; m++) {
+            append(slot, slot.series[m], quantizeInput((Metric)m, proc));
+        }
+
+        slot.head = (slot.head + 1) % SAMPLES;
+        if (slot.count < SAMPLES) {
+            slot.count++;
+        }
+
+        // Once per full window, tighten scales (amortized O(1))
+        if (slot.head == 0) {
+            for (int m = 0; m < METRIC_COUNT; m++) {
+                normalize(slot.series[m], slot.count);
+            }
+        }
+    }
+
+    // Evict processes that were not seen in this update
+    for (auto it = index.begin(); it != index.end(); ) {
+        if (slots[it->second].generation != generation) {
+            freeList.push_back(it->second);
+            it = index.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+// Get decoded samples for a process, oldest first
+int ProcessHistory::getSamples(const ProcessKey& key, Metric metric,
+                               std::vector<double>& out) const {
+    out.clear();
+
+    auto it = index.find(key);
+    if (it == index.end()) {
+        return 0;
+    }
+
+    const Slot& slot = slots[it->second];
+    const Series& series = slot.series[metric];
+    double scale = series.exponent > 0 ? (double)(1ULL << series.exponent) : 1.0;
+
+    int start = (slot.head - slot.count + SAMPLES) % SAMPLES;
+    for (int i = 0; i < slot.count; i++) {
+        uint8_t code = getCode(series, (start + i) % SAMPLES);
+        out.push_back(scaleOutput(metric, code * scale / 15.0));
+    }
+
+    return slot.count;
+}
+
+// Render recent samples as a sparkline, scaled to the window maximum
+std::string ProcessHistory::sparkline(const ProcessKey& key, Metric metric, int width) const {
+    static const char levels[] = " .:-=+*#%@";
+    static const int levelCount = sizeof(levels) - 1;
+
+    std::string line(std::max(0, width), ' ');
+
+    auto it = index.find(key);
+    if (it == index.end() || width <= 0) {
+        return line;
+    }
+
+    const Slot& slot = slots[it->second];
+    const Series& series = slot.series[metric];
+    int count = std::min<int>(slot.count, width);
+
+    uint8_t maxCode = 0;
+    for (int i = 0; i < count; i++) {
+        maxCode = std::max(maxCode, getCode(series, (slot.head - 1 - i + SAMPLES) % SAMPLES));
+    }
+
+    // Right-align so the newest sample is always the last character
+    for (int i = 0; i < count; i++) {
+        uint8_t code = getCode(series, (slot.head - 1 - i + SAMPLES) % SAMPLES);
+        int level = maxCode > 0 ? (code * (levelCount - 1) + maxCode - 1) / maxCode : 0;
+        line[width - 1 - i] = levels[level];
+    }
+
+    return line;
+}
+
+// Release every slot
+void ProcessHistory::clear() {
+    index.clear();
+    freeList.clear();
+    for (size_t i = slots.size(); i > 0; i--) {
+        freeList.push_back(i - 1);
+    }
+    droppedCount = 0;
+}
+
+// Total memory used by the pool and the index
+size_t ProcessHistory::memoryUsage() const {
+    size_t nodeSize = sizeof(ProcessKey) + sizeof(uint32_t) + 2 * sizeof(void*);
+    return slots.capacity() * sizeof(Slot) +
+           freeList.capacity() * sizeof(uint32_t) +
+           index.bucket_count() * sizeof(void*) +
+           index.size() * nodeSize;
+}
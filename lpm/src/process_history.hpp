@@ -0,0 +1,82 @@
+#pragma once
+
+#include "process.hpp"
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <cstdint>
+
+// Recent samples of CPU%, RSS and thread count per process instance.
+//
+// Each process owns one fixed-size slot from a pool allocated up front.
+// Samples are quantized to 4-bit codes relative to a per-series
+// power-of-two scale, so a 60-sample series takes 31 bytes and a
+// process with all three series takes 96 bytes.
+// Appending a sample is O(1); slots are released when a process exits.
+class ProcessHistory {
+public:
+    static const int SAMPLES = 60;
+
+    enum Metric {
+        CPU,
+        RSS,
+        THREADS,
+        METRIC_COUNT
+    };
+
+    explicit ProcessHistory(size_t capacity = 8192);
+
+    // Append one sample for every process and evict exited ones
+    void update(const std::vector<Process>& processes);
+
+    // Forget all samples (e.g. after jumping to another point in a recording)
+    void clear();
+
+    // Decoded samples for a process, oldest first. Returns sample count.
+    int getSamples(const ProcessKey& key, Metric metric, std::vector<double>& out) const;
+
+    // Render the newest 'width' samples as an ASCII sparkline
+    std::string sparkline(const ProcessKey& key, Metric metric, int width) const;
+
+    // Number of processes currently tracked
+    size_t size() const { return index.size(); }
+
+    // Maximum number of processes that can be tracked
+    size_t capacity() const { return slots.size(); }
+
+    // Processes not tracked because the pool was full (last update)
+    size_t dropped() const { return droppedCount; }
+
+    // Bytes of sample storage per process
+    static size_t bytesPerProcess() { return sizeof(Slot); }
+
+    // Total memory used by the store (pool + index)
+    size_t memoryUsage() const;
+
+private:
+    // One quantized series: 4-bit codes, value = code / 15 * 2^exponent
+    struct Series {
+        uint8_t exponent;
+        uint8_t codes[SAMPLES / 2];
+    };
+
+    struct Slot {
+        uint8_t generation;    // Last update that saw this process
+        uint8_t head;          // Next write position
+        uint8_t count;         // Valid samples
+        Series series[METRIC_COUNT];
+    };
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeList;
+    std::unordered_map<ProcessKey, uint32_t, ProcessKeyHash> index;
+    uint8_t generation;
+    size_t droppedCount;
+
+    static uint8_t getCode(const Series& series, int pos);
+    static void setCode(Series& series, int pos, uint8_t code);
+    static void append(Slot& slot, Series& series, uint64_t value);
+    static void normalize(Series& series, int count);
+    static uint64_t quantizeInput(Metric metric, const Process& proc);
+    static double scaleOutput(Metric metric, double value);
+};
@@ -0,0 +1,131 @@
+#include "process_leaks.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+LeakDetector::LeakDetector(double halfLifeSeconds)
+    : halfLife(halfLifeSeconds), thresholds{10, 120.0, 1024.0, 5.0, 0.8},
+      origin(0), lastTimestamp(0), generation(0) {
+}
+
+void LeakDetector::clear() {
+    fits.clear();
+    origin = 0;
+    lastTimestamp = 0;
+}
+
+void LeakDetector::update(const std::vector<Process>& processes, int64_t timestampNs) {
+    if (!fits.empty() && timestampNs <= lastTimestamp) {
+        clear();
+    }
+    if (fits.empty()) {
+        origin = timestampNs;
+    }
+    lastTimestamp = timestampNs;
+    generation++;
+
+    double t = (timestampNs - origin) / 1e9;
+    for (const auto& proc : processes) {
+        if (proc.vmRSS <= 0) {
+            continue;
+        }
+        double y = (double)proc.vmRSS;
+
+        auto it = fits.find(proc.key());
+        if (it == fits.end()) {
+            Fit fit{1.0, 1.0, t, y, 0.0, 0.0, 0.0, t, t, 1, proc.vmRSS, generation};
+            fits.emplace(proc.key(), fit);
+            continue;
+        }
+
+        // Weighted running co-moments (West), older samples decayed
+        Fit& fit = it->second;
+        double decay = std::exp2(-(t - fit.lastT) / halfLife);
+        fit.weight = decay * fit.weight + 1.0;
+        fit.weight2 = decay * decay * fit.weight2 + 1.0;
+        double dx = t - fit.meanT;
+        double dy = y - fit.meanY;
+        fit.meanT += dx / fit.weight;
+        fit.meanY += dy / fit.weight;
+        fit.sxx = decay * fit.sxx + dx * (t - fit.meanT);
+        fit.sxy = decay * fit.sxy + dx * (y - fit.meanY);
+        fit.syy = decay * fit.syy + dy * (y - fit.meanY);
+        fit.lastT = t;
+        fit.samples++;
+        fit.rssKB = proc.vmRSS;
+        fit.generation = generation;
+    }
+
+    for (auto it = fits.begin(); it != fits.end(); ) {
+        if (it->second.generation != generation) {
+            it = fits.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+LeakTrend LeakDetector::evaluate(const Fit& fit) const {
+    LeakTrend trend{0.0, 0.0, 0.0, fit.lastT - fit.firstT, fit.samples, fit.rssKB, false};
+    if (fit.sxx <= 0.0) {
+        return trend;
+    }
+
+    trend.slope = fit.sxy / fit.sxx;
+    double explained = trend.slope * fit.sxy;
+    double residual = std::max(0.0, fit.syy - explained);
+    trend.fit = fit.syy > 0.0 ? explained / fit.syy : 0.0;
+
+    // Standard error of the slope with the effective (decayed) sample count
+    double n = fit.weight * fit.weight / fit.weight2;
+    if (n > 2.0 && trend.slope != 0.0) {
+        double error = std::sqrt(residual / (n - 2.0) / fit.sxx);
+        trend.tScore = error > 0.0 ? trend.slope / error : std::copysign(1e9, trend.slope);
+    }
+
+    trend.suspected = trend.samples >= thresholds.minSamples &&
+                      trend.spanSeconds >= thresholds.minSpanSeconds &&
+                      trend.slope * 3600.0 >= thresholds.minGrowthKBPerHour &&
+                      trend.tScore >= thresholds.minTScore &&
+                      trend.fit >= thresholds.minFit;
+    return trend;
+}
+
+bool LeakDetector::getTrend(const ProcessKey& key, LeakTrend& trend) const {
+    auto it = fits.find(key);
+    if (it == fits.end() || it->second.samples < 2) {
+        return false;
+    }
+    trend = evaluate(it->second);
+    return true;
+}
+
+std::vector<std::pair<ProcessKey, LeakTrend>> LeakDetector::getSuspects() const {
+    std::vector<std::pair<ProcessKey, LeakTrend>> suspects;
+    for (const auto& entry : fits) {
+        LeakTrend trend = evaluate(entry.second);
+        if (trend.suspected) {
+            suspects.emplace_back(entry.first, trend);
+        }
+    }
+    std::sort(suspects.begin(), suspects.end(), [](const auto& a, const auto& b) {
+        return a.second.slope > b.second.slope;
+    });
+    return suspects;
+}
+
+std::string LeakDetector::formatGrowth(double kbPerHour) {
+    char buf[16];
+    double size = std::fabs(kbPerHour);
+    const char* sign = kbPerHour < 0 ? "-" : "+";
+    if (size < 1.0) {
+        return "0";
+    } else if (size >= 1024.0 * 1024) {
+        snprintf(buf, sizeof(buf), "%s%.1fG", sign, size / (1024.0 * 1024));
+    } else if (size >= 1024.0) {
+        snprintf(buf, sizeof(buf), "%s%.1fM", sign, size / 1024.0);
+    } else {
+        snprintf(buf, sizeof(buf), "%s%.0fK", sign, size);
+    }
+    return buf;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "process.hpp"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+// RSS trend of one process
+struct LeakTrend {
+    double slope;                   // kB per second
+    double tScore;                  // slope / its standard error
+    double fit;                     // R squared of the line
+    double spanSeconds;             // Time since the first sample
+    uint32_t samples;
+    long rssKB;                     // Latest RSS
+    bool suspected;
+};
+
+// Finds processes whose RSS grows steadily. Each (pid, starttime) keeps an
+// online least-squares fit of RSS against time in constant memory: running
+// means and co-moments, updated per sample and exponentially decayed so the
+// fit follows the last 'halfLife' seconds. A process is a suspected leak
+// once the fitted growth is positive, fast enough, and significant: the
+// slope is several standard errors from zero over a long enough window.
+//
+// Timestamps may be monotonic (live) or wall clock (recordings); going
+// back in time starts over.
+class LeakDetector {
+public:
+    struct Thresholds {
+        uint32_t minSamples;
+        double minSpanSeconds;
+        double minGrowthKBPerHour;
+        double minTScore;
+        double minFit;              // R squared; rules out one-off steps
+    };
+
+    explicit LeakDetector(double halfLifeSeconds = 1800);
+
+    void setThresholds(const Thresholds& thresholds) { this->thresholds = thresholds; }
+    const Thresholds& getThresholds() const { return thresholds; }
+
+    // Add one sample per process taken at 'timestampNs'; exited processes
+    // are forgotten
+    void update(const std::vector<Process>& processes, int64_t timestampNs);
+
+    void clear();
+
+    // Trend of a process; false until it has two samples
+    bool getTrend(const ProcessKey& key, LeakTrend& trend) const;
+
+    // Suspected leaks, fastest growing first
+    std::vector<std::pair<ProcessKey, LeakTrend>> getSuspects() const;
+
+    size_t size() const { return fits.size(); }
+
+    // "+1.5M", "-200K" for a growth in kB per hour
+    static std::string formatGrowth(double kbPerHour);
+
+private:
+    struct Fit {
+        double weight;              // Decayed sample count and its square sum
+        double weight2;
+        double meanT;               // Seconds since 'origin'
+        double meanY;               // kB
+        double sxx;
+        double sxy;
+        double syy;
+        double firstT;
+        double lastT;
+        uint32_t samples;
+        long rssKB;
+        uint32_t generation;
+    };
+
+    double halfLife;
+    Thresholds thresholds;
+    std::unordered_map<ProcessKey, Fit, ProcessKeyHash> fits;
+    int64_t origin;                 // Timestamp of the first sample
+    int64_t lastTimestamp;
+    uint32_t generation;
+
+    LeakTrend evaluate(const Fit& fit) const;
+};
@@ -0,0 +1,132 @@
+#include "process_memory.hpp"
+#include "process_source.hpp"
+#include "process_profile.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+MemoryCollector::MemoryCollector()
+    : tick(0), budgetNs(20000000), cost() {
+}
+
+// Start a refresh
+void MemoryCollector::beginRefresh() {
+    tick++;
+    cost = Cost();
+}
+
+// Read one process if its cached entry is due
+bool MemoryCollector::refresh(const Process& proc, ProcessSource& source, bool useBudget,
+                              uint64_t start) {
+    Entry& entry = cache[proc.key()];
+    if (entry.valid && entry.nextTick > tick) {
+        cost.cached++;
+        return true;
+    }
+    if (useBudget && Profiler::now() - start > budgetNs) {
+        cost.deferred++;
+        return true;
+    }
+
+    MemoryUsage usage;
+    {
+        ScopedTimer timer(Profiler::STAGE_SMAPS);
+        cost.reads++;
+        if (!source.readMemoryUsage(proc.pid, usage)) {
+            cache.erase(proc.key());
+            return false;
+        }
+    }
+
+    // Back off while PSS is stable (within 2%), read every refresh otherwise
+    if (!entry.valid) {
+        entry.interval = 1;
+    } else if (std::labs(usage.pss - entry.usage.pss) * 50 <= entry.usage.pss) {
+        entry.interval = std::min(entry.interval * 2, MAX_INTERVAL);
+    } else {
+        entry.interval = 1;
+    }
+    entry.usage = usage;
+    entry.nextTick = tick + entry.interval;
+    entry.valid = true;
+    return true;
+}
+
+// Refresh the named processes within the budget
+void MemoryCollector::update(const std::vector<const Process*>& candidates,
+                             ProcessSource& source) {
+    uint64_t start = Profiler::now();
+
+    for (const Process* proc : candidates) {
+        refresh(*proc, source, true, start);
+    }
+
+    cost.ns += Profiler::now() - start;
+}
+
+// Exact top-K by PSS with RSS as the upper bound
+std::vector<const Process*> MemoryCollector::topByPSS(const std::vector<Process>& processes,
+                                                      size_t count, ProcessSource& source) {
+    uint64_t start = Profiler::now();
+
+    std::vector<const Process*> byRSS;
+    byRSS.reserve(processes.size());
+    for (const auto& proc : processes) {
+        if (proc.vmRSS > 0) {
+            byRSS.push_back(&proc);
+        }
+    }
+    std::sort(byRSS.begin(), byRSS.end(),
+              [](const Process* a, const Process* b) { return a->vmRSS > b->vmRSS; });
+
+    // Min-heap of the best 'count' by PSS
+    auto largerPSS = [this](const Process* a, const Process* b) {
+        return cache[a->key()].usage.pss > cache[b->key()].usage.pss;
+    };
+    std::vector<const Process*> heap;
+    for (const Process* proc : byRSS) {
+        if (count == 0) {
+            break;
+        }
+        if (heap.size() == count && proc->vmRSS <= cache[heap.front()->key()].usage.pss) {
+            break;
+        }
+        if (!refresh(*proc, source, false, start)) {
+            continue;
+        }
+        if (heap.size() < count) {
+            heap.push_back(proc);
+            std::push_heap(heap.begin(), heap.end(), largerPSS);
+        } else if (cache[proc->key()].usage.pss > cache[heap.front()->key()].usage.pss) {
+            std::pop_heap(heap.begin(), heap.end(), largerPSS);
+            heap.back() = proc;
+            std::push_heap(heap.begin(), heap.end(), largerPSS);
+        }
+    }
+    std::sort_heap(heap.begin(), heap.end(), largerPSS);
+
+    cost.ns += Profiler::now() - start;
+    return heap;
+}
+
+// Cached values for a process
+const MemoryUsage* MemoryCollector::find(const ProcessKey& key) const {
+    auto it = cache.find(key);
+    return it != cache.end() && it->second.valid ? &it->second.usage : nullptr;
+}
+
+// Forget processes that have exited
+void MemoryCollector::prune(const std::vector<Process>& processes) {
+    if (cache.empty()) {
+        return;
+    }
+
+    std::unordered_map<ProcessKey, Entry, ProcessKeyHash> alive;
+    alive.reserve(cache.size());
+    for (const auto& proc : processes) {
+        auto it = cache.find(proc.key());
+        if (it != cache.end()) {
+            alive.insert(*it);
+        }
+    }
+    cache.swap(alive);
+}
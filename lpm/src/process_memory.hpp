@@ -0,0 +1,77 @@
+#pragma once
+
+#include "process.hpp"
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+class ProcessSource;
+
+// Memory of a process with shared pages accounted for (kB)
+struct MemoryUsage {
+    long pss;      // Proportional set size: shared pages split among sharers
+    long uss;      // Unique set size: Private_Clean + Private_Dirty
+    long swap;
+
+    MemoryUsage() : pss(0), uss(0), swap(0) {}
+};
+
+// Precise (PSS/USS/swap) memory from smaps_rollup, which is expensive to
+// read, so only for the processes a caller names (top-K candidates or
+// visible rows). Results are cached: a process whose PSS stays stable is
+// re-read every 2, 4, ... up to MAX_INTERVAL refreshes, and one whose PSS
+// moves is re-read every refresh. Each refresh spends at most the budget;
+// due processes beyond it keep their cached values until the next one.
+class MemoryCollector {
+public:
+    static constexpr unsigned MAX_INTERVAL = 16;
+
+    // What the current refresh has cost so far
+    struct Cost {
+        uint64_t ns;         // Time spent reading smaps_rollup
+        size_t reads;        // Files read
+        size_t cached;       // Served from the cache (not yet due)
+        size_t deferred;     // Due but over the budget
+    };
+
+    MemoryCollector();
+
+    // Start a refresh: advance the cadence clock and reset the cost
+    void beginRefresh();
+
+    // Refresh the processes in 'candidates', most important first
+    void update(const std::vector<const Process*>& candidates, ProcessSource& source);
+
+    // Exact top 'count' processes by PSS. Processes are visited in
+    // descending RSS order and, since PSS never exceeds RSS, reading stops
+    // once the next RSS cannot beat the count-th largest PSS. The budget
+    // does not apply.
+    std::vector<const Process*> topByPSS(const std::vector<Process>& processes, size_t count,
+                                         ProcessSource& source);
+
+    // Cached values for a process, or nullptr if never read
+    const MemoryUsage* find(const ProcessKey& key) const;
+
+    // Forget processes that are not in 'processes'
+    void prune(const std::vector<Process>& processes);
+
+    void setBudget(uint64_t ns) { budgetNs = ns; }
+    const Cost& getCost() const { return cost; }
+
+private:
+    struct Entry {
+        MemoryUsage usage;
+        unsigned long nextTick;    // Refresh at which the entry is due
+        unsigned interval;         // Refreshes between reads
+        bool valid;
+    };
+
+    std::unordered_map<ProcessKey, Entry, ProcessKeyHash> cache;
+    unsigned long tick;
+    uint64_t budgetNs;
+    Cost cost;
+
+    // Read one process if due; false if it has no smaps_rollup
+    bool refresh(const Process& proc, ProcessSource& source, bool useBudget, uint64_t start);
+};
@@ -0,0 +1,521 @@
+#include "process_metrics.hpp"
+#include "process_source.hpp"
+#include <algorithm>
+#include <iterator>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+// Metadata of each family, written once per body
+static const char* const PROCESS_HEADERS[] = {
+    "# HELP lpm_process_resident_bytes Resident set size.\n"
+    "# TYPE lpm_process_resident_bytes gauge\n"
+    "# UNIT lpm_process_resident_bytes bytes\n",
+    "# HELP lpm_process_cpu_percent CPU usage over the last interval, percent of all CPUs.\n"
+    "# TYPE lpm_process_cpu_percent gauge\n",
+    "# HELP lpm_process_threads Threads.\n"
+    "# TYPE lpm_process_threads gauge\n",
+};
+static const char* const PROCESS_NAMES[] = {
+    "lpm_process_resident_bytes", "lpm_process_cpu_percent", "lpm_process_threads",
+};
+static const char* const GROUP_SUFFIXES[] = {
+    "_processes", "_resident_bytes", "_cpu_percent",
+};
+static const char* const GROUP_HELP[] = {
+    "Processes.", "Resident set size of all processes.",
+    "CPU usage over the last interval, percent of all CPUs.",
+};
+
+// MetricsExporter implementation
+
+MetricsExporter::MetricsExporter(size_t topK)
+    : topK(topK), total{0, 0, 0.0, 0}, other(), rendered(0) {
+    users.kind = "user";
+    cgroups.kind = "cgroup";
+    users.total = cgroups.total = Totals{0, 0, 0.0, 0};
+    other.labels = "{pid=\"other\"}";
+    users.other.labels = "{user=\"other\"}";
+    cgroups.other.labels = "{cgroup=\"other\"}";
+}
+
+// Interned ID of a user or cgroup, adding it if new
+int MetricsExporter::GroupSet::intern(const std::string& name) {
+    auto it = ids.find(name);
+    if (it != ids.end()) {
+        return it->second;
+    }
+
+    GroupSeries group;
+    group.labels = std::string("{") + kind + "=\"";
+    appendEscaped(group.labels, name);
+    group.labels += "\"}";
+    group.totals = Totals{0, 0, 0.0, 0};
+    group.dirty = true;
+    group.shown = false;
+    groups.push_back(group);
+    ids.emplace(name, (int)groups.size() - 1);
+    return (int)groups.size() - 1;
+}
+
+void MetricsExporter::accumulate(Totals& totals, const ProcessSeries& entry, int sign) {
+    totals.count += sign;
+    totals.rssKB += sign * entry.rssKB;
+    totals.cpuPercent += sign * entry.cpuPercent;
+    totals.threads += sign * entry.threads;
+    // Sums of doubles drift; an empty set is exactly zero
+    if (totals.count == 0) {
+        totals = Totals{0, 0, 0.0, 0};
+    }
+}
+
+// Add or remove one process's share of the totals and of its user and
+// cgroup, and its place in the rankings. Called with -1 before a series
+// changes and +1 after, so the ordered sets never hold stale values.
+void MetricsExporter::contribute(ProcessSeries& entry, int sign) {
+    if (sign < 0) {
+        byRss.erase(std::make_tuple(entry.rssKB, entry.pid, &entry));
+        byCpu.erase(std::make_tuple(entry.cpuPercent, entry.pid, &entry));
+    } else {
+        byRss.emplace(entry.rssKB, entry.pid, &entry);
+        byCpu.emplace(entry.cpuPercent, entry.pid, &entry);
+    }
+    accumulate(total, entry, sign);
+
+    std::pair<GroupSet*, int> targets[] = {{&users, entry.user}, {&cgroups, entry.cgroup}};
+    for (const auto& target : targets) {
+        if (target.second < 0) {
+            continue;
+        }
+        GroupSet& set = *target.first;
+        GroupSeries& group = set.groups[target.second];
+        if (group.totals.count > 0) {
+            set.byRss.erase({group.totals.rssKB, target.second});
+        }
+        accumulate(group.totals, entry, sign);
+        accumulate(set.total, entry, sign);
+        if (group.totals.count > 0) {
+            set.byRss.emplace(group.totals.rssKB, target.second);
+        }
+        group.dirty = true;
+    }
+}
+
+void MetricsExporter::add(const Process& proc, ProcessSource& source) {
+    ProcessSeries& entry = series[proc.key()];
+    entry.pid = proc.pid;
+    entry.labels = processLabels(proc);
+    entry.user = users.intern(proc.user.empty() ? "unknown" : proc.user);
+    std::string path;
+    entry.cgroup = source.readCgroup(proc.pid, path) ? cgroups.intern(path) : -1;
+    entry.rssKB = proc.vmRSS;
+    entry.cpuPercent = proc.cpuPercent;
+    entry.threads = proc.numThreads;
+    entry.dirty = true;
+    entry.shown = false;
+    contribute(entry, 1);
+}
+
+void MetricsExporter::remove(const Process& proc) {
+    auto it = series.find(proc.key());
+    if (it != series.end()) {
+        contribute(it->second, -1);
+        if (it->second.shown) {
+            shown.erase(std::find(shown.begin(), shown.end(), &it->second));
+        }
+        series.erase(it);
+    }
+}
+
+// Apply one change set
+void MetricsExporter::update(const std::vector<Process>& processes, const SnapshotDiff& diff,
+                             ProcessSource& source, int64_t timestamp) {
+    const uint32_t exported = SnapshotDiff::FIELD_NAME | SnapshotDiff::FIELD_USER |
+                              SnapshotDiff::FIELD_VMRSS | SnapshotDiff::FIELD_CPU |
+                              SnapshotDiff::FIELD_THREADS;
+
+    for (const Process* proc : diff.getRemoved()) {
+        remove(*proc);
+    }
+    for (const Process* proc : diff.getAdded()) {
+        add(*proc, source);
+    }
+    for (const auto& change : diff.getChanged()) {
+        if (!(change.fields & exported)) {
+            continue;
+        }
+        auto it = series.find(change.current->key());
+        if (it == series.end()) {
+            continue;
+        }
+
+        const Process& proc = *change.current;
+        ProcessSeries& entry = it->second;
+        contribute(entry, -1);
+        if (change.fields & (SnapshotDiff::FIELD_NAME | SnapshotDiff::FIELD_USER)) {
+            entry.labels = processLabels(proc);
+            entry.user = users.intern(proc.user.empty() ? "unknown" : proc.user);
+        }
+        entry.rssKB = proc.vmRSS;
+        entry.cpuPercent = proc.cpuPercent;
+        entry.threads = proc.numThreads;
+        entry.dirty = true;
+        contribute(entry, 1);
+    }
+
+    rendered = 0;
+    selectProcesses();
+    selectGroups(users);
+    selectGroups(cgroups);
+    assemble(processes.size(), timestamp);
+}
+
+// Top K by RSS plus top K by CPU%, in PID order; the rest go to 'other'
+void MetricsExporter::selectProcesses() {
+    // Idle processes and kernel threads would only fill the lists with
+    // arbitrary picks
+    std::vector<ProcessSeries*> next;
+    for (auto it = byRss.rbegin(); it != byRss.rend() && next.size() < topK &&
+                                   std::get<0>(*it) > 0; ++it) {
+        next.push_back(std::get<2>(*it));
+    }
+    size_t limit = next.size() + topK;
+    for (auto it = byCpu.rbegin(); it != byCpu.rend() && next.size() < limit &&
+                                   std::get<0>(*it) > 0; ++it) {
+        next.push_back(std::get<2>(*it));
+    }
+    std::sort(next.begin(), next.end(),
+              [](const ProcessSeries* a, const ProcessSeries* b) { return a->pid < b->pid; });
+    next.erase(std::unique(next.begin(), next.end()), next.end());
+
+    // Newly shown series may hold lines from before they dropped out
+    for (ProcessSeries* entry : next) {
+        if (entry->dirty || !entry->shown) {
+            renderProcess(*entry);
+        }
+    }
+
+    for (ProcessSeries* entry : shown) {
+        entry->shown = false;
+    }
+    Totals rest = total;
+    for (ProcessSeries* entry : next) {
+        entry->shown = true;
+        rest.count--;
+        rest.rssKB -= entry->rssKB;
+        rest.cpuPercent -= entry->cpuPercent;
+        rest.threads -= entry->threads;
+    }
+    shown.swap(next);
+
+    other.rssKB = rest.rssKB;
+    other.cpuPercent = rest.count > 0 ? std::max(0.0, rest.cpuPercent) : 0.0;
+    other.threads = (int)rest.threads;
+    renderProcess(other);
+}
+
+// Top K groups by RSS, in name order; the rest go to the set's 'other'
+void MetricsExporter::selectGroups(GroupSet& set) {
+    std::vector<int> ranked;
+    for (auto it = set.byRss.rbegin(); it != set.byRss.rend() && ranked.size() < topK; ++it) {
+        ranked.push_back(it->second);
+    }
+    std::sort(ranked.begin(), ranked.end(),
+              [&set](int a, int b) { return set.groups[a].labels < set.groups[b].labels; });
+
+    for (int id : set.shown) {
+        set.groups[id].shown = false;
+    }
+    Totals& rest = set.other.totals;
+    rest = set.total;
+    for (int id : ranked) {
+        GroupSeries& group = set.groups[id];
+        if (group.dirty || !group.shown) {
+            renderGroup(set, group);
+        }
+        group.shown = true;
+        rest.count -= group.totals.count;
+        rest.rssKB -= group.totals.rssKB;
+        rest.cpuPercent -= group.totals.cpuPercent;
+    }
+    if (rest.count == 0 || rest.cpuPercent < 0) {
+        rest.cpuPercent = 0.0;
+    }
+    set.shown.swap(ranked);
+    renderGroup(set, set.other);
+}
+
+void MetricsExporter::renderProcess(ProcessSeries& entry) {
+    double values[PROCESS_FAMILIES] = {
+        entry.rssKB * 1024.0, entry.cpuPercent, (double)entry.threads,
+    };
+    for (int family = 0; family < PROCESS_FAMILIES; family++) {
+        std::string& line = entry.lines[family];
+        line.assign(PROCESS_NAMES[family]);
+        line += entry.labels;
+        line += ' ';
+        appendNumber(line, values[family]);
+        line += '\n';
+    }
+    entry.dirty = false;
+    rendered++;
+}
+
+void MetricsExporter::renderGroup(const GroupSet& set, GroupSeries& group) {
+    double values[GROUP_FAMILIES] = {
+        (double)group.totals.count, group.totals.rssKB * 1024.0, group.totals.cpuPercent,
+    };
+    for (int family = 0; family < GROUP_FAMILIES; family++) {
+        std::string& line = group.lines[family];
+        line.assign("lpm_");
+        line += set.kind;
+        line += GROUP_SUFFIXES[family];
+        line += group.labels;
+        line += ' ';
+        appendNumber(line, values[family]);
+        line += '\n';
+    }
+    group.dirty = false;
+    rendered++;
+}
+
+// Concatenate the rendered lines of the shown series
+void MetricsExporter::assemble(size_t processCount, int64_t timestamp) {
+    body.clear();
+    body += "# HELP lpm_processes Processes in the last snapshot.\n"
+            "# TYPE lpm_processes gauge\n"
+            "lpm_processes ";
+    appendNumber(body, (double)processCount);
+    body += "\n# HELP lpm_snapshot_timestamp_seconds When the last snapshot was taken.\n"
+            "# TYPE lpm_snapshot_timestamp_seconds gauge\n"
+            "# UNIT lpm_snapshot_timestamp_seconds seconds\n"
+            "lpm_snapshot_timestamp_seconds ";
+    char stamp[32];
+    snprintf(stamp, sizeof(stamp), "%.3f\n", timestamp / 1e9);
+    body += stamp;
+
+    for (int family = 0; family < PROCESS_FAMILIES; family++) {
+        body += PROCESS_HEADERS[family];
+        for (const ProcessSeries* entry : shown) {
+            body += entry->lines[family];
+        }
+        body += other.lines[family];
+    }
+
+    for (const GroupSet* set : {&users, &cgroups}) {
+        if (set->shown.empty()) {
+            continue;
+        }
+        for (int family = 0; family < GROUP_FAMILIES; family++) {
+            std::string name = std::string("lpm_") + set->kind + GROUP_SUFFIXES[family];
+            body += "# HELP " + name + " " + GROUP_HELP[family] + "\n";
+            body += "# TYPE " + name + " gauge\n";
+            if (family == GROUP_RSS) {
+                body += "# UNIT " + name + " bytes\n";
+            }
+            for (int id : set->shown) {
+                body += set->groups[id].lines[family];
+            }
+            body += set->other.lines[family];
+        }
+    }
+    body += "# EOF\n";
+}
+
+std::string MetricsExporter::processLabels(const Process& proc) {
+    std::string labels = "{pid=\"" + std::to_string(proc.pid) + "\",name=\"";
+    appendEscaped(labels, proc.name);
+    labels += "\",user=\"";
+    appendEscaped(labels, proc.user);
+    labels += "\"}";
+    return labels;
+}
+
+// Label values escape backslash, double quote and newline
+void MetricsExporter::appendEscaped(std::string& out, const std::string& value) {
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            out += '\\';
+            out += c;
+        } else if (c == '\n') {
+            out += "\\n";
+        } else {
+            out += c;
+        }
+    }
+}
+
+// Integers exactly, fractions to two decimals
+void MetricsExporter::appendNumber(std::string& out, double value) {
+    char text[32];
+    if (value == std::floor(value) && std::fabs(value) < 1e15) {
+        snprintf(text, sizeof(text), "%lld", (long long)value);
+    } else {
+        snprintf(text, sizeof(text), "%.2f", value);
+    }
+    out += text;
+}
+
+// MetricsServer implementation
+
+MetricsServer::MetricsServer() : listenFd(-1), scrapes(0) {
+}
+
+MetricsServer::~MetricsServer() {
+    close();
+}
+
+// Listen on a Unix socket path or an IPv4 address and port
+bool MetricsServer::open(const std::string& address, std::string& error) {
+    close();
+
+    if (address.compare(0, 5, "unix:") == 0) {
+        std::string path = address.substr(5);
+        struct sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+            error = "invalid socket path: " + path;
+            return false;
+        }
+        std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+        // A socket left behind by an earlier run; never remove anything else
+        struct stat info;
+        if (stat(path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode)) {
+            unlink(path.c_str());
+        }
+
+        listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (listenFd < 0 || bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+            listen(listenFd, 16) != 0) {
+            error = "cannot listen on " + path + ": " + strerror(errno);
+            close();
+            return false;
+        }
+        socketPath = path;
+        return true;
+    }
+
+    size_t colon = address.rfind(':');
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    std::string host = colon == std::string::npos ? "" : address.substr(0, colon);
+    long port = colon == std::string::npos ? 0 : std::strtol(address.c_str() + colon + 1, nullptr, 10);
+    if (port <= 0 || port > 65535 || inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+        error = "invalid address: " + address + " (use unix:/path or HOST:PORT)";
+        return false;
+    }
+    addr.sin_port = htons((uint16_t)port);
+
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int reuse = 1;
+    if (listenFd < 0 ||
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0 ||
+        bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(listenFd, 16) != 0) {
+        error = "cannot listen on " + address + ": " + strerror(errno);
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MetricsServer::close() {
+    if (listenFd >= 0) {
+        ::close(listenFd);
+        listenFd = -1;
+    }
+    if (!socketPath.empty()) {
+        unlink(socketPath.c_str());
+        socketPath.clear();
+    }
+}
+
+// Accept and answer scrapes until the timeout (or a signal)
+void MetricsServer::serve(const std::string& body, int timeoutMs) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while (listenFd >= 0) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int elapsedMs = (int)((now.tv_sec - start.tv_sec) * 1000 +
+                              (now.tv_nsec - start.tv_nsec) / 1000000);
+        if (elapsedMs >= timeoutMs) {
+            return;
+        }
+
+        struct pollfd pfd = {listenFd, POLLIN, 0};
+        if (poll(&pfd, 1, timeoutMs - elapsedMs) <= 0) {
+            return;
+        }
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd >= 0) {
+            answer(fd, body);
+            ::close(fd);
+        }
+    }
+}
+
+// Read one request and write the response. A scraper that stalls is
+// dropped after a second so it cannot hold up collection.
+void MetricsServer::answer(int fd, const std::string& body) {
+    struct timeval timeout = {1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    char request[4096];
+    size_t length = 0;
+    while (length < sizeof(request) - 1) {
+        ssize_t n = recv(fd, request + length, sizeof(request) - 1 - length, 0);
+        if (n <= 0) {
+            break;
+        }
+        length += n;
+        request[length] = '\0';
+        if (std::strstr(request, "\r\n\r\n") || std::strstr(request, "\n\n")) {
+            break;
+        }
+    }
+    request[length] = '\0';
+
+    std::string header;
+    const std::string* content = &body;
+    static const std::string notFound = "Not found: try /metrics\n";
+    if (std::strncmp(request, "GET /metrics ", 13) == 0 || std::strncmp(request, "GET / ", 6) == 0) {
+        header = "HTTP/1.0 200 OK\r\n"
+                 "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n";
+        scrapes++;
+    } else {
+        header = "HTTP/1.0 404 Not Found\r\nContent-Type: text/plain\r\n";
+        content = &notFound;
+    }
+    header += "Content-Length: " + std::to_string(content->size()) + "\r\n"
+              "Connection: close\r\n\r\n";
+
+    const std::string* parts[] = {&header, content};
+    for (const std::string* part : parts) {
+        size_t sent = 0;
+        while (sent < part->size()) {
+            ssize_t n = send(fd, part->data() + sent, part->size() - sent, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return;
+            }
+            sent += n;
+        }
+    }
+}
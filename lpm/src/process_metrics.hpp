@@ -0,0 +1,140 @@
+#pragma once
+
+#include "process.hpp"
+#include "process_snapshot.hpp"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <set>
+#include <tuple>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+class ProcessSource;
+
+// Maintains an OpenMetrics exposition of the process table. Per-process
+// series are limited to the top K by RSS and the top K by CPU%; users and
+// cgroups to the top K by RSS. Everything else is summed into series
+// labelled "other". Updates apply SnapshotDiff change sets: totals and
+// the rankings (ordered sets by RSS and CPU%) are adjusted per changed
+// process, the top K are read off the front of the rankings, and only
+// series whose values changed are re-rendered. An update costs
+// O(changes log n) plus the size of the body; serving a scrape costs
+// nothing but writing the last body out.
+class MetricsExporter {
+public:
+    explicit MetricsExporter(size_t topK = 20);
+
+    // Apply the change set of 'diff' (just updated with 'processes'). New
+    // processes have their cgroup read from 'source' once.
+    void update(const std::vector<Process>& processes, const SnapshotDiff& diff,
+                ProcessSource& source, int64_t timestamp);
+
+    // The current exposition, ending with "# EOF"
+    const std::string& getBody() const { return body; }
+
+    // Series rendered by the last update (for --stats)
+    size_t getRenderedCount() const { return rendered; }
+
+private:
+    enum ProcessFamily { PROCESS_RSS, PROCESS_CPU, PROCESS_THREADS, PROCESS_FAMILIES };
+    enum GroupFamily { GROUP_COUNT, GROUP_RSS, GROUP_CPU, GROUP_FAMILIES };
+
+    struct Totals {
+        size_t count;
+        long rssKB;
+        double cpuPercent;
+        long threads;
+    };
+
+    struct ProcessSeries {
+        int pid;
+        std::string labels;                 // {pid="..",name="..",user=".."}
+        int user;                           // Group IDs
+        int cgroup;                         // -1 if unknown
+        long rssKB;
+        double cpuPercent;
+        int threads;
+        std::string lines[PROCESS_FAMILIES];
+        bool dirty;                         // Values changed since rendered
+        bool shown;
+    };
+
+    struct GroupSeries {
+        std::string labels;
+        Totals totals;
+        std::string lines[GROUP_FAMILIES];
+        bool dirty;
+        bool shown;
+    };
+
+    // Users and cgroups, interned; each has its own 'other'
+    struct GroupSet {
+        const char* kind;                   // "user" or "cgroup"
+        std::vector<GroupSeries> groups;
+        std::unordered_map<std::string, int> ids;
+        std::set<std::pair<long, int>> byRss;   // Non-empty groups, ascending
+        Totals total;                       // All groups
+        std::vector<int> shown;
+        GroupSeries other;
+
+        int intern(const std::string& name);
+    };
+
+    // Rankings ascending by value, then PID; read from the back
+    template <typename Value>
+    using Ranking = std::set<std::tuple<Value, int, ProcessSeries*>>;
+
+    size_t topK;
+    std::unordered_map<ProcessKey, ProcessSeries, ProcessKeyHash> series;
+    Ranking<long> byRss;
+    Ranking<double> byCpu;
+    Totals total;                           // All processes
+    std::vector<ProcessSeries*> shown;
+    ProcessSeries other;
+    GroupSet users;
+    GroupSet cgroups;
+    std::string body;
+    size_t rendered;
+
+    void add(const Process& proc, ProcessSource& source);
+    void remove(const Process& proc);
+    void contribute(ProcessSeries& entry, int sign);
+    void selectProcesses();
+    void selectGroups(GroupSet& set);
+    void renderProcess(ProcessSeries& entry);
+    void renderGroup(const GroupSet& set, GroupSeries& group);
+    void assemble(size_t processCount, int64_t timestamp);
+
+    static void accumulate(Totals& totals, const ProcessSeries& entry, int sign);
+    static std::string processLabels(const Process& proc);
+    static void appendEscaped(std::string& out, const std::string& value);
+    static void appendNumber(std::string& out, double value);
+};
+
+// Serves a MetricsExporter body over HTTP on a Unix socket or a TCP
+// address. One thread: the caller waits in poll() for scrapes and its
+// next collection deadline.
+class MetricsServer {
+public:
+    MetricsServer();
+    ~MetricsServer();
+
+    // Listen on "unix:/path" or "HOST:PORT" (IPv4)
+    bool open(const std::string& address, std::string& error);
+
+    // Answer scrapes with 'body' until 'timeoutMs' passes
+    void serve(const std::string& body, int timeoutMs);
+
+    void close();
+
+    uint64_t getScrapeCount() const { return scrapes; }
+
+private:
+    int listenFd;
+    std::string socketPath;             // Removed on close (Unix sockets)
+    uint64_t scrapes;
+
+    void answer(int fd, const std::string& body);
+};
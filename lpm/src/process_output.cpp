@@ -0,0 +1,448 @@
+#include "process_output.hpp"
+#include <charconv>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <unistd.h>
+
+// Binary stream layout (host byte order, not portable across endianness):
+//   header: "LPMP" magic, uint16 version (1), uint16 reserved
+//   record: uint16 length of the rest of the record, then
+//           int32 pid, int32 ppid, int64 vmSize, int64 vmRSS,
+//           uint64 utime, uint64 stime, int64 starttime, int32 threads,
+//           uint32 cpu (hundredths of a percent), uint8 state,
+//           uint8 name length + name, uint8 user length + user
+static const char BINARY_MAGIC[4] = {'L', 'P', 'M', 'P'};
+static const uint16_t BINARY_VERSION = 1;
+
+// OutputBuffer constructor
+OutputBuffer::OutputBuffer(int fd, size_t capacity)
+    : fd(fd), buffer(capacity), used(0), writeFailed(false) {
+}
+
+// Flush remaining data on destruction
+OutputBuffer::~OutputBuffer() {
+    flush();
+}
+
+// Flush the buffer if 'length' more bytes would not fit
+void OutputBuffer::reserve(size_t length) {
+    if (used + length > buffer.size()) {
+        flush();
+    }
+}
+
+// Append bytes to the buffer
+void OutputBuffer::write(const char* data, size_t length) {
+    if (length > buffer.size()) {
+        flush();
+        // Too large to buffer: write straight through
+        while (length > 0 && !writeFailed) {
+            ssize_t n = ::write(fd, data, length);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                writeFailed = true;
+                break;
+            }
+            data += n;
+            length -= n;
+        }
+        return;
+    }
+
+    reserve(length);
+    std::memcpy(buffer.data() + used, data, length);
+    used += length;
+}
+
+// Append one character
+void OutputBuffer::put(char c) {
+    reserve(1);
+    buffer[used++] = c;
+}
+
+// Append a signed integer
+void OutputBuffer::writeInt(long long value) {
+    reserve(24);
+    auto result = std::to_chars(buffer.data() + used, buffer.data() + buffer.size(), value);
+    used = result.ptr - buffer.data();
+}
+
+// Append an unsigned integer
+void OutputBuffer::writeUInt(unsigned long long value) {
+    reserve(24);
+    auto result = std::to_chars(buffer.data() + used, buffer.data() + buffer.size(), value);
+    used = result.ptr - buffer.data();
+}
+
+// Append a floating point value with fixed precision
+void OutputBuffer::writeDouble(double value, int precision) {
+    reserve(64);
+    auto result = std::to_chars(buffer.data() + used, buffer.data() + buffer.size(),
+                                value, std::chars_format::fixed, precision);
+    if (result.ec == std::errc()) {
+        used = result.ptr - buffer.data();
+    } else {
+        put('0');
+    }
+}
+
+// Write buffered data to the file descriptor
+bool OutputBuffer::flush() {
+    size_t offset = 0;
+    while (offset < used && !writeFailed) {
+        ssize_t n = ::write(fd, buffer.data() + offset, used - offset);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            writeFailed = true; // e.g. EPIPE when the reader went away
+            break;
+        }
+        offset += n;
+    }
+    used = 0;
+    return !writeFailed;
+}
+
+// ProcessWriter constructor
+ProcessWriter::ProcessWriter(Format format, OutputBuffer& out)
+    : format(format), out(out), includeIO(false), includeSched(false) {
+}
+
+// Parse an output format name
+bool ProcessWriter::parseFormat(const std::string& name, Format& format) {
+    if (name == "table") {
+        format = FORMAT_TABLE;
+    } else if (name == "json" || name == "jsonl") {
+        format = FORMAT_JSON;
+    } else if (name == "csv") {
+        format = FORMAT_CSV;
+    } else if (name == "binary") {
+        format = FORMAT_BINARY;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Write the stream header
+void ProcessWriter::begin() {
+    if (format == FORMAT_CSV) {
+        out.write(std::string("pid,ppid,name,user,state,vm_size_kb,vm_rss_kb,"
+                              "utime,stime,cpu_percent,threads,starttime"));
+        if (includeIO) {
+            out.write(std::string(",read_bytes,write_bytes,syscr,syscw,read_bytes_per_sec,"
+                                  "write_bytes_per_sec,syscr_per_sec,syscw_per_sec"));
+        }
+        if (includeSched) {
+            out.write(std::string(",run_ns,wait_ns,timeslices,voluntary_switches,"
+                                  "involuntary_switches,wait_percent,voluntary_per_sec,"
+                                  "involuntary_per_sec"));
+        }
+        out.put('\n');
+    } else if (format == FORMAT_BINARY) {
+        out.write(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+        out.writeRaw<uint16_t>(BINARY_VERSION);
+        out.writeRaw<uint16_t>(0);
+    }
+}
+
+// Length of the valid UTF-8 sequence starting at 'data', or 0 if it is
+// malformed (bad lead or continuation byte, overlong, surrogate, > U+10FFFF)
+static size_t utf8SequenceLength(const unsigned char* data, size_t available) {
+    unsigned char lead = data[0];
+    size_t length;
+    unsigned char min = 0x80, max = 0xBF;   // Allowed range of the second byte
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        if (lead == 0xE0) {
+            min = 0xA0;                     // Overlong
+        } else if (lead == 0xED) {
+            max = 0x9F;                     // UTF-16 surrogates
+        }
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        if (lead == 0xF0) {
+            min = 0x90;                     // Overlong
+        } else if (lead == 0xF4) {
+            max = 0x8F;                     // Above U+10FFFF
+        }
+    } else {
+        return 0;
+    }
+    
+    if (available < length || data[1] < min || data[1] > max) {
+        return 0;
+    }
+    for (size_t i = 2; i < length; i++) {
+        if ((data[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+    }
+    return length;
+}
+
+// Write a JSON string literal with escaping. comm and cmdline are
+// arbitrary bytes, so invalid UTF-8 is replaced with U+FFFD.
+void ProcessWriter::writeJSONString(const std::string& text) {
+    static const char hex[] = "0123456789abcdef";
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(text.data());
+    size_t size = text.size();
+
+    out.put('"');
+    for (size_t i = 0; i < size; ) {
+        unsigned char c = data[i];
+        if (c >= 0x80) {
+            size_t length = utf8SequenceLength(data + i, size - i);
+            if (length == 0) {
+                out.write("\\ufffd", 6);
+                i++;
+            } else {
+                out.write(text.data() + i, length);
+                i += length;
+            }
+            continue;
+        }
+        if (c == '"' || c == '\\') {
+            out.put('\\');
+            out.put(c);
+        } else if (c < 0x20) {
+            char escape[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+            out.write(escape, sizeof(escape));
+        } else {
+            out.put(c);
+        }
+        i++;
+    }
+    out.put('"');
+}
+
+// Write a CSV field, quoting only when needed
+void ProcessWriter::writeCSVField(const std::string& text) {
+    if (text.find_first_of(",\"\n\r") == std::string::npos) {
+        out.write(text);
+        return;
+    }
+
+    out.put('"');
+    for (char c : text) {
+        if (c == '"') {
+            out.put('"');
+        }
+        out.put(c);
+    }
+    out.put('"');
+}
+
+// Write one process
+void ProcessWriter::write(const Process& proc) {
+    switch (format) {
+        case FORMAT_JSON:
+            out.write("{\"pid\":", 7);
+            out.writeInt(proc.pid);
+            out.write(",\"ppid\":", 8);
+            out.writeInt(proc.ppid);
+            out.write(",\"name\":", 8);
+            writeJSONString(proc.name);
+            out.write(",\"user\":", 8);
+            writeJSONString(proc.user);
+            out.write(",\"state\":", 9);
+            writeJSONString(proc.state);
+            out.write(",\"vm_size_kb\":", 14);
+            out.writeInt(proc.vmSize);
+            out.write(",\"vm_rss_kb\":", 13);
+            out.writeInt(proc.vmRSS);
+            out.write(",\"utime\":", 9);
+            out.writeUInt(proc.utime);
+            out.write(",\"stime\":", 9);
+            out.writeUInt(proc.stime);
+            out.write(",\"cpu_percent\":", 15);
+            out.writeDouble(proc.cpuPercent, 2);
+            out.write(",\"threads\":", 11);
+            out.writeInt(proc.numThreads);
+            out.write(",\"starttime\":", 13);
+            out.writeInt(proc.starttime);
+            if (includeIO) {
+                out.write(",\"read_bytes\":", 14);
+                out.writeUInt(proc.readBytes);
+                out.write(",\"write_bytes\":", 15);
+                out.writeUInt(proc.writeBytes);
+                out.write(",\"syscr\":", 9);
+                out.writeUInt(proc.syscr);
+                out.write(",\"syscw\":", 9);
+                out.writeUInt(proc.syscw);
+                out.write(",\"read_bytes_per_sec\":", 22);
+                out.writeDouble(proc.readRate, 1);
+                out.write(",\"write_bytes_per_sec\":", 23);
+                out.writeDouble(proc.writeRate, 1);
+                out.write(",\"syscr_per_sec\":", 17);
+                out.writeDouble(proc.syscrRate, 1);
+                out.write(",\"syscw_per_sec\":", 17);
+                out.writeDouble(proc.syscwRate, 1);
+            }
+            if (includeSched) {
+                out.write(",\"run_ns\":", 10);
+                out.writeUInt(proc.runNs);
+                out.write(",\"wait_ns\":", 11);
+                out.writeUInt(proc.waitNs);
+                out.write(",\"timeslices\":", 14);
+                out.writeUInt(proc.timeslices);
+                out.write(",\"voluntary_switches\":", 22);
+                out.writeUInt(proc.voluntarySwitches);
+                out.write(",\"involuntary_switches\":", 24);
+                out.writeUInt(proc.involuntarySwitches);
+                out.write(",\"wait_percent\":", 16);
+                out.writeDouble(proc.waitPercent, 2);
+                out.write(",\"voluntary_per_sec\":", 21);
+                out.writeDouble(proc.voluntaryRate, 1);
+                out.write(",\"involuntary_per_sec\":", 23);
+                out.writeDouble(proc.involuntaryRate, 1);
+            }
+            out.write("}\n", 2);
+            break;
+
+        case FORMAT_CSV:
+            out.writeInt(proc.pid);
+            out.put(',');
+            out.writeInt(proc.ppid);
+            out.put(',');
+            writeCSVField(proc.name);
+            out.put(',');
+            writeCSVField(proc.user);
+            out.put(',');
+            writeCSVField(proc.state);
+            out.put(',');
+            out.writeInt(proc.vmSize);
+            out.put(',');
+            out.writeInt(proc.vmRSS);
+            out.put(',');
+            out.writeUInt(proc.utime);
+            out.put(',');
+            out.writeUInt(proc.stime);
+            out.put(',');
+            out.writeDouble(proc.cpuPercent, 2);
+            out.put(',');
+            out.writeInt(proc.numThreads);
+            out.put(',');
+            out.writeInt(proc.starttime);
+            if (includeIO) {
+                out.put(',');
+                out.writeUInt(proc.readBytes);
+                out.put(',');
+                out.writeUInt(proc.writeBytes);
+                out.put(',');
+                out.writeUInt(proc.syscr);
+                out.put(',');
+                out.writeUInt(proc.syscw);
+                out.put(',');
+                out.writeDouble(proc.readRate, 1);
+                out.put(',');
+                out.writeDouble(proc.writeRate, 1);
+                out.put(',');
+                out.writeDouble(proc.syscrRate, 1);
+                out.put(',');
+                out.writeDouble(proc.syscwRate, 1);
+            }
+            if (includeSched) {
+                out.put(',');
+                out.writeUInt(proc.runNs);
+                out.put(',');
+                out.writeUInt(proc.waitNs);
+                out.put(',');
+                out.writeUInt(proc.timeslices);
+                out.put(',');
+                out.writeUInt(proc.voluntarySwitches);
+                out.put(',');
+                out.writeUInt(proc.involuntarySwitches);
+                out.put(',');
+                out.writeDouble(proc.waitPercent, 2);
+                out.put(',');
+                out.writeDouble(proc.voluntaryRate, 1);
+                out.put(',');
+                out.writeDouble(proc.involuntaryRate, 1);
+            }
+            out.put('\n');
+            break;
+
+        case FORMAT_BINARY: {
+            uint8_t nameLength = (uint8_t)std::min<size_t>(proc.name.size(), 255);
+            uint8_t userLength = (uint8_t)std::min<size_t>(proc.user.size(), 255);
+            uint16_t length = 4 + 4 + 8 + 8 + 8 + 8 + 8 + 4 + 4 + 1 +
+                              1 + nameLength + 1 + userLength;
+
+            out.writeRaw<uint16_t>(length);
+            out.writeRaw<int32_t>(proc.pid);
+            out.writeRaw<int32_t>(proc.ppid);
+            out.writeRaw<int64_t>(proc.vmSize);
+            out.writeRaw<int64_t>(proc.vmRSS);
+            out.writeRaw<uint64_t>(proc.utime);
+            out.writeRaw<uint64_t>(proc.stime);
+            out.writeRaw<int64_t>(proc.starttime);
+            out.writeRaw<int32_t>(proc.numThreads);
+            out.writeRaw<uint32_t>((uint32_t)(proc.cpuPercent * 100 + 0.5));
+            out.writeRaw<uint8_t>(proc.state.empty() ? '?' : proc.state[0]);
+            out.writeRaw<uint8_t>(nameLength);
+            out.write(proc.name.data(), nameLength);
+            out.writeRaw<uint8_t>(userLength);
+            out.write(proc.user.data(), userLength);
+            break;
+        }
+
+        case FORMAT_TABLE:
+            break;
+    }
+}
+
+// CSV header of the group rows; JSON needs none
+void ProcessWriter::beginGroups(const char* keyField) {
+    if (format == FORMAT_CSV) {
+        out.write(std::string(keyField));
+        out.write(std::string(",count,threads,rss_kb,max_rss_kb,cpu_percent\n"));
+    }
+}
+
+// One group as a JSON object or CSV row
+void ProcessWriter::writeGroup(const char* keyField, const std::string& key,
+                               const ProcessGroup& group) {
+    if (format == FORMAT_JSON) {
+        out.put('{');
+        writeJSONString(keyField);
+        out.put(':');
+        writeJSONString(key);
+        out.write(",\"count\":", 9);
+        out.writeUInt(group.count);
+        out.write(",\"threads\":", 11);
+        out.writeInt(group.threads);
+        out.write(",\"rss_kb\":", 10);
+        out.writeInt(group.rssKB);
+        out.write(",\"max_rss_kb\":", 14);
+        out.writeInt(group.maxRssKB);
+        out.write(",\"cpu_percent\":", 15);
+        out.writeDouble(group.cpuPercent, 2);
+        out.write("}\n", 2);
+    } else if (format == FORMAT_CSV) {
+        writeCSVField(key);
+        out.put(',');
+        out.writeUInt(group.count);
+        out.put(',');
+        out.writeInt(group.threads);
+        out.put(',');
+        out.writeInt(group.rssKB);
+        out.put(',');
+        out.writeInt(group.maxRssKB);
+        out.put(',');
+        out.writeDouble(group.cpuPercent, 2);
+        out.put('\n');
+    }
+}
+
+// Finish the stream
+void ProcessWriter::end() {
+    out.flush();
+}
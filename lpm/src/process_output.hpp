@@ -0,0 +1,95 @@
+#pragma once
+
+#include "process.hpp"
+#include "process_group.hpp"
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// Buffered writer to a file descriptor. Numbers are formatted with
+// std::to_chars directly into the buffer, avoiding iostream overhead.
+class OutputBuffer {
+public:
+    explicit OutputBuffer(int fd = 1, size_t capacity = 64 * 1024);
+    ~OutputBuffer();
+
+    void write(const char* data, size_t length);
+    void write(const std::string& text) { write(text.data(), text.size()); }
+    void put(char c);
+
+    void writeInt(long long value);
+    void writeUInt(unsigned long long value);
+    void writeDouble(double value, int precision);
+
+    // Write raw bytes of a value in host byte order
+    template <typename T>
+    void writeRaw(T value) { write(reinterpret_cast<const char*>(&value), sizeof(T)); }
+
+    // Flush buffered data; returns false once a write has failed
+    bool flush();
+
+    bool failed() const { return writeFailed; }
+
+private:
+    int fd;
+    std::vector<char> buffer;
+    size_t used;
+    bool writeFailed;
+
+    // Make sure 'length' bytes fit in the buffer
+    void reserve(size_t length);
+};
+
+// Streams processes in a machine-readable format, one row at a time
+class ProcessWriter {
+public:
+    enum Format {
+        FORMAT_TABLE,     // Human-readable tables (handled by the caller)
+        FORMAT_JSON,      // JSON Lines: one object per process, valid UTF-8
+        FORMAT_CSV,       // CSV with a header row
+        FORMAT_BINARY     // Length-prefixed records in host byte order
+    };
+
+    ProcessWriter(Format format, OutputBuffer& out);
+
+    // Parse "table|json|csv|binary"
+    static bool parseFormat(const std::string& name, Format& format);
+
+    // Append I/O counters and rates to JSON and CSV rows (call before
+    // begin(); the binary layout is unchanged)
+    void setIncludeIO(bool include) { includeIO = include; }
+
+    // Append scheduler statistics and rates to JSON and CSV rows (call
+    // before begin())
+    void setIncludeSched(bool include) { includeSched = include; }
+
+    // Optional fields (ProcessFields bits) the rows contain
+    unsigned requiredFields() const {
+        return format == FORMAT_TABLE ? ProcessFields::NONE :
+               ProcessFields::USER | (includeIO ? ProcessFields::IO : ProcessFields::NONE) |
+               (includeSched ? ProcessFields::SCHED : ProcessFields::NONE);
+    }
+
+    // Write the stream header (CSV header row, binary magic)
+    void begin();
+
+    // Write one process
+    void write(const Process& proc);
+
+    // Group rows (JSON and CSV) in place of process rows: the key under
+    // 'keyField' ("user", "name", "state"), then the totals
+    void beginGroups(const char* keyField);
+    void writeGroup(const char* keyField, const std::string& key, const ProcessGroup& group);
+
+    // Finish the stream and flush
+    void end();
+
+private:
+    Format format;
+    OutputBuffer& out;
+    bool includeIO;
+    bool includeSched;
+
+    void writeJSONString(const std::string& text);
+    void writeCSVField(const std::string& text);
+};
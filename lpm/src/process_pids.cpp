@@ -0,0 +1,104 @@
+#include "process_pids.hpp"
+#include "process_profile.hpp"
+#include <cerrno>
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/syscall.h>
+
+// Record layout returned by getdents64 (not exported by all libcs)
+struct LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+PidEnumerator::PidEnumerator(size_t bufferSize)
+    : fd(-1), buffer(bufferSize), error(0) {
+}
+
+PidEnumerator::~PidEnumerator() {
+    close();
+}
+
+// Open a directory for listing
+bool PidEnumerator::open(const std::string& path) {
+    close();
+    error = 0;
+
+    fd = ::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        error = errno;
+        return false;
+    }
+    Profiler::add(Profiler::FILES_OPENED, 1);
+    return true;
+}
+
+void PidEnumerator::close() {
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+// Read one buffer of entries and keep the numeric directories. procfs
+// resumes each read from the next PID after the last one returned, so
+// processes exiting or starting between chunks never cause entries to be
+// skipped or repeated.
+bool PidEnumerator::nextChunk(std::vector<int>& ids) {
+    if (fd < 0) {
+        return false;
+    }
+
+    long length;
+    do {
+        length = syscall(SYS_getdents64, fd, buffer.data(), buffer.size());
+    } while (length < 0 && errno == EINTR);
+
+    if (length <= 0) {
+        // End of directory, or e.g. ENOENT when a task directory's process
+        // exits mid-listing: what was read so far stands
+        error = length < 0 ? errno : 0;
+        close();
+        return false;
+    }
+    Profiler::add(Profiler::BYTES_READ, length);
+
+    for (long offset = 0; offset < length; ) {
+        const LinuxDirent64* entry = reinterpret_cast<const LinuxDirent64*>(buffer.data() + offset);
+        offset += entry->d_reclen;
+
+        // DT_UNKNOWN: some filesystems leave the type to a stat; a
+        // numeric non-directory just fails to read later
+        if (entry->d_type != DT_DIR && entry->d_type != DT_UNKNOWN) {
+            continue;
+        }
+
+        const char* name = entry->d_name;
+        if (*name < '1' || *name > '9') {
+            continue;
+        }
+        long id = 0;
+        while (*name >= '0' && *name <= '9' && id <= 0x7fffffff) {
+            id = id * 10 + (*name++ - '0');
+        }
+        if (*name == '\0' && id <= 0x7fffffff) {
+            ids.push_back((int)id);
+        }
+    }
+    return true;
+}
+
+// List a whole directory
+bool PidEnumerator::list(const std::string& path, std::vector<int>& ids) {
+    if (!open(path)) {
+        return false;
+    }
+    while (nextChunk(ids)) {
+    }
+    return true;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// Lists the numeric entries of a directory (/proc, or /proc/<pid>/task)
+// with getdents64 into a reusable buffer. Names are parsed in place and
+// d_type is trusted when the filesystem fills it in, so no entry costs a
+// stat or a string. IDs come out one buffer at a time, a few thousand per
+// chunk, which suits handing chunks to parallel readers.
+class PidEnumerator {
+public:
+    explicit PidEnumerator(size_t bufferSize = 128 * 1024);
+    ~PidEnumerator();
+
+    PidEnumerator(const PidEnumerator&) = delete;
+    PidEnumerator& operator=(const PidEnumerator&) = delete;
+
+    // Start listing a directory; false (with errno set) if it cannot be opened
+    bool open(const std::string& path);
+
+    // Append the next chunk of IDs in directory order; false once the
+    // listing has ended (completely, or on an error) and the directory
+    // has been closed
+    bool nextChunk(std::vector<int>& ids);
+
+    // List a whole directory; false if it could not be opened. An error
+    // part way through keeps the IDs read until then.
+    bool list(const std::string& path, std::vector<int>& ids);
+
+    // errno of the error that ended the last listing early, or 0
+    int getError() const { return error; }
+
+private:
+    int fd;
+    std::vector<char> buffer;
+    int error;
+
+    void close();
+};
@@ -0,0 +1,253 @@
+#include "process_profile.hpp"
+#include <mutex>
+#include <algorithm>
+#include <new>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <ctime>
+
+// Stage timings: 4 sub-buckets per power of two
+static const int HISTOGRAM_BITS = 2;
+static const int HISTOGRAM_BUCKETS = LogHistogram::bucketCount(HISTOGRAM_BITS);
+
+int LogHistogram::bucketIndex(uint64_t value, int subBits) {
+    uint64_t size = 1ULL << subBits;
+    if (value < size) {
+        return (int)value;
+    }
+    int msb = 63 - __builtin_clzll(value);
+    int sub = (int)((value >> (msb - subBits)) & (size - 1));
+    return (int)(size + (msb - subBits) * size + sub);
+}
+
+uint64_t LogHistogram::bucketValue(int index, int subBits) {
+    int size = 1 << subBits;
+    if (index < size) {
+        return index;
+    }
+    int msb = (index - size) / size + subBits;
+    uint64_t sub = (index - size) % size;
+    uint64_t low = (size + sub) << (msb - subBits);
+    return low + ((1ULL << (msb - subBits)) >> 1);
+}
+
+LogHistogram::LogHistogram(int subBits) : subBits(subBits), count(0), min(UINT64_MAX), max(0) {
+}
+
+void LogHistogram::add(uint64_t value) {
+    if (buckets.empty()) {
+        buckets.assign(bucketCount(subBits), 0);
+    }
+    buckets[bucketIndex(value, subBits)]++;
+    count++;
+    min = std::min(min, value);
+    max = std::max(max, value);
+}
+
+uint64_t LogHistogram::percentile(double fraction) const {
+    if (count == 0) {
+        return 0;
+    }
+    uint64_t target = std::max<uint64_t>(1, (uint64_t)std::ceil(fraction * count));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); i++) {
+        seen += buckets[i];
+        if (seen >= target) {
+            return std::min(std::max(bucketValue((int)i, subBits), min), max);
+        }
+    }
+    return max;
+}
+
+// One thread's histograms. Only the owning thread writes; the atomics
+// let other threads read concurrently without locks.
+struct ThreadProfile {
+    struct StageData {
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> totalNs;
+        std::atomic<uint64_t> maxNs;
+        std::atomic<uint64_t> buckets[HISTOGRAM_BUCKETS];
+    };
+
+    StageData stages[Profiler::STAGE_COUNT];
+
+    ThreadProfile() {
+        for (auto& stage : stages) {
+            stage.count.store(0, std::memory_order_relaxed);
+            stage.totalNs.store(0, std::memory_order_relaxed);
+            stage.maxNs.store(0, std::memory_order_relaxed);
+            for (auto& bucket : stage.buckets) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+};
+
+// Profiles of every thread that ever recorded. Entries are never freed,
+// so samples from exited threads stay in the totals.
+static std::mutex registryMutex;
+static std::vector<ThreadProfile*> registry;
+
+static ThreadProfile& localProfile() {
+    thread_local ThreadProfile* profile = nullptr;
+    if (!profile) {
+        profile = new ThreadProfile();
+        std::lock_guard<std::mutex> lock(registryMutex);
+        registry.push_back(profile);
+    }
+    return *profile;
+}
+
+std::atomic<uint64_t> Profiler::counters[Profiler::COUNTER_COUNT];
+
+// Monotonic clock in nanoseconds
+uint64_t Profiler::now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Record one timed run of a stage
+void Profiler::record(Stage stage, uint64_t ns) {
+    ThreadProfile::StageData& data = localProfile().stages[stage];
+
+    // Single writer: load + store is enough and avoids locked instructions
+    data.count.store(data.count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    data.totalNs.store(data.totalNs.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+    if (ns > data.maxNs.load(std::memory_order_relaxed)) {
+        data.maxNs.store(ns, std::memory_order_relaxed);
+    }
+    std::atomic<uint64_t>& bucket = data.buckets[LogHistogram::bucketIndex(ns, HISTOGRAM_BITS)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+// Merge the histograms of all threads for one stage
+Profiler::StageSummary Profiler::summarize(Stage stage) {
+    StageSummary summary = {0, 0, 0, 0, 0, 0};
+    std::vector<uint64_t> buckets(HISTOGRAM_BUCKETS, 0);
+
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (const ThreadProfile* profile : registry) {
+            const ThreadProfile::StageData& data = profile->stages[stage];
+            summary.count += data.count.load(std::memory_order_relaxed);
+            summary.totalNs += data.totalNs.load(std::memory_order_relaxed);
+            uint64_t maxNs = data.maxNs.load(std::memory_order_relaxed);
+            if (maxNs > summary.maxNs) {
+                summary.maxNs = maxNs;
+            }
+            for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+                buckets[i] += data.buckets[i].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Bucket counts may be a sample or two ahead of 'count' while a
+    // thread is recording; percentiles use the bucket total
+    uint64_t total = 0;
+    for (uint64_t n : buckets) {
+        total += n;
+    }
+    if (total == 0) {
+        return summary;
+    }
+
+    uint64_t targets[3] = {(total * 50 + 99) / 100, (total * 95 + 99) / 100, (total * 99 + 99) / 100};
+    uint64_t* results[3] = {&summary.p50Ns, &summary.p95Ns, &summary.p99Ns};
+    uint64_t seen = 0;
+    int next = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS && next < 3; i++) {
+        seen += buckets[i];
+        while (next < 3 && seen >= targets[next]) {
+            *results[next++] = std::min(LogHistogram::bucketValue(i, HISTOGRAM_BITS), summary.maxNs);
+        }
+    }
+
+    return summary;
+}
+
+const char* Profiler::getStageName(Stage stage) {
+    switch (stage) {
+        case STAGE_SCAN:      return "getAllProcesses";
+        case STAGE_READ_PROC: return "readFromProc";
+        case STAGE_GETPWUID:  return "getpwuid";
+        case STAGE_FILTER:    return "updateFilter";
+        case STAGE_TREE:      return "buildTree";
+        case STAGE_DRAW:      return "draw";
+        case STAGE_SMAPS:     return "smaps_rollup";
+        case STAGE_GROUP:     return "groupBy";
+        case STAGE_CGROUP:    return "cgroups";
+        default:              return "?";
+    }
+}
+
+// Format a duration with a unit that keeps it short
+static std::string formatNs(uint64_t ns) {
+    char buf[32];
+    if (ns < 10000) {
+        snprintf(buf, sizeof(buf), "%lluns", (unsigned long long)ns);
+    } else if (ns < 10000000) {
+        snprintf(buf, sizeof(buf), "%.1fus", ns / 1e3);
+    } else {
+        snprintf(buf, sizeof(buf), "%.1fms", ns / 1e6);
+    }
+    return buf;
+}
+
+// Human-readable table of all stages and counters
+std::vector<std::string> Profiler::formatReport() {
+    std::vector<std::string> lines;
+    char buf[160];
+
+    snprintf(buf, sizeof(buf), "%-16s %9s %10s %10s %10s %10s %10s",
+             "STAGE", "COUNT", "AVG", "P50", "P95", "P99", "MAX");
+    lines.push_back(buf);
+
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        StageSummary s = summarize((Stage)i);
+        uint64_t avg = s.count ? s.totalNs / s.count : 0;
+        snprintf(buf, sizeof(buf), "%-16s %9llu %10s %10s %10s %10s %10s",
+                 getStageName((Stage)i), (unsigned long long)s.count,
+                 formatNs(avg).c_str(), formatNs(s.p50Ns).c_str(), formatNs(s.p95Ns).c_str(),
+                 formatNs(s.p99Ns).c_str(), formatNs(s.maxNs).c_str());
+        lines.push_back(buf);
+    }
+
+    snprintf(buf, sizeof(buf), "files opened %llu, bytes read %llu, allocations %llu (%llu bytes)",
+             (unsigned long long)get(FILES_OPENED), (unsigned long long)get(BYTES_READ),
+             (unsigned long long)get(ALLOCATIONS), (unsigned long long)get(ALLOCATED_BYTES));
+    lines.push_back(buf);
+
+    return lines;
+}
+
+// Count every heap allocation made by the program
+void* operator new(size_t size) {
+    Profiler::add(Profiler::ALLOCATIONS, 1);
+    Profiler::add(Profiler::ALLOCATED_BYTES, size);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    Profiler::add(Profiler::ALLOCATIONS, 1);
+    Profiler::add(Profiler::ALLOCATED_BYTES, size);
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+// Out of line so GCC does not pair the inlined free() with operator new
+__attribute__((noinline)) void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { operator delete(p); }
+void operator delete(void* p, size_t) noexcept { operator delete(p); }
+void operator delete[](void* p, size_t) noexcept { operator delete(p); }
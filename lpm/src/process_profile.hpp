@@ -0,0 +1,112 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+// Counts of values in log-spaced buckets: values below 2^subBits get
+// their own bucket, larger ones 2^subBits sub-buckets per power of two.
+// The size is fixed however many values are added (allocated by the first
+// one); percentiles are bucket midpoints, within 2^-(subBits+1) of the
+// value (12.5% for 2 bits), clamped to the smallest and largest seen.
+class LogHistogram {
+public:
+    static constexpr int bucketCount(int subBits) {
+        return (1 << subBits) + (64 - subBits) * (1 << subBits);
+    }
+    static int bucketIndex(uint64_t value, int subBits);
+    static uint64_t bucketValue(int index, int subBits);  // Midpoint of the bucket
+
+    explicit LogHistogram(int subBits = 2);
+
+    void add(uint64_t value);
+
+    uint64_t getCount() const { return count; }
+
+    // Value at 'fraction' (0..1) of the values added; 0 if none
+    uint64_t percentile(double fraction) const;
+
+private:
+    int subBits;
+    std::vector<uint64_t> buckets;
+    uint64_t count;
+    uint64_t min;
+    uint64_t max;
+};
+
+// Self-profiling of LPM's own hot paths. Each thread records stage
+// timings into its own histogram (plain relaxed atomics, no locks on the
+// recording path); readers merge all threads on demand. Cheap enough to
+// stay enabled: a timed stage costs two vDSO clock reads.
+class Profiler {
+public:
+    enum Stage {
+        STAGE_SCAN,          // ProcessManager::forEachProcess / getAllProcesses
+        STAGE_READ_PROC,     // Process::readFromProc
+        STAGE_GETPWUID,      // UID to user name lookups
+        STAGE_FILTER,        // ProcessTUI::updateFilter
+        STAGE_TREE,          // ProcessTree::buildTree
+        STAGE_DRAW,          // ProcessTUI::draw
+        STAGE_SMAPS,         // MemoryCollector: smaps_rollup reads for PSS/USS
+        STAGE_GROUP,         // ProcessGrouper: group view aggregation
+        STAGE_CGROUP,        // CgroupTree::build
+        STAGE_COUNT
+    };
+
+    enum Counter {
+        FILES_OPENED,
+        BYTES_READ,
+        ALLOCATIONS,         // Calls to operator new
+        ALLOCATED_BYTES,
+        COUNTER_COUNT
+    };
+
+    struct StageSummary {
+        uint64_t count;
+        uint64_t totalNs;
+        uint64_t maxNs;
+        uint64_t p50Ns;      // Percentiles are bucket midpoints (within 12.5%)
+        uint64_t p95Ns;
+        uint64_t p99Ns;
+    };
+
+    // Monotonic clock in nanoseconds
+    static uint64_t now();
+
+    // Record one timed run of a stage on the calling thread
+    static void record(Stage stage, uint64_t ns);
+
+    // Process-wide counters
+    static void add(Counter counter, uint64_t value) {
+        counters[counter].fetch_add(value, std::memory_order_relaxed);
+    }
+    static uint64_t get(Counter counter) {
+        return counters[counter].load(std::memory_order_relaxed);
+    }
+
+    // Merge the histograms of all threads for one stage
+    static StageSummary summarize(Stage stage);
+
+    static const char* getStageName(Stage stage);
+
+    // Human-readable table of all stages and counters
+    static std::vector<std::string> formatReport();
+
+private:
+    static std::atomic<uint64_t> counters[COUNTER_COUNT];
+};
+
+// Times the enclosing scope as one run of a stage
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Profiler::Stage stage) : stage(stage), start(Profiler::now()) {}
+    ~ScopedTimer() { Profiler::record(stage, Profiler::now() - start); }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Profiler::Stage stage;
+    uint64_t start;
+};
@@ -0,0 +1,846 @@
+#include "process_record.hpp"
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <ctime>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char RECORD_MAGIC[8] = {'L', 'P', 'M', 'R', 'E', 'C', 0, 0};
+static const size_t MIN_MAP_SIZE = 1 << 20;       // 1 MB
+static const size_t MAX_GROW_STEP = 64 << 20;     // 64 MB
+
+// Fields stored in delta records (CPU% is derived from utime/stime on replay)
+static const uint32_t RECORDED_FIELDS = ~(uint32_t)SnapshotDiff::FIELD_CPU;
+
+// RecordCodec implementation
+
+// Append an unsigned LEB128 varint
+void RecordCodec::putVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t)value);
+}
+
+// Append a signed value with zigzag encoding
+void RecordCodec::putSigned(std::vector<uint8_t>& out, int64_t value) {
+    putVarint(out, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+// Append a length-prefixed string
+void RecordCodec::putString(std::vector<uint8_t>& out, const std::string& text) {
+    putVarint(out, text.size());
+    out.insert(out.end(), text.begin(), text.end());
+}
+
+// Append a full process record
+void RecordCodec::putProcess(std::vector<uint8_t>& out, const Process& proc) {
+    putVarint(out, proc.pid);
+    putSigned(out, proc.starttime);
+    putVarint(out, proc.ppid);
+    putString(out, proc.name);
+    putString(out, proc.user);
+    putString(out, proc.state);
+    putSigned(out, proc.vmSize);
+    putSigned(out, proc.vmRSS);
+    putVarint(out, proc.utime);
+    putVarint(out, proc.stime);
+    putSigned(out, proc.numThreads);
+}
+
+// Read an unsigned varint
+bool RecordCodec::getVarint(const uint8_t*& pos, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && pos < end; shift += 7) {
+        uint8_t byte = *pos++;
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Read a zigzag-encoded signed value
+bool RecordCodec::getSigned(const uint8_t*& pos, const uint8_t* end, int64_t& value) {
+    uint64_t raw;
+    if (!getVarint(pos, end, raw)) {
+        return false;
+    }
+    value = (int64_t)(raw >> 1) ^ -(int64_t)(raw & 1);
+    return true;
+}
+
+// Read a length-prefixed string
+bool RecordCodec::getString(const uint8_t*& pos, const uint8_t* end, std::string& text) {
+    uint64_t length;
+    if (!getVarint(pos, end, length) || length > (uint64_t)(end - pos)) {
+        return false;
+    }
+    text.assign(reinterpret_cast<const char*>(pos), length);
+    pos += length;
+    return true;
+}
+
+// Read a full process record
+bool RecordCodec::getProcess(const uint8_t*& pos, const uint8_t* end, Process& proc) {
+    uint64_t pid, ppid, utime, stime;
+    int64_t starttime, vmSize, vmRSS, threads;
+
+    if (!getVarint(pos, end, pid) || !getSigned(pos, end, starttime) ||
+        !getVarint(pos, end, ppid) || !getString(pos, end, proc.name) ||
+        !getString(pos, end, proc.user) || !getString(pos, end, proc.state) ||
+        !getSigned(pos, end, vmSize) || !getSigned(pos, end, vmRSS) ||
+        !getVarint(pos, end, utime) || !getVarint(pos, end, stime) ||
+        !getSigned(pos, end, threads)) {
+        return false;
+    }
+
+    proc.pid = (int)pid;
+    proc.starttime = starttime;
+    proc.ppid = (int)ppid;
+    proc.vmSize = vmSize;
+    proc.vmRSS = vmRSS;
+    proc.utime = utime;
+    proc.stime = stime;
+    proc.numThreads = (int)threads;
+    proc.cpuPercent = 0.0;
+    return true;
+}
+
+// SnapshotRecorder implementation
+
+SnapshotRecorder::SnapshotRecorder()
+    : fd(-1), map(nullptr), mapSize(0), dataEnd(0), frameCount(0),
+      keyframeSpacingNs(3600 * 1000000000LL), lastFrameSize(0), keyframeTime(0),
+      keyframeSize(0), deltaBytes(0) {
+}
+
+SnapshotRecorder::~SnapshotRecorder() {
+    close();
+}
+
+// Create a recording file and map its first chunk
+bool SnapshotRecorder::open(const std::string& path, int64_t intervalNs, std::string& error) {
+    close();
+
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        error = std::string("cannot create ") + path + ": " + strerror(errno);
+        return false;
+    }
+
+    if (ftruncate(fd, MIN_MAP_SIZE) != 0) {
+        error = std::string("cannot size ") + path + ": " + strerror(errno);
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+
+    void* addr = mmap(nullptr, MIN_MAP_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        error = std::string("cannot map ") + path + ": " + strerror(errno);
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+
+    map = static_cast<uint8_t*>(addr);
+    mapSize = MIN_MAP_SIZE;
+    dataEnd = sizeof(RecordFileHeader);
+    frameCount = 0;
+    deltaBytes = 0;
+    index.clear();
+    diff.reset();
+
+    RecordFileHeader* hdr = header();
+    std::memset(hdr, 0, sizeof(RecordFileHeader));
+    std::memcpy(hdr->magic, RECORD_MAGIC, sizeof(hdr->magic));
+    hdr->version = RECORD_VERSION;
+    hdr->clockTicks = (uint32_t)sysconf(_SC_CLK_TCK);
+    hdr->intervalNs = intervalNs;
+    hdr->dataEnd = dataEnd;
+
+    return true;
+}
+
+// Grow the file so 'length' more bytes fit after dataEnd
+bool SnapshotRecorder::ensureCapacity(size_t length, std::string& error) {
+    if (dataEnd + length <= mapSize) {
+        return true;
+    }
+
+    size_t newSize = mapSize + std::min(mapSize, MAX_GROW_STEP);
+    newSize = std::max(newSize, (size_t)(dataEnd + length));
+
+    if (ftruncate(fd, newSize) != 0) {
+        error = std::string("cannot grow the file: ") + strerror(errno);
+        return false;
+    }
+
+    void* addr = mremap(map, mapSize, newSize, MREMAP_MAYMOVE);
+    if (addr == MAP_FAILED) {
+        error = std::string("cannot remap the file: ") + strerror(errno);
+        return false;
+    }
+
+    map = static_cast<uint8_t*>(addr);
+    mapSize = newSize;
+    return true;
+}
+
+// Append one snapshot as a keyframe or a delta frame
+bool SnapshotRecorder::writeSnapshot(const std::vector<Process>& processes, int64_t timestamp,
+                                     uint64_t cpuTicks, std::string& error) {
+    if (!map) {
+        error = "not open";
+        return false;
+    }
+
+    diff.update(processes);
+    bool keyframe = frameCount == 0 || deltaBytes >= keyframeSize ||
+                    timestamp - keyframeTime >= keyframeSpacingNs;
+
+    payload.clear();
+    if (keyframe) {
+        RecordCodec::putVarint(payload, processes.size());
+        for (const auto& proc : processes) {
+            RecordCodec::putProcess(payload, proc);
+        }
+    } else {
+        const auto& added = diff.getAdded();
+        RecordCodec::putVarint(payload, added.size());
+        for (const Process* proc : added) {
+            RecordCodec::putProcess(payload, *proc);
+        }
+
+        const auto& removed = diff.getRemoved();
+        RecordCodec::putVarint(payload, removed.size());
+        for (const Process* proc : removed) {
+            RecordCodec::putVarint(payload, proc->pid);
+            RecordCodec::putSigned(payload, proc->starttime);
+        }
+
+        // Count changes that touch a recorded field
+        size_t changedCount = 0;
+        for (const auto& change : diff.getChanged()) {
+            if (change.fields & RECORDED_FIELDS) {
+                changedCount++;
+            }
+        }
+
+        RecordCodec::putVarint(payload, changedCount);
+        for (const auto& change : diff.getChanged()) {
+            uint32_t fields = change.fields & RECORDED_FIELDS;
+            if (!fields) {
+                continue;
+            }
+
+            const Process& now = *change.current;
+            const Process& before = *change.previous;
+            RecordCodec::putVarint(payload, now.pid);
+            RecordCodec::putSigned(payload, now.starttime);
+            RecordCodec::putVarint(payload, fields);
+
+            if (fields & SnapshotDiff::FIELD_PPID)
+                RecordCodec::putSigned(payload, (int64_t)now.ppid - before.ppid);
+            if (fields & SnapshotDiff::FIELD_NAME)
+                RecordCodec::putString(payload, now.name);
+            if (fields & SnapshotDiff::FIELD_USER)
+                RecordCodec::putString(payload, now.user);
+            if (fields & SnapshotDiff::FIELD_STATE)
+                RecordCodec::putString(payload, now.state);
+            if (fields & SnapshotDiff::FIELD_VMSIZE)
+                RecordCodec::putSigned(payload, now.vmSize - before.vmSize);
+            if (fields & SnapshotDiff::FIELD_VMRSS)
+                RecordCodec::putSigned(payload, now.vmRSS - before.vmRSS);
+            if (fields & SnapshotDiff::FIELD_UTIME)
+                RecordCodec::putSigned(payload, (int64_t)(now.utime - before.utime));
+            if (fields & SnapshotDiff::FIELD_STIME)
+                RecordCodec::putSigned(payload, (int64_t)(now.stime - before.stime));
+            if (fields & SnapshotDiff::FIELD_THREADS)
+                RecordCodec::putSigned(payload, (int64_t)now.numThreads - before.numThreads);
+        }
+    }
+
+    RecordFrameHeader frame;
+    std::memset(&frame, 0, sizeof(frame));
+    frame.magic = RECORD_FRAME_MAGIC;
+    frame.type = keyframe ? RECORD_KEYFRAME : RECORD_DELTA;
+    frame.timestamp = timestamp;
+    frame.cpuTicks = cpuTicks;
+    frame.payloadSize = (uint32_t)payload.size();
+    frame.processCount = (uint32_t)processes.size();
+
+    size_t frameSize = sizeof(frame) + payload.size();
+    if (!ensureCapacity(frameSize, error)) {
+        return false;
+    }
+
+    std::memcpy(map + dataEnd, &frame, sizeof(frame));
+    std::memcpy(map + dataEnd + sizeof(frame), payload.data(), payload.size());
+
+    if (keyframe) {
+        RecordIndexEntry entry;
+        std::memset(&entry, 0, sizeof(entry));
+        entry.timestamp = timestamp;
+        entry.offset = dataEnd;
+        entry.frameNumber = frameCount;
+        index.push_back(entry);
+        keyframeTime = timestamp;
+        keyframeSize = frameSize;
+        deltaBytes = 0;
+    } else {
+        deltaBytes += frameSize;
+    }
+
+    // Commit: the frame becomes visible to readers only now
+    dataEnd += frameSize;
+    frameCount++;
+    lastFrameSize = frameSize;
+
+    RecordFileHeader* hdr = header();
+    if (hdr->startTime == 0) {
+        hdr->startTime = timestamp;
+    }
+    hdr->endTime = timestamp;
+    hdr->frameCount = frameCount;
+    hdr->keyframeCount = (uint32_t)index.size();
+    hdr->dataEnd = dataEnd;
+
+    return true;
+}
+
+// Parse a duration such as "1s", "500ms", "2m" or a bare number of seconds
+bool SnapshotRecorder::parseDuration(const std::string& text, int64_t& nanoseconds) {
+    char* end = nullptr;
+    double value = std::strtod(text.c_str(), &end);
+    if (end == text.c_str() || value < 0) {
+        return false;
+    }
+
+    std::string unit = end;
+    double scale;
+    if (unit.empty() || unit == "s") {
+        scale = 1e9;
+    } else if (unit == "ms") {
+        scale = 1e6;
+    } else if (unit == "us") {
+        scale = 1e3;
+    } else if (unit == "m") {
+        scale = 60e9;
+    } else if (unit == "h") {
+        scale = 3600e9;
+    } else {
+        return false;
+    }
+
+    nanoseconds = (int64_t)(value * scale);
+    return true;
+}
+
+// Write the footer index and truncate to the final size
+void SnapshotRecorder::close() {
+    if (!map) {
+        return;
+    }
+
+    size_t footerSize = sizeof(RecordFooter) + index.size() * sizeof(RecordIndexEntry);
+    std::string error;
+    if (ensureCapacity(footerSize, error)) {
+        RecordFooter footer;
+        footer.magic = RECORD_FOOTER_MAGIC;
+        footer.entryCount = (uint32_t)index.size();
+
+        std::memcpy(map + dataEnd, &footer, sizeof(footer));
+        if (!index.empty()) {
+            std::memcpy(map + dataEnd + sizeof(footer), index.data(),
+                        index.size() * sizeof(RecordIndexEntry));
+        }
+        header()->footerOffset = dataEnd;
+    } else {
+        footerSize = 0;
+    }
+
+    size_t finalSize = dataEnd + footerSize;
+    msync(map, finalSize, MS_SYNC);
+    munmap(map, mapSize);
+    if (ftruncate(fd, finalSize) != 0) {
+        // Leave the file padded; readers stop at dataEnd anyway
+    }
+    ::close(fd);
+
+    map = nullptr;
+    mapSize = 0;
+    fd = -1;
+}
+
+// SnapshotReader implementation
+
+SnapshotReader::SnapshotReader()
+    : fd(-1), map(nullptr), mapSize(0), dataEnd(0), frameCount(0),
+      startTime(0), endTime(0), intervalNs(0), positioned(false),
+      currentFrame(0), nextFrame(0), nextOffset(0), currentTime(0), currentTicks(0) {
+}
+
+SnapshotReader::~SnapshotReader() {
+    close();
+}
+
+// Map a recording and load (or rebuild) its keyframe index
+bool SnapshotReader::open(const std::string& path, std::string& error) {
+    close();
+
+    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error = std::string("cannot open ") + path + ": " + strerror(errno);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(RecordFileHeader)) {
+        error = path + " is not a recording";
+        close();
+        return false;
+    }
+
+    void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        error = std::string("cannot map ") + path + ": " + strerror(errno);
+        close();
+        return false;
+    }
+    map = static_cast<const uint8_t*>(addr);
+    mapSize = st.st_size;
+
+    RecordFileHeader hdr;
+    std::memcpy(&hdr, map, sizeof(hdr));
+    if (std::memcmp(hdr.magic, RECORD_MAGIC, sizeof(hdr.magic)) != 0) {
+        error = path + " is not a recording";
+        close();
+        return false;
+    }
+    if (hdr.version != RECORD_VERSION) {
+        error = path + ": unsupported recording version " + std::to_string(hdr.version);
+        close();
+        return false;
+    }
+
+    dataEnd = std::min<uint64_t>(hdr.dataEnd, mapSize);
+    startTime = hdr.startTime;
+    intervalNs = hdr.intervalNs;
+
+    // Use the footer index when the recording was closed cleanly
+    bool haveFooter = false;
+    if (hdr.footerOffset >= sizeof(RecordFileHeader) &&
+        hdr.footerOffset + sizeof(RecordFooter) <= mapSize) {
+        RecordFooter footer;
+        std::memcpy(&footer, map + hdr.footerOffset, sizeof(footer));
+        size_t entriesSize = (size_t)footer.entryCount * sizeof(RecordIndexEntry);
+        if (footer.magic == RECORD_FOOTER_MAGIC && footer.entryCount > 0 &&
+            hdr.footerOffset + sizeof(footer) + entriesSize <= mapSize) {
+            index.resize(footer.entryCount);
+            std::memcpy(index.data(), map + hdr.footerOffset + sizeof(footer), entriesSize);
+            frameCount = hdr.frameCount;
+            endTime = hdr.endTime;
+            haveFooter = true;
+        }
+    }
+
+    if (!haveFooter && !scanFrames(error)) {
+        error = path + ": " + error;
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+// Unmap the recording
+void SnapshotReader::close() {
+    if (map) {
+        munmap(const_cast<uint8_t*>(map), mapSize);
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+
+    fd = -1;
+    map = nullptr;
+    mapSize = 0;
+    dataEnd = 0;
+    frameCount = 0;
+    index.clear();
+    state.clear();
+    busy.clear();
+    positioned = false;
+}
+
+// Read the frame header at 'offset' if a complete frame starts there
+bool SnapshotReader::frameAt(uint64_t offset, RecordFrameHeader& frame) const {
+    if (offset + sizeof(RecordFrameHeader) > dataEnd) {
+        return false;
+    }
+    std::memcpy(&frame, map + offset, sizeof(frame));
+    return frame.magic == RECORD_FRAME_MAGIC &&
+           offset + sizeof(RecordFrameHeader) + frame.payloadSize <= dataEnd;
+}
+
+// Build the keyframe index by walking every frame header
+bool SnapshotReader::scanFrames(std::string& error) {
+    RecordFrameHeader frame;
+    uint64_t offset = sizeof(RecordFileHeader);
+
+    index.clear();
+    frameCount = 0;
+    while (frameAt(offset, frame)) {
+        if (frame.type == RECORD_KEYFRAME) {
+            RecordIndexEntry entry;
+            std::memset(&entry, 0, sizeof(entry));
+            entry.timestamp = frame.timestamp;
+            entry.offset = offset;
+            entry.frameNumber = frameCount;
+            index.push_back(entry);
+        } else if (index.empty()) {
+            error = "recording does not start with a keyframe";
+            return false;
+        }
+        endTime = frame.timestamp;
+        frameCount++;
+        offset += sizeof(frame) + frame.payloadSize;
+    }
+
+    if (frameCount == 0) {
+        error = "recording is empty";
+        return false;
+    }
+    return true;
+}
+
+// Decode the frame at nextOffset on top of the current state
+bool SnapshotReader::applyNextFrame() {
+    RecordFrameHeader frame;
+    if (nextFrame >= frameCount || !frameAt(nextOffset, frame)) {
+        return false;
+    }
+
+    const uint8_t* pos = map + nextOffset + sizeof(frame);
+    const uint8_t* end = pos + frame.payloadSize;
+    uint64_t tickDiff = 0;
+    if (positioned && frame.cpuTicks > currentTicks) {
+        tickDiff = frame.cpuTicks - currentTicks;
+    }
+
+    bool ok;
+    if (frame.type == RECORD_KEYFRAME) {
+        ok = applyKeyframe(pos, end, tickDiff);
+    } else {
+        ok = positioned && applyDelta(pos, end, tickDiff);
+    }
+    if (!ok) {
+        state.clear();
+        busy.clear();
+        positioned = false;
+        return false;
+    }
+
+    positioned = true;
+    currentFrame = nextFrame++;
+    currentTime = frame.timestamp;
+    currentTicks = frame.cpuTicks;
+    nextOffset += sizeof(frame) + frame.payloadSize;
+    return true;
+}
+
+// CPU% from the change in utime + stime over a frame
+static double frameCPU(unsigned long before, unsigned long after, uint64_t tickDiff) {
+    if (tickDiff == 0 || after <= before) {
+        return 0.0;
+    }
+    return (100.0 * (after - before)) / tickDiff;
+}
+
+// Replace the state with a keyframe's full process list
+bool SnapshotReader::applyKeyframe(const uint8_t* pos, const uint8_t* end, uint64_t tickDiff) {
+    uint64_t count;
+    if (!RecordCodec::getVarint(pos, end, count)) {
+        return false;
+    }
+
+    std::unordered_map<ProcessKey, Process, ProcessKeyHash> fresh;
+    fresh.reserve(count);
+    busy.clear();
+
+    Process proc;
+    for (uint64_t i = 0; i < count; i++) {
+        if (!RecordCodec::getProcess(pos, end, proc)) {
+            return false;
+        }
+
+        auto it = state.find(proc.key());
+        if (it != state.end()) {
+            proc.cpuPercent = frameCPU(it->second.utime + it->second.stime,
+                                       proc.utime + proc.stime, tickDiff);
+            if (proc.cpuPercent > 0) {
+                busy.push_back(proc.key());
+            }
+        }
+        fresh.emplace(proc.key(), proc);
+    }
+
+    state.swap(fresh);
+    return true;
+}
+
+// Apply added, removed and changed processes from a delta frame
+bool SnapshotReader::applyDelta(const uint8_t* pos, const uint8_t* end, uint64_t tickDiff) {
+    // Processes absent from the change list used no CPU this frame
+    for (const auto& key : busy) {
+        auto it = state.find(key);
+        if (it != state.end()) {
+            it->second.cpuPercent = 0.0;
+        }
+    }
+    busy.clear();
+
+    uint64_t count;
+    Process proc;
+    if (!RecordCodec::getVarint(pos, end, count)) {
+        return false;
+    }
+    for (uint64_t i = 0; i < count; i++) {
+        if (!RecordCodec::getProcess(pos, end, proc)) {
+            return false;
+        }
+        state[proc.key()] = proc;
+    }
+
+    uint64_t pid;
+    int64_t starttime;
+    if (!RecordCodec::getVarint(pos, end, count)) {
+        return false;
+    }
+    for (uint64_t i = 0; i < count; i++) {
+        if (!RecordCodec::getVarint(pos, end, pid) ||
+            !RecordCodec::getSigned(pos, end, starttime)) {
+            return false;
+        }
+        state.erase(ProcessKey((int)pid, starttime));
+    }
+
+    if (!RecordCodec::getVarint(pos, end, count)) {
+        return false;
+    }
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t fields;
+        if (!RecordCodec::getVarint(pos, end, pid) ||
+            !RecordCodec::getSigned(pos, end, starttime) ||
+            !RecordCodec::getVarint(pos, end, fields)) {
+            return false;
+        }
+
+        auto it = state.find(ProcessKey((int)pid, starttime));
+        if (it == state.end()) {
+            return false;
+        }
+        Process& target = it->second;
+        unsigned long cpuBefore = target.utime + target.stime;
+
+        int64_t delta;
+        bool ok = true;
+        if (fields & SnapshotDiff::FIELD_PPID) {
+            ok = ok && RecordCodec::getSigned(pos, end, delta);
+            target.ppid += (int)delta;
+        }
+        if (fields & SnapshotDiff::FIELD_NAME)
+            ok = ok && RecordCodec::getString(pos, end, target.name);
+        if (fields & SnapshotDiff::FIELD_USER)
+            ok = ok && RecordCodec::getString(pos, end, target.user);
+        if (fields & SnapshotDiff::FIELD_STATE)
+            ok = ok && RecordCodec::getString(pos, end, target.state);
+        if (fields & SnapshotDiff::FIELD_VMSIZE) {
+            ok = ok && RecordCodec::getSigned(pos, end, delta);
+            target.vmSize += delta;
+        }
+        if (fields & SnapshotDiff::FIELD_VMRSS) {
+            ok = ok && RecordCodec::getSigned(pos, end, delta);
+            target.vmRSS += delta;
+        }
+        if (fields & SnapshotDiff::FIELD_UTIME) {
+            ok = ok && RecordCodec::getSigned(pos, end, delta);
+            target.utime += delta;
+        }
+        if (fields & SnapshotDiff::FIELD_STIME) {
+            ok = ok && RecordCodec::getSigned(pos, end, delta);
+            target.stime += delta;
+        }
+        if (fields & SnapshotDiff::FIELD_THREADS) {
+            ok = ok && RecordCodec::getSigned(pos, end, delta);
+            target.numThreads += (int)delta;
+        }
+        if (!ok) {
+            return false;
+        }
+
+        target.cpuPercent = frameCPU(cpuBefore, target.utime + target.stime, tickDiff);
+        if (target.cpuPercent > 0) {
+            busy.push_back(it->first);
+        }
+    }
+
+    return true;
+}
+
+// Position at frame 'frame'
+bool SnapshotReader::seekFrame(uint32_t frame) {
+    if (frame >= frameCount) {
+        return false;
+    }
+    if (positioned && frame == currentFrame) {
+        return true;
+    }
+
+    // Nearest keyframe at or before the target
+    auto it = std::upper_bound(index.begin(), index.end(), frame,
+                               [](uint32_t value, const RecordIndexEntry& entry) {
+                                   return value < entry.frameNumber;
+                               });
+    if (it == index.begin()) {
+        return false;
+    }
+    --it;
+
+    // Moving forward within reach of the current state: keep applying deltas
+    bool restart = !positioned || frame < currentFrame || it->frameNumber > currentFrame;
+    if (restart) {
+        // Landing exactly on a keyframe: start one keyframe earlier so the
+        // target still has a previous frame to derive CPU% from
+        if (it->frameNumber == frame && it != index.begin()) {
+            --it;
+        }
+        state.clear();
+        busy.clear();
+        positioned = false;
+        nextOffset = it->offset;
+        nextFrame = it->frameNumber;
+    }
+
+    while (!positioned || currentFrame < frame) {
+        if (!applyNextFrame()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Position at the last frame recorded at or before 'timestamp'
+bool SnapshotReader::seekTime(int64_t timestamp) {
+    if (index.empty()) {
+        return false;
+    }
+
+    auto it = std::upper_bound(index.begin(), index.end(), timestamp,
+                               [](int64_t value, const RecordIndexEntry& entry) {
+                                   return value < entry.timestamp;
+                               });
+    if (it != index.begin()) {
+        --it;
+    }
+
+    // Walk frame headers (without decoding) up to the requested time
+    uint32_t frame = it->frameNumber;
+    uint64_t offset = it->offset;
+    RecordFrameHeader header;
+    if (!frameAt(offset, header)) {
+        return false;
+    }
+    offset += sizeof(header) + header.payloadSize;
+    while (frame + 1 < frameCount && frameAt(offset, header) && header.timestamp <= timestamp) {
+        frame++;
+        offset += sizeof(header) + header.payloadSize;
+    }
+
+    return seekFrame(frame);
+}
+
+// The snapshot at the current frame, in PID order
+void SnapshotReader::getProcesses(std::vector<Process>& out) const {
+    out.clear();
+    out.reserve(state.size());
+    for (const auto& entry : state) {
+        out.push_back(entry.second);
+    }
+    std::sort(out.begin(), out.end(),
+              [](const Process& a, const Process& b) { return a.pid < b.pid; });
+}
+
+// Parse an absolute time of day, a date and time, or an offset from the start
+bool SnapshotReader::parseTime(const std::string& text, int64_t& timestamp) const {
+    if (!text.empty() && text[0] == '+') {
+        int64_t offset;
+        if (!SnapshotRecorder::parseDuration(text.substr(1), offset)) {
+            return false;
+        }
+        timestamp = startTime + offset;
+        return true;
+    }
+
+    time_t start = (time_t)(startTime / 1000000000LL);
+    struct tm startTm;
+    localtime_r(&start, &startTm);
+
+    static const char* dateFormats[] = {
+        "%Y-%m-%d %H:%M:%S", "%Y-%m-%dT%H:%M:%S", "%Y-%m-%d %H:%M", "%Y-%m-%dT%H:%M"
+    };
+    for (const char* format : dateFormats) {
+        struct tm tm;
+        std::memset(&tm, 0, sizeof(tm));
+        const char* end = strptime(text.c_str(), format, &tm);
+        if (end && *end == '\0') {
+            tm.tm_isdst = -1;
+            timestamp = (int64_t)mktime(&tm) * 1000000000LL;
+            return true;
+        }
+    }
+
+    static const char* timeFormats[] = {"%H:%M:%S", "%H:%M"};
+    for (const char* format : timeFormats) {
+        struct tm tm;
+        std::memset(&tm, 0, sizeof(tm));
+        const char* end = strptime(text.c_str(), format, &tm);
+        if (end && *end == '\0') {
+            // Time of day on the first day of the recording, or the next
+            // day if that is before the recording started
+            tm.tm_year = startTm.tm_year;
+            tm.tm_mon = startTm.tm_mon;
+            tm.tm_mday = startTm.tm_mday;
+            tm.tm_isdst = -1;
+            time_t when = mktime(&tm);
+            if (when < start) {
+                tm.tm_mday++;
+                tm.tm_isdst = -1;
+                when = mktime(&tm);
+            }
+            timestamp = (int64_t)when * 1000000000LL;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Format a timestamp as local "YYYY-MM-DD HH:MM:SS"
+std::string SnapshotReader::formatTime(int64_t timestamp) {
+    time_t seconds = (time_t)(timestamp / 1000000000LL);
+    struct tm tm;
+    localtime_r(&seconds, &tm);
+
+    char buf[32];
+    strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+    return buf;
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include "process.hpp"
+#include "process_snapshot.hpp"
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+
+// On-disk layout of a recording (host byte order, not portable across endianness):
+//
+//   RecordFileHeader
+//   frame*            RecordFrameHeader + payload
+//   footer            RecordFooter + RecordIndexEntry[keyframeCount]
+//
+// A keyframe payload holds every process in full. A delta payload holds
+// added processes in full, keys of exited ones, and for changed ones only
+// a field mask and the changed values (zigzag varint deltas for numbers).
+// The header's dataEnd always points past the last complete frame, so a
+// recording cut short by a crash is still readable up to that point.
+
+struct RecordFileHeader {
+    char magic[8];           // "LPMREC\0\0"
+    uint32_t version;
+    uint32_t clockTicks;     // sysconf(_SC_CLK_TCK) of the recording host
+    int64_t startTime;       // First frame, ns since the epoch
+    int64_t intervalNs;      // Requested sampling interval
+    uint64_t dataEnd;        // End of the last complete frame
+    uint64_t footerOffset;   // 0 until the recording is closed
+    uint32_t frameCount;
+    uint32_t keyframeCount;
+    int64_t endTime;         // Last frame, ns since the epoch
+};
+
+struct RecordFrameHeader {
+    uint32_t magic;          // RECORD_FRAME_MAGIC
+    uint8_t type;            // RECORD_KEYFRAME or RECORD_DELTA
+    uint8_t reserved[3];
+    int64_t timestamp;       // ns since the epoch
+    uint64_t cpuTicks;       // Cumulative system CPU time from /proc/stat
+    uint32_t payloadSize;
+    uint32_t processCount;   // Processes in the snapshot after this frame
+};
+
+struct RecordIndexEntry {
+    int64_t timestamp;
+    uint64_t offset;         // Offset of the keyframe's RecordFrameHeader
+    uint32_t frameNumber;
+    uint32_t reserved;
+};
+
+struct RecordFooter {
+    uint32_t magic;          // RECORD_FOOTER_MAGIC
+    uint32_t entryCount;
+};
+
+const uint32_t RECORD_VERSION = 1;
+const uint32_t RECORD_FRAME_MAGIC = 0x464d504c;   // "LPMF"
+const uint32_t RECORD_FOOTER_MAGIC = 0x494d504c;  // "LPMI"
+const uint8_t RECORD_KEYFRAME = 1;
+const uint8_t RECORD_DELTA = 2;
+
+// Appends delta-encoded snapshots to a memory-mapped recording file
+class SnapshotRecorder {
+public:
+    SnapshotRecorder();
+    ~SnapshotRecorder();
+
+    // Create (or truncate) a recording file
+    bool open(const std::string& path, int64_t intervalNs, std::string& error);
+
+    // Append one snapshot. A keyframe is written once the deltas since the
+    // last one add up to its size, so disk use follows churn, or when the
+    // keyframe spacing has passed. False (with the reason) if the file
+    // cannot grow.
+    bool writeSnapshot(const std::vector<Process>& processes, int64_t timestamp,
+                       uint64_t cpuTicks, std::string& error);
+
+    // Write the footer index and truncate the file to its final size
+    void close();
+
+    // Longest time between keyframes (default one hour)
+    void setKeyframeSpacing(int64_t nanoseconds) { keyframeSpacingNs = nanoseconds; }
+
+    // Parse a duration such as "1s", "500ms", "2m" or a bare number of seconds
+    static bool parseDuration(const std::string& text, int64_t& nanoseconds);
+
+    uint32_t getFrameCount() const { return frameCount; }
+    uint32_t getKeyframeCount() const { return (uint32_t)index.size(); }
+    uint64_t getBytesWritten() const { return dataEnd; }
+    size_t getLastFrameSize() const { return lastFrameSize; }
+
+private:
+    int fd;
+    uint8_t* map;
+    size_t mapSize;
+    uint64_t dataEnd;
+    uint32_t frameCount;
+    int64_t keyframeSpacingNs;
+    size_t lastFrameSize;
+    int64_t keyframeTime;            // Timestamp of the last keyframe
+    uint64_t keyframeSize;           // Its size, header included
+    uint64_t deltaBytes;             // Delta frames written since
+
+    SnapshotDiff diff;
+    std::vector<RecordIndexEntry> index;
+    std::vector<uint8_t> payload;
+
+    RecordFileHeader* header() { return reinterpret_cast<RecordFileHeader*>(map); }
+
+    // Grow the file and mapping so 'length' more bytes fit after dataEnd;
+    // false with the reason in 'error'
+    bool ensureCapacity(size_t length, std::string& error);
+};
+
+// Reconstructs snapshots from a recording. The file is memory-mapped;
+// seeking finds the nearest keyframe by binary search over the footer
+// index and applies the delta frames after it, which add up to no more
+// than the keyframe itself.
+class SnapshotReader {
+public:
+    SnapshotReader();
+    ~SnapshotReader();
+
+    // Map a recording. Files without a footer (still being written, or
+    // cut short) are indexed by scanning the frame headers once.
+    bool open(const std::string& path, std::string& error);
+    void close();
+
+    uint32_t getFrameCount() const { return frameCount; }
+    int64_t getStartTime() const { return startTime; }
+    int64_t getEndTime() const { return endTime; }
+    int64_t getInterval() const { return intervalNs; }
+
+    // Position at frame 'frame' (0-based)
+    bool seekFrame(uint32_t frame);
+
+    // Position at the last frame recorded at or before 'timestamp'
+    bool seekTime(int64_t timestamp);
+
+    // Step one frame forward or back
+    bool next() { return seekFrame(currentFrame + 1); }
+    bool previous() { return currentFrame > 0 && seekFrame(currentFrame - 1); }
+
+    uint32_t getFrameNumber() const { return currentFrame; }
+    int64_t getTimestamp() const { return currentTime; }
+
+    // The snapshot at the current frame, in PID order. CPU% is derived
+    // from utime/stime against the previous frame.
+    void getProcesses(std::vector<Process>& out) const;
+
+    // Parse "HH:MM[:SS]" (on the recording's first day, or the day after),
+    // "YYYY-MM-DD HH:MM[:SS]", or "+DURATION" from the start of the recording
+    bool parseTime(const std::string& text, int64_t& timestamp) const;
+
+    // Format a timestamp as local "YYYY-MM-DD HH:MM:SS"
+    static std::string formatTime(int64_t timestamp);
+
+private:
+    int fd;
+    const uint8_t* map;
+    size_t mapSize;
+    uint64_t dataEnd;
+    uint32_t frameCount;
+    int64_t startTime;
+    int64_t endTime;
+    int64_t intervalNs;
+    std::vector<RecordIndexEntry> index;
+
+    // Reconstructed state at currentFrame
+    std::unordered_map<ProcessKey, Process, ProcessKeyHash> state;
+    std::vector<ProcessKey> busy;     // Processes with nonzero CPU% in state
+    bool positioned;
+    uint32_t currentFrame;
+    uint32_t nextFrame;               // Frame number at nextOffset
+    uint64_t nextOffset;              // Offset of the next frame to decode
+    int64_t currentTime;
+    uint64_t currentTicks;
+
+    // Read the frame header at 'offset'; false if no complete frame starts there
+    bool frameAt(uint64_t offset, RecordFrameHeader& frame) const;
+
+    // Build the keyframe index by walking every frame header
+    bool scanFrames(std::string& error);
+
+    // Decode the frame at nextOffset on top of the current state
+    bool applyNextFrame();
+    bool applyKeyframe(const uint8_t* pos, const uint8_t* end, uint64_t tickDiff);
+    bool applyDelta(const uint8_t* pos, const uint8_t* end, uint64_t tickDiff);
+};
+
+// Varint encoding shared by the recorder and reader
+class RecordCodec {
+public:
+    static void putVarint(std::vector<uint8_t>& out, uint64_t value);
+    static void putSigned(std::vector<uint8_t>& out, int64_t value);
+    static void putString(std::vector<uint8_t>& out, const std::string& text);
+    static void putProcess(std::vector<uint8_t>& out, const Process& proc);
+    
+    // Readers return false on truncated input
+    static bool getVarint(const uint8_t*& pos, const uint8_t* end, uint64_t& value);
+    static bool getSigned(const uint8_t*& pos, const uint8_t* end, int64_t& value);
+    static bool getString(const uint8_t*& pos, const uint8_t* end, std::string& text);
+    static bool getProcess(const uint8_t*& pos, const uint8_t* end, Process& proc);
+};
@@ -0,0 +1,329 @@
+#include "process_rules.hpp"
+#include "process_control.hpp"
+#include "process_record.hpp"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+// Position of 'token' in 'text' outside quotes, from 'start'
+static size_t findUnquoted(const std::string& text, const std::string& token, size_t start = 0) {
+    char quote = 0;
+    for (size_t i = start; i < text.size(); i++) {
+        char c = text[i];
+        if (quote) {
+            if (c == quote) {
+                quote = 0;
+            }
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (text.compare(i, token.size(), token) == 0) {
+            return i;
+        }
+    }
+    return std::string::npos;
+}
+
+static std::string trim(const std::string& text) {
+    size_t start = text.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) {
+        return "";
+    }
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(start, end - start + 1);
+}
+
+// SnapshotDiff fields a condition reads; PIDs never change for a process
+static uint32_t dependenciesOf(const FilterExpression::Condition& cond) {
+    switch (cond.field) {
+        case FilterExpression::FIELD_PPID:    return SnapshotDiff::FIELD_PPID;
+        case FilterExpression::FIELD_NAME:    return SnapshotDiff::FIELD_NAME;
+        case FilterExpression::FIELD_USER:    return SnapshotDiff::FIELD_USER;
+        case FilterExpression::FIELD_STATE:   return SnapshotDiff::FIELD_STATE;
+        case FilterExpression::FIELD_RSS:     return SnapshotDiff::FIELD_VMRSS;
+        case FilterExpression::FIELD_VSZ:     return SnapshotDiff::FIELD_VMSIZE;
+        case FilterExpression::FIELD_CPU:     return SnapshotDiff::FIELD_CPU;
+        case FilterExpression::FIELD_THREADS: return SnapshotDiff::FIELD_THREADS;
+        case FilterExpression::FIELD_SEARCH:
+            return SnapshotDiff::FIELD_NAME | SnapshotDiff::FIELD_USER;
+        default:
+            return 0;
+    }
+}
+
+// Parse "CONDITION [for DUR] -> STEP[, then STEP after DUR]..."
+bool Rule::parse(const std::string& line, std::string& error) {
+    text = trim(line);
+    holdNs = 0;
+    steps.clear();
+    dependencies = 0;
+
+    size_t arrow = findUnquoted(text, "->");
+    if (arrow == std::string::npos) {
+        error = "missing '->' before the action";
+        return false;
+    }
+    std::string left = text.substr(0, arrow);
+    std::string right = text.substr(arrow + 2);
+
+    // "for DUR" may sit anywhere among the conditions
+    for (size_t pos = findUnquoted(left, "for"); pos != std::string::npos;
+         pos = findUnquoted(left, "for", pos + 3)) {
+        bool wordStart = pos == 0 || std::isspace((unsigned char)left[pos - 1]);
+        bool wordEnd = pos + 3 < left.size() && std::isspace((unsigned char)left[pos + 3]);
+        if (!wordStart || !wordEnd) {
+            continue;
+        }
+        size_t start = left.find_first_not_of(" \t", pos + 3);
+        size_t end = start == std::string::npos ? std::string::npos
+                                                : left.find_first_of(" \t", start);
+        std::string duration = start == std::string::npos ? ""
+                               : left.substr(start, end == std::string::npos ? end : end - start);
+        if (!SnapshotRecorder::parseDuration(duration, holdNs) || holdNs < 0) {
+            error = "invalid duration after 'for': '" + duration + "'";
+            return false;
+        }
+        left.erase(pos, end == std::string::npos ? std::string::npos : end - pos);
+        break;
+    }
+
+    if (trim(left).empty()) {
+        error = "missing condition";
+        return false;
+    }
+    if (!condition.parse(left, error)) {
+        return false;
+    }
+    for (const auto& cond : condition.getConditions()) {
+        dependencies |= dependenciesOf(cond);
+    }
+
+    std::stringstream list(right);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        std::vector<std::string> words;
+        std::stringstream stream(item);
+        std::string word;
+        while (stream >> word) {
+            std::transform(word.begin(), word.end(), word.begin(),
+                           [](unsigned char c) { return std::tolower(c); });
+            words.push_back(word);
+        }
+        if (!words.empty() && words[0] == "then") {
+            words.erase(words.begin());
+        }
+
+        RuleStep step{RuleStep::ALERT, 0, 0};
+        if (words.size() >= 2 && words[words.size() - 2] == "after") {
+            if (!SnapshotRecorder::parseDuration(words.back(), step.delayNs) ||
+                step.delayNs < 0) {
+                error = "invalid duration after 'after': '" + words.back() + "'";
+                return false;
+            }
+            words.resize(words.size() - 2);
+        }
+
+        if (words.size() == 1 && words[0] == "alert") {
+            step.kind = RuleStep::ALERT;
+        } else if (words.size() == 2 && words[0] == "nice") {
+            char* end = nullptr;
+            long nice = std::strtol(words[1].c_str(), &end, 10);
+            if (*end != '\0' || nice < -20 || nice > 19) {
+                error = "nice value must be between -20 and 19";
+                return false;
+            }
+            step.kind = RuleStep::NICE;
+            step.value = (int)nice;
+        } else if (words.size() == 1 && ProcessController::parseSignal(words[0], step.value)) {
+            step.kind = RuleStep::SIGNAL;
+        } else {
+            error = "unknown action '" + trim(item) + "' (use a signal, nice N or alert)";
+            return false;
+        }
+        steps.push_back(step);
+    }
+    if (steps.empty()) {
+        error = "missing action after '->'";
+        return false;
+    }
+    return true;
+}
+
+// RuleEngine implementation
+
+RuleEngine::RuleEngine() : dryRun(false), evaluations(0) {
+}
+
+// Read one rule per line
+bool RuleEngine::load(const std::string& path, std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    std::string line;
+    int number = 0;
+    while (std::getline(file, line)) {
+        number++;
+        size_t comment = findUnquoted(line, "#");
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        if (trim(line).empty()) {
+            continue;
+        }
+        if (!add(line, error)) {
+            error = path + ":" + std::to_string(number) + ": " + error;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool RuleEngine::add(const std::string& line, std::string& error) {
+    Rule rule;
+    if (!rule.parse(line, error)) {
+        return false;
+    }
+    rules.push_back(rule);
+    states.emplace_back();
+    return true;
+}
+
+unsigned RuleEngine::requiredFields() const {
+    unsigned fields = ProcessFields::NONE;
+    for (const auto& rule : rules) {
+        fields |= rule.condition.requiredFields();
+    }
+    return fields;
+}
+
+// Re-check one rule for one process and start or end its state
+void RuleEngine::evaluate(size_t rule, const Process& proc, int64_t now) {
+    evaluations++;
+    const Rule& current = rules[rule];
+    auto& table = states[rule];
+    auto it = table.find(proc.key());
+
+    if (current.condition.matches(proc)) {
+        if (it == table.end()) {
+            State state{now, 0, now + current.holdNs + current.steps[0].delayNs, 0, proc.name};
+            table.emplace(proc.key(), state);
+            deadlines.push(Deadline{state.nextAt, rule, proc.key()});
+        } else {
+            it->second.clearSince = 0;
+            it->second.name = proc.name;
+        }
+        return;
+    }
+
+    if (it == table.end()) {
+        return;
+    }
+    if (it->second.step == 0) {
+        // The hold had not elapsed; nothing to undo
+        table.erase(it);
+    } else if (it->second.clearSince == 0) {
+        it->second.clearSince = now;
+        deadlines.push(Deadline{now + current.holdNs, rule, proc.key()});
+    }
+}
+
+// Handle a deadline: re-arm a cleared rule, or take the next step
+void RuleEngine::advance(size_t rule, const ProcessKey& key, int64_t now,
+                         std::vector<RuleEvent>& due) {
+    const Rule& current = rules[rule];
+    auto& table = states[rule];
+    auto it = table.find(key);
+    if (it == table.end()) {
+        return;
+    }
+
+    State& state = it->second;
+    if (state.clearSince != 0 && now >= state.clearSince + current.holdNs) {
+        table.erase(it);
+        return;
+    }
+    if (state.step < current.steps.size() && now >= state.nextAt) {
+        due.push_back(RuleEvent{rule, key, state.name, current.steps[state.step], false});
+        state.step++;
+        if (state.step < current.steps.size()) {
+            state.nextAt = now + current.steps[state.step].delayNs;
+            deadlines.push(Deadline{state.nextAt, rule, key});
+        }
+    }
+}
+
+// Take due actions, one ProcessController batch per signal or nice value
+void RuleEngine::dispatch(std::vector<RuleEvent>& due) {
+    if (dryRun) {
+        return;
+    }
+
+    std::map<std::pair<int, int>, std::vector<size_t>> batches;
+    for (size_t i = 0; i < due.size(); i++) {
+        if (due[i].step.kind != RuleStep::ALERT) {
+            batches[{due[i].step.kind, due[i].step.value}].push_back(i);
+        }
+    }
+
+    for (const auto& batch : batches) {
+        std::vector<ProcessKey> targets;
+        for (size_t i : batch.second) {
+            targets.push_back(due[i].target);
+        }
+
+        if (batch.first.first == RuleStep::SIGNAL) {
+            SignalOptions options;
+            options.signal = batch.first.second;
+            std::vector<SignalResult> results = ProcessController::sendSignalBatch(targets, options);
+            for (size_t j = 0; j < results.size(); j++) {
+                due[batch.second[j]].gone = results[j].status == SignalResult::GONE;
+            }
+        } else {
+            ControlAction action;
+            action.setNice = true;
+            action.nice = batch.first.second;
+            std::vector<ControlResult> results = ProcessController::applyBatch(targets, action);
+            for (size_t j = 0; j < results.size(); j++) {
+                due[batch.second[j]].gone = results[j].gone || results[j].raced;
+            }
+        }
+    }
+}
+
+// Re-evaluate changed processes against the rules reading what changed,
+// then act on the deadlines that have passed
+void RuleEngine::update(const SnapshotDiff& diff, int64_t now, std::vector<RuleEvent>& events) {
+    evaluations = 0;
+
+    for (const Process* proc : diff.getRemoved()) {
+        for (auto& table : states) {
+            table.erase(proc->key());
+        }
+    }
+    for (const Process* proc : diff.getAdded()) {
+        for (size_t rule = 0; rule < rules.size(); rule++) {
+            evaluate(rule, *proc, now);
+        }
+    }
+    for (const auto& change : diff.getChanged()) {
+        for (size_t rule = 0; rule < rules.size(); rule++) {
+            if (rules[rule].dependencies & change.fields) {
+                evaluate(rule, *change.current, now);
+            }
+        }
+    }
+
+    std::vector<RuleEvent> due;
+    while (!deadlines.empty() && deadlines.top().time <= now) {
+        Deadline deadline = deadlines.top();
+        deadlines.pop();
+        advance(deadline.rule, deadline.key, now, due);
+    }
+
+    dispatch(due);
+    events.insert(events.end(), due.begin(), due.end());
+}
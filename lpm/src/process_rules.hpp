@@ -0,0 +1,113 @@
+#pragma once
+
+#include "process.hpp"
+#include "process_filter.hpp"
+#include "process_snapshot.hpp"
+#include <string>
+#include <vector>
+#include <queue>
+#include <unordered_map>
+#include <cstdint>
+
+// One step of a rule's action, taken 'delayNs' after the previous one
+struct RuleStep {
+    enum Kind {
+        ALERT,          // Log only
+        SIGNAL,         // Send 'value' through ProcessController::sendSignalBatch
+        NICE            // Renice to 'value' through ProcessController::applyBatch
+    };
+
+    Kind kind;
+    int value;
+    int64_t delayNs;
+};
+
+// A rule such as:
+//
+//   rss > 8G for 30s && name ~ "worker" -> SIGTERM, then SIGKILL after 10s
+//
+// The condition is a FilterExpression; "for DUR" makes it fire only once
+// a process has matched continuously for DUR. Steps are comma-separated:
+// a signal (SIGTERM, TERM or 15), "nice N" or "alert", each optionally
+// prefixed with "then" and followed by "after DUR".
+struct Rule {
+    std::string text;
+    FilterExpression condition;
+    int64_t holdNs;                 // "for" duration
+    std::vector<RuleStep> steps;
+    uint32_t dependencies;          // SnapshotDiff field bits the condition reads
+
+    // Parse one rule line; false with 'error' set on syntax errors
+    bool parse(const std::string& line, std::string& error);
+};
+
+// An action taken (or, in a dry run, due)
+struct RuleEvent {
+    size_t rule;                    // Index into the engine's rules
+    ProcessKey target;
+    std::string name;
+    RuleStep step;
+    bool gone;                      // The process exited before the action
+};
+
+// Evaluates rules against snapshot change sets. A process is only
+// re-evaluated against the rules reading a field that changed, and
+// holds and escalations wait in a deadline queue, so a refresh costs
+// O(changes + due actions) however many processes and rules there are.
+//
+// State is kept per rule and (pid, starttime) while the condition holds.
+// Once a rule has fired for a process it does not fire again until the
+// condition has been false for the hold time (at least one refresh);
+// escalation steps continue until then, or until the process exits.
+class RuleEngine {
+public:
+    RuleEngine();
+
+    // Read rules from a file, one per line ('#' starts a comment)
+    bool load(const std::string& path, std::string& error);
+
+    // Add one rule
+    bool add(const std::string& line, std::string& error);
+
+    const std::vector<Rule>& getRules() const { return rules; }
+
+    // Optional fields (ProcessFields bits) the conditions read
+    unsigned requiredFields() const;
+
+    // Log actions without taking them
+    void setDryRun(bool dryRun) { this->dryRun = dryRun; }
+
+    // Apply the change set of 'diff' at monotonic time 'now' (ns) and take
+    // the actions that are due; they are appended to 'events'
+    void update(const SnapshotDiff& diff, int64_t now, std::vector<RuleEvent>& events);
+
+    // Rule evaluations done by the last update
+    size_t getEvaluationCount() const { return evaluations; }
+
+private:
+    struct State {
+        int64_t since;              // Condition true since
+        int64_t clearSince;         // Condition false since (0 while true)
+        int64_t nextAt;             // Time of the next step
+        size_t step;                // Steps taken
+        std::string name;
+    };
+
+    struct Deadline {
+        int64_t time;
+        size_t rule;
+        ProcessKey key;
+
+        bool operator>(const Deadline& other) const { return time > other.time; }
+    };
+
+    std::vector<Rule> rules;
+    std::vector<std::unordered_map<ProcessKey, State, ProcessKeyHash>> states;
+    std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline>> deadlines;
+    bool dryRun;
+    size_t evaluations;
+
+    void evaluate(size_t rule, const Process& proc, int64_t now);
+    void advance(size_t rule, const ProcessKey& key, int64_t now, std::vector<RuleEvent>& due);
+    void dispatch(std::vector<RuleEvent>& due);
+};
@@ -0,0 +1,388 @@
+#include "process_shared.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "the seqlock needs lock-free 64-bit atomics in shared memory");
+
+static const char SHARED_MAGIC[8] = {'L', 'P', 'M', 'S', 'H', 'M', 0, 0};
+static const size_t REGION_HEADER_SIZE = 4096;
+
+// Bytes of one slot, page aligned
+static size_t slotSize(uint32_t capacity) {
+    size_t size = sizeof(SharedSlotHeader) + (size_t)capacity * sizeof(SharedProcessRecord);
+    return (size + 4095) & ~(size_t)4095;
+}
+
+static size_t regionSize(uint32_t capacity) {
+    return REGION_HEADER_SIZE + 2 * slotSize(capacity);
+}
+
+static size_t slotOffset(uint32_t capacity, uint64_t generation) {
+    return REGION_HEADER_SIZE + (generation & 1) * slotSize(capacity);
+}
+
+// True if 'pid' names a running process (possibly another user's)
+static bool processAlive(int pid) {
+    return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+// Copy a string into a fixed field, truncating and NUL-terminating
+static void copyField(char* field, size_t size, const std::string& text) {
+    size_t length = std::min(text.size(), size - 1);
+    std::memcpy(field, text.data(), length);
+    std::memset(field + length, 0, size - length);
+}
+
+// SnapshotPublisher implementation
+
+SnapshotPublisher::SnapshotPublisher() : map(nullptr), mapSize(0) {
+}
+
+SnapshotPublisher::~SnapshotPublisher() {
+    close();
+}
+
+// Create the region, taking it over from a daemon that has exited
+bool SnapshotPublisher::open(const std::string& name, int64_t intervalNs, std::string& error) {
+    close();
+
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0 && errno == EEXIST) {
+        int existing = shm_open(name.c_str(), O_RDONLY, 0);
+        SharedRegionHeader owner;
+        if (existing >= 0 && read(existing, &owner, sizeof(owner)) == (ssize_t)sizeof(owner) &&
+            std::memcmp(owner.magic, SHARED_MAGIC, sizeof(SHARED_MAGIC)) == 0 &&
+            processAlive(owner.daemonPid)) {
+            ::close(existing);
+            error = name + " is published by process " + std::to_string(owner.daemonPid);
+            return false;
+        }
+        if (existing >= 0) {
+            ::close(existing);
+        }
+        shm_unlink(name.c_str());
+        fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    }
+    if (fd < 0) {
+        error = "cannot create " + name + ": " + strerror(errno);
+        return false;
+    }
+
+    // Readable by every user on the host regardless of the umask
+    fchmod(fd, 0644);
+    size_t size = regionSize(SHARED_CAPACITY);
+    if (ftruncate(fd, size) != 0) {
+        error = "cannot size " + name + ": " + strerror(errno);
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        error = "cannot map " + name + ": " + strerror(errno);
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    this->name = name;
+    map = static_cast<uint8_t*>(mapping);
+    mapSize = size;
+
+    // The file is zero-filled, so the generation starts at 0
+    SharedRegionHeader* head = header();
+    head->version = SHARED_VERSION;
+    head->recordSize = sizeof(SharedProcessRecord);
+    head->capacity = SHARED_CAPACITY;
+    head->daemonPid = getpid();
+    head->intervalNs = intervalNs;
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(head->magic, SHARED_MAGIC, sizeof(SHARED_MAGIC));
+    return true;
+}
+
+// Write the next snapshot into the slot readers are not on
+void SnapshotPublisher::publish(const std::vector<Process>& processes, unsigned fields,
+                                int64_t timestamp, uint64_t cpuTicks, double uptime) {
+    if (!map) {
+        return;
+    }
+
+    SharedRegionHeader* head = header();
+    uint64_t generation = head->generation.load(std::memory_order_relaxed) + 1;
+    uint8_t* base = map + slotOffset(head->capacity, generation);
+    SharedSlotHeader* slot = reinterpret_cast<SharedSlotHeader*>(base);
+    SharedProcessRecord* records = reinterpret_cast<SharedProcessRecord*>(slot + 1);
+
+    slot->sequence.store(2 * generation - 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint32_t count = (uint32_t)std::min<size_t>(processes.size(), head->capacity);
+    for (uint32_t i = 0; i < count; i++) {
+        const Process& proc = processes[i];
+        SharedProcessRecord& record = records[i];
+        record.pid = proc.pid;
+        record.ppid = proc.ppid;
+        record.starttime = proc.starttime;
+        record.vmSize = proc.vmSize;
+        record.vmRSS = proc.vmRSS;
+        record.utime = proc.utime;
+        record.stime = proc.stime;
+        record.readBytes = proc.readBytes;
+        record.writeBytes = proc.writeBytes;
+        record.syscr = proc.syscr;
+        record.syscw = proc.syscw;
+        record.numThreads = proc.numThreads;
+        record.state = proc.state.empty() ? '?' : proc.state[0];
+        record.hasIO = proc.hasIO;
+        copyField(record.name, sizeof(record.name), proc.name);
+        copyField(record.user, sizeof(record.user), proc.user);
+    }
+    slot->timestamp = timestamp;
+    slot->cpuTicks = cpuTicks;
+    slot->uptime = uptime;
+    slot->count = count;
+    slot->fields = fields;
+    slot->truncated = (uint32_t)(processes.size() - count);
+
+    slot->sequence.store(2 * generation, std::memory_order_release);
+    head->generation.store(generation, std::memory_order_release);
+}
+
+// Unmap and remove the region; attached readers keep their mapping
+void SnapshotPublisher::close() {
+    if (map) {
+        munmap(map, mapSize);
+        shm_unlink(name.c_str());
+        map = nullptr;
+        mapSize = 0;
+    }
+}
+
+uint64_t SnapshotPublisher::getGeneration() const {
+    return map ? reinterpret_cast<const SharedRegionHeader*>(map)->generation.load() : 0;
+}
+
+// SharedSnapshotSource implementation
+
+SharedSnapshotSource::SharedSnapshotSource()
+    : map(nullptr), mapSize(0), generation(0), cpuTicks(0), uptime(0.0), valid(false),
+      torn(0), stale(0), current(nullptr), cursor(0) {
+}
+
+SharedSnapshotSource::~SharedSnapshotSource() {
+    if (map) {
+        munmap(const_cast<uint8_t*>(map), mapSize);
+    }
+}
+
+// Map the region of a running daemon read-only
+bool SharedSnapshotSource::open(const std::string& name, std::string& error) {
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        error = errno == ENOENT ? "no lpm --daemon is publishing " + name
+                                : "cannot open " + name + ": " + strerror(errno);
+        return false;
+    }
+
+    SharedRegionHeader head;
+    struct stat info;
+    if (read(fd, &head, sizeof(head)) != (ssize_t)sizeof(head) ||
+        std::memcmp(head.magic, SHARED_MAGIC, sizeof(SHARED_MAGIC)) != 0 ||
+        fstat(fd, &info) != 0) {
+        ::close(fd);
+        error = name + " is not an lpm snapshot region";
+        return false;
+    }
+    if (head.version != SHARED_VERSION || head.recordSize != sizeof(SharedProcessRecord) ||
+        (size_t)info.st_size < regionSize(head.capacity)) {
+        ::close(fd);
+        error = name + " was published by an incompatible lpm";
+        return false;
+    }
+
+    size_t size = regionSize(head.capacity);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        error = "cannot map " + name + ": " + strerror(errno);
+        return false;
+    }
+
+    this->name = name;
+    map = static_cast<const uint8_t*>(mapping);
+    mapSize = size;
+    return true;
+}
+
+// Copy the latest complete snapshot. A slot whose sequence is not that of
+// the header's generation before and after the copy is being rewritten;
+// try again with the newer one. If the daemon keeps overtaking the copy,
+// the scan sees the previous snapshot again, as when nothing was published.
+bool SharedSnapshotSource::pin() {
+    current = nullptr;
+    cursor = 0;
+    if (!map) {
+        return false;
+    }
+
+    const SharedRegionHeader* head = header();
+    for (int attempt = 0; attempt < 8; attempt++) {
+        uint64_t latest = head->generation.load(std::memory_order_acquire);
+        if (latest == 0) {
+            return false;
+        }
+        if (valid && latest == generation) {
+            return true;                    // Already copied
+        }
+
+        const SharedSlotHeader* slot = reinterpret_cast<const SharedSlotHeader*>(
+            map + slotOffset(head->capacity, latest));
+        if (slot->sequence.load(std::memory_order_acquire) != 2 * latest) {
+            continue;
+        }
+        uint32_t count = std::min(slot->count, head->capacity);
+        uint64_t pinnedTicks = slot->cpuTicks;
+        double pinnedUptime = slot->uptime;
+        spare.resize(count);
+        std::memcpy(spare.data(), slot + 1, count * sizeof(SharedProcessRecord));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot->sequence.load(std::memory_order_relaxed) != 2 * latest) {
+            torn++;
+            continue;
+        }
+
+        records.swap(spare);
+        generation = latest;
+        cpuTicks = pinnedTicks;
+        uptime = pinnedUptime;
+        valid = true;
+        return true;
+    }
+
+    if (valid) {
+        stale++;
+    }
+    return valid;
+}
+
+// Find one record of the pinned snapshot
+bool SharedSnapshotSource::fetch(int pid) {
+    if (current && current->pid == pid) {
+        return true;
+    }
+    if (!valid) {
+        return false;
+    }
+
+    // Scans read PIDs in the order listed, so the cursor is usually right
+    uint32_t count = (uint32_t)records.size();
+    uint32_t index = cursor;
+    if (index >= count || records[index].pid != pid) {
+        uint32_t low = 0, high = count;
+        while (low < high) {
+            uint32_t middle = low + (high - low) / 2;
+            if (records[middle].pid < pid) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        index = low;
+    }
+    if (index >= count || records[index].pid != pid) {
+        current = nullptr;
+        return false;
+    }
+
+    cursor = index + 1;
+    current = &records[index];
+    return true;
+}
+
+// PIDs of the pinned snapshot (pinning one if the scan did not)
+void SharedSnapshotSource::listPids(std::vector<int>& pids) {
+    if (!valid && !pin()) {
+        return;
+    }
+
+    for (const auto& record : records) {
+        pids.push_back(record.pid);
+    }
+}
+
+// Stat fields of one process
+bool SharedSnapshotSource::readProcess(int pid, Process& proc) {
+    if (!fetch(pid)) {
+        return false;
+    }
+
+    proc.pid = current->pid;
+    proc.ppid = current->ppid;
+    proc.name.assign(current->name, strnlen(current->name, sizeof(current->name)));
+    proc.state.assign(1, current->state);
+    proc.vmSize = current->vmSize;
+    proc.vmRSS = current->vmRSS;
+    proc.utime = current->utime;
+    proc.stime = current->stime;
+    proc.numThreads = current->numThreads;
+    proc.starttime = current->starttime;
+    return true;
+}
+
+// Owner as resolved by the daemon
+bool SharedSnapshotSource::readUser(int pid, Process& proc) {
+    if (!fetch(pid) || current->user[0] == '\0') {
+        return false;
+    }
+
+    proc.user.assign(current->user, strnlen(current->user, sizeof(current->user)));
+    return true;
+}
+
+// I/O counters, if the daemon collects them
+bool SharedSnapshotSource::readIO(int pid, Process& proc) {
+    if (!fetch(pid) || !current->hasIO) {
+        return false;
+    }
+
+    proc.readBytes = current->readBytes;
+    proc.writeBytes = current->writeBytes;
+    proc.syscr = current->syscr;
+    proc.syscw = current->syscw;
+    proc.hasIO = true;
+    return true;
+}
+
+// Called first in every scan, so this is where the snapshot is pinned
+unsigned long SharedSnapshotSource::getTotalCPUTime() {
+    pin();
+    return cpuTicks;
+}
+
+double SharedSnapshotSource::getUptime() {
+    return uptime;
+}
+
+// Description for status lines, with any snapshots that could not be
+// copied consistently
+std::string SharedSnapshotSource::describe() const {
+    int daemon = map ? header()->daemonPid : 0;
+    std::string text = "shm:" + name + (processAlive(daemon) ? " (daemon " + std::to_string(daemon)
+                                                             : " (daemon gone");
+    if (torn > 0) {
+        text += ", " + std::to_string(torn) + " torn";
+    }
+    if (stale > 0) {
+        text += ", " + std::to_string(stale) + " stale";
+    }
+    return text + ")";
+}
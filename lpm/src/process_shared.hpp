@@ -0,0 +1,159 @@
+#pragma once
+
+#include "process_source.hpp"
+#include <atomic>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Layout of the shared-memory region (/dev/shm/<name>):
+//
+//   SharedRegionHeader          one page
+//   SharedSlot[2]               SharedSlotHeader + SharedProcessRecord[capacity]
+//
+// Snapshot number G is written to slot G % 2, so the one readers are on
+// is only overwritten two snapshots later. Each slot carries a seqlock:
+// its sequence is 2G - 1 while snapshot G is written and 2G once it is
+// complete, after which the header's generation becomes G. Readers check
+// the sequence after copying each record and drop a snapshot that changed
+// under them. The region is sparse, so only written records cost memory.
+
+struct SharedRegionHeader {
+    char magic[8];                       // "LPMSHM\0\0"
+    uint32_t version;
+    uint32_t recordSize;                 // sizeof(SharedProcessRecord)
+    uint32_t capacity;                   // Records per slot
+    int32_t daemonPid;
+    int64_t intervalNs;                  // Publishing interval
+    std::atomic<uint64_t> generation;    // Latest complete snapshot, 0 if none
+};
+
+struct SharedSlotHeader {
+    std::atomic<uint64_t> sequence;      // Seqlock, odd while being written
+    int64_t timestamp;                   // ns since the epoch
+    uint64_t cpuTicks;                   // Cumulative system CPU time
+    double uptime;                       // Seconds since boot
+    uint32_t count;                      // Records in this snapshot
+    uint32_t fields;                     // ProcessFields collected
+    uint32_t truncated;                  // Processes beyond the capacity
+    uint32_t reserved[5];
+};
+
+// One process, with raw counters; readers derive CPU% and rates
+struct SharedProcessRecord {
+    int32_t pid;
+    int32_t ppid;
+    int64_t starttime;
+    int64_t vmSize;
+    int64_t vmRSS;
+    uint64_t utime;
+    uint64_t stime;
+    uint64_t readBytes;
+    uint64_t writeBytes;
+    uint64_t syscr;
+    uint64_t syscw;
+    int32_t numThreads;
+    char state;
+    uint8_t hasIO;
+    uint8_t reserved[2];
+    char name[64];                       // Truncated, NUL-terminated
+    char user[32];
+};
+
+const uint32_t SHARED_VERSION = 1;
+const uint32_t SHARED_CAPACITY = 65536;
+const char* const SHARED_DEFAULT_NAME = "/lpm";
+
+// Publishes snapshots from one collector (lpm --daemon) for any number of
+// SharedSnapshotSource readers
+class SnapshotPublisher {
+public:
+    SnapshotPublisher();
+    ~SnapshotPublisher();
+
+    // Create the region; fails if another live daemon owns it
+    bool open(const std::string& name, int64_t intervalNs, std::string& error);
+
+    // Write one snapshot (processes in PID order)
+    void publish(const std::vector<Process>& processes, unsigned fields, int64_t timestamp,
+                 uint64_t cpuTicks, double uptime);
+
+    // Unmap and remove the region
+    void close();
+
+    uint64_t getGeneration() const;
+    size_t getRegionSize() const { return mapSize; }
+
+private:
+    std::string name;
+    uint8_t* map;
+    size_t mapSize;
+
+    SharedRegionHeader* header() { return reinterpret_cast<SharedRegionHeader*>(map); }
+};
+
+// Reads the snapshots of a running lpm --daemon instead of scanning /proc.
+// Each scan pins the latest snapshot when ProcessManager asks for the CPU
+// time, copying its records out of the mapping under the seqlock; PIDs,
+// stat fields, users and I/O counters are then read from that copy, so
+// a publish mid-scan cannot cut the listing short. Threads, cgroups and
+// smaps are read from /proc directly, since they are only fetched for
+// processes being looked at. Scheduler statistics are not published.
+class SharedSnapshotSource : public ProcfsSource {
+public:
+    SharedSnapshotSource();
+    ~SharedSnapshotSource() override;
+
+    // Map the region of a daemon; false (with the reason) if there is none
+    bool open(const std::string& name, std::string& error);
+
+    void listPids(std::vector<int>& pids) override;
+    bool readProcess(int pid, Process& proc) override;
+    bool readUser(int pid, Process& proc) override;
+    bool readIO(int pid, Process& proc) override;
+    bool readSched(int pid, Process& proc) override {
+        (void)pid;
+        (void)proc;
+        return false;
+    }
+    unsigned long getTotalCPUTime() override;
+    double getUptime() override;
+    std::string describe() const override;
+
+    // Copies discarded because the daemon overwrote the slot mid-copy, and
+    // scans that fell back to the previous snapshot after every retry
+    uint64_t getTornCount() const { return torn; }
+    uint64_t getStaleCount() const { return stale; }
+
+private:
+    std::string name;
+    const uint8_t* map;
+    size_t mapSize;
+
+    // Pinned snapshot, copied out of the mapping; 'spare' receives the
+    // next copy so a torn one never replaces a consistent one
+    uint64_t generation;
+    std::vector<SharedProcessRecord> records;
+    std::vector<SharedProcessRecord> spare;
+    uint64_t cpuTicks;
+    double uptime;
+    bool valid;              // A consistent snapshot has been copied
+    uint64_t torn;
+    uint64_t stale;
+
+    // Last record read
+    const SharedProcessRecord* current;
+    uint32_t cursor;         // Index of the next record in PID order
+
+    const SharedRegionHeader* header() const {
+        return reinterpret_cast<const SharedRegionHeader*>(map);
+    }
+
+    // Copy the latest complete snapshot, keeping the previous one if every
+    // attempt is overwritten
+    bool pin();
+
+    // Point 'current' at the record of 'pid'; false if absent
+    bool fetch(int pid);
+};
@@ -0,0 +1,68 @@
+#include "process_snapshot.hpp"
+
+// SnapshotDiff constructor
+SnapshotDiff::SnapshotDiff() {
+}
+
+// Compare two samples of the same process
+uint32_t SnapshotDiff::compare(const Process& before, const Process& after) {
+    uint32_t fields = 0;
+
+    if (before.ppid != after.ppid)             fields |= FIELD_PPID;
+    if (before.name != after.name)             fields |= FIELD_NAME;
+    if (before.user != after.user)             fields |= FIELD_USER;
+    if (before.state != after.state)           fields |= FIELD_STATE;
+    if (before.vmSize != after.vmSize)         fields |= FIELD_VMSIZE;
+    if (before.vmRSS != after.vmRSS)           fields |= FIELD_VMRSS;
+    if (before.utime != after.utime)           fields |= FIELD_UTIME;
+    if (before.stime != after.stime)           fields |= FIELD_STIME;
+    if (before.numThreads != after.numThreads) fields |= FIELD_THREADS;
+    if (before.cpuPercent != after.cpuPercent) fields |= FIELD_CPU;
+
+    return fields;
+}
+
+// Compare a snapshot with the previous one
+void SnapshotDiff::update(const std::vector<Process>& current) {
+    added.clear();
+    removed.clear();
+    changed.clear();
+
+    next.clear();
+    next.reserve(current.size());
+
+    for (const auto& proc : current) {
+        ProcessKey key = proc.key();
+        next.emplace(key, proc);
+
+        auto it = previous.find(key);
+        if (it == previous.end()) {
+            added.push_back(&proc);
+        } else {
+            uint32_t fields = compare(it->second, proc);
+            if (fields != 0) {
+                changed.push_back(Change{&proc, &it->second, fields});
+            }
+        }
+    }
+
+    // Whatever is not in the new snapshot has exited
+    for (const auto& entry : previous) {
+        if (next.find(entry.first) == next.end()) {
+            removed.push_back(&entry.second);
+        }
+    }
+
+    // The old snapshot moves to 'next' (node addresses are preserved),
+    // keeping Change::previous and removed entries valid
+    previous.swap(next);
+}
+
+// Forget the previous snapshot
+void SnapshotDiff::reset() {
+    previous.clear();
+    next.clear();
+    added.clear();
+    removed.clear();
+    changed.clear();
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "process.hpp"
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+// Field-level change set between consecutive process snapshots
+class SnapshotDiff {
+public:
+    // Bits identifying which fields of a process changed
+    enum FieldBits {
+        FIELD_PPID    = 1 << 0,
+        FIELD_NAME    = 1 << 1,
+        FIELD_USER    = 1 << 2,
+        FIELD_STATE   = 1 << 3,
+        FIELD_VMSIZE  = 1 << 4,
+        FIELD_VMRSS   = 1 << 5,
+        FIELD_UTIME   = 1 << 6,
+        FIELD_STIME   = 1 << 7,
+        FIELD_THREADS = 1 << 8,
+        FIELD_CPU     = 1 << 9
+    };
+
+    struct Change {
+        const Process* current;   // Points into the snapshot passed to update()
+        const Process* previous;  // Valid until the next update()
+        uint32_t fields;
+    };
+
+    SnapshotDiff();
+
+    // Compare a snapshot with the previous one. Pointers to current
+    // processes stay valid while 'current' is unchanged; pointers to
+    // previous values stay valid until the next update.
+    void update(const std::vector<Process>& current);
+
+    // Forget the previous snapshot (the next update reports everything as added)
+    void reset();
+
+    // Processes that appeared since the previous snapshot
+    const std::vector<const Process*>& getAdded() const { return added; }
+
+    // Processes that exited since the previous snapshot (last known values)
+    const std::vector<const Process*>& getRemoved() const { return removed; }
+
+    // Processes with at least one changed field
+    const std::vector<Change>& getChanged() const { return changed; }
+
+    // Compare two samples of the same process
+    static uint32_t compare(const Process& before, const Process& after);
+
+private:
+    std::unordered_map<ProcessKey, Process, ProcessKeyHash> previous;
+    std::unordered_map<ProcessKey, Process, ProcessKeyHash> next;
+    std::vector<const Process*> added;
+    std::vector<const Process*> removed;
+    std::vector<Change> changed;
+};
@@ -0,0 +1,686 @@
+#include "process_source.hpp"
+#include "process_profile.hpp"
+#include "process_system.hpp"
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <pwd.h>
+#include <time.h>
+#include <unistd.h>
+
+// ProcfsSource implementation
+
+ProcfsSource::ProcfsSource() : root("/proc") {
+}
+
+ProcfsSource::ProcfsSource(const std::string& root) : root(root) {
+}
+
+// List numeric directories under the root. A failure part way through
+// keeps the PIDs read so far rather than dropping the snapshot.
+void ProcfsSource::listPids(std::vector<int>& pids) {
+    time_t now = time(nullptr);
+    if (now - userNamesTime >= 60) {
+        userNames.clear();
+        userNamesTime = now;
+    }
+
+    size_t first = pids.size();
+    pidEnumerator.list(root, pids);
+
+    // procfs lists PIDs in order; an ordinary directory does not
+    if (!std::is_sorted(pids.begin() + first, pids.end())) {
+        std::sort(pids.begin() + first, pids.end());
+    }
+}
+
+// Read the stat file of one process from <root>/<pid>
+bool ProcfsSource::readProcess(int pid, Process& proc) {
+    return proc.readFromProc(pid, root, ProcessFields::NONE);
+}
+
+// Read <root>/<pid>/status for the owner. Names are cached by UID: the
+// status read stays, but each UID costs one getpwuid, not each process.
+bool ProcfsSource::readUser(int pid, Process& proc) {
+    int uid;
+    if (!proc.readStatusFromProc(pid, root, uid)) {
+        return false;
+    }
+
+    auto it = userNames.find(uid);
+    if (it == userNames.end()) {
+        ScopedTimer timer(Profiler::STAGE_GETPWUID);
+        struct passwd* pw = getpwuid(uid);
+        it = userNames.emplace(uid, pw ? pw->pw_name : std::to_string(uid)).first;
+    }
+    proc.user = it->second;
+    return true;
+}
+
+// List the numeric entries of <root>/<pid>/task
+bool ProcfsSource::listThreads(int pid, std::vector<int>& tids) {
+    size_t first = tids.size();
+    if (!taskEnumerator.list(root + "/" + std::to_string(pid) + "/task", tids)) {
+        return false;
+    }
+
+    if (!std::is_sorted(tids.begin() + first, tids.end())) {
+        std::sort(tids.begin() + first, tids.end());
+    }
+    return true;
+}
+
+// Read one thread from <root>/<pid>/task/<tid>
+bool ProcfsSource::readThread(int pid, int tid, Process& thread) {
+    return thread.readThreadFromProc(pid, tid, root);
+}
+
+// Read <root>/<pid>/cgroup. The unified hierarchy entry "0::/path" is
+// preferred; on v1-only systems the first controller's path is used.
+bool ProcfsSource::readCgroup(int pid, std::string& path) {
+    std::ifstream file(root + "/" + std::to_string(pid) + "/cgroup");
+    if (!file.is_open()) {
+        return false;
+    }
+    Profiler::add(Profiler::FILES_OPENED, 1);
+
+    std::string line;
+    bool found = false;
+    while (std::getline(file, line)) {
+        Profiler::add(Profiler::BYTES_READ, line.size() + 1);
+
+        // hierarchy-ID:controller-list:path
+        size_t colon = line.find(':', line.find(':') + 1);
+        if (colon == std::string::npos) {
+            continue;
+        }
+        if (line.compare(0, 3, "0::") == 0) {
+            path = line.substr(colon + 1);
+            return true;
+        }
+        if (!found) {
+            path = line.substr(colon + 1);
+            found = true;
+        }
+    }
+    return found;
+}
+
+// Read PSS, USS and swap from <root>/<pid>/smaps_rollup (Linux 4.14+)
+bool ProcfsSource::readMemoryUsage(int pid, MemoryUsage& usage) {
+    std::string path = root + "/" + std::to_string(pid) + "/smaps_rollup";
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    Profiler::add(Profiler::FILES_OPENED, 1);
+
+    // The rollup is about 1 kB; the kernel walks every mapping to produce it
+    char buf[4096];
+    ssize_t length = 0;
+    while ((size_t)length < sizeof(buf) - 1) {
+        ssize_t n = read(fd, buf + length, sizeof(buf) - 1 - length);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        length += n;
+    }
+    close(fd);
+    Profiler::add(Profiler::BYTES_READ, length);
+    buf[length] = '\0';
+
+    usage = MemoryUsage();
+    bool found = false;
+    for (char* line = buf; line && *line; ) {
+        char* next = strchr(line, '\n');
+        if (strncmp(line, "Pss:", 4) == 0) {
+            usage.pss = atol(line + 4);
+            found = true;
+        } else if (strncmp(line, "Private_Clean:", 14) == 0) {
+            usage.uss += atol(line + 14);
+        } else if (strncmp(line, "Private_Dirty:", 14) == 0) {
+            usage.uss += atol(line + 14);
+        } else if (strncmp(line, "Swap:", 5) == 0) {
+            usage.swap = atol(line + 5);
+        }
+        line = next ? next + 1 : nullptr;
+    }
+    return found;
+}
+
+// Read <root>/<pid>/io
+bool ProcfsSource::readIO(int pid, Process& proc) {
+    return proc.readIOFromProc(pid, root);
+}
+
+// Read <root>/<pid>/schedstat, or sum the threads' for a multithreaded
+// process (numThreads comes from the stat read before)
+bool ProcfsSource::readSched(int pid, Process& proc) {
+    if (proc.numThreads > 1) {
+        schedTids.clear();
+        if (taskEnumerator.list(root + "/" + std::to_string(pid) + "/task", schedTids) &&
+            proc.readTaskSchedFromProc(pid, schedTids, root)) {
+            return true;
+        }
+    }
+    return proc.readSchedFromProc(pid, root);
+}
+
+// Get total CPU time since boot (sum of all CPU time values)
+// The first line of stat is "cpu  user nice system idle iowait irq
+// softirq steal guest guest_nice"; steal counts (time the hypervisor gave
+// to other guests) and guest time, already in user and nice, does not
+unsigned long ProcfsSource::getTotalCPUTime() {
+    int fd = open((root + "/stat").c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return 0;
+    }
+    Profiler::add(Profiler::FILES_OPENED, 1);
+
+    char buf[512];
+    ssize_t length = read(fd, buf, sizeof(buf));
+    close(fd);
+    if (length <= 4 || memcmp(buf, "cpu ", 4) != 0) {
+        return 0;
+    }
+    Profiler::add(Profiler::BYTES_READ, length);
+
+    CPUTimes times{};
+    times.parse(buf + 3, buf + length);
+    return times.total();
+}
+
+// Get system uptime in seconds
+double ProcfsSource::getUptime() {
+    std::ifstream uptimeFile(root + "/uptime");
+    if (!uptimeFile.is_open()) {
+        return 0.0;
+    }
+    Profiler::add(Profiler::FILES_OPENED, 1);
+
+    double uptime = 0.0;
+    uptimeFile >> uptime;
+    return uptime;
+}
+
+// SyntheticSource implementation
+
+static const long CLOCK_TICKS = 100;
+
+// User names used by the generator and the UIDs written by writeTree()
+static const struct {
+    const char* name;
+    int uid;
+} SYNTHETIC_USERS[] = {
+    {"root", 0}, {"www-data", 33}, {"postgres", 114}, {"alice", 1000}, {"bob", 1001},
+};
+
+static int syntheticUid(const std::string& user) {
+    for (const auto& entry : SYNTHETIC_USERS) {
+        if (user == entry.name) {
+            return entry.uid;
+        }
+    }
+    return 65534;
+}
+
+SyntheticSource::SyntheticSource(size_t count, uint64_t seed)
+    : targetCount(std::max<size_t>(count, 8)), rng(seed ? seed : 1), nextPid(1),
+      cpus(16), totalTicks(0), uptime(3 * 86400.0), realTime(false), lastScan(0.0) {
+    processes.reserve(targetCount + targetCount / 8);
+    shortLived.reserve(processes.capacity());
+
+    totalTicks = (unsigned long)(uptime * CLOCK_TICKS * cpus);
+
+    spawn(0, "systemd", "root", 12000, 1, false);
+    int kthreadd = spawn(0, "kthreadd", "root", 0, 1, false);
+
+    // Per-CPU kernel threads plus a pool of workers, about 5% of the table
+    static const char* perCPU[] = {"cpuhp", "migration", "ksoftirqd", "kworker"};
+    size_t kernelThreads = std::max<size_t>(targetCount / 20, 8);
+    for (size_t i = 0; i < kernelThreads; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "%s/%d", perCPU[i % 4], (int)(i / 4) % cpus);
+        spawn(kthreadd, name, "root", 0, 1, false);
+    }
+
+    while (processes.size() < targetCount) {
+        spawnWorkload();
+    }
+    reindex();
+}
+
+// xorshift64*: deterministic across platforms and standard libraries
+uint64_t SyntheticSource::random() {
+    rng ^= rng >> 12;
+    rng ^= rng << 25;
+    rng ^= rng >> 27;
+    return rng * 2685821657736338717ULL;
+}
+
+// Log-uniform size between two bounds, in kB
+long SyntheticSource::randomSize(long minKB, long maxKB) {
+    double lo = std::log((double)minKB);
+    double hi = std::log((double)maxKB);
+    return (long)std::exp(lo + (hi - lo) * uniform());
+}
+
+// Add a process; returns its PID, or -1 once the table is full
+int SyntheticSource::spawn(int ppid, const std::string& name, const std::string& user,
+                           long rssKB, int threads, bool ephemeral) {
+    if (ppid < 0 || processes.size() >= targetCount) {
+        return -1;
+    }
+
+    Process proc;
+    proc.pid = nextPid;
+    proc.ppid = ppid;
+    proc.name = name;
+    proc.user = user;
+    proc.state = "S";
+    proc.vmRSS = rssKB & ~3L;    // Whole 4 kB pages
+    proc.vmSize = rssKB > 0 ? rssKB * 4 + randomSize(8000, 400000) : 0;
+    proc.numThreads = threads;
+    proc.starttime = (long)(uptime * CLOCK_TICKS * (ephemeral ? 1.0 : uniform()));
+    unsigned long age = (unsigned long)(uptime * CLOCK_TICKS) - proc.starttime;
+    proc.utime = (unsigned long)(age * 0.01 * uniform());
+    proc.stime = proc.utime / 4;
+    addIO(proc, proc.utime);
+
+    // PIDs are handed out in order, leaving gaps like a busy real system
+    nextPid += 1 + (int)(random() % 3);
+
+    processes.push_back(proc);
+    shortLived.push_back(ephemeral);
+    byPid[proc.pid] = processes.size() - 1;
+    return proc.pid;
+}
+
+// Spawn one subtree of a randomly chosen shape
+void SyntheticSource::spawnWorkload() {
+    static const char* services[] = {
+        "systemd-journald", "systemd-udevd", "dbus-daemon", "cron", "rsyslogd",
+        "NetworkManager", "polkitd", "chronyd", "containerd", "dockerd",
+    };
+    static const char* tools[] = {"vim", "less", "top", "git", "ssh", "python3", "man"};
+    static const char* runtimes[] = {"python3", "java", "node", "ruby", "gunicorn"};
+    static const char* humans[] = {"alice", "bob"};
+
+    double pick = uniform();
+
+    if (pick < 0.25) {
+        // System service, sometimes with a pool of workers
+        const char* name = services[random() % 10];
+        spawn(1, name, "root", randomSize(2000, 80000), 1 + random() % 8, false);
+        if (uniform() < 0.3) {
+            bool web = uniform() < 0.5;
+            int master = spawn(1, web ? "nginx" : "postgres", web ? "www-data" : "postgres",
+                               randomSize(4000, 40000), 1, false);
+            int workers = 2 + random() % 14;
+            for (int i = 0; i < workers; i++) {
+                spawn(master, web ? "nginx" : "postgres", web ? "www-data" : "postgres",
+                      randomSize(4000, 200000), 1, false);
+            }
+        }
+    } else if (pick < 0.50) {
+        // Login session: sshd -> shell -> tools, or a tmux server with panes
+        const char* user = humans[random() % 2];
+        int sshd = spawn(1, "sshd", "root", randomSize(5000, 10000), 1, false);
+        int shell = spawn(sshd, "bash", user, randomSize(3000, 6000), 1, false);
+        if (uniform() < 0.4) {
+            int tmux = spawn(shell, "tmux: server", user, randomSize(3000, 8000), 1, false);
+            int panes = 1 + random() % 8;
+            for (int i = 0; i < panes; i++) {
+                int pane = spawn(tmux, "bash", user, randomSize(3000, 6000), 1, false);
+                if (uniform() < 0.6) {
+                    spawn(pane, tools[random() % 7], user, randomSize(4000, 120000), 1, false);
+                }
+            }
+        } else {
+            spawn(shell, tools[random() % 7], user, randomSize(4000, 120000), 1, false);
+        }
+    } else if (pick < 0.65) {
+        // Parallel build: deep, short-lived chains make -> sh -> g++ -> cc1plus
+        const char* user = humans[random() % 2];
+        int make = spawn(1, "make", user, randomSize(3000, 20000), 1, false);
+        int jobs = 2 + random() % 30;
+        for (int i = 0; i < jobs; i++) {
+            int sh = spawn(make, "sh", user, randomSize(1000, 3000), 1, true);
+            int driver = spawn(sh, "g++", user, randomSize(2000, 8000), 1, true);
+            spawn(driver, "cc1plus", user, randomSize(100000, 1500000), 1, true);
+        }
+    } else if (pick < 0.80) {
+        // Browser: a broad, shallow tree with large renderers
+        const char* user = humans[random() % 2];
+        int browser = spawn(1, "chrome", user, randomSize(200000, 800000), 30 + random() % 40, false);
+        int renderers = 5 + random() % 60;
+        for (int i = 0; i < renderers; i++) {
+            spawn(browser, "chrome", user, randomSize(30000, 600000), 10 + random() % 20, false);
+        }
+    } else {
+        // Container: shim -> application -> worker fan-out
+        int shim = spawn(1, "containerd-shim", "root", randomSize(8000, 15000), 10, false);
+        const char* runtime = runtimes[random() % 5];
+        int app = spawn(shim, runtime, "www-data", randomSize(30000, 300000), 4 + random() % 20, false);
+        int workers = 2 + random() % 64;
+        for (int i = 0; i < workers; i++) {
+            spawn(app, runtime, "www-data", randomSize(20000, 400000), 1 + random() % 4,
+                  uniform() < 0.3);
+        }
+    }
+}
+
+// I/O for 'ticks' of CPU time. Each process gets a fixed mix from its PID
+// (no random numbers, so the generated table does not change): from
+// nearly none to about 4 MB read and 1 MB written per CPU second.
+void SyntheticSource::addIO(Process& proc, unsigned long ticks) {
+    unsigned mix = ((unsigned)proc.pid * 2654435761u) >> 28;   // 0-15
+    unsigned long long kb = (unsigned long long)ticks * mix * mix / 6;
+    proc.readBytes += kb * 1024;
+    proc.writeBytes += kb * 256;
+    proc.syscr += (unsigned long long)ticks * (mix + 1) * 4;
+    proc.syscw += (unsigned long long)ticks * (mix + 1);
+}
+
+// Rebuild the PID index after removals
+void SyntheticSource::reindex() {
+    byPid.clear();
+    byPid.reserve(processes.size());
+    for (size_t i = 0; i < processes.size(); i++) {
+        byPid[processes[i].pid] = i;
+    }
+}
+
+// Simulate 'seconds' of activity
+void SyntheticSource::advance(double seconds) {
+    uptime += seconds;
+    unsigned long ticks = (unsigned long)(seconds * CLOCK_TICKS);
+    totalTicks += ticks * cpus;
+
+    std::vector<bool> reaped(processes.size(), false);
+    size_t reapedCount = 0;
+
+    for (size_t i = 0; i < processes.size(); i++) {
+        Process& proc = processes[i];
+
+        // A few percent of processes are busy in any interval
+        if (uniform() < 0.03) {
+            unsigned long used = (unsigned long)(ticks * uniform());
+            proc.utime += used;
+            proc.stime += used / 5;
+            proc.state = "R";
+            addIO(proc, used);
+        } else {
+            proc.state = "S";
+        }
+
+        if (proc.vmRSS > 0 && uniform() < 0.05) {
+            long change = (long)(proc.vmRSS * 0.05 * (uniform() * 2 - 1));
+            proc.vmRSS = std::max(4L, (proc.vmRSS + change) & ~3L);
+            proc.vmSize = std::max(proc.vmSize, proc.vmRSS);
+        }
+
+        if (shortLived[i] && uniform() < std::min(1.0, 0.2 * seconds)) {
+            reaped[i] = true;
+            reapedCount++;
+        }
+    }
+
+    if (reapedCount > 0) {
+        size_t out = 0;
+        for (size_t i = 0; i < processes.size(); i++) {
+            if (!reaped[i]) {
+                if (out != i) {
+                    processes[out] = std::move(processes[i]);
+                    shortLived[out] = shortLived[i];
+                }
+                out++;
+            }
+        }
+        processes.resize(out);
+        shortLived.resize(out);
+        reindex();
+
+        // Orphans are adopted by init
+        for (auto& proc : processes) {
+            if (proc.ppid > 0 && byPid.find(proc.ppid) == byPid.end()) {
+                proc.ppid = 1;
+            }
+        }
+    }
+
+    while (processes.size() < targetCount) {
+        spawnWorkload();
+    }
+}
+
+// List PIDs in ascending order
+void SyntheticSource::listPids(std::vector<int>& pids) {
+    pids.reserve(pids.size() + processes.size());
+    for (const auto& proc : processes) {
+        pids.push_back(proc.pid);
+    }
+}
+
+// Called first in every scan, so this is where simulated time passes;
+// less than a tick since the last call is carried over to the next
+unsigned long SyntheticSource::getTotalCPUTime() {
+    if (realTime) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        double seconds = now.tv_sec + now.tv_nsec / 1e9;
+        if (lastScan == 0.0) {
+            lastScan = seconds;
+        } else if (seconds - lastScan >= 1.0 / CLOCK_TICKS) {
+            advance(std::min(seconds - lastScan, 60.0));
+            lastScan = seconds;
+        }
+    }
+    return totalTicks;
+}
+
+// Copy one process out of the table
+bool SyntheticSource::readProcess(int pid, Process& proc) {
+    auto it = byPid.find(pid);
+    if (it == byPid.end()) {
+        return false;
+    }
+    proc = processes[it->second];
+    proc.cpuPercent = 0.0;
+    
+    // Users and I/O counters are only handed out by readUser() and readIO()
+    proc.user.clear();
+    proc.readBytes = proc.writeBytes = proc.syscr = proc.syscw = 0;
+    return true;
+}
+
+// Copy the user of one process
+bool SyntheticSource::readUser(int pid, Process& proc) {
+    auto it = byPid.find(pid);
+    if (it == byPid.end()) {
+        return false;
+    }
+    proc.user = processes[it->second].user;
+    return true;
+}
+
+// Only the generator's own user names occur
+bool SyntheticSource::userNameMayContain(const std::string& text) {
+    for (const auto& entry : SYNTHETIC_USERS) {
+        if (std::string(entry.name).find(text) != std::string::npos) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Copy the I/O counters of one process
+bool SyntheticSource::readIO(int pid, Process& proc) {
+    auto it = byPid.find(pid);
+    if (it == byPid.end()) {
+        return false;
+    }
+    const Process& source = processes[it->second];
+    proc.readBytes = source.readBytes;
+    proc.writeBytes = source.writeBytes;
+    proc.syscr = source.syscr;
+    proc.syscw = source.syscw;
+    proc.hasIO = true;
+    return true;
+}
+
+// Cgroup of a generated process, derived from its workload: the subtree
+// under a direct child of init shares one slice or scope, like systemd
+// and kubelet would arrange it
+bool SyntheticSource::readCgroup(int pid, std::string& path) {
+    return cgroupOf(pid, path);
+}
+
+bool SyntheticSource::cgroupOf(int pid, std::string& path) const {
+    auto it = byPid.find(pid);
+    if (it == byPid.end()) {
+        return false;
+    }
+
+    // Walk up to the workload's top process
+    const Process* top = &processes[it->second];
+    while (top->ppid > 2) {
+        auto parent = byPid.find(top->ppid);
+        if (parent == byPid.end()) {
+            break;
+        }
+        top = &processes[parent->second];
+    }
+
+    std::string id = std::to_string(top->pid);
+    std::string userSlice = "/user.slice/user-" + std::to_string(syntheticUid(top->user)) + ".slice";
+    if (top->ppid != 1) {
+        path = "/";  // init and kernel threads
+    } else if (top->name == "containerd-shim") {
+        path = "/kubepods/burstable/pod" + id;
+        if (top->pid != pid) {
+            path += "/cri-containerd-" + id;
+        }
+    } else if (top->name == "sshd") {
+        path = "/user.slice/session-" + id + ".scope";
+    } else if (top->name == "make") {
+        path = userSlice + "/build-" + id + ".scope";
+    } else if (top->name == "chrome") {
+        path = userSlice + "/app.slice/chrome-" + id + ".scope";
+    } else {
+        path = "/system.slice/" + top->name + ".service";
+    }
+    return true;
+}
+
+// Generated PSS/USS: workers forked from a same-named parent share most
+// of their pages with it, other processes share only libraries
+bool SyntheticSource::readMemoryUsage(int pid, MemoryUsage& usage) {
+    auto it = byPid.find(pid);
+    if (it == byPid.end() || processes[it->second].vmRSS <= 0) {
+        return false;
+    }
+
+    const Process& proc = processes[it->second];
+    auto parent = byPid.find(proc.ppid);
+    bool forked = parent != byPid.end() && processes[parent->second].name == proc.name;
+    usage.uss = proc.vmRSS * (forked ? 3 : 7) / 10;
+    usage.pss = usage.uss + (proc.vmRSS - usage.uss) / (forked ? 8 : 3);
+    usage.swap = 0;
+    return true;
+}
+
+// Description for status lines
+std::string SyntheticSource::describe() const {
+    return "synthetic (" + std::to_string(processes.size()) + " processes)";
+}
+
+// Write the table as a fake /proc tree
+bool SyntheticSource::writeTree(const std::string& dir, std::string& error) const {
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    if (ec) {
+        error = "cannot create " + dir + ": " + ec.message();
+        return false;
+    }
+
+    // Aggregate CPU line: the first seven fields add up to totalTicks
+    {
+        std::ofstream stat(dir + "/stat");
+        unsigned long user = totalTicks / 5;
+        unsigned long system = totalTicks / 20;
+        stat << "cpu  " << user << " 0 " << system << " " << (totalTicks - user - system)
+             << " 0 0 0 0 0 0\n";
+        std::ofstream uptimeFile(dir + "/uptime");
+        uptimeFile << uptime << " " << uptime * cpus * 0.8 << "\n";
+        if (!stat || !uptimeFile) {
+            error = "cannot write " + dir;
+            return false;
+        }
+    }
+
+    // stat gives RSS in pages, read back with the page size of this host
+    long pageKB = std::max(1L, sysconf(_SC_PAGESIZE) / 1024);
+
+    for (const auto& proc : processes) {
+        std::string base = dir + "/" + std::to_string(proc.pid);
+        std::filesystem::create_directory(base, ec);
+        if (ec) {
+            error = "cannot create " + base + ": " + ec.message();
+            return false;
+        }
+
+        // Field order follows proc(5): pid (comm) state ppid pgrp session
+        // tty_nr tpgid flags minflt cminflt majflt cmajflt utime stime
+        // cutime cstime priority nice num_threads itrealvalue starttime
+        std::ofstream stat(base + "/stat");
+        stat << proc.pid << " (" << proc.name << ") " << proc.state << " " << proc.ppid
+             << " " << proc.pid << " " << proc.pid << " 0 -1 4194560 0 0 0 0 "
+             << proc.utime << " " << proc.stime << " 0 0 20 0 " << proc.numThreads
+             << " 0 " << proc.starttime << " " << proc.vmSize * 1024 << " "
+             << (proc.vmRSS + pageKB - 1) / pageKB << "\n";
+
+        int uid = syntheticUid(proc.user);
+        std::ofstream status(base + "/status");
+        status << "Name:\t" << proc.name << "\n"
+               << "State:\t" << proc.state << "\n"
+               << "PPid:\t" << proc.ppid << "\n"
+               << "Uid:\t" << uid << "\t" << uid << "\t" << uid << "\t" << uid << "\n";
+        if (proc.vmSize > 0) {
+            status << "VmSize:\t" << proc.vmSize << " kB\n"
+                   << "VmRSS:\t" << proc.vmRSS << " kB\n";
+        }
+        status << "Threads:\t" << proc.numThreads << "\n";
+
+        std::string cgroupPath;
+        cgroupOf(proc.pid, cgroupPath);
+        std::ofstream cgroup(base + "/cgroup");
+        cgroup << "0::" << cgroupPath << "\n";
+
+        std::ofstream io(base + "/io");
+        io << "rchar: " << proc.readBytes + proc.syscr * 512 << "\n"
+           << "wchar: " << proc.writeBytes + proc.syscw * 512 << "\n"
+           << "syscr: " << proc.syscr << "\n"
+           << "syscw: " << proc.syscw << "\n"
+           << "read_bytes: " << proc.readBytes << "\n"
+           << "write_bytes: " << proc.writeBytes << "\n"
+           << "cancelled_write_bytes: 0\n";
+
+        if (!stat || !status || !cgroup || !io) {
+            error = "cannot write " + base;
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include "process.hpp"
+#include "process_memory.hpp"
+#include "process_pids.hpp"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <ctime>
+
+// Where process information comes from. ProcessManager reads through a
+// source, so collectors, filters and the tree builder can run against
+// the live system, a captured /proc tree, or generated data.
+class ProcessSource {
+public:
+    virtual ~ProcessSource() {}
+
+    // Append the PIDs of all processes (ascending)
+    virtual void listPids(std::vector<int>& pids) = 0;
+
+    // Read the stat fields of one process (see ProcessFields); false if it
+    // has gone
+    virtual bool readProcess(int pid, Process& proc) = 0;
+
+    // Read the owner of a process into proc.user; false if unavailable
+    virtual bool readUser(int pid, Process& proc) = 0;
+
+    // False when no user name this source reports can contain the
+    // lowercased 'text', so searches can skip reading users. Only a source
+    // that knows all of its users may say so: /proc cannot, since name
+    // services need not list every account they resolve.
+    virtual bool userNameMayContain(const std::string& text) {
+        (void)text;
+        return true;
+    }
+
+    // Append the thread IDs of a process (ascending); false if the
+    // process has gone or the source has no per-thread data
+    virtual bool listThreads(int pid, std::vector<int>& tids) {
+        (void)pid;
+        (void)tids;
+        return false;
+    }
+    
+    // Read one thread of a process; false if it has gone
+    virtual bool readThread(int pid, int tid, Process& thread) {
+        (void)pid;
+        (void)tid;
+        (void)thread;
+        return false;
+    }
+
+    // Read the cgroup of a process (the v2 path, e.g. "/system.slice/x.service");
+    // false if unavailable
+    virtual bool readCgroup(int pid, std::string& path) {
+        (void)pid;
+        (void)path;
+        return false;
+    }
+
+    // Read PSS, USS and swap (smaps_rollup); false if unavailable
+    virtual bool readMemoryUsage(int pid, MemoryUsage& usage) {
+        (void)pid;
+        (void)usage;
+        return false;
+    }
+
+    // Read the I/O counters of a process into 'proc'; false if unavailable
+    virtual bool readIO(int pid, Process& proc) {
+        (void)pid;
+        (void)proc;
+        return false;
+    }
+
+    // Read the scheduler statistics of a process into 'proc'; false if
+    // unavailable. The context switch counts come with readUser(), and
+    // are replaced here by the totals of all threads where known.
+    virtual bool readSched(int pid, Process& proc) {
+        (void)pid;
+        (void)proc;
+        return false;
+    }
+
+    // Cumulative CPU time of all CPUs in clock ticks
+    virtual unsigned long getTotalCPUTime() = 0;
+
+    // Seconds since boot
+    virtual double getUptime() = 0;
+
+    // True when PIDs name processes on this host, so signals and
+    // priority changes apply to them
+    virtual bool isLive() const { return false; }
+
+    // Directory holding the <pid>/ files, which the details pane reads for
+    // the selected process; empty if no files stand behind the source
+    virtual std::string getProcRoot() const { return std::string(); }
+
+    // Human-readable description for status lines
+    virtual std::string describe() const = 0;
+};
+
+// The live /proc filesystem
+class ProcfsSource : public ProcessSource {
+public:
+    ProcfsSource();
+
+    void listPids(std::vector<int>& pids) override;
+    bool readProcess(int pid, Process& proc) override;
+    bool readUser(int pid, Process& proc) override;
+    bool listThreads(int pid, std::vector<int>& tids) override;
+    bool readThread(int pid, int tid, Process& thread) override;
+    bool readCgroup(int pid, std::string& path) override;
+    bool readMemoryUsage(int pid, MemoryUsage& usage) override;
+    bool readIO(int pid, Process& proc) override;
+    bool readSched(int pid, Process& proc) override;
+    unsigned long getTotalCPUTime() override;
+    double getUptime() override;
+    bool isLive() const override { return root == "/proc"; }
+    std::string getProcRoot() const override { return root; }
+    std::string describe() const override { return root; }
+
+protected:
+    std::string root;
+
+    explicit ProcfsSource(const std::string& root);
+
+private:
+    PidEnumerator pidEnumerator;
+    PidEnumerator taskEnumerator{16 * 1024};
+    std::vector<int> schedTids;
+
+    // Names of the UIDs seen, resolved once each with getpwuid and
+    // dropped every minute so account changes show up
+    std::unordered_map<int, std::string> userNames;
+    time_t userNamesTime = 0;
+};
+
+// A captured or generated /proc tree in an ordinary directory. Only the
+// files LPM reads are needed: <pid>/stat, <pid>/status, stat and uptime
+// (<pid>/task/<tid>/stat, <pid>/cgroup and <pid>/io for thread, cgroup
+// and I/O views).
+class DirectorySource : public ProcfsSource {
+public:
+    explicit DirectorySource(const std::string& root) : ProcfsSource(root) {}
+
+    bool isLive() const override { return false; }
+};
+
+// Deterministic in-memory process table with realistic tree shapes:
+// kernel threads, system services, login sessions, build trees,
+// browsers and container workloads
+class SyntheticSource : public ProcessSource {
+public:
+    explicit SyntheticSource(size_t count, uint64_t seed = 1);
+
+    void listPids(std::vector<int>& pids) override;
+    bool readProcess(int pid, Process& proc) override;
+    bool readUser(int pid, Process& proc) override;
+    bool userNameMayContain(const std::string& text) override;
+    bool readCgroup(int pid, std::string& path) override;
+    bool readMemoryUsage(int pid, MemoryUsage& usage) override;
+    bool readIO(int pid, Process& proc) override;
+    unsigned long getTotalCPUTime() override;
+    double getUptime() override { return uptime; }
+    std::string describe() const override;
+
+    // Simulate 'seconds' of activity: accumulate CPU time, drift memory,
+    // reap short-lived processes and spawn replacements
+    void advance(double seconds = 1.0);
+
+    // Advance by the wall-clock time between scans, so refreshes see CPU
+    // usage and churn. Off by default, which keeps the table fixed for
+    // benchmarks and writeTree().
+    void setRealTime(bool enabled) { realTime = enabled; }
+
+    // Write the table as a fake /proc tree readable by DirectorySource
+    bool writeTree(const std::string& dir, std::string& error) const;
+
+    // All processes in PID order
+    const std::vector<Process>& getProcesses() const { return processes; }
+
+private:
+    std::vector<Process> processes;          // Sorted by PID
+    std::unordered_map<int, size_t> byPid;
+    std::vector<bool> shortLived;            // Parallel to processes
+    size_t targetCount;
+    uint64_t rng;
+    int nextPid;
+    int cpus;
+    unsigned long totalTicks;
+    double uptime;
+    bool realTime;
+    double lastScan;                         // CLOCK_MONOTONIC seconds; 0 before the first scan
+
+    uint64_t random();
+    double uniform() { return (random() >> 11) * (1.0 / 9007199254740992.0); }
+    long randomSize(long minKB, long maxKB);
+
+    int spawn(int ppid, const std::string& name, const std::string& user,
+              long rssKB, int threads, bool ephemeral);
+    void spawnWorkload();
+    void reindex();
+    bool cgroupOf(int pid, std::string& path) const;
+    static void addIO(Process& proc, unsigned long ticks);
+};
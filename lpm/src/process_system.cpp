@@ -0,0 +1,275 @@
+#include "process_system.hpp"
+#include "process_profile.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+static const char* skipSpaces(const char* pos, const char* end) {
+    while (pos < end && (*pos == ' ' || *pos == '\t')) {
+        pos++;
+    }
+    return pos;
+}
+
+static const char* lineEnd(const char* pos, const char* end) {
+    const char* newline = static_cast<const char*>(memchr(pos, '\n', end - pos));
+    return newline ? newline : end;
+}
+
+static uint64_t parseNumber(const char*& pos, const char* end) {
+    pos = skipSpaces(pos, end);
+    uint64_t value = 0;
+    while (pos < end && *pos >= '0' && *pos <= '9') {
+        value = value * 10 + (*pos++ - '0');
+    }
+    return value;
+}
+
+// "12.34"; independent of the locale, unlike strtod
+static double parseDecimal(const char*& pos, const char* end) {
+    double value = (double)parseNumber(pos, end);
+    if (pos < end && *pos == '.') {
+        double scale = 0.1;
+        for (pos++; pos < end && *pos >= '0' && *pos <= '9'; pos++) {
+            value += (*pos - '0') * scale;
+            scale *= 0.1;
+        }
+    }
+    return value;
+}
+
+const char* CPUTimes::parse(const char* pos, const char* end) {
+    const char* stop = lineEnd(pos, end);
+    uint64_t* fields[] = {&user, &nice, &system, &idle, &iowait,
+                          &irq, &softirq, &steal, &guest, &guestNice};
+    for (uint64_t* field : fields) {
+        *field = parseNumber(pos, stop);
+    }
+    return stop;
+}
+
+static double percent(uint64_t part, uint64_t whole) {
+    return whole > 0 ? part * 100.0 / whole : 0.0;
+}
+
+SystemSampler::SystemSampler(const std::string& root)
+    : root(root), statFd(-1), meminfoFd(-1), loadavgFd(-1),
+      total{}, prevTotal{}, stats{}, samples(0) {
+    std::fill(pressureFd, pressureFd + PRESSURE_FILES, -1);
+}
+
+SystemSampler::~SystemSampler() {
+    close();
+}
+
+static int openFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        Profiler::add(Profiler::FILES_OPENED, 1);
+    }
+    return fd;
+}
+
+bool SystemSampler::open() {
+    close();
+    statFd = openFile(root + "/stat");
+    if (statFd < 0) {
+        return false;
+    }
+    meminfoFd = openFile(root + "/meminfo");
+    loadavgFd = openFile(root + "/loadavg");
+    const char* pressureNames[] = {"cpu", "memory", "io"};
+    for (int i = 0; i < PRESSURE_FILES; i++) {
+        pressureFd[i] = openFile(root + "/pressure/" + pressureNames[i]);
+    }
+
+    // One "cpuN" line is at most ~220 bytes; meminfo fits in a few kB
+    long cpus = std::max(1L, sysconf(_SC_NPROCESSORS_CONF));
+    buffer.assign(std::max<size_t>(8192, 256 * (cpus + 2)), '\0');
+    cores.assign(cpus, CPUTimes{});
+    prevCores.assign(cpus, CPUTimes{});
+    online.assign(cpus, 0);
+    stats.coreBusy.assign(cpus, -1.0);
+    samples = 0;
+    return true;
+}
+
+void SystemSampler::close() {
+    for (int* fd : {&statFd, &meminfoFd, &loadavgFd,
+                    &pressureFd[0], &pressureFd[1], &pressureFd[2]}) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+ssize_t SystemSampler::read(int fd) {
+    if (fd < 0) {
+        return -1;
+    }
+    ssize_t length;
+    do {
+        length = pread(fd, buffer.data(), buffer.size(), 0);
+    } while (length < 0 && errno == EINTR);
+    if (length > 0) {
+        Profiler::add(Profiler::BYTES_READ, length);
+    }
+    return length;
+}
+
+bool SystemSampler::sample() {
+    if (!isOpen() && !open()) {
+        return false;
+    }
+    if (!readStat()) {
+        return false;
+    }
+    readMeminfo();
+    readLoadavg();
+    stats.hasPressure = pressureFd[PRESSURE_CPU] >= 0;
+    readPressure(pressureFd[PRESSURE_CPU], stats.cpuPressure);
+    readPressure(pressureFd[PRESSURE_MEMORY], stats.memoryPressure);
+    readPressure(pressureFd[PRESSURE_IO], stats.ioPressure);
+    samples++;
+    return true;
+}
+
+// The cpu lines lead /proc/stat; the buffer holds all of them, and the
+// read stops before most of the interrupt counters
+bool SystemSampler::readStat() {
+    ssize_t length = read(statFd);
+    if (length <= 0) {
+        return false;
+    }
+    const char* pos = buffer.data();
+    const char* end = pos + length;
+
+    prevTotal = total;
+    std::swap(prevCores, cores);
+    std::vector<uint8_t>& wasOnline = online;
+    bool haveTotal = false;
+
+    // Offline cores have no line; a core needs two consecutive samples
+    size_t count = cores.size();
+    std::vector<double>& busy = stats.coreBusy;
+    std::fill(busy.begin(), busy.end(), -1.0);
+
+    while (pos < end && end - pos > 3 && memcmp(pos, "cpu", 3) == 0) {
+        const char* next = lineEnd(pos, end);
+        if (next == end) {
+            break;                  // Truncated line
+        }
+        pos += 3;
+        if (*pos == ' ') {
+            total.parse(pos, next);
+            haveTotal = true;
+        } else {
+            size_t index = (size_t)parseNumber(pos, next);
+            if (index < count) {
+                CPUTimes& core = cores[index];
+                core.parse(pos, next);
+                const CPUTimes& prev = prevCores[index];
+                if (wasOnline[index] && core.total() > prev.total() &&
+                    core.busy() >= prev.busy()) {
+                    busy[index] = percent(core.busy() - prev.busy(),
+                                          core.total() - prev.total());
+                }
+                wasOnline[index] = 2;   // Seen this sample
+            }
+        }
+        pos = next + 1;
+    }
+    for (size_t i = 0; i < count; i++) {
+        wasOnline[i] = wasOnline[i] == 2 ? 1 : 0;
+    }
+
+    if (!haveTotal) {
+        return false;
+    }
+    stats.cpuBusy = stats.cpuIowait = stats.cpuSteal = 0;
+    if (samples > 0 && total.total() > prevTotal.total() && total.busy() >= prevTotal.busy()) {
+        uint64_t elapsed = total.total() - prevTotal.total();
+        stats.cpuBusy = percent(total.busy() - prevTotal.busy(), elapsed);
+        stats.cpuIowait = percent(total.iowait - std::min(total.iowait, prevTotal.iowait), elapsed);
+        stats.cpuSteal = percent(total.steal - std::min(total.steal, prevTotal.steal), elapsed);
+    }
+    return true;
+}
+
+void SystemSampler::readMeminfo() {
+    ssize_t length = read(meminfoFd);
+    if (length <= 0) {
+        return;
+    }
+    static const struct {
+        const char* key;
+        size_t length;
+        uint64_t SystemStats::*field;
+    } KEYS[] = {
+        {"MemTotal:", 9, &SystemStats::memTotalKB},
+        {"MemAvailable:", 13, &SystemStats::memAvailableKB},
+        {"SwapTotal:", 10, &SystemStats::swapTotalKB},
+        {"SwapFree:", 9, &SystemStats::swapFreeKB},
+    };
+
+    const char* pos = buffer.data();
+    const char* end = pos + length;
+    int found = 0;
+    while (pos < end && found < 4) {
+        const char* next = lineEnd(pos, end);
+        for (const auto& key : KEYS) {
+            if ((size_t)(next - pos) > key.length && memcmp(pos, key.key, key.length) == 0) {
+                const char* value = pos + key.length;
+                stats.*key.field = parseNumber(value, next);
+                found++;
+                break;
+            }
+        }
+        pos = next + 1;
+    }
+}
+
+// "0.70 0.67 0.60 2/76 19145"
+void SystemSampler::readLoadavg() {
+    ssize_t length = read(loadavgFd);
+    if (length <= 0) {
+        return;
+    }
+    const char* pos = buffer.data();
+    const char* end = pos + length;
+    stats.load1 = parseDecimal(pos, end);
+    stats.load5 = parseDecimal(pos, end);
+    stats.load15 = parseDecimal(pos, end);
+    stats.runnable = (int)parseNumber(pos, end);
+    if (pos < end && *pos == '/') {
+        pos++;
+    }
+    stats.tasks = (int)parseNumber(pos, end);
+}
+
+// "some avg10=0.79 avg60=... total=..." and a "full" line
+void SystemSampler::readPressure(int fd, Pressure& pressure) {
+    pressure = Pressure{};
+    ssize_t length = read(fd);
+    if (length <= 0) {
+        return;
+    }
+    const char* pos = buffer.data();
+    const char* end = pos + length;
+    while (pos < end) {
+        const char* next = lineEnd(pos, end);
+        const char* avg = (next - pos > 11) ? pos + 5 : next;
+        if (avg < next && memcmp(avg, "avg10=", 6) == 0) {
+            avg += 6;
+            if (memcmp(pos, "some", 4) == 0) {
+                pressure.some = parseDecimal(avg, next);
+            } else if (memcmp(pos, "full", 4) == 0) {
+                pressure.full = parseDecimal(avg, next);
+            }
+        }
+        pos = next + 1;
+    }
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <sys/types.h>
+
+// One "cpu" line of /proc/stat, in clock ticks
+struct CPUTimes {
+    uint64_t user;
+    uint64_t nice;
+    uint64_t system;
+    uint64_t idle;
+    uint64_t iowait;
+    uint64_t irq;
+    uint64_t softirq;
+    uint64_t steal;
+    uint64_t guest;                 // Already counted in user and nice
+    uint64_t guestNice;
+
+    // All time, steal included and guest time counted once
+    uint64_t total() const {
+        return user + nice + system + idle + iowait + irq + softirq + steal;
+    }
+    uint64_t busy() const { return total() - idle - iowait; }
+
+    // Parse the numbers after "cpu" or "cpuN"; missing trailing fields
+    // (older kernels) are zero. Returns the end of the line.
+    const char* parse(const char* pos, const char* end);
+};
+
+// Pressure stall averages over the last 10 seconds, in percent
+struct Pressure {
+    double some;                    // Share of time some tasks stalled
+    double full;                    // Share of time all non-idle tasks stalled
+};
+
+// System-wide figures of the last sample; utilization is over the
+// interval since the sample before
+struct SystemStats {
+    double cpuBusy;                 // All cores, percent
+    double cpuIowait;
+    double cpuSteal;
+    std::vector<double> coreBusy;   // Per core; -1 for offline cores
+
+    uint64_t memTotalKB;
+    uint64_t memAvailableKB;
+    uint64_t swapTotalKB;
+    uint64_t swapFreeKB;
+
+    double load1;
+    double load5;
+    double load15;
+    int runnable;                   // Runnable tasks
+    int tasks;                      // All tasks
+
+    bool hasPressure;               // /proc/pressure exists (PSI enabled)
+    Pressure cpuPressure;
+    Pressure memoryPressure;
+    Pressure ioPressure;
+};
+
+// Samples /proc/stat (aggregate and per-core lines), meminfo, loadavg and
+// pressure/{cpu,memory,io}. The files are opened once and re-read with
+// pread; parsing is in place over buffers sized when opened, so a sample
+// makes no allocations. Only the head of /proc/stat is read: the cpu lines
+// come first, before the long interrupt counters.
+class SystemSampler {
+public:
+    explicit SystemSampler(const std::string& root = "/proc");
+    ~SystemSampler();
+
+    SystemSampler(const SystemSampler&) = delete;
+    SystemSampler& operator=(const SystemSampler&) = delete;
+
+    // Open the files; false if /proc/stat cannot be opened. Missing
+    // optional files (pressure) are skipped.
+    bool open();
+    bool isOpen() const { return statFd >= 0; }
+
+    // Read everything once; opens the files first if needed
+    bool sample();
+
+    const SystemStats& getStats() const { return stats; }
+
+    // Samples taken (utilization needs two)
+    uint64_t getSampleCount() const { return samples; }
+
+    void close();
+
+private:
+    enum PressureFile { PRESSURE_CPU, PRESSURE_MEMORY, PRESSURE_IO, PRESSURE_FILES };
+
+    std::string root;
+    int statFd;
+    int meminfoFd;
+    int loadavgFd;
+    int pressureFd[PRESSURE_FILES];
+    std::vector<char> buffer;
+    CPUTimes total;
+    CPUTimes prevTotal;
+    std::vector<CPUTimes> cores;
+    std::vector<CPUTimes> prevCores;
+    std::vector<uint8_t> online;
+    SystemStats stats;
+    uint64_t samples;
+
+    ssize_t read(int fd);
+    bool readStat();
+    void readMeminfo();
+    void readLoadavg();
+    void readPressure(int fd, Pressure& pressure);
+};
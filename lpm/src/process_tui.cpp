@@ -1,425 +1,1762 @@
-#include "process_tui.hpp"
-#include "process_control.hpp"
-#include "process_tree.hpp"
-#include <iomanip>
-#include <sstream>
-#include <ctime>
-#include <unistd.h>
-
-ProcessTUI::ProcessTUI() 
-    : selectedIndex(0), scrollOffset(0), screenHeight(0), screenWidth(0),
-      sortField(ProcessSorter::BY_PID), sortAscending(true),
-      searchQuery(""), statusMessage(""), showTree(false),
-      refreshInterval(2.0), lastRefresh(0) {
-}
-
-ProcessTUI::~ProcessTUI() {
-    cleanup();
-}
-
-// Initialize ncurses
-bool ProcessTUI::init() {
-    initscr();              // Initialize screen
-    cbreak();               // Disable line buffering
-    noecho();               // Don't echo keypresses
-    keypad(stdscr, TRUE);   // Enable function keys
-    nodelay(stdscr, TRUE);  // Non-blocking getch()
-    curs_set(0);            // Hide cursor
-    
-    // Check if colors are supported
-    if (has_colors()) {
-        start_color();
-        init_pair(1, COLOR_WHITE, COLOR_BLUE);    // Header
-        init_pair(2, COLOR_BLACK, COLOR_WHITE);   // Selected
-        init_pair(3, COLOR_GREEN, COLOR_BLACK);   // Normal
-        init_pair(4, COLOR_RED, COLOR_BLACK);     // Error
-        init_pair(5, COLOR_YELLOW, COLOR_BLACK);  // Warning
-    }
-    
-    getmaxyx(stdscr, screenHeight, screenWidth);
-    
-    refreshProcesses();
-    setStatus("LPM Started - Press 'h' for help");
-    
-    return true;
-}
-
-// Cleanup ncurses
-void ProcessTUI::cleanup() {
-    if (isendwin() == FALSE) {
-        endwin();
-    }
-}
-
-// Main event loop
-void ProcessTUI::run() {
-    bool running = true;
-    
-    while (running) {
-        // Check if terminal was resized
-        getmaxyx(stdscr, screenHeight, screenWidth);
-        
-        // Auto-refresh
-        time_t now = time(nullptr);
-        if (now - lastRefresh >= refreshInterval) {
-            refreshProcesses();
-            lastRefresh = now;
-        }
-        
-        draw();
-        
-        int ch = getch();
-        if (ch != ERR) {
-            if (ch == 'q' || ch == 'Q') {
-                running = false;
-            } else {
-                handleInput(ch);
-            }
-        }
-        
-        usleep(50000); // 50ms delay
-    }
-}
-
-// Draw the entire UI
-void ProcessTUI::draw() {
-    clear();
-    
-    drawHeader();
-    drawProcessList();
-    drawStatusBar();
-    drawHelpBar();
-    
-    refresh();
-}
-
-// Draw header with system info
-void ProcessTUI::drawHeader() {
-    attron(COLOR_PAIR(1) | A_BOLD);
-    
-    std::string title = " Linux Process Manager (LPM) ";
-    int titlePos = (screenWidth - title.length()) / 2;
-    
-    // Fill entire line with background color
-    for (int i = 0; i < screenWidth; i++) {
-        mvaddch(0, i, ' ');
-    }
-    
-    mvprintw(0, titlePos, "%s", title.c_str());
-    
-    // Show process count
-    std::string count = "Processes: " + std::to_string(filteredProcesses.size()) + 
-                       "/" + std::to_string(processes.size()) + " ";
-    mvprintw(0, screenWidth - count.length(), "%s", count.c_str());
-    
-    attroff(COLOR_PAIR(1) | A_BOLD);
-}
-
-// Draw process list
-void ProcessTUI::drawProcessList() {
-    int startY = 2;
-    int listHeight = screenHeight - 5;
-    
-    // Draw column headers
-    attron(A_BOLD);
-    mvprintw(startY, 0, "%-8s %-20s %-10s %-8s %-10s %s", 
-             "PID", "NAME", "USER", "STATE", "MEMORY", "CPU%");
-    attroff(A_BOLD);
-    
-    // Draw processes
-    int displayCount = std::min((int)filteredProcesses.size() - scrollOffset, listHeight);
-    
-    for (int i = 0; i < displayCount; i++) {
-        int procIndex = scrollOffset + i;
-        const Process& proc = filteredProcesses[procIndex];
-        
-        int y = startY + 1 + i;
-        
-        // Highlight selected
-        if (procIndex == selectedIndex) {
-            attron(COLOR_PAIR(2) | A_BOLD);
-        }
-        
-        std::string memStr = proc.vmRSS > 0 ? 
-                            std::to_string(proc.vmRSS / 1024) + "M" : "N/A";
-        
-        mvprintw(y, 0, "%-8d %-20.20s %-10.10s %-8s %-10s %.2f", 
-                 proc.pid, proc.name.c_str(), proc.user.c_str(),
-                 proc.state.c_str(), memStr.c_str(), proc.cpuPercent);
-        
-        if (procIndex == selectedIndex) {
-            attroff(COLOR_PAIR(2) | A_BOLD);
-        }
-    }
-}
-
-// Draw status bar
-void ProcessTUI::drawStatusBar() {
-    int y = screenHeight - 2;
-    
-    attron(COLOR_PAIR(3));
-    mvprintw(y, 0, "%s", statusMessage.c_str());
-    attroff(COLOR_PAIR(3));
-}
-
-// Draw help bar
-void ProcessTUI::drawHelpBar() {
-    int y = screenHeight - 1;
-    
-    std::string help = "[q]Quit [r]Refresh [k]Kill [n]Nice [/]Search [s]Sort [t]Tree [h]Help";
-    
-    attron(COLOR_PAIR(1));
-    for (int i = 0; i < screenWidth; i++) {
-        mvaddch(y, i, ' ');
-    }
-    mvprintw(y, 0, "%s", help.c_str());
-    attroff(COLOR_PAIR(1));
-}
-
-// Handle keyboard input
-void ProcessTUI::handleInput(int ch) {
-    handleNavigation(ch);
-    handleActions(ch);
-    handleSorting(ch);
-}
-
-// Handle navigation keys
-void ProcessTUI::handleNavigation(int ch) {
-    int listHeight = screenHeight - 5;
-    
-    switch (ch) {
-        case KEY_UP:
-        case 'k':
-            if (selectedIndex > 0) {
-                selectedIndex--;
-                if (selectedIndex < scrollOffset) {
-                    scrollOffset = selectedIndex;
-                }
-            }
-            break;
-            
-        case KEY_DOWN:
-        case 'j':
-            if (selectedIndex < (int)filteredProcesses.size() - 1) {
-                selectedIndex++;
-                if (selectedIndex >= scrollOffset + listHeight) {
-                    scrollOffset = selectedIndex - listHeight + 1;
-                }
-            }
-            break;
-            
-        case KEY_PPAGE: // Page Up
-            selectedIndex = std::max(0, selectedIndex - listHeight);
-            scrollOffset = std::max(0, scrollOffset - listHeight);
-            break;
-            
-        case KEY_NPAGE: // Page Down
-            selectedIndex = std::min((int)filteredProcesses.size() - 1, 
-                                   selectedIndex + listHeight);
-            scrollOffset = std::min((int)filteredProcesses.size() - listHeight,
-                                  scrollOffset + listHeight);
-            break;
-    }
-}
-
-// Handle action keys
-void ProcessTUI::handleActions(int ch) {
-    switch (ch) {
-        case 'r':
-        case 'R':
-            refreshProcesses();
-            setStatus("Processes refreshed");
-            break;
-            
-        case 'k':
-        case 'K':
-            killSelectedProcess();
-            break;
-            
-        case 'n':
-        case 'N':
-            changeSelectedPriority();
-            break;
-            
-        case '/':
-            promptSearch();
-            break;
-            
-        case 't':
-        case 'T':
-            toggleTreeView();
-            break;
-            
-        case 'h':
-        case 'H':
-        case KEY_F(1):
-            showHelp();
-            break;
-            
-        case '\n':
-        case KEY_ENTER:
-            showProcessDetails();
-            break;
-    }
-}
-
-// Handle sorting keys
-void ProcessTUI::handleSorting(int ch) {
-    bool needSort = false;
-    
-    switch (ch) {
-        case 'P':
-            sortField = ProcessSorter::BY_PID;
-            needSort = true;
-            break;
-        case 'N':
-            sortField = ProcessSorter::BY_NAME;
-            needSort = true;
-            break;
-        case 'M':
-            sortField = ProcessSorter::BY_MEMORY;
-            needSort = true;
-            break;
-        case 'C':
-            sortField = ProcessSorter::BY_CPU;
-            needSort = true;
-            break;
-        case 'U':
-            sortField = ProcessSorter::BY_USER;
-            needSort = true;
-            break;
-    }
-    
-    if (needSort) {
-        sortAscending = !sortAscending;
-        ProcessSorter::sort(filteredProcesses, sortField, sortAscending);
-        setStatus("Sorted by field");
-    }
-}
-
-// Refresh process list
-void ProcessTUI::refreshProcesses() {
-    processes = manager.getAllProcesses();
-    updateFilter();
-    
-    // Adjust selection if needed
-    if (selectedIndex >= (int)filteredProcesses.size()) {
-        selectedIndex = std::max(0, (int)filteredProcesses.size() - 1);
-    }
-}
-
-// Kill selected process
-void ProcessTUI::killSelectedProcess() {
-    if (selectedIndex >= 0 && selectedIndex < (int)filteredProcesses.size()) {
-        int pid = filteredProcesses[selectedIndex].pid;
-        
-        // Confirm
-        setStatus("Kill process " + std::to_string(pid) + "? (y/n)");
-        draw();
-        
-        nodelay(stdscr, FALSE);
-        int ch = getch();
-        nodelay(stdscr, TRUE);
-        
-        if (ch == 'y' || ch == 'Y') {
-            if (ProcessController::terminate(pid)) {
-                setStatus("Process " + std::to_string(pid) + " terminated");
-                refreshProcesses();
-            } else {
-                setStatus("Failed to kill process " + std::to_string(pid));
-            }
-        } else {
-            setStatus("Cancelled");
-        }
-    }
-}
-
-// Change process priority
-void ProcessTUI::changeSelectedPriority() {
-    if (selectedIndex >= 0 && selectedIndex < (int)filteredProcesses.size()) {
-        int pid = filteredProcesses[selectedIndex].pid;
-        setStatus("Enter new nice value (-20 to 19): ");
-        // Implementation would require input handling
-        setStatus("Priority change not implemented in this demo");
-    }
-}
-
-// Show process details
-void ProcessTUI::showProcessDetails() {
-    // Would show detailed view of selected process
-    setStatus("Details view not implemented");
-}
-
-// Prompt for search
-void ProcessTUI::promptSearch() {
-    setStatus("Search not fully implemented");
-}
-
-// Toggle tree view
-void ProcessTUI::toggleTreeView() {
-    showTree = !showTree;
-    setStatus(showTree ? "Tree view enabled" : "List view enabled");
-}
-
-// Show help dialog
-void ProcessTUI::showHelp() {
-    clear();
-    int y = 2;
-    
-    mvprintw(y++, 2, "=== LPM Help ===");
-    y++;
-    mvprintw(y++, 2, "Navigation:");
-    mvprintw(y++, 4, "Up/Down, j/k  - Move selection");
-    mvprintw(y++, 4, "PgUp/PgDn     - Page up/down");
-    y++;
-    mvprintw(y++, 2, "Actions:");
-    mvprintw(y++, 4, "r - Refresh");
-    mvprintw(y++, 4, "k - Kill process");
-    mvprintw(y++, 4, "n - Change priority (nice)");
-    mvprintw(y++, 4, "/ - Search");
-    mvprintw(y++, 4, "t - Toggle tree view");
-    y++;
-    mvprintw(y++, 2, "Sorting (toggle ascending/descending):");
-    mvprintw(y++, 4, "P - Sort by PID");
-    mvprintw(y++, 4, "N - Sort by Name");
-    mvprintw(y++, 4, "M - Sort by Memory");
-    mvprintw(y++, 4, "C - Sort by CPU");
-    mvprintw(y++, 4, "U - Sort by User");
-    y++;
-    mvprintw(y++, 2, "q - Quit");
-    y++;
-    mvprintw(y++, 2, "Press any key to continue...");
-    
-    refresh();
-    nodelay(stdscr, FALSE);
-    getch();
-    nodelay(stdscr, TRUE);
-}
-
-// Update filtered process list
-void ProcessTUI::updateFilter() {
-    if (searchQuery.empty()) {
-        filteredProcesses = processes;
-    } else {
-        filteredProcesses = ProcessFilter::search(processes, searchQuery);
-    }
-    
-    ProcessSorter::sort(filteredProcesses, sortField, sortAscending);
-}
-
-// Set status message
-void ProcessTUI::setStatus(const std::string& message) {
-    statusMessage = message;
-}
-
-// Get state description
-std::string ProcessTUI::getStateDescription(const std::string& state) {
-    if (state == "R") return "Running";
-    if (state == "S") return "Sleeping";
-    if (state == "D") return "Disk Sleep";
-    if (state == "Z") return "Zombie";
-    if (state == "T") return "Stopped";
-    if (state == "t") return "Tracing";
-    if (state == "X") return "Dead";
-    return "Unknown";
-}
+#include "process_tui.hpp"
+#include "process_control.hpp"
+#include "process_tree.hpp"
+#include "process_source.hpp"
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
+#include <signal.h>
+
+ProcessTUI::ProcessTUI() 
+    : selectedIndex(0), scrollOffset(0), screenHeight(0), screenWidth(0),
+      sortField(ProcessSorter::BY_PID), sortAscending(true),
+      searchQuery(""), statusMessage(""), showTree(false),
+      refreshInterval(2.0), lastRefresh(0), refreshTick(0),
+      showDetails(false), detailsExitTick(0), detailsExitRow(-1), leakSort(false), replay(nullptr), replayPlaying(false), preciseMemory(false),
+      showIO(false), showSched(false), groupView(false), groupKey(ProcessGrouper::BY_USER),
+      groupSort(ProcessGrouper::SORT_RSS), savedSelection(0), savedScroll(0),
+      events(nullptr), lastEventTime(0),
+      showStats(false), refreshCost() {
+}
+
+ProcessTUI::~ProcessTUI() {
+    cleanup();
+}
+
+// Initialize ncurses
+bool ProcessTUI::init() {
+    initscr();              // Initialize screen
+    cbreak();               // Disable line buffering
+    noecho();               // Don't echo keypresses
+    keypad(stdscr, TRUE);   // Enable function keys
+    nodelay(stdscr, TRUE);  // Non-blocking getch()
+    curs_set(0);            // Hide cursor
+    
+    // Check if colors are supported
+    if (has_colors()) {
+        start_color();
+        init_pair(1, COLOR_WHITE, COLOR_BLUE);    // Header
+        init_pair(2, COLOR_BLACK, COLOR_WHITE);   // Selected
+        init_pair(3, COLOR_GREEN, COLOR_BLACK);   // Normal
+        init_pair(4, COLOR_RED, COLOR_BLACK);     // Error
+        init_pair(5, COLOR_YELLOW, COLOR_BLACK);  // Warning
+    }
+    
+    getmaxyx(stdscr, screenHeight, screenWidth);
+    
+    if (!replay) {
+        events = dynamic_cast<ProcessEventSource*>(&manager.getSource());
+    }
+    refreshProcesses();
+    if (replay) {
+        setStatus("Replaying " + std::to_string(replay->getFrameCount()) +
+                  " frames - [/] step, {/} 1 minute, p play, g go to time");
+    } else {
+        setStatus("LPM Started - Press 'h' for help");
+    }
+    
+    return true;
+}
+
+// Cleanup ncurses
+void ProcessTUI::cleanup() {
+    if (isendwin() == FALSE) {
+        endwin();
+    }
+}
+
+// Main event loop
+void ProcessTUI::run() {
+    bool running = true;
+    
+    while (running) {
+        // Check if terminal was resized
+        getmaxyx(stdscr, screenHeight, screenWidth);
+        
+        // Auto-refresh (a replay only advances while playing)
+        time_t now = time(nullptr);
+        if (replay) {
+            if (replayPlaying) {
+                seekReplay((int64_t)replay->getFrameNumber() + 1);
+            }
+        } else if (now - lastRefresh >= refreshInterval) {
+            refreshProcesses();
+            lastRefresh = now;
+        } else if (events) {
+            // Drain between refreshes so short-lived processes get named
+            events->poll(0);
+        }
+        
+        draw();
+        
+        int ch = getch();
+        if (ch != ERR) {
+            if (ch == 'q' || ch == 'Q') {
+                running = false;
+            } else {
+                handleInput(ch);
+            }
+        }
+        
+        usleep(50000); // 50ms delay
+    }
+}
+
+// Draw the entire UI
+void ProcessTUI::draw() {
+    ScopedTimer timer(Profiler::STAGE_DRAW);
+    clear();
+    
+    drawHeader();
+    drawProcessList();
+    if (showDetails && !groupView) {
+        int paneY = headerHeight() + 1 + getListHeight();
+        drawDetailsPane(paneY, screenHeight - 2 - paneY);
+    }
+    if (showStats) {
+        drawStatsOverlay();
+    }
+    drawStatusBar();
+    drawHelpBar();
+    
+    refresh();
+}
+
+// Draw header with system info
+void ProcessTUI::drawHeader() {
+    attron(COLOR_PAIR(1) | A_BOLD);
+    
+    std::string title = " Linux Process Manager (LPM) ";
+    int titlePos = (screenWidth - title.length()) / 2;
+    
+    // Fill entire line with background color
+    for (int i = 0; i < screenWidth; i++) {
+        mvaddch(0, i, ' ');
+    }
+    
+    mvprintw(0, titlePos, "%s", title.c_str());
+    
+    // Show process count (thread rows excluded)
+    size_t shown = std::count(threadOwner.begin(), threadOwner.end(), -1);
+    std::string count = "Processes: " + std::to_string(shown) + 
+                       "/" + std::to_string(processes.size()) + " ";
+    mvprintw(0, screenWidth - count.length(), "%s", count.c_str());
+    
+    attroff(COLOR_PAIR(1) | A_BOLD);
+    
+    // Replay position
+    if (replay) {
+        std::string position = "Replay " + SnapshotReader::formatTime(replay->getTimestamp()) +
+                               "  frame " + std::to_string(replay->getFrameNumber() + 1) +
+                               "/" + std::to_string(replay->getFrameCount()) +
+                               (replayPlaying ? "  [playing]" : "  [paused]");
+        attron(COLOR_PAIR(5) | A_BOLD);
+        mvprintw(1, 0, "%.*s", screenWidth, position.c_str());
+        attroff(COLOR_PAIR(5) | A_BOLD);
+    } else if (headerHeight() > 2) {
+        drawSystemMeters(1);
+        drawCoreStrip(2);
+    } else if (!eventSummary.empty()) {
+        mvprintw(1, 0, "%.*s", screenWidth, eventSummary.c_str());
+    }
+}
+
+// Draw process list
+void ProcessTUI::drawProcessList() {
+    if (groupView) {
+        drawGroupList();
+        return;
+    }
+    
+    int startY = headerHeight();
+    int listHeight = getListHeight();
+    
+    // Draw column headers
+    const char* memoryHeader = leakSort ? "RSS/h" : preciseMemory ? "PSS" : "MEMORY";
+    char extra[64] = "";
+    int extraLength = 0;
+    if (showIO) {
+        extraLength += snprintf(extra + extraLength, sizeof(extra) - extraLength, "%-8s %-8s ",
+                                "READ/s", "WRITE/s");
+    }
+    if (showSched) {
+        snprintf(extra + extraLength, sizeof(extra) - extraLength, "%-7s %-8s ", "WAIT%", "CSW/s");
+    }
+    attron(A_BOLD);
+    mvprintw(startY, 0, "%-8s %-20s %-10s %-8s %-10s %-7s %s%-16s %s",
+             "PID", "NAME", "USER", "STATE", memoryHeader, "CPU%", extra,
+             "CPU HISTORY", "RSS HISTORY");
+    attroff(A_BOLD);
+    
+    // Draw processes
+    int displayCount = std::min((int)filteredProcesses.size() - scrollOffset, listHeight);
+    
+    for (int i = 0; i < displayCount; i++) {
+        int procIndex = scrollOffset + i;
+        const Process& proc = filteredProcesses[procIndex];
+        
+        int y = startY + 1 + i;
+        
+        // Highlight selected and marked rows
+        bool isMarked = marked.count(proc.key()) > 0;
+        if (procIndex == selectedIndex) {
+            attron(COLOR_PAIR(2) | A_BOLD);
+        } else if (isMarked) {
+            attron(COLOR_PAIR(5) | A_BOLD);
+        }
+        
+        mvprintw(y, 0, "%s", getProcessLine(proc, screenWidth).c_str());
+        
+        if (isMarked) {
+            mvaddch(y, 7, '*');
+        }
+        
+        if (procIndex == selectedIndex) {
+            attroff(COLOR_PAIR(2) | A_BOLD);
+        } else if (isMarked) {
+            attroff(COLOR_PAIR(5) | A_BOLD);
+        }
+    }
+}
+
+// Format a byte rate as "0", "812K", "3.2M" or "1.1G"
+static std::string formatRate(double bytes) {
+    char buf[16];
+    if (bytes < 1.0) {
+        return "0";
+    } else if (bytes >= 1024.0 * 1024 * 1024) {
+        snprintf(buf, sizeof(buf), "%.1fG", bytes / (1024.0 * 1024 * 1024));
+    } else if (bytes >= 1024.0 * 1024) {
+        snprintf(buf, sizeof(buf), "%.1fM", bytes / (1024.0 * 1024));
+    } else {
+        snprintf(buf, sizeof(buf), "%.0fK", std::max(1.0, bytes / 1024.0));
+    }
+    return buf;
+}
+
+// Append 'text' at the cursor, clipped to the screen width
+static void addClipped(const char* text, int screenWidth) {
+    int x = getcurx(stdscr);
+    if (x < screenWidth) {
+        addnstr(text, screenWidth - x);
+    }
+}
+
+// "[|||||     ]" filled to 'percent', green, yellow or red by level
+static void addMeter(double percent, int width, int screenWidth) {
+    int filled = std::min(width, std::max(0, (int)(percent * width / 100.0 + 0.5)));
+    int color = percent >= 90 ? 4 : percent >= 60 ? 5 : 3;
+    addClipped("[", screenWidth);
+    attron(COLOR_PAIR(color) | A_BOLD);
+    for (int i = 0; i < filled; i++) {
+        addClipped("|", screenWidth);
+    }
+    attroff(COLOR_PAIR(color) | A_BOLD);
+    for (int i = filled; i < width; i++) {
+        addClipped(" ", screenWidth);
+    }
+    addClipped("]", screenWidth);
+}
+
+// CPU and memory meters, load averages and pressure stall (PSI) averages
+void ProcessTUI::drawSystemMeters(int y) {
+    const SystemStats& stats = systemSampler.getStats();
+    char buf[128];
+    move(y, 0);
+    
+    addClipped("CPU ", screenWidth);
+    addMeter(stats.cpuBusy, 10, screenWidth);
+    snprintf(buf, sizeof(buf), " %5.1f%%", stats.cpuBusy);
+    addClipped(buf, screenWidth);
+    if (stats.cpuIowait >= 0.1 || stats.cpuSteal >= 0.1) {
+        snprintf(buf, sizeof(buf), " wa %.1f st %.1f", stats.cpuIowait, stats.cpuSteal);
+        addClipped(buf, screenWidth);
+    }
+    
+    if (stats.memTotalKB > 0) {
+        uint64_t used = stats.memTotalKB - std::min(stats.memTotalKB, stats.memAvailableKB);
+        addClipped("  Mem ", screenWidth);
+        addMeter(used * 100.0 / stats.memTotalKB, 10, screenWidth);
+        snprintf(buf, sizeof(buf), " %s/%s", formatRate(used * 1024.0).c_str(),
+                 formatRate(stats.memTotalKB * 1024.0).c_str());
+        addClipped(buf, screenWidth);
+    }
+    if (stats.swapTotalKB > 0) {
+        uint64_t used = stats.swapTotalKB - std::min(stats.swapTotalKB, stats.swapFreeKB);
+        snprintf(buf, sizeof(buf), "  Swap %s/%s", formatRate(used * 1024.0).c_str(),
+                 formatRate(stats.swapTotalKB * 1024.0).c_str());
+        addClipped(buf, screenWidth);
+    }
+    
+    snprintf(buf, sizeof(buf), "  Load %.2f %.2f %.2f", stats.load1, stats.load5, stats.load15);
+    addClipped(buf, screenWidth);
+    
+    if (stats.hasPressure) {
+        snprintf(buf, sizeof(buf), "  PSI cpu %.1f mem %.1f/%.1f io %.1f/%.1f",
+                 stats.cpuPressure.some, stats.memoryPressure.some, stats.memoryPressure.full,
+                 stats.ioPressure.some, stats.ioPressure.full);
+        int color = std::max({stats.cpuPressure.some, stats.memoryPressure.some,
+                              stats.ioPressure.some}) >= 10 ? 4 : 0;
+        if (color) {
+            attron(COLOR_PAIR(color) | A_BOLD);
+        }
+        addClipped(buf, screenWidth);
+        if (color) {
+            attroff(COLOR_PAIR(color) | A_BOLD);
+        }
+    }
+}
+
+// Per-core utilisation: small meters when they fit on the row, otherwise
+// one level character per core. Offline cores show as blanks.
+void ProcessTUI::drawCoreStrip(int y) {
+    static const char LEVELS[] = "_.:-=+*#%@";
+    const std::vector<double>& cores = systemSampler.getStats().coreBusy;
+    move(y, 0);
+    
+    int meterWidth = 5;
+    int cellWidth = meterWidth + 6;         // " 12[|||  ] "
+    bool meters = (int)cores.size() * cellWidth <= screenWidth;
+    if (!meters) {
+        addClipped("Cores ", screenWidth);
+    }
+    for (size_t i = 0; i < cores.size(); i++) {
+        double busy = cores[i];
+        if (meters) {
+            char label[24];
+            snprintf(label, sizeof(label), "%3zu", i);
+            addClipped(label, screenWidth);
+            if (busy < 0) {
+                addClipped("[  -  ]", screenWidth);
+            } else {
+                addMeter(busy, meterWidth, screenWidth);
+            }
+            addClipped(" ", screenWidth);
+            continue;
+        }
+        char level[2] = {' ', '\0'};
+        if (busy >= 0) {
+            level[0] = LEVELS[std::min(9, (int)(busy / 10.0 + 0.5))];
+        }
+        int color = busy >= 90 ? 4 : busy >= 60 ? 5 : 3;
+        attron(COLOR_PAIR(color) | A_BOLD);
+        addClipped(level, screenWidth);
+        attroff(COLOR_PAIR(color) | A_BOLD);
+    }
+    
+    if (!eventSummary.empty()) {
+        addClipped("  ", screenWidth);
+        addClipped(eventSummary.c_str(), screenWidth);
+    }
+}
+
+// Format one row of the process list, cut to 'width' columns
+std::string ProcessTUI::getProcessLine(const Process& proc, int width) {
+    std::string memStr = proc.vmRSS > 0 ? 
+                        std::to_string(proc.vmRSS / 1024) + "M" : "N/A";
+    if (preciseMemory && proc.vmRSS > 0) {
+        // RSS (marked ~) until the process's PSS has been read
+        const MemoryUsage* usage = memory.find(proc.key());
+        memStr = usage ? std::to_string(usage->pss / 1024) + "M" : "~" + memStr;
+    }
+    if (leakSort) {
+        // Growth per hour, marked ! for suspected leaks
+        LeakTrend trend;
+        memStr = "-";
+        if (leaks.getTrend(proc.key(), trend)) {
+            memStr = (trend.suspected ? "!" : "") + LeakDetector::formatGrowth(trend.slope * 3600);
+        }
+    }
+    
+    std::string cpuSpark = history.sparkline(proc.key(), ProcessHistory::CPU, 16);
+    std::string rssSpark = history.sparkline(proc.key(), ProcessHistory::RSS, 16);
+    
+    // Read and write rates; "-" where the counters are unreadable
+    std::string ioStr;
+    if (showIO) {
+        char io[32];
+        if (proc.hasIO) {
+            snprintf(io, sizeof(io), "%-8s %-8s ", formatRate(proc.readRate).c_str(),
+                     formatRate(proc.writeRate).c_str());
+        } else {
+            snprintf(io, sizeof(io), "%-8s %-8s ", "-", "-");
+        }
+        ioStr = io;
+    }
+    
+    // Run-queue wait and context switches per second; "-" without schedstat
+    std::string schedStr;
+    if (showSched) {
+        char sched[32];
+        if (proc.hasSched) {
+            snprintf(sched, sizeof(sched), "%-7.1f %-8.0f ", proc.waitPercent,
+                     proc.voluntaryRate + proc.involuntaryRate);
+        } else {
+            snprintf(sched, sizeof(sched), "%-7s %-8s ", "-", "-");
+        }
+        schedStr = sched;
+    }
+    
+    char line[256];
+    int length = snprintf(line, sizeof(line), "%-8d %-20.20s %-10.10s %-8s %-10s %-7.2f %s%s%s %s",
+                          proc.pid, proc.name.c_str(), proc.user.c_str(),
+                          proc.state.c_str(), memStr.c_str(), proc.cpuPercent,
+                          ioStr.c_str(), schedStr.c_str(), cpuSpark.c_str(), rssSpark.c_str());
+    length = std::min(length, (int)sizeof(line) - 1);
+    return std::string(line, std::max(0, std::min(length, width)));
+}
+
+// Draw the group view: one row of totals per user, name or state
+void ProcessTUI::drawGroupList() {
+    static const char* LABELS[] = {nullptr, "COUNT", "THREADS", "RSS", "MAX RSS", "CPU%"};
+    int startY = headerHeight();
+    int listHeight = getListHeight();
+    
+    // The sorted column is marked with '*'
+    char labels[ProcessGrouper::COLUMN_COUNT][16];
+    for (int i = 0; i < ProcessGrouper::COLUMN_COUNT; i++) {
+        std::string label = i == 0 ? ProcessGrouper::keyName(groupKey) : LABELS[i];
+        std::transform(label.begin(), label.end(), label.begin(), ::toupper);
+        snprintf(labels[i], sizeof(labels[i]), "%s%s", label.c_str(), i == groupSort ? "*" : "");
+    }
+    attron(A_BOLD);
+    mvprintw(startY, 0, "%-24s %8s %8s %10s %10s %8s", labels[0], labels[1], labels[2],
+             labels[3], labels[4], labels[5]);
+    attroff(A_BOLD);
+    
+    const std::vector<ProcessGroup>& groups = grouper.getGroups();
+    int displayCount = std::min((int)groups.size() - scrollOffset, listHeight);
+    for (int i = 0; i < displayCount; i++) {
+        int index = scrollOffset + i;
+        const ProcessGroup& group = groups[index];
+        std::string key = grouper.getKey(group.keyId);
+        if (groupKey == ProcessGrouper::BY_STATE) {
+            key += " (" + getStateDescription(key) + ")";
+        }
+        
+        char line[256];
+        snprintf(line, sizeof(line), "%-24.24s %8zu %8ld %10s %10s %8.1f", key.c_str(),
+                 group.count, group.threads, formatRate(group.rssKB * 1024.0).c_str(),
+                 formatRate(group.maxRssKB * 1024.0).c_str(), group.cpuPercent);
+        
+        if (index == selectedIndex) {
+            attron(COLOR_PAIR(2) | A_BOLD);
+            for (int x = 0; x < screenWidth; x++) {
+                mvaddch(startY + 1 + i, x, ' ');
+            }
+        }
+        mvprintw(startY + 1 + i, 0, "%.*s", screenWidth, line);
+        if (index == selectedIndex) {
+            attroff(COLOR_PAIR(2) | A_BOLD);
+        }
+    }
+}
+
+// Draw LPM's own timings and counters over the top right of the list
+void ProcessTUI::drawStatsOverlay() {
+    std::vector<std::string> lines = Profiler::formatReport();
+    
+    char buf[160];
+    snprintf(buf, sizeof(buf), "last refresh: %llu files, %llu kB read, %llu allocations (%llu kB)",
+             (unsigned long long)refreshCost[Profiler::FILES_OPENED],
+             (unsigned long long)refreshCost[Profiler::BYTES_READ] / 1024,
+             (unsigned long long)refreshCost[Profiler::ALLOCATIONS],
+             (unsigned long long)refreshCost[Profiler::ALLOCATED_BYTES] / 1024);
+    lines.push_back(buf);
+    
+    if (preciseMemory) {
+        const MemoryCollector::Cost& cost = memory.getCost();
+        snprintf(buf, sizeof(buf), "precise memory: %zu smaps_rollup read, %zu cached, "
+                 "%zu deferred, %.1f ms", cost.reads, cost.cached, cost.deferred, cost.ns / 1e6);
+        lines.push_back(buf);
+    }
+    
+    size_t width = 0;
+    for (const auto& line : lines) {
+        width = std::max(width, line.size());
+    }
+    int boxWidth = std::min((int)width + 2, screenWidth);
+    int x = std::max(0, screenWidth - boxWidth);
+    
+    attron(COLOR_PAIR(1));
+    int top = headerHeight();
+    mvprintw(top, x, "%-*.*s", boxWidth, boxWidth, " LPM self-profile (S to close)");
+    for (size_t i = 0; i < lines.size() && top + 1 + (int)i < screenHeight - 2; i++) {
+        mvprintw(top + 1 + i, x, " %-*.*s", boxWidth - 1, boxWidth - 1, lines[i].c_str());
+    }
+    attroff(COLOR_PAIR(1));
+}
+
+// Draw status bar
+void ProcessTUI::drawStatusBar() {
+    int y = screenHeight - 2;
+    
+    attron(COLOR_PAIR(3));
+    mvprintw(y, 0, "%s", statusMessage.c_str());
+    attroff(COLOR_PAIR(3));
+}
+
+// Draw help bar
+void ProcessTUI::drawHelpBar() {
+    int y = screenHeight - 1;
+    
+    std::string help = "[q]Quit [r]Refresh [k]Kill [Space]Mark [a]Mark all [n]Nice [/]Search [t]Tree [e]Threads [Enter]Details [h]Help";
+    if (replay) {
+        help = "[q]Quit [[/]]Step [{/}]1 min [p]Play [g]Go to [Home/End]Start/end [/]Search [h]Help";
+    }
+    if (groupView) {
+        help = "[q]Quit [G]Next grouping [o]Sort column [Enter]Show processes [/]Search [h]Help";
+    }
+    
+    attron(COLOR_PAIR(1));
+    for (int i = 0; i < screenWidth; i++) {
+        mvaddch(y, i, ' ');
+    }
+    mvprintw(y, 0, "%s", help.c_str());
+    attroff(COLOR_PAIR(1));
+}
+
+// Handle keyboard input
+void ProcessTUI::handleInput(int ch) {
+    if (groupView) {
+        handleGroupInput(ch);
+    } else {
+        handleNavigation(ch);
+        handleActions(ch);
+        handleSorting(ch);
+    }
+    if (replay) {
+        handleReplay(ch);
+    }
+}
+
+// Handle replay scrubbing keys
+void ProcessTUI::handleReplay(int ch) {
+    int64_t frame = replay->getFrameNumber();
+    int64_t perMinute = 60000000000LL / std::max<int64_t>(1, replay->getInterval());
+    
+    switch (ch) {
+        case ']':
+            replayPlaying = false;
+            seekReplay(frame + 1);
+            break;
+        case '[':
+            replayPlaying = false;
+            seekReplay(frame - 1);
+            break;
+        case '}':
+            seekReplay(frame + perMinute);
+            break;
+        case '{':
+            seekReplay(frame - perMinute);
+            break;
+        case KEY_HOME:
+            seekReplay(0);
+            break;
+        case KEY_END:
+            seekReplay((int64_t)replay->getFrameCount() - 1);
+            break;
+        case 'p':
+            replayPlaying = !replayPlaying;
+            setStatus(replayPlaying ? "Playing" : "Paused");
+            break;
+        case 'g':
+            promptReplayTime();
+            break;
+    }
+}
+
+// Move the replay to a frame (clamped to the recording) and reload the list
+void ProcessTUI::seekReplay(int64_t frame) {
+    int64_t last = (int64_t)replay->getFrameCount() - 1;
+    frame = std::max<int64_t>(0, std::min(frame, last));
+    
+    uint32_t current = replay->getFrameNumber();
+    if (frame == current) {
+        if (frame == last) {
+            replayPlaying = false;
+        }
+        return;
+    }
+    
+    if (!replay->seekFrame((uint32_t)frame)) {
+        replayPlaying = false;
+        setStatus("Recording is damaged at frame " + std::to_string(frame + 1));
+        return;
+    }
+    
+    // Sparklines only make sense for consecutive frames
+    if (frame != current + 1) {
+        history.clear();
+        leaks.clear();
+    }
+    refreshProcesses();
+}
+
+// Ask for a time and jump to it
+void ProcessTUI::promptReplayTime() {
+    bool wasPlaying = replayPlaying;
+    replayPlaying = false;
+    
+    std::string input;
+    promptInput("Go to (HH:MM[:SS], YYYY-MM-DD HH:MM[:SS] or +DURATION): ", input);
+    if (input.empty()) {
+        replayPlaying = wasPlaying;
+        setStatus("Cancelled");
+        return;
+    }
+    
+    int64_t timestamp;
+    if (!replay->parseTime(input, timestamp)) {
+        setStatus("Invalid time: " + input);
+        return;
+    }
+    
+    uint32_t current = replay->getFrameNumber();
+    if (!replay->seekTime(timestamp)) {
+        setStatus("Recording is damaged");
+        return;
+    }
+    if (replay->getFrameNumber() != current) {
+        history.clear();
+        leaks.clear();
+    }
+    refreshProcesses();
+    setStatus("At " + SnapshotReader::formatTime(replay->getTimestamp()));
+}
+
+// Handle navigation keys
+void ProcessTUI::handleNavigation(int ch) {
+    int listHeight = getListHeight();
+    
+    switch (ch) {
+        case KEY_UP:
+        case 'k':
+            if (selectedIndex > 0) {
+                selectedIndex--;
+                if (selectedIndex < scrollOffset) {
+                    scrollOffset = selectedIndex;
+                }
+            }
+            break;
+            
+        case KEY_DOWN:
+        case 'j':
+            if (selectedIndex < rowCount() - 1) {
+                selectedIndex++;
+                if (selectedIndex >= scrollOffset + listHeight) {
+                    scrollOffset = selectedIndex - listHeight + 1;
+                }
+            }
+            break;
+            
+        case KEY_PPAGE: // Page Up
+            selectedIndex = std::max(0, selectedIndex - listHeight);
+            scrollOffset = std::max(0, scrollOffset - listHeight);
+            break;
+            
+        case KEY_NPAGE: // Page Down
+            selectedIndex = std::min(rowCount() - 1, 
+                                   selectedIndex + listHeight);
+            scrollOffset = std::max(0, std::min(rowCount() - listHeight,
+                                                scrollOffset + listHeight));
+            break;
+    }
+}
+
+// Handle action keys
+void ProcessTUI::handleActions(int ch) {
+    switch (ch) {
+        case 'r':
+        case 'R':
+            refreshProcesses();
+            setStatus("Processes refreshed");
+            break;
+            
+        case 'k':
+        case 'K':
+            killSelectedProcess();
+            break;
+            
+        // 'N' sorts by name
+        case 'n':
+            changeSelectedPriority();
+            break;
+            
+        case ' ':
+            toggleMark();
+            break;
+            
+        case 'a':
+        case 'A':
+            toggleMarkAll();
+            break;
+            
+        case '/':
+            promptSearch();
+            break;
+            
+        case 't':
+        case 'T':
+            toggleTreeView();
+            break;
+            
+        case 'e':
+        case 'E':
+            toggleThreads();
+            break;
+            
+        case 'm':
+            togglePreciseMemory();
+            break;
+            
+        case 'i':
+            toggleIO();
+            break;
+            
+        case 'w':
+            toggleSched();
+            break;
+            
+        case 'S':
+            showStats = !showStats;
+            break;
+            
+        case 'G':
+            toggleGroupView();
+            break;
+            
+        case 'h':
+        case 'H':
+        case KEY_F(1):
+            showHelp();
+            break;
+            
+        case '\n':
+        case KEY_ENTER:
+            showProcessDetails();
+            break;
+    }
+}
+
+// Handle sorting keys
+void ProcessTUI::handleSorting(int ch) {
+    bool needSort = false;
+    
+    switch (ch) {
+        case 'P':
+            sortField = ProcessSorter::BY_PID;
+            needSort = true;
+            break;
+        case 'N':
+            sortField = ProcessSorter::BY_NAME;
+            needSort = true;
+            break;
+        case 'M':
+            sortField = ProcessSorter::BY_MEMORY;
+            needSort = true;
+            break;
+        case 'C':
+            sortField = ProcessSorter::BY_CPU;
+            needSort = true;
+            break;
+        case 'U':
+            sortField = ProcessSorter::BY_USER;
+            needSort = true;
+            break;
+        case 'I':
+            if (!showIO) {
+                setStatus("Turn on the I/O columns with 'i' first");
+                return;
+            }
+            sortField = ProcessSorter::BY_IO;
+            needSort = true;
+            break;
+        case 'W':
+        case 'X':
+            if (!showSched) {
+                setStatus("Turn on the scheduler columns with 'w' first");
+                return;
+            }
+            sortField = ch == 'W' ? ProcessSorter::BY_WAIT : ProcessSorter::BY_SWITCHES;
+            needSort = true;
+            break;
+        case 'L':
+            leakSort = !leakSort;
+            updateFilter();
+            setStatus(leakSort ? "Suspected leaks first (" + std::to_string(leaks.getSuspects().size()) +
+                                 " of " + std::to_string(leaks.size()) + " processes)"
+                               : "Leak sort off");
+            return;
+    }
+    
+    if (needSort) {
+        leakSort = false;
+        sortAscending = !sortAscending;
+        updateFilter();
+        setStatus("Sorted by field");
+    }
+}
+
+// Refresh process list
+void ProcessTUI::refreshProcesses() {
+    uint64_t before[Profiler::COUNTER_COUNT];
+    for (int i = 0; i < Profiler::COUNTER_COUNT; i++) {
+        before[i] = Profiler::get((Profiler::Counter)i);
+    }
+    
+    if (replay) {
+        replay->getProcesses(processes);
+    } else {
+        processes = manager.getAllProcesses();
+        updateEventSummary();
+    }
+    if (!replay && manager.isLive()) {
+        systemSampler.sample();
+    }
+    history.update(processes);
+    leaks.update(processes, replay ? replay->getTimestamp() : (int64_t)Profiler::now());
+    refreshTick++;
+    if (!expanded.empty()) {
+        refreshThreads();
+    }
+    if (preciseMemory) {
+        memory.beginRefresh();
+        memory.prune(processes);
+    }
+    updateFilter();
+    
+    // Adjust selection if needed
+    if (selectedIndex >= rowCount()) {
+        selectedIndex = std::max(0, rowCount() - 1);
+    }
+    
+    // Keep the details of a process that just exited up for a tick
+    if (showDetails && detailsKey.pid > 0 &&
+        std::none_of(processes.begin(), processes.end(),
+                     [this](const Process& proc) { return proc.key() == detailsKey; })) {
+        detailsExitTick = refreshTick;
+        detailsExitRow = selectedIndex;
+    }
+    
+    if (preciseMemory) {
+        updatePreciseMemory();
+    }
+    
+    // Drop marks of processes that no longer exist
+    if (!marked.empty()) {
+        std::unordered_set<ProcessKey, ProcessKeyHash> alive;
+        for (const auto& proc : processes) {
+            if (marked.count(proc.key())) {
+                alive.insert(proc.key());
+            }
+        }
+        marked.swap(alive);
+    }
+    
+    for (int i = 0; i < Profiler::COUNTER_COUNT; i++) {
+        refreshCost[i] = Profiler::get((Profiler::Counter)i) - before[i];
+    }
+}
+
+// Switch the memory column between RSS and PSS
+void ProcessTUI::togglePreciseMemory() {
+    bool synthetic = dynamic_cast<SyntheticSource*>(&manager.getSource()) != nullptr;
+    if (!preciseMemory && (replay || (!manager.isLive() && !synthetic))) {
+        setStatus("PSS needs smaps_rollup from the live system");
+        return;
+    }
+    
+    preciseMemory = !preciseMemory;
+    if (!preciseMemory) {
+        setStatus("Memory column shows RSS");
+        return;
+    }
+    
+    memory.beginRefresh();
+    updateFilter();
+    updatePreciseMemory();
+    const MemoryCollector::Cost& cost = memory.getCost();
+    char buf[128];
+    snprintf(buf, sizeof(buf), "Memory column shows PSS (%zu smaps_rollup read in %.1f ms)",
+             cost.reads, cost.ns / 1e6);
+    setStatus(buf);
+}
+
+// Show or hide the read/write rate columns. The first scan with I/O is
+// only a baseline, so rates appear from the following refresh.
+void ProcessTUI::toggleIO() {
+    if (replay) {
+        setStatus("I/O counters are not recorded");
+        return;
+    }
+    
+    showIO = !showIO;
+    updateFields();
+    if (!showIO && sortField == ProcessSorter::BY_IO) {
+        sortField = ProcessSorter::BY_PID;
+        sortAscending = true;
+    }
+    refreshProcesses();
+    setStatus(showIO ? "I/O columns on (rates from the next refresh); I sorts by I/O" :
+                       "I/O columns off");
+}
+
+// Show or hide the run-queue wait and context switch columns
+void ProcessTUI::toggleSched() {
+    if (replay) {
+        setStatus("Scheduler statistics are not recorded");
+        return;
+    }
+    
+    showSched = !showSched;
+    updateFields();
+    if (!showSched && (sortField == ProcessSorter::BY_WAIT ||
+                       sortField == ProcessSorter::BY_SWITCHES)) {
+        sortField = ProcessSorter::BY_PID;
+        sortAscending = true;
+    }
+    refreshProcesses();
+    setStatus(showSched ? "Scheduler columns on (rates from the next refresh); "
+                          "W sorts by wait, X by switches" :
+                          "Scheduler columns off");
+}
+
+// Fields the manager reads: the user always, the rest while shown
+void ProcessTUI::updateFields() {
+    manager.setFields(ProcessFields::USER |
+                      (showIO ? ProcessFields::IO : ProcessFields::NONE) |
+                      (showSched ? ProcessFields::SCHED : ProcessFields::NONE));
+}
+
+// Read PSS for the visible rows (the top of a memory sort was read by
+// updateFilter already, so those come from the cache)
+void ProcessTUI::updatePreciseMemory() {
+    std::vector<const Process*> visible;
+    int end = std::min((int)filteredProcesses.size(), scrollOffset + getListHeight());
+    for (int i = std::max(0, scrollOffset); i < end; i++) {
+        if (threadOwner[i] < 0 && filteredProcesses[i].vmRSS > 0) {
+            visible.push_back(&filteredProcesses[i]);
+        }
+    }
+    memory.update(visible, manager.getSource());
+}
+
+// Spawn and exit rates since the previous refresh, and the short-lived
+// processes that no refresh could show
+void ProcessTUI::updateEventSummary() {
+    if (!events) {
+        return;
+    }
+    
+    uint64_t now = Profiler::now();
+    ProcessEventCounters counters = events->getCounters();
+    std::vector<ShortLivedProcess> shortLived;
+    events->takeShortLived(shortLived);
+    
+    if (lastEventTime > 0 && now > lastEventTime) {
+        double seconds = (now - lastEventTime) / 1e9;
+        char buf[200];
+        int length = snprintf(buf, sizeof(buf), "%s: %.1f forks/s, %.1f exits/s, %llu short-lived",
+                              events->isEventDriven() ? "Proc events" : "Polling",
+                              (counters.forks - lastEvents.forks) / seconds,
+                              (counters.exits - lastEvents.exits) / seconds,
+                              (unsigned long long)(counters.shortLived - lastEvents.shortLived));
+        if (!shortLived.empty() && length > 0 && length < (int)sizeof(buf)) {
+            snprintf(buf + length, sizeof(buf) - length, " (last: %d %s, %.1f ms)",
+                     shortLived.back().pid, shortLived.back().name.c_str(),
+                     shortLived.back().lifetimeNs / 1e6);
+        }
+        eventSummary = buf;
+    }
+    lastEvents = counters;
+    lastEventTime = now;
+}
+
+// Mark or unmark the selected process and move to the next row
+void ProcessTUI::toggleMark() {
+    if (selectedIndex < 0 || selectedIndex >= (int)filteredProcesses.size()) {
+        return;
+    }
+    
+    ProcessKey key = filteredProcesses[ownerRow(selectedIndex)].key();
+    if (!marked.erase(key)) {
+        marked.insert(key);
+    }
+    handleNavigation(KEY_DOWN);
+    setStatus(std::to_string(marked.size()) + " processes marked");
+}
+
+// Mark every process in the current filter, or clear all marks
+void ProcessTUI::toggleMarkAll() {
+    if (!marked.empty()) {
+        marked.clear();
+        setStatus("Marks cleared");
+        return;
+    }
+    
+    for (size_t i = 0; i < filteredProcesses.size(); i++) {
+        if (threadOwner[i] < 0 && filteredProcesses[i].pid != getpid()) {
+            marked.insert(filteredProcesses[i].key());
+        }
+    }
+    setStatus(std::to_string(marked.size()) + " processes marked");
+}
+
+// Marked processes, or the selected one if nothing is marked
+std::vector<ProcessKey> ProcessTUI::getActionTargets() {
+    std::vector<ProcessKey> targets;
+    
+    if (!marked.empty()) {
+        targets.assign(marked.begin(), marked.end());
+    } else if (selectedIndex >= 0 && selectedIndex < (int)filteredProcesses.size()) {
+        targets.push_back(filteredProcesses[ownerRow(selectedIndex)].key());
+    }
+    
+    return targets;
+}
+
+// Kill the marked processes (or the selected one). Targets are
+// identified by (pid, starttime) so recycled PIDs are never signalled.
+void ProcessTUI::killSelectedProcess() {
+    if (replay || !manager.isLive()) {
+        return;
+    }
+    
+    std::vector<ProcessKey> targets = getActionTargets();
+    if (targets.empty()) {
+        return;
+    }
+    
+    std::string what = targets.size() == 1 ?
+                       "process " + std::to_string(targets[0].pid) :
+                       std::to_string(targets.size()) + " marked processes";
+    
+    // Confirm
+    setStatus("Terminate " + what + "? (y)es / (e)scalate to SIGKILL after 3s / (n)o");
+    draw();
+    
+    nodelay(stdscr, FALSE);
+    int ch = getch();
+    nodelay(stdscr, TRUE);
+    
+    SignalOptions options;
+    options.signal = SIGTERM;
+    if (ch == 'e' || ch == 'E') {
+        options.timeoutMs = 3000;
+        options.escalate = true;
+        setStatus("Waiting for " + what + " to exit...");
+        draw();
+    } else if (ch != 'y' && ch != 'Y') {
+        setStatus("Cancelled");
+        return;
+    }
+    
+    std::vector<SignalResult> results = ProcessController::sendSignalBatch(targets, options);
+    
+    int counts[SignalResult::FAILED + 1] = {0};
+    for (const auto& result : results) {
+        counts[result.status]++;
+    }
+    
+    std::string summary = "Signalled " + std::to_string(results.size()) + ":";
+    for (int status = SignalResult::SENT; status <= SignalResult::FAILED; status++) {
+        if (counts[status] > 0) {
+            summary += " " + std::to_string(counts[status]) + " " +
+                       ProcessController::getStatusName((SignalResult::Status)status);
+        }
+    }
+    
+    marked.clear();
+    refreshProcesses();
+    setStatus(summary);
+}
+
+// Change the nice value of the marked processes (or the selected one),
+// applied to every thread of each process
+void ProcessTUI::changeSelectedPriority() {
+    if (replay || !manager.isLive()) {
+        setStatus("Not available for " + std::string(replay ? "a replay" : manager.getSource().describe()));
+        return;
+    }
+    
+    std::vector<ProcessKey> targets = getActionTargets();
+    if (targets.empty()) {
+        return;
+    }
+    
+    std::string input;
+    promptInput("New nice value for " + std::to_string(targets.size()) +
+                " process(es) (-20 to 19): ", input);
+    if (input.empty()) {
+        setStatus("Cancelled");
+        return;
+    }
+    
+    char* end = nullptr;
+    long nice = std::strtol(input.c_str(), &end, 10);
+    if (*end != '\0' || nice < -20 || nice > 19) {
+        setStatus("Invalid nice value: " + input);
+        return;
+    }
+    
+    ControlAction action;
+    action.setNice = true;
+    action.nice = (int)nice;
+    std::vector<ControlResult> results = ProcessController::applyBatch(targets, action);
+    
+    int ok = 0, gone = 0, failed = 0, error = 0;
+    for (const auto& result : results) {
+        if (result.gone || result.raced) {
+            gone++;
+        } else if (result.failures > 0) {
+            failed++;
+            error = result.error;
+        } else {
+            ok++;
+        }
+    }
+    
+    std::string summary = "Nice " + std::to_string(nice) + ": " + std::to_string(ok) + " ok";
+    if (gone > 0) {
+        summary += ", " + std::to_string(gone) + " gone";
+    }
+    if (failed > 0) {
+        summary += ", " + std::to_string(failed) + " failed (" + strerror(error) + ")";
+    }
+    setStatus(summary);
+}
+
+// Read a line of input on the status bar. Enter confirms, Escape cancels
+// (output is left empty).
+void ProcessTUI::promptInput(const std::string& prompt, std::string& output) {
+    output.clear();
+    nodelay(stdscr, FALSE);
+    curs_set(1);
+    
+    while (true) {
+        setStatus(prompt + output);
+        draw();
+        move(screenHeight - 2, std::min(screenWidth - 1, (int)statusMessage.size()));
+        refresh();
+        
+        int ch = getch();
+        if (ch == '\n' || ch == KEY_ENTER) {
+            break;
+        } else if (ch == 27) {
+            output.clear();
+            break;
+        } else if (ch == KEY_BACKSPACE || ch == 127 || ch == 8) {
+            if (!output.empty()) {
+                output.pop_back();
+            }
+        } else if (ch >= 32 && ch < 127) {
+            output += (char)ch;
+        }
+    }
+    
+    curs_set(0);
+    nodelay(stdscr, TRUE);
+}
+
+// Toggle the details pane for the selected process
+void ProcessTUI::showProcessDetails() {
+    showDetails = !showDetails;
+    
+    // Keep the selection visible in the resized list
+    int listHeight = getListHeight();
+    if (selectedIndex >= scrollOffset + listHeight) {
+        scrollOffset = selectedIndex - listHeight + 1;
+    }
+    setStatus(showDetails ? "Details pane opened" : "Details pane closed");
+}
+
+// Draw details of the selected process. Data is loaded by the
+// background loader and only for the selected PID.
+void ProcessTUI::drawDetailsPane(int startY, int height) {
+    if (height < 2) {
+        return;
+    }
+    
+    attron(COLOR_PAIR(1));
+    for (int i = 0; i < screenWidth; i++) {
+        mvaddch(startY, i, ' ');
+    }
+    
+    if (selectedIndex < 0 || selectedIndex >= (int)filteredProcesses.size()) {
+        mvprintw(startY, 1, "Details: no process selected");
+        attroff(COLOR_PAIR(1));
+        return;
+    }
+    
+    // A process that left the list at the last refresh
+    ProcessDetails details;
+    if (detailsExitTick == refreshTick && detailsExitRow == selectedIndex &&
+        detailsLoader.getLast(details) && ProcessKey(details.pid, details.starttime) == detailsKey) {
+        mvprintw(startY, 1, "Details: %d (%s) - process exited", details.pid, details.name.c_str());
+        attroff(COLOR_PAIR(1));
+        drawDetailsBody(details, detailsKey, startY, height);
+        return;
+    }
+    
+    const Process& proc = filteredProcesses[ownerRow(selectedIndex)];
+    std::string procRoot = replay ? std::string() : manager.getSource().getProcRoot();
+    if (procRoot.empty()) {
+        // Only the collected fields exist for recorded or generated processes
+        mvprintw(startY, 1, "Details: %d (%s) - %s", proc.pid, proc.name.c_str(),
+                 replay ? "recorded snapshot" : manager.getSource().describe().c_str());
+        attroff(COLOR_PAIR(1));
+        
+        char buf[160];
+        snprintf(buf, sizeof(buf), "PPID %d  User %s  State %s  VmSize %ld kB  VmRSS %ld kB  "
+                 "Threads %d  utime %lu  stime %lu", proc.ppid, proc.user.c_str(),
+                 proc.state.c_str(), proc.vmSize, proc.vmRSS, proc.numThreads,
+                 proc.utime, proc.stime);
+        mvprintw(startY + 1, 1, "%.*s", std::max(0, screenWidth - 2), buf);
+        if (height > 2) {
+            std::string cpu = "CPU%     [" +
+                              history.sparkline(proc.key(), ProcessHistory::CPU, ProcessHistory::SAMPLES) + "]";
+            mvprintw(startY + 2, 1, "%.*s", std::max(0, screenWidth - 2), cpu.c_str());
+        }
+        if (height > 3) {
+            std::string rss = "RSS kB   [" +
+                              history.sparkline(proc.key(), ProcessHistory::RSS, ProcessHistory::SAMPLES) + "]";
+            mvprintw(startY + 3, 1, "%.*s", std::max(0, screenWidth - 2), rss.c_str());
+        }
+        return;
+    }
+    detailsKey = proc.key();
+    detailsLoader.request(proc, refreshTick, procRoot);
+    bool exited = false;
+    bool ready = detailsLoader.get(details, exited);
+    
+    std::string source = manager.isLive() ? "" : " - " + manager.getSource().describe();
+    mvprintw(startY, 1, "Details: %d (%s)%s%s", proc.pid, proc.name.c_str(),
+             exited ? " - process exited" : source.c_str(),
+             detailsLoader.isLoading() ? " [loading...]" : "");
+    attroff(COLOR_PAIR(1));
+    
+    if (ready) {
+        drawDetailsBody(details, proc.key(), startY, height);
+    }
+}
+
+// Lines of the details pane below its title
+void ProcessTUI::drawDetailsBody(const ProcessDetails& details, const ProcessKey& key,
+                                 int startY, int height) {
+    std::vector<std::string> lines;
+    lines.push_back("Cmdline: " + details.cmdline);
+    lines.push_back("Exe:     " + details.exe);
+    lines.push_back("Cwd:     " + details.cwd);
+    lines.push_back("Cgroup:  " + details.cgroup);
+    
+    std::ostringstream oss;
+    oss << "Env: " << details.environCount << " vars (" << details.environBytes << " bytes)"
+        << "   FDs: " << (details.fdCount >= 0 ? std::to_string(details.fdCount) : "N/A")
+        << "   Threads: " << details.threads.size();
+    lines.push_back(oss.str());
+    
+    oss.str("");
+    if (details.smapsAvailable) {
+        oss << "Memory (kB): Rss " << details.rss << "  Pss " << details.pss
+            << " (anon " << details.pssAnon << ", file " << details.pssFile
+            << ", shmem " << details.pssShmem << ")  Swap " << details.swap
+            << "  SwapPss " << details.swapPss;
+        lines.push_back(oss.str());
+        oss.str("");
+        oss << "             Shared clean/dirty " << details.sharedClean << "/"
+            << details.sharedDirty << "  Private clean/dirty " << details.privateClean
+            << "/" << details.privateDirty;
+    } else {
+        oss << "Memory: smaps_rollup not available";
+    }
+    lines.push_back(oss.str());
+    
+    oss.str("");
+    if (details.ioAvailable) {
+        oss << "I/O: read " << details.readBytes << " B (rchar " << details.rchar
+            << ", syscr " << details.syscr << ")  write " << details.writeBytes
+            << " B (wchar " << details.wchar << ", syscw " << details.syscw << ")";
+    } else {
+        oss << "I/O: not available (permission denied)";
+    }
+    lines.push_back(oss.str());
+    
+    // Full-window history for the selected process
+    std::vector<double> samples;
+    static const struct {
+        ProcessHistory::Metric metric;
+        const char* label;
+    } series[] = {
+        {ProcessHistory::CPU, "CPU%"},
+        {ProcessHistory::RSS, "RSS kB"},
+        {ProcessHistory::THREADS, "Threads"},
+    };
+    for (const auto& entry : series) {
+        history.getSamples(key, entry.metric, samples);
+        double peak = samples.empty() ? 0 : *std::max_element(samples.begin(), samples.end());
+        oss.str("");
+        oss << std::left << std::setw(8) << entry.label << " ["
+            << history.sparkline(key, entry.metric, ProcessHistory::SAMPLES)
+            << "] max " << std::fixed << std::setprecision(entry.metric == ProcessHistory::CPU ? 1 : 0)
+            << peak;
+        lines.push_back(oss.str());
+    }
+    
+    LeakTrend trend;
+    if (leaks.getTrend(key, trend)) {
+        oss.str("");
+        oss << "RSS trend " << LeakDetector::formatGrowth(trend.slope * 3600) << "/h over "
+            << (long)trend.spanSeconds << "s, t " << std::setprecision(1) << std::min(trend.tScore, 999.0)
+            << ", R2 " << std::setprecision(2) << trend.fit
+            << (trend.suspected ? " - suspected leak" : "");
+        lines.push_back(oss.str());
+    }
+    
+    oss.str("");
+    oss << "History: " << history.size() << "/" << history.capacity() << " processes, "
+        << ProcessHistory::bytesPerProcess() << " B/process, "
+        << history.memoryUsage() / 1024 << " kB total";
+    if (history.dropped() > 0) {
+        oss << ", " << history.dropped() << " untracked";
+    }
+    lines.push_back(oss.str());
+    
+    // Busiest threads first
+    std::vector<ThreadInfo> threads = details.threads;
+    std::stable_sort(threads.begin(), threads.end(),
+                     [](const ThreadInfo& a, const ThreadInfo& b) {
+                         return a.cpuPercent > b.cpuPercent;
+                     });
+    
+    char buf[128];
+    lines.push_back("Threads:  TID      NAME             STATE  CPU%");
+    for (const auto& thread : threads) {
+        snprintf(buf, sizeof(buf), "          %-8d %-16.16s %-6s %.2f",
+                 thread.tid, thread.name.c_str(), thread.state.c_str(), thread.cpuPercent);
+        lines.push_back(buf);
+    }
+    
+    for (int i = 0; i < (int)lines.size() && i < height - 1; i++) {
+        mvprintw(startY + 1 + i, 1, "%.*s", std::max(0, screenWidth - 2), lines[i].c_str());
+    }
+}
+
+// Prompt for search (an empty query clears the filter)
+void ProcessTUI::promptSearch() {
+    promptInput("Search: ", searchQuery);
+    updateFilter();
+    selectedIndex = 0;
+    scrollOffset = 0;
+    setStatus(searchQuery.empty() ? "Search cleared" :
+              "Showing " + std::to_string(filteredProcesses.size()) + " matches for \"" +
+              searchQuery + "\"");
+}
+
+// Cycle the group view: by user, by name, by state, then back to the
+// process list with its selection restored
+void ProcessTUI::toggleGroupView() {
+    if (!groupView) {
+        savedSelection = selectedIndex;
+        savedScroll = scrollOffset;
+        groupView = true;
+        groupKey = ProcessGrouper::BY_USER;
+    } else if (groupKey != ProcessGrouper::BY_STATE) {
+        groupKey = (ProcessGrouper::Key)(groupKey + 1);
+    } else {
+        groupView = false;
+        selectedIndex = std::min(savedSelection, std::max(0, rowCount() - 1));
+        scrollOffset = std::min(savedScroll, selectedIndex);
+        setStatus("Process list");
+        return;
+    }
+    
+    selectedIndex = 0;
+    scrollOffset = 0;
+    updateGroups();
+    setStatus("Grouped by " + std::string(ProcessGrouper::keyName(groupKey)) + ": " +
+              std::to_string(grouper.getGroups().size()) + " groups");
+}
+
+// Aggregate the processes matching the search (thread rows are not part
+// of 'processes') and sort the groups
+void ProcessTUI::updateGroups() {
+    ScopedTimer timer(Profiler::STAGE_GROUP);
+    std::string lowerQuery = searchQuery;
+    std::transform(lowerQuery.begin(), lowerQuery.end(), lowerQuery.begin(), ::tolower);
+    
+    grouper.begin(groupKey);
+    for (const auto& proc : processes) {
+        if (lowerQuery.empty() || ProcessFilter::matchesQuery(proc, lowerQuery)) {
+            grouper.add(proc);
+        }
+    }
+    grouper.sort(groupSort);
+}
+
+// Rows in the current view
+int ProcessTUI::rowCount() const {
+    return groupView ? (int)grouper.getGroups().size() : (int)filteredProcesses.size();
+}
+
+// Keys of the group view; process actions do not apply to groups
+void ProcessTUI::handleGroupInput(int ch) {
+    static const struct {
+        int key;
+        ProcessGrouper::Column column;
+    } SORT_KEYS[] = {
+        {'N', ProcessGrouper::SORT_KEY}, {'P', ProcessGrouper::SORT_COUNT},
+        {'T', ProcessGrouper::SORT_THREADS}, {'M', ProcessGrouper::SORT_RSS},
+        {'X', ProcessGrouper::SORT_MAX_RSS}, {'C', ProcessGrouper::SORT_CPU},
+    };
+    
+    handleNavigation(ch);
+    for (const auto& entry : SORT_KEYS) {
+        if (ch == entry.key) {
+            groupSort = entry.column;
+            updateGroups();
+            setStatus(std::string("Groups sorted by ") + ProcessGrouper::columnName(groupSort));
+            return;
+        }
+    }
+    
+    switch (ch) {
+        case 'o':
+            groupSort = (ProcessGrouper::Column)((groupSort + 1) % ProcessGrouper::COLUMN_COUNT);
+            updateGroups();
+            setStatus(std::string("Groups sorted by ") + ProcessGrouper::columnName(groupSort));
+            break;
+        case 'G':
+            toggleGroupView();
+            break;
+        case '\n':
+        case KEY_ENTER:
+            openSelectedGroup();
+            break;
+        case 'r':
+        case 'R':
+            refreshProcesses();
+            setStatus("Processes refreshed");
+            break;
+        case '/':
+            promptSearch();
+            break;
+        case 'S':
+            showStats = !showStats;
+            break;
+        case 'h':
+        case 'H':
+        case KEY_F(1):
+            showHelp();
+            break;
+        case 'k':
+        case 'K':
+        case 'n':
+        case ' ':
+        case 'a':
+        case 'A':
+        case 'e':
+        case 'E':
+        case 't':
+            setStatus("Not available in the group view ('G' to cycle back to processes)");
+            break;
+    }
+}
+
+// Leave the group view for the selected group's processes: a search for
+// a user or name, or the list sorted by state at the group's first row
+void ProcessTUI::openSelectedGroup() {
+    const std::vector<ProcessGroup>& groups = grouper.getGroups();
+    if (selectedIndex < 0 || selectedIndex >= (int)groups.size()) {
+        return;
+    }
+    std::string key = grouper.getKey(groups[selectedIndex].keyId);
+    groupView = false;
+    selectedIndex = 0;
+    scrollOffset = 0;
+    
+    if (groupKey == ProcessGrouper::BY_STATE) {
+        sortField = ProcessSorter::BY_STATE;
+        sortAscending = true;
+        leakSort = false;
+        updateFilter();
+        for (size_t i = 0; i < filteredProcesses.size(); i++) {
+            if (filteredProcesses[i].state == key) {
+                selectedIndex = (int)i;
+                scrollOffset = (int)i;
+                break;
+            }
+        }
+        setStatus("Sorted by state at " + key + " (" + getStateDescription(key) + ")");
+        return;
+    }
+    
+    searchQuery = key;
+    updateFilter();
+    setStatus("Showing " + std::to_string(filteredProcesses.size()) + " matches for \"" +
+              searchQuery + "\"");
+}
+
+// Expand the selected process into its threads, or collapse it
+void ProcessTUI::toggleThreads() {
+    if (selectedIndex < 0 || selectedIndex >= (int)filteredProcesses.size()) {
+        return;
+    }
+    
+    Process owner = filteredProcesses[ownerRow(selectedIndex)];
+    ProcessKey key = owner.key();
+    
+    if (expanded.erase(key)) {
+        threads.erase(key);
+        updateFilter();
+        setStatus("Collapsed threads of process " + std::to_string(owner.pid));
+    } else if (replay) {
+        setStatus("Threads are not recorded");
+        return;
+    } else if (!manager.getThreads(owner, threads[key])) {
+        threads.erase(key);
+        setStatus("No thread information for process " + std::to_string(owner.pid));
+        return;
+    } else {
+        expanded.insert(key);
+        updateFilter();
+        setStatus(std::to_string(threads[key].size()) + " threads of process " +
+                  std::to_string(owner.pid) + " (CPU% from the next refresh)");
+    }
+    
+    // Keep the owner selected and visible
+    for (size_t i = 0; i < filteredProcesses.size(); i++) {
+        if (threadOwner[i] < 0 && filteredProcesses[i].key() == key) {
+            selectedIndex = (int)i;
+            break;
+        }
+    }
+    if (selectedIndex < scrollOffset) {
+        scrollOffset = selectedIndex;
+    }
+}
+
+// Re-read the threads of expanded processes; forget processes that exited
+void ProcessTUI::refreshThreads() {
+    std::unordered_set<ProcessKey, ProcessKeyHash> alive;
+    for (const auto& proc : processes) {
+        ProcessKey key = proc.key();
+        if (expanded.count(key) && manager.getThreads(proc, threads[key])) {
+            alive.insert(key);
+        }
+    }
+    
+    for (auto it = threads.begin(); it != threads.end(); ) {
+        if (alive.count(it->first)) {
+            ++it;
+        } else {
+            it = threads.erase(it);
+        }
+    }
+    expanded.swap(alive);
+}
+
+// Toggle tree view
+void ProcessTUI::toggleTreeView() {
+    showTree = !showTree;
+    setStatus(showTree ? "Tree view enabled" : "List view enabled");
+}
+
+// Show help dialog
+void ProcessTUI::showHelp() {
+    clear();
+    int y = 2;
+    
+    mvprintw(y++, 2, "=== LPM Help ===");
+    y++;
+    mvprintw(y++, 2, "Navigation:");
+    mvprintw(y++, 4, "Up/Down, j/k  - Move selection");
+    mvprintw(y++, 4, "PgUp/PgDn     - Page up/down");
+    y++;
+    mvprintw(y++, 2, "Actions:");
+    mvprintw(y++, 4, "r - Refresh");
+    mvprintw(y++, 4, "k - Kill process (or all marked processes)");
+    mvprintw(y++, 4, "Space - Mark/unmark process");
+    mvprintw(y++, 4, "a - Mark all filtered processes / clear marks");
+    mvprintw(y++, 4, "n - Change priority (nice) of selected/marked processes");
+    mvprintw(y++, 4, "/ - Search");
+    mvprintw(y++, 4, "t - Toggle tree view");
+    mvprintw(y++, 4, "e - Expand/collapse the threads of the selected process");
+    mvprintw(y++, 4, "m - Toggle precise memory (PSS from smaps_rollup)");
+    mvprintw(y++, 4, "i - Toggle I/O read/write rate columns (/proc/<pid>/io)");
+    mvprintw(y++, 4, "w - Toggle run-queue wait and context switch columns (schedstat)");
+    mvprintw(y++, 4, "Enter - Toggle details pane");
+    mvprintw(y++, 4, "S - Toggle LPM self-profile overlay");
+    mvprintw(y++, 4, "G - Group by user, then name, then state, then back to processes");
+    y++;
+    mvprintw(y++, 2, "Sorting (toggle ascending/descending):");
+    mvprintw(y++, 4, "P - Sort by PID");
+    mvprintw(y++, 4, "N - Sort by Name");
+    mvprintw(y++, 4, "M - Sort by Memory");
+    mvprintw(y++, 4, "C - Sort by CPU");
+    mvprintw(y++, 4, "U - Sort by User");
+    mvprintw(y++, 4, "I - Sort by I/O rate (with I/O columns on)");
+    mvprintw(y++, 4, "W - Sort by run-queue wait, X - by context switches (columns on)");
+    mvprintw(y++, 4, "L - Suspected memory leaks first (RSS growth per hour)");
+    y++;
+    mvprintw(y++, 2, "Group view:");
+    mvprintw(y++, 4, "o - Next sort column    N/P/T/M/X/C - Sort by key/count/threads/RSS/max RSS/CPU");
+    mvprintw(y++, 4, "Enter - Show the group's processes");
+    y++;
+    if (replay) {
+        mvprintw(y++, 2, "Replay:");
+        mvprintw(y++, 4, "[ / ]         - Step one frame back/forward");
+        mvprintw(y++, 4, "{ / }         - Jump one minute back/forward");
+        mvprintw(y++, 4, "Home / End    - First/last frame");
+        mvprintw(y++, 4, "p - Play/pause    g - Go to time");
+        y++;
+    }
+    mvprintw(y++, 2, "q - Quit");
+    y++;
+    mvprintw(y++, 2, "Press any key to continue...");
+    
+    refresh();
+    nodelay(stdscr, FALSE);
+    getch();
+    nodelay(stdscr, TRUE);
+}
+
+// Update filtered process list
+void ProcessTUI::updateFilter() {
+    if (groupView) {
+        updateGroups();
+    }
+    
+    ScopedTimer timer(Profiler::STAGE_FILTER);
+    if (searchQuery.empty()) {
+        filteredProcesses = processes;
+    } else {
+        filteredProcesses = ProcessFilter::search(processes, searchQuery);
+    }
+    
+    ProcessSorter::sort(filteredProcesses, sortField, sortAscending);
+    
+    // With PSS shown, the first page of a descending memory sort is the
+    // exact top by PSS; the rest stays in RSS order
+    if (preciseMemory && sortField == ProcessSorter::BY_MEMORY && !sortAscending) {
+        std::vector<const Process*> top = memory.topByPSS(filteredProcesses, getListHeight(),
+                                                          manager.getSource());
+        std::unordered_set<ProcessKey, ProcessKeyHash> first;
+        std::vector<Process> rows;
+        rows.reserve(filteredProcesses.size());
+        for (const Process* proc : top) {
+            rows.push_back(*proc);
+            first.insert(proc->key());
+        }
+        for (auto& proc : filteredProcesses) {
+            if (!first.count(proc.key())) {
+                rows.push_back(std::move(proc));
+            }
+        }
+        filteredProcesses.swap(rows);
+    }
+    
+    // Suspected leaks first, fastest growing first; the rest keep their order
+    if (leakSort) {
+        std::vector<std::pair<double, size_t>> suspects;
+        for (size_t i = 0; i < filteredProcesses.size(); i++) {
+            LeakTrend trend;
+            if (leaks.getTrend(filteredProcesses[i].key(), trend) && trend.suspected) {
+                suspects.emplace_back(trend.slope, i);
+            }
+        }
+        std::stable_sort(suspects.begin(), suspects.end(),
+                         [](const auto& a, const auto& b) { return a.first > b.first; });
+        
+        std::vector<bool> first(filteredProcesses.size(), false);
+        std::vector<Process> rows;
+        rows.reserve(filteredProcesses.size());
+        for (const auto& suspect : suspects) {
+            rows.push_back(std::move(filteredProcesses[suspect.second]));
+            first[suspect.second] = true;
+        }
+        for (size_t i = 0; i < filteredProcesses.size(); i++) {
+            if (!first[i]) {
+                rows.push_back(std::move(filteredProcesses[i]));
+            }
+        }
+        filteredProcesses.swap(rows);
+    }
+    
+    threadOwner.assign(filteredProcesses.size(), -1);
+    if (threads.empty()) {
+        return;
+    }
+    
+    // Insert the threads of expanded processes below their owner,
+    // sorted by the same field
+    std::vector<Process> rows;
+    std::vector<int> owners;
+    rows.reserve(filteredProcesses.size());
+    owners.reserve(filteredProcesses.size());
+    
+    for (auto& proc : filteredProcesses) {
+        int owner = (int)rows.size();
+        auto it = threads.find(proc.key());
+        rows.push_back(std::move(proc));
+        owners.push_back(-1);
+        if (it == threads.end()) {
+            continue;
+        }
+        
+        std::vector<Process> list = it->second;
+        ProcessSorter::sort(list, sortField, sortAscending);
+        for (auto& thread : list) {
+            thread.name = " `- " + thread.name;
+            rows.push_back(std::move(thread));
+            owners.push_back(owner);
+        }
+    }
+    
+    filteredProcesses.swap(rows);
+    threadOwner.swap(owners);
+}
+
+// Row of the process a row belongs to (itself unless it is a thread row)
+int ProcessTUI::ownerRow(int row) const {
+    return threadOwner[row] < 0 ? row : threadOwner[row];
+}
+
+// Rows above the column headers: the title, then the system meters and
+// per-core strip once the live system has been sampled, or one row for
+// the replay position or event rates
+int ProcessTUI::headerHeight() const {
+    return !replay && systemSampler.getSampleCount() > 0 ? 3 : 2;
+}
+
+// Number of process rows that fit on screen
+int ProcessTUI::getListHeight() {
+    int height = screenHeight - headerHeight() - 3;
+    if (showDetails && !groupView) {
+        height /= 2;
+    }
+    return std::max(1, height);
+}
+
+// Set status message
+void ProcessTUI::setStatus(const std::string& message) {
+    statusMessage = message;
+}
+
+// Get state description
+std::string ProcessTUI::getStateDescription(const std::string& state) {
+    if (state == "R") return "Running";
+    if (state == "S") return "Sleeping";
+    if (state == "D") return "Disk Sleep";
+    if (state == "Z") return "Zombie";
+    if (state == "T") return "Stopped";
+    if (state == "t") return "Tracing";
+    if (state == "X") return "Dead";
+    if (state == "I") return "Idle";
+    return "Unknown";
+}
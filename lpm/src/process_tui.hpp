@@ -1,71 +1,180 @@
-#pragma once
-
-#include "process.hpp"
-#include "process_filter.hpp"
-#include <ncurses.h>
-#include <vector>
-#include <string>
-
-// Interactive TUI for process management
-class ProcessTUI {
-public:
-    ProcessTUI();
-    ~ProcessTUI();
-    
-    // Initialize ncurses
-    bool init();
-    
-    // Cleanup ncurses
-    void cleanup();
-    
-    // Main event loop
-    void run();
-
-private:
-    ProcessManager manager;
-    std::vector<Process> processes;
-    std::vector<Process> filteredProcesses;
-    
-    int selectedIndex;
-    int scrollOffset;
-    int screenHeight;
-    int screenWidth;
-    
-    ProcessSorter::SortField sortField;
-    bool sortAscending;
-    
-    std::string searchQuery;
-    std::string statusMessage;
-    bool showTree;
-    double refreshInterval;
-    time_t lastRefresh;
-    
-    // UI Drawing
-    void draw();
-    void drawHeader();
-    void drawProcessList();
-    void drawStatusBar();
-    void drawHelpBar();
-    
-    // Event handling
-    void handleInput(int ch);
-    void handleNavigation(int ch);
-    void handleActions(int ch);
-    void handleSorting(int ch);
-    
-    // Actions
-    void refreshProcesses();
-    void killSelectedProcess();
-    void changeSelectedPriority();
-    void showProcessDetails();
-    void promptSearch();
-    void toggleTreeView();
-    void showHelp();
-    
-    // Utilities
-    void updateFilter();
-    void setStatus(const std::string& message);
-    std::string getProcessLine(const Process& proc, int width);
-    std::string getStateDescription(const std::string& state);
-    void promptInput(const std::string& prompt, std::string& output);
-};
+#pragma once
+
+#include "process.hpp"
+#include "process_filter.hpp"
+#include "process_details.hpp"
+#include "process_history.hpp"
+#include "process_leaks.hpp"
+#include "process_record.hpp"
+#include "process_profile.hpp"
+#include "process_events.hpp"
+#include "process_system.hpp"
+#include "process_group.hpp"
+#include <ncurses.h>
+#include <vector>
+#include <string>
+#include <unordered_set>
+#include <unordered_map>
+
+// Interactive TUI for process management
+class ProcessTUI {
+public:
+    ProcessTUI();
+    ~ProcessTUI();
+    
+    // Initialize ncurses
+    bool init();
+    
+    // Cleanup ncurses
+    void cleanup();
+    
+    // Main event loop
+    void run();
+    
+    // Browse a recording instead of the live system (call before init)
+    void setReplay(SnapshotReader* reader) { replay = reader; }
+    
+    // Format one row of the process list, cut to 'width' columns
+    std::string getProcessLine(const Process& proc, int width);
+
+private:
+    ProcessManager manager;
+    std::vector<Process> processes;
+    std::vector<Process> filteredProcesses;
+    
+    int selectedIndex;
+    int scrollOffset;
+    int screenHeight;
+    int screenWidth;
+    
+    ProcessSorter::SortField sortField;
+    bool sortAscending;
+    
+    std::string searchQuery;
+    std::string statusMessage;
+    bool showTree;
+    double refreshInterval;
+    time_t lastRefresh;
+    unsigned long refreshTick;     // Incremented on every refresh
+    
+    bool showDetails;
+    ProcessDetailsLoader detailsLoader;
+    
+    // Process the details pane showed last; if it left the list at a
+    // refresh, its last details stay up (marked exited) for that tick
+    // while the selection stays on the same row
+    ProcessKey detailsKey;
+    unsigned long detailsExitTick;
+    int detailsExitRow;
+    ProcessHistory history;
+    
+    // RSS trends; with leakSort on, suspected leaks come first and the
+    // memory column shows growth per hour
+    LeakDetector leaks;
+    bool leakSort;
+    
+    // Processes marked for batch actions
+    std::unordered_set<ProcessKey, ProcessKeyHash> marked;
+    
+    // Processes expanded into their threads, with the threads read on the
+    // last refresh. Thread rows follow their owner in filteredProcesses;
+    // threadOwner holds the owner's row for thread rows and -1 otherwise.
+    std::unordered_set<ProcessKey, ProcessKeyHash> expanded;
+    std::unordered_map<ProcessKey, std::vector<Process>, ProcessKeyHash> threads;
+    std::vector<int> threadOwner;
+    
+    // Replay of a recording (nullptr for the live system)
+    SnapshotReader* replay;
+    bool replayPlaying;
+    
+    // Precise memory mode: PSS for visible rows and the top of a memory sort
+    bool preciseMemory;
+    MemoryCollector memory;
+    
+    // Storage read/write rate columns (/proc/<pid>/io is only read while on)
+    bool showIO;
+    
+    // Run-queue wait and context switch rate columns (schedstat is only
+    // read while on)
+    bool showSched;
+    
+    // Group view: totals per user, name or state over the processes
+    // matching the search, in place of the process list. The process
+    // list's selection is kept while it is shown.
+    bool groupView;
+    ProcessGrouper grouper;
+    ProcessGrouper::Key groupKey;
+    ProcessGrouper::Column groupSort;
+    int savedSelection;
+    int savedScroll;
+    
+    // CPU, memory, load and pressure meters in the header (live only)
+    SystemSampler systemSampler;
+    
+    // Spawn/exit rates when processes are tracked with proc events
+    ProcessEventSource* events;
+    ProcessEventCounters lastEvents;
+    uint64_t lastEventTime;
+    std::string eventSummary;
+    
+    // Self-profiling overlay and the I/O and allocation cost of the last refresh
+    bool showStats;
+    uint64_t refreshCost[Profiler::COUNTER_COUNT];
+    
+    // UI Drawing
+    void draw();
+    void drawHeader();
+    void drawSystemMeters(int y);
+    void drawCoreStrip(int y);
+    void drawProcessList();
+    void drawGroupList();
+    void drawStatusBar();
+    void drawHelpBar();
+    void drawDetailsPane(int startY, int height);
+    void drawDetailsBody(const ProcessDetails& details, const ProcessKey& key,
+                         int startY, int height);
+    void drawStatsOverlay();
+    
+    // Event handling
+    void handleInput(int ch);
+    void handleNavigation(int ch);
+    void handleActions(int ch);
+    void handleSorting(int ch);
+    void handleReplay(int ch);
+    void handleGroupInput(int ch);
+    
+    // Actions
+    void refreshProcesses();
+    void updateEventSummary();
+    void togglePreciseMemory();
+    void toggleIO();
+    void toggleSched();
+    void updateFields();
+    void updatePreciseMemory();
+    void killSelectedProcess();
+    void toggleMark();
+    void toggleMarkAll();
+    std::vector<ProcessKey> getActionTargets();
+    void changeSelectedPriority();
+    void showProcessDetails();
+    void promptSearch();
+    void toggleTreeView();
+    void toggleThreads();
+    void toggleGroupView();
+    void openSelectedGroup();
+    void refreshThreads();
+    void showHelp();
+    void seekReplay(int64_t frame);
+    void promptReplayTime();
+    
+    // Utilities
+    void updateFilter();
+    void updateGroups();
+    int rowCount() const;
+    int ownerRow(int row) const;
+    int headerHeight() const;
+    int getListHeight();
+    void setStatus(const std::string& message);
+    std::string getStateDescription(const std::string& state);
+    void promptInput(const std::string& prompt, std::string& output);
+};
@@ -0,0 +1,241 @@
+#include "process_watch.hpp"
+#include "process_profile.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+
+static const long CLOCK_TICKS = sysconf(_SC_CLK_TCK);
+
+// Re-read a pinned /proc file from the start
+static ssize_t readPinned(int fd, char* buf, size_t size) {
+    ssize_t length;
+    do {
+        length = pread(fd, buf, size, 0);
+    } while (length < 0 && errno == EINTR);
+    if (length > 0) {
+        Profiler::add(Profiler::BYTES_READ, length);
+    }
+    return length;
+}
+
+static int openPinned(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        Profiler::add(Profiler::FILES_OPENED, 1);
+    }
+    return fd;
+}
+
+ProcessWatcher::ProcessWatcher() : keepHistory(false) {
+}
+
+ProcessWatcher::~ProcessWatcher() {
+    for (auto& target : targets) {
+        close(target);
+    }
+}
+
+bool ProcessWatcher::add(ProcessManager& manager, int pid, bool threads, std::string& error) {
+    Process proc = manager.getProcess(pid);
+    if (pid <= 0 || proc.name.empty()) {
+        error = "no process " + std::to_string(pid);
+        return false;
+    }
+
+    WatchTarget target{};
+    target.owner = pid;
+    target.thread = false;
+    if (!pin(target, "/proc/" + std::to_string(pid), pid, proc.starttime)) {
+        error = "process " + std::to_string(pid) + " exited";
+        return false;
+    }
+    targets.push_back(std::move(target));
+
+    if (threads) {
+        threadOwners.push_back(pid);
+        addThreads(pid, proc.name);
+    }
+    return true;
+}
+
+// Open the files of one process or thread directory and take a baseline.
+// The start time is checked after opening, so a PID reused in between
+// is not watched in place of the original.
+bool ProcessWatcher::pin(WatchTarget& target, const std::string& dir, int id, long starttime) {
+    target.statFd = openPinned(dir + "/stat");
+    target.schedFd = openPinned(dir + "/schedstat");
+    target.statusFd = openPinned(dir + "/status");
+    target.alive = target.statFd >= 0;
+    target.prevTime = 0;
+
+    if (!read(target, Profiler::now()) ||
+        (starttime >= 0 && scratch.starttime != starttime)) {
+        close(target);
+        return false;
+    }
+    target.key = ProcessKey(id, scratch.starttime);
+    target.name = scratch.name;
+    return true;
+}
+
+void ProcessWatcher::close(WatchTarget& target) {
+    for (int* fd : {&target.statFd, &target.schedFd, &target.statusFd}) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+    target.alive = false;
+}
+
+// Pin the threads of 'pid' not watched yet
+void ProcessWatcher::addThreads(int pid, const std::string& name) {
+    std::string taskDir = "/proc/" + std::to_string(pid) + "/task";
+    tids.clear();
+    if (!taskEnumerator.list(taskDir, tids)) {
+        return;
+    }
+
+    std::vector<int> watched;
+    for (const auto& target : targets) {
+        if (target.thread && target.owner == pid && target.alive) {
+            watched.push_back(target.key.pid);
+        }
+    }
+    std::sort(watched.begin(), watched.end());
+
+    for (int tid : tids) {
+        if (std::binary_search(watched.begin(), watched.end(), tid)) {
+            continue;
+        }
+        WatchTarget target{};
+        target.owner = pid;
+        target.thread = true;
+        if (pin(target, taskDir + "/" + std::to_string(tid), tid, -1)) {
+            if (target.name.empty()) {
+                target.name = name;
+            }
+            targets.push_back(std::move(target));
+        }
+    }
+}
+
+void ProcessWatcher::refreshThreads() {
+    for (int pid : threadOwners) {
+        auto owner = std::find_if(targets.begin(), targets.end(), [pid](const WatchTarget& t) {
+            return !t.thread && t.owner == pid;
+        });
+        if (owner != targets.end() && owner->alive) {
+            addThreads(pid, owner->name);
+        }
+    }
+}
+
+// Read one target into its latest sample; false once it has gone. CPU%
+// and wait% are left at -1 for the first sample.
+bool ProcessWatcher::read(WatchTarget& target, int64_t now) {
+    if (!target.alive) {
+        return false;
+    }
+
+    char buf[4096];
+    ssize_t length = readPinned(target.statFd, buf, sizeof(buf));
+    if (length <= 0 || !scratch.parseStat(buf, length)) {
+        close(target);
+        return false;
+    }
+    unsigned long ticks = scratch.utime + scratch.stime;
+    target.state = scratch.state.empty() ? '?' : scratch.state[0];
+
+    // "run_ns wait_ns timeslices"; a process's file covers its main
+    // thread only, so it is used for single-threaded processes and threads
+    uint64_t runNs = 0, waitNs = 0;
+    bool precise = false;
+    if (target.schedFd >= 0 && (target.thread || scratch.numThreads == 1)) {
+        length = readPinned(target.schedFd, buf, sizeof(buf) - 1);
+        if (length > 0) {
+            buf[length] = '\0';
+            char* end;
+            runNs = std::strtoull(buf, &end, 10);
+            waitNs = std::strtoull(end, nullptr, 10);
+            precise = true;
+        }
+    }
+
+    if (!target.thread && target.statusFd >= 0) {
+        length = readPinned(target.statusFd, buf, sizeof(buf));
+        int uid;
+        if (length > 0 && scratch.parseStatus(buf, length, uid)) {
+            target.vmRSS = scratch.vmRSS;
+        }
+    } else if (!target.thread) {
+        target.vmRSS = scratch.vmRSS;
+    }
+
+    target.cpuPercent = -1;
+    target.waitPercent = -1;
+    if (target.prevTime > 0 && now > target.prevTime) {
+        double elapsed = (double)(now - target.prevTime);
+        if (precise && target.prevRunNs > 0 && runNs >= target.prevRunNs) {
+            target.cpuPercent = (runNs - target.prevRunNs) * 100.0 / elapsed;
+            target.waitPercent = (waitNs - target.prevWaitNs) * 100.0 / elapsed;
+        } else if (ticks >= target.prevTicks) {
+            target.cpuPercent = (ticks - target.prevTicks) * 1e11 / CLOCK_TICKS / elapsed;
+        }
+    }
+
+    target.time = now;
+    target.prevTime = now;
+    target.prevTicks = ticks;
+    target.prevRunNs = precise ? runNs : 0;
+    target.prevWaitNs = waitNs;
+    return true;
+}
+
+void ProcessWatcher::sample(int64_t now) {
+    for (auto& target : targets) {
+        read(target, now);
+    }
+
+    // A process whose threads are all watched gets their exact sums
+    for (int pid : threadOwners) {
+        double cpu = 0, wait = 0;
+        bool complete = true;
+        WatchTarget* owner = nullptr;
+        for (auto& target : targets) {
+            if (target.owner != pid || !target.alive || target.time != now) {
+                continue;
+            }
+            if (!target.thread) {
+                owner = &target;
+            } else if (target.cpuPercent < 0 || target.waitPercent < 0) {
+                complete = false;
+            } else {
+                cpu += target.cpuPercent;
+                wait += target.waitPercent;
+            }
+        }
+        if (owner && complete && owner->cpuPercent >= 0) {
+            owner->cpuPercent = cpu;
+            owner->waitPercent = wait;
+        }
+    }
+
+    if (keepHistory) {
+        for (auto& target : targets) {
+            if (target.alive && target.time == now && target.cpuPercent >= 0) {
+                target.cpuHistory.add((uint64_t)(target.cpuPercent * 100 + 0.5));
+                if (target.waitPercent >= 0) {
+                    target.waitHistory.add((uint64_t)(target.waitPercent * 100 + 0.5));
+                }
+            }
+        }
+    }
+}
+
+size_t ProcessWatcher::getLiveCount() const {
+    return std::count_if(targets.begin(), targets.end(),
+                         [](const WatchTarget& target) { return target.alive; });
+}
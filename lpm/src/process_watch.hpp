@@ -0,0 +1,87 @@
+#pragma once
+
+#include "process.hpp"
+#include "process_pids.hpp"
+#include "process_profile.hpp"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// A process or thread sampled by ProcessWatcher, with its latest sample.
+// Rates are over the interval since the sample before.
+struct WatchTarget {
+    ProcessKey key;                 // For threads, pid is the TID
+    int owner;                      // Owning PID (the PID itself for processes)
+    std::string name;
+    bool thread;
+    bool alive;                     // False once a read fails; files are closed
+
+    int64_t time;                   // CLOCK_MONOTONIC ns of the latest sample
+    char state;
+    double cpuPercent;              // Run time from schedstat (ticks without it)
+    double waitPercent;             // Runnable but waiting for a CPU (schedstat)
+    long vmRSS;                     // kB, exact from status (processes only)
+
+    // CPU% and wait% of every sample, in hundredths of a percent, when
+    // history is on (16 buckets per power of two: within about 3%)
+    LogHistogram cpuHistory{4};
+    LogHistogram waitHistory{4};
+
+    // Pinned descriptors and the previous counters
+    int statFd;
+    int schedFd;                    // -1 without schedstat
+    int statusFd;
+    int64_t prevTime;
+    unsigned long prevTicks;
+    uint64_t prevRunNs;
+    uint64_t prevWaitNs;
+};
+
+// Samples a few processes (and optionally their threads) at high rates.
+// Their stat, schedstat and status files are opened once and re-read
+// with pread at offset 0, so a sample costs three reads per target and no
+// opens, path building or directory lookups. A pinned descriptor keeps
+// referring to the process it was opened for: once that process exits,
+// reads fail instead of landing on a process that reused the PID.
+class ProcessWatcher {
+public:
+    ProcessWatcher();
+    ~ProcessWatcher();
+
+    ProcessWatcher(const ProcessWatcher&) = delete;
+    ProcessWatcher& operator=(const ProcessWatcher&) = delete;
+
+    // Count every sample's CPU% and wait% for percentiles
+    void setKeepHistory(bool keep) { keepHistory = keep; }
+
+    // Resolve 'pid' with ProcessManager::getProcess and pin its files;
+    // with 'threads', pin each of its threads too
+    bool add(ProcessManager& manager, int pid, bool threads, std::string& error);
+
+    // Pin threads started since the last call (or add)
+    void refreshThreads();
+
+    // Read every live target at CLOCK_MONOTONIC time 'now'
+    void sample(int64_t now);
+
+    const std::vector<WatchTarget>& getTargets() const { return targets; }
+    size_t getLiveCount() const;
+
+    // Percentage at 'fraction' (0..1) of a history
+    static double percentile(const LogHistogram& history, double fraction) {
+        return history.percentile(fraction) / 100.0;
+    }
+
+private:
+    std::vector<WatchTarget> targets;
+    std::vector<int> threadOwners;      // PIDs whose threads are watched
+    PidEnumerator taskEnumerator{16 * 1024};
+    std::vector<int> tids;
+    Process scratch;
+    bool keepHistory;
+
+    bool pin(WatchTarget& target, const std::string& dir, int id, long starttime);
+    bool read(WatchTarget& target, int64_t now);
+    void close(WatchTarget& target);
+    void addThreads(int pid, const std::string& name);
+};